@@ -0,0 +1,345 @@
+#include "compressed_image.h"
+#include "half_float.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace filmtracker {
+
+namespace {
+
+// 每组残差个数（共用一个位宽）
+constexpr uint32_t kBlockSize = 32;
+
+/**
+ * fp16 / fp32 位模式 <-> 保序整数
+ */
+inline uint32_t orderedHalf(uint16_t half) {
+    return (half & 0x8000u) ? (~half & 0xFFFFu) : (half | 0x8000u);
+}
+
+inline uint16_t fromOrderedHalf(uint32_t key) {
+    return static_cast<uint16_t>((key & 0x8000u) ? (key & 0x7FFFu) : (~key & 0xFFFFu));
+}
+
+inline uint32_t orderedFloat(uint32_t bits) {
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+inline uint32_t fromOrderedFloat(uint32_t key) {
+    return (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+}
+
+/**
+ * MED 预测（a = 左，b = 上，c = 左上）
+ */
+inline uint32_t predictMed(uint32_t a, uint32_t b, uint32_t c) {
+    const uint32_t maxAB = std::max(a, b);
+    const uint32_t minAB = std::min(a, b);
+    if (c >= maxAB) {
+        return minAB;
+    }
+    if (c <= minAB) {
+        return maxAB;
+    }
+    return a + b - c;
+}
+
+inline uint32_t zigzag(uint32_t residual) {
+    return (residual << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(residual) >> 31);
+}
+
+inline uint32_t unzigzag(uint32_t value) {
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+inline uint32_t bitWidth(uint32_t value) {
+    return value == 0 ? 0 : 32 - static_cast<uint32_t>(__builtin_clz(value));
+}
+
+/**
+ * 残差写入：凑满一组后按组内最大位宽打包
+ */
+class BlockWriter {
+public:
+    explicit BlockWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void put(uint32_t value) {
+        m_block[m_count++] = value;
+        if (m_count == kBlockSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (m_count == 0) {
+            return;
+        }
+        uint32_t bits = 0;
+        for (uint32_t i = 0; i < m_count; ++i) {
+            bits |= m_block[i];
+        }
+        const uint32_t width = bitWidth(bits);
+        const size_t position = m_out.size();
+        m_out.resize(position + 1 + (m_count * width + 7) / 8);
+        uint8_t* dst = m_out.data() + position;
+        *dst++ = static_cast<uint8_t>(width);
+
+        uint64_t accumulator = 0;
+        uint32_t pending = 0;
+        for (uint32_t i = 0; i < m_count && width > 0; ++i) {
+            accumulator |= static_cast<uint64_t>(m_block[i]) << pending;
+            pending += width;
+            while (pending >= 8) {
+                *dst++ = static_cast<uint8_t>(accumulator);
+                accumulator >>= 8;
+                pending -= 8;
+            }
+        }
+        if (pending > 0) {
+            *dst = static_cast<uint8_t>(accumulator);
+        }
+        m_count = 0;
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint32_t m_block[kBlockSize];
+    uint32_t m_count = 0;
+};
+
+/**
+ * 残差读取（与 BlockWriter 的分组一致：每组 kBlockSize 个，最后一组为剩余个数）
+ */
+class BlockReader {
+public:
+    BlockReader(const uint8_t* data, size_t total) : m_data(data), m_remaining(total) {}
+
+    uint32_t get() {
+        if (m_index == m_count) {
+            fill();
+        }
+        return m_block[m_index++];
+    }
+
+private:
+    void fill() {
+        m_count = static_cast<uint32_t>(std::min<size_t>(kBlockSize, m_remaining));
+        m_remaining -= m_count;
+        m_index = 0;
+
+        const uint32_t width = *m_data++;
+        if (width == 0) {
+            std::fill(m_block, m_block + m_count, 0u);
+            return;
+        }
+        const uint8_t* src = m_data;
+        const uint64_t mask = (width == 32) ? 0xFFFFFFFFull : ((1ull << width) - 1);
+        uint64_t accumulator = 0;
+        uint32_t available = 0;
+        for (uint32_t i = 0; i < m_count; ++i) {
+            while (available < width) {
+                accumulator |= static_cast<uint64_t>(*src++) << available;
+                available += 8;
+            }
+            m_block[i] = static_cast<uint32_t>(accumulator & mask);
+            accumulator >>= width;
+            available -= width;
+        }
+        m_data += (m_count * width + 7) / 8;
+    }
+
+    const uint8_t* m_data;
+    size_t m_remaining;
+    uint32_t m_block[kBlockSize];
+    uint32_t m_count = 0;
+    uint32_t m_index = 0;
+};
+
+/**
+ * 编码一个带（rows 行）
+ */
+void encodeBand(const float* src, uint32_t width, uint32_t rows, bool lossless, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> previous(width);
+    std::vector<uint32_t> current(width);
+    std::vector<uint16_t> half(lossless ? 0 : width);
+    out.reserve(static_cast<size_t>(width) * rows);
+
+    BlockWriter writer(out);
+    for (uint32_t y = 0; y < rows; ++y) {
+        const float* row = src + static_cast<size_t>(y) * width;
+        if (lossless) {
+            for (uint32_t x = 0; x < width; ++x) {
+                uint32_t bits;
+                std::memcpy(&bits, &row[x], sizeof(bits));
+                current[x] = orderedFloat(bits);
+            }
+        } else {
+            floatToHalfRow(row, half.data(), width);
+            for (uint32_t x = 0; x < width; ++x) {
+                current[x] = orderedHalf(half[x]);
+            }
+        }
+        // 带内首行只有左邻像素，其余行每行首像素用上方像素
+        const uint32_t* cur = current.data();
+        const uint32_t* prev = previous.data();
+        if (y == 0) {
+            writer.put(zigzag(cur[0]));
+            for (uint32_t x = 1; x < width; ++x) {
+                writer.put(zigzag(cur[x] - cur[x - 1]));
+            }
+        } else {
+            writer.put(zigzag(cur[0] - prev[0]));
+            for (uint32_t x = 1; x < width; ++x) {
+                writer.put(zigzag(cur[x] - predictMed(cur[x - 1], prev[x], prev[x - 1])));
+            }
+        }
+        previous.swap(current);
+    }
+    writer.flush();
+}
+
+/**
+ * 解码一个带
+ */
+void decodeBand(const uint8_t* data, uint32_t width, uint32_t rows, bool lossless, float* dst) {
+    std::vector<uint32_t> previous(width);
+    std::vector<uint32_t> current(width);
+    std::vector<uint16_t> half(lossless ? 0 : width);
+
+    BlockReader reader(data, static_cast<size_t>(width) * rows);
+    for (uint32_t y = 0; y < rows; ++y) {
+        uint32_t* cur = current.data();
+        const uint32_t* prev = previous.data();
+        if (y == 0) {
+            cur[0] = unzigzag(reader.get());
+            for (uint32_t x = 1; x < width; ++x) {
+                cur[x] = cur[x - 1] + unzigzag(reader.get());
+            }
+        } else {
+            cur[0] = prev[0] + unzigzag(reader.get());
+            for (uint32_t x = 1; x < width; ++x) {
+                cur[x] = predictMed(cur[x - 1], prev[x], prev[x - 1]) + unzigzag(reader.get());
+            }
+        }
+        float* row = dst + static_cast<size_t>(y) * width;
+        if (lossless) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint32_t bits = fromOrderedFloat(current[x]);
+                std::memcpy(&row[x], &bits, sizeof(bits));
+            }
+        } else {
+            for (uint32_t x = 0; x < width; ++x) {
+                half[x] = fromOrderedHalf(current[x]);
+            }
+            halfToFloatRow(half.data(), row, width);
+        }
+        previous.swap(current);
+    }
+}
+
+/**
+ * 把 [0, count) 分给多个线程
+ */
+template <typename Fn>
+void parallelFor(uint32_t count, Fn fn) {
+    const uint32_t numThreads = std::max(1u, std::min({4u, std::thread::hardware_concurrency(), count}));
+    if (numThreads <= 1) {
+        for (uint32_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    const uint32_t itemsPerThread = count / numThreads;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t) {
+        uint32_t start = t * itemsPerThread;
+        uint32_t end = (t == numThreads - 1) ? count : (t + 1) * itemsPerThread;
+        threads.emplace_back([&fn, start, end]() {
+            for (uint32_t i = start; i < end; ++i) {
+                fn(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
+std::shared_ptr<const CompressedImage> CompressedImage::compress(const LinearImage& image, CacheCompression mode) {
+    std::shared_ptr<CompressedImage> compressed(new CompressedImage());
+    compressed->m_width = image.width;
+    compressed->m_height = image.height;
+    compressed->m_provenance = image.provenance;
+    compressed->m_mode = (mode == CacheCompression::HALF_DELTA) ? CacheCompression::HALF_DELTA
+                                                                 : CacheCompression::LOSSLESS_DELTA;
+
+    const uint32_t bands = compressed->bandCount();
+    const uint32_t items = bands * 3;
+    const bool lossless = compressed->m_mode == CacheCompression::LOSSLESS_DELTA;
+    const float* planes[3] = {image.r.data(), image.g.data(), image.b.data()};
+
+    // 各带独立编码，再按顺序拼接
+    std::vector<std::vector<uint8_t>> encoded(items);
+    parallelFor(items, [&](uint32_t item) {
+        const uint32_t band = item % bands;
+        const uint32_t row0 = band * kBandRows;
+        const uint32_t rows = std::min(kBandRows, image.height - row0);
+        encodeBand(planes[item / bands] + static_cast<size_t>(row0) * image.width,
+                   image.width, rows, lossless, encoded[item]);
+    });
+
+    compressed->m_bandOffsets.resize(items + 1);
+    size_t total = 0;
+    for (uint32_t i = 0; i < items; ++i) {
+        compressed->m_bandOffsets[i] = total;
+        total += encoded[i].size();
+    }
+    compressed->m_bandOffsets[items] = total;
+
+    compressed->m_data.resize(total);
+    for (uint32_t i = 0; i < items; ++i) {
+        if (!encoded[i].empty()) {
+            std::memcpy(compressed->m_data.data() + compressed->m_bandOffsets[i], encoded[i].data(), encoded[i].size());
+        }
+    }
+    return compressed;
+}
+
+void CompressedImage::decompress(LinearImage& output) const {
+    if (output.width != m_width || output.height != m_height ||
+        output.r.size() != static_cast<size_t>(m_width) * m_height) {
+        output = LinearImage(m_width, m_height);
+    }
+    output.provenance = m_provenance;
+
+    const uint32_t bands = bandCount();
+    const bool lossless = m_mode == CacheCompression::LOSSLESS_DELTA;
+    float* planes[3] = {output.r.data(), output.g.data(), output.b.data()};
+    parallelFor(bands * 3, [&](uint32_t item) {
+        const uint32_t band = item % bands;
+        const uint32_t row0 = band * kBandRows;
+        const uint32_t rows = std::min(kBandRows, m_height - row0);
+        decodeBand(m_data.data() + m_bandOffsets[item], m_width, rows, lossless,
+                   planes[item / bands] + static_cast<size_t>(row0) * m_width);
+    });
+}
+
+std::shared_ptr<const LinearImage> CompressedImage::decompress() const {
+    std::shared_ptr<LinearImage> image = std::make_shared<LinearImage>(m_width, m_height);
+    decompress(*image);
+    return image;
+}
+
+size_t CompressedImage::compressedBytes() const {
+    return sizeof(*this) + m_data.capacity() + m_bandOffsets.capacity() * sizeof(size_t);
+}
+
+size_t CompressedImage::uncompressedBytes() const {
+    return static_cast<size_t>(m_width) * m_height * 3 * sizeof(float);
+}
+
+} // namespace filmtracker
@@ -0,0 +1,85 @@
+#ifndef FILMTRACKER_COMPRESSED_IMAGE_H
+#define FILMTRACKER_COMPRESSED_IMAGE_H
+
+#include "raw_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 缓存条目的压缩方式
+ */
+enum class CacheCompression : int {
+    NONE = 0,              // fp32 平面原样保存
+    HALF_DELTA = 1,        // fp16 + 预测差分 + 分块位打包（近无损，相对误差约 0.05%）
+    LOSSLESS_DELTA = 2     // fp32 位模式 + 预测差分 + 分块位打包（无损）
+};
+
+/**
+ * 压缩的线性图像（不可变，用于内存缓存）
+ *
+ * 每个平面按 kBandRows 行分带独立编码，带之间没有依赖，压缩和解压都按带分给多个线程：
+ * - 像素值映射为保序整数（fp16 或 fp32 的位模式，负数按位取反），数值接近的像素整数也接近
+ * - 预测：带内首行用左邻像素，其余行用 MED（LOCO-I 中值边缘检测）预测
+ * - 残差 zigzag 后每 kBlockSize 个一组，按组内最大位宽打包（1 字节位宽 + 打包数据）
+ *
+ * 平滑的双边滤波基础层 fp16 模式约为 fp32 的 1/3 - 1/5；细节层、噪声多的图像压缩率较低。
+ */
+class CompressedImage {
+public:
+    /**
+     * 压缩图像
+     *
+     * @param image 输入图像
+     * @param mode HALF_DELTA 或 LOSSLESS_DELTA（NONE 按 LOSSLESS_DELTA 处理）
+     * @return 压缩结果
+     */
+    static std::shared_ptr<const CompressedImage> compress(const LinearImage& image, CacheCompression mode);
+
+    /**
+     * 解压到调用方的图像（尺寸不符时重新分配）
+     */
+    void decompress(LinearImage& output) const;
+
+    /**
+     * 解压为新的共享缓冲区
+     */
+    std::shared_ptr<const LinearImage> decompress() const;
+
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    uint64_t provenance() const { return m_provenance; }
+    CacheCompression mode() const { return m_mode; }
+
+    /**
+     * 压缩后占用的字节数
+     */
+    size_t compressedBytes() const;
+
+    /**
+     * 解压后 fp32 平面的字节数
+     */
+    size_t uncompressedBytes() const;
+
+private:
+    CompressedImage() = default;
+
+    // 每个编码带的行数
+    static constexpr uint32_t kBandRows = 16;
+
+    uint32_t bandCount() const { return (m_height + kBandRows - 1) / kBandRows; }
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint64_t m_provenance = 0;
+    CacheCompression m_mode = CacheCompression::HALF_DELTA;
+    std::vector<uint8_t> m_data;
+    std::vector<size_t> m_bandOffsets;     // 平面 * 带数 + 带 -> m_data 中的起点，末尾为总长度
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_COMPRESSED_IMAGE_H
@@ -0,0 +1,322 @@
+#include "decoded_image_cache.h"
+#include "half_image_file.h"
+#include "image_hash_cache.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <android/log.h>
+
+#define LOG_TAG "DecodedImageCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+const char* const kEntryExtension = ".flc";
+
+/**
+ * 写入缓存文件头之后的自定义数据：完整的缓存键（用于校验哈希碰撞）+ 元数据
+ */
+struct StoredEntry {
+    char filePath[512];
+    int64_t fileSize;
+    int64_t modifiedTimeNs;
+    uint32_t decodeSettings;
+    uint32_t reserved;
+    RawMetadata metadata;
+};
+
+static_assert(sizeof(StoredEntry) <= HalfImageFile::kMaxUserDataSize, "StoredEntry too large");
+
+int64_t modifiedTimeNs(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+bool keyMatches(const StoredEntry& stored, const DecodedImageCache::Key& key) {
+    return stored.fileSize == key.fileSize &&
+           stored.modifiedTimeNs == key.modifiedTimeNs &&
+           stored.decodeSettings == key.decodeSettings &&
+           key.filePath.compare(0, std::string::npos, stored.filePath,
+                                strnlen(stored.filePath, sizeof(stored.filePath))) == 0;
+}
+
+} // namespace
+
+DecodedImageCache& DecodedImageCache::getInstance() {
+    static DecodedImageCache instance;
+    return instance;
+}
+
+DecodedImageCache::~DecodedImageCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_writeQueue.clear();
+    }
+    m_writeCondition.notify_all();
+    if (m_writerThread.joinable()) {
+        m_writerThread.join();
+    }
+}
+
+bool DecodedImageCache::makeKey(const char* filePath, uint32_t decodeSettings, Key& key) {
+    struct stat st;
+    if (!filePath || stat(filePath, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    // 路径超长时无法完整写入文件头，不缓存
+    if (std::strlen(filePath) >= sizeof(StoredEntry::filePath)) {
+        return false;
+    }
+    key.filePath = filePath;
+    key.fileSize = static_cast<int64_t>(st.st_size);
+    key.modifiedTimeNs = modifiedTimeNs(st);
+    key.decodeSettings = decodeSettings;
+    return true;
+}
+
+bool DecodedImageCache::initialize(const std::string& cacheDir, size_t maxSizeMB) {
+    DiskCacheIndex index(maxSizeMB * 1024 * 1024);
+    if (!DiskCacheIndex::open(cacheDir, kEntryExtension, index)) {
+        return false;
+    }
+
+    const size_t entryCount = index.size();
+    const size_t totalBytes = index.totalBytes();
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index = std::move(index);
+        evicted = collectEvictionsLocked();
+    }
+    for (const auto& path : evicted) {
+        unlink(path.c_str());
+    }
+
+    LOGI("initialize: %s, %zu entries (%zu evicted), %zu MB / %zu MB",
+         cacheDir.c_str(), entryCount, evicted.size(), totalBytes / (1024 * 1024), maxSizeMB);
+    return true;
+}
+
+bool DecodedImageCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.isOpen() && m_index.maxBytes() > 0;
+}
+
+std::string DecodedImageCache::entryPath(const Key& key) const {
+    uint64_t hash = ImageHashCache::hashBytes(key.filePath.data(), key.filePath.size(), 0);
+    hash = ImageHashCache::hashBytes(&key.fileSize, sizeof(key.fileSize), hash);
+    hash = ImageHashCache::hashBytes(&key.modifiedTimeNs, sizeof(key.modifiedTimeNs), hash);
+    hash = ImageHashCache::hashBytes(&key.decodeSettings, sizeof(key.decodeSettings), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 "%s", hash, kEntryExtension);
+    return name;
+}
+
+bool DecodedImageCache::find(const Key& key, LinearImage& image, RawMetadata& metadata) {
+    std::string name;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_index.isOpen()) {
+            return false;
+        }
+        name = entryPath(key);
+        if (!m_index.contains(name)) {
+            m_stats.misses++;
+            return false;
+        }
+        path = m_index.pathOf(name);
+    }
+
+    // 文件 I/O 在锁外进行
+    StoredEntry stored;
+    size_t bytesRead = 0;
+    HalfImageFile::ReadStatus status = HalfImageFile::readUserData(path, &stored, sizeof(stored));
+    if (status == HalfImageFile::ReadStatus::OK && !keyMatches(stored, key)) {
+        status = HalfImageFile::ReadStatus::INVALID;
+    }
+    if (status == HalfImageFile::ReadStatus::OK) {
+        status = HalfImageFile::read(path, image, nullptr, sizeof(stored), &bytesRead);
+    }
+    if (status == HalfImageFile::ReadStatus::OK &&
+        (image.width != stored.metadata.width || image.height != stored.metadata.height)) {
+        status = HalfImageFile::ReadStatus::INVALID;
+    }
+    const bool hit = status == HalfImageFile::ReadStatus::OK;
+
+    if (hit) {
+        metadata = stored.metadata;
+        // 更新 mtime，作为下次启动时的 LRU 依据
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (hit) {
+        m_stats.hits++;
+        m_stats.bytesRead += bytesRead;
+        m_index.touch(name);
+    } else {
+        m_stats.misses++;
+        // 损坏或键不匹配（哈希碰撞）的文件直接删除，之后会被新结果覆盖；
+        // 打开 / 映射失败或内存不足只算未命中，条目保留
+        if (status == HalfImageFile::ReadStatus::INVALID) {
+            m_index.erase(name);
+            unlink(path.c_str());
+            LOGW("find: Invalid cache entry %s removed", name.c_str());
+        }
+    }
+    return hit;
+}
+
+bool DecodedImageCache::store(const Key& key, const LinearImage& image, const RawMetadata& metadata) {
+    std::string name;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_index.isOpen() || m_index.maxBytes() == 0) {
+            return false;
+        }
+        // 单个条目超过总容量时不缓存
+        if (HalfImageFile::fileSize(image.width, image.height) > m_index.maxBytes()) {
+            return false;
+        }
+        name = entryPath(key);
+        path = m_index.pathOf(name);
+    }
+
+    StoredEntry stored;
+    std::memset(&stored, 0, sizeof(stored));
+    strncpy(stored.filePath, key.filePath.c_str(), sizeof(stored.filePath) - 1);
+    stored.fileSize = key.fileSize;
+    stored.modifiedTimeNs = key.modifiedTimeNs;
+    stored.decodeSettings = key.decodeSettings;
+    stored.metadata = metadata;
+
+    size_t bytesWritten = HalfImageFile::write(path, image, &stored, sizeof(stored));
+
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bytesWritten == 0) {
+            m_stats.writeFailures++;
+            return false;
+        }
+        m_stats.writes++;
+        m_stats.bytesWritten += bytesWritten;
+
+        m_index.put(name, bytesWritten);
+        evicted = collectEvictionsLocked();
+    }
+    for (const auto& evictedPath : evicted) {
+        unlink(evictedPath.c_str());
+    }
+    return true;
+}
+
+bool DecodedImageCache::storeAsync(const Key& key, std::shared_ptr<const LinearImage> image,
+                                   const RawMetadata& metadata) {
+    if (!image) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_index.isOpen() || m_index.maxBytes() == 0 || m_stopping) {
+            return false;
+        }
+        if (HalfImageFile::fileSize(image->width, image->height) > m_index.maxBytes()) {
+            return false;
+        }
+        if (m_writeQueue.size() >= kMaxPendingWrites) {
+            m_stats.droppedWrites++;
+            LOGW("storeAsync: Write queue full, skipping %s", key.filePath.c_str());
+            return false;
+        }
+        m_writeQueue.push_back(WriteJob{key, std::move(image), metadata});
+        if (!m_writerThread.joinable()) {
+            m_writerThread = std::thread(&DecodedImageCache::writerLoop, this);
+        }
+    }
+    m_writeCondition.notify_one();
+    return true;
+}
+
+void DecodedImageCache::writerLoop() {
+    while (true) {
+        WriteJob job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_writeCondition.wait(lock, [this]() { return m_stopping || !m_writeQueue.empty(); });
+            if (m_stopping) {
+                break;
+            }
+            job = std::move(m_writeQueue.front());
+            m_writeQueue.pop_front();
+            m_writing = true;
+        }
+
+        store(job.key, *job.image, job.metadata);
+        job.image.reset();  // 写完立即释放图像引用
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writing = false;
+        }
+        m_idleCondition.notify_all();
+    }
+}
+
+void DecodedImageCache::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this]() { return m_stopping || (m_writeQueue.empty() && !m_writing); });
+}
+
+std::vector<std::string> DecodedImageCache::collectEvictionsLocked() {
+    std::vector<std::string> evicted = m_index.collectEvictions();
+    m_stats.evictions += evicted.size();
+    return evicted;
+}
+
+void DecodedImageCache::clear() {
+    std::vector<std::string> paths;
+    {
+        // 丢弃未开始的写入，等待正在写入的条目完成后再清空
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_writeQueue.clear();
+        m_idleCondition.wait(lock, [this]() { return !m_writing; });
+        paths = m_index.clear();
+    }
+    for (const auto& path : paths) {
+        unlink(path.c_str());
+    }
+    LOGI("Cache cleared, %zu files removed", paths.size());
+}
+
+void DecodedImageCache::setMaxSizeMB(size_t maxSizeMB) {
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index.setMaxBytes(maxSizeMB * 1024 * 1024);
+        evicted = collectEvictionsLocked();
+    }
+    for (const auto& path : evicted) {
+        unlink(path.c_str());
+    }
+}
+
+DecodedImageCache::Stats DecodedImageCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.entryCount = m_index.size();
+    stats.totalBytes = m_index.totalBytes();
+    return stats;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,180 @@
+#ifndef FILMTRACKER_DECODED_IMAGE_CACHE_H
+#define FILMTRACKER_DECODED_IMAGE_CACHE_H
+
+#include "raw_types.h"
+#include "disk_cache_index.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace filmtracker {
+
+/**
+ * 解码图像磁盘缓存
+ *
+ * 把 RAW 解码（LibRaw 解包 + 去马赛克）后的线性图像以 fp16 平面格式
+ * 保存到应用缓存目录，再次打开同一文件时直接映射读取，跳过解码。
+ *
+ * - 缓存键：文件路径 + 文件大小 + 修改时间 + 解码设置，源文件被修改后自动失效
+ * - 写入：临时文件 + fsync + rename，崩溃不会留下半写的缓存文件；
+ *   storeAsync 交给后台写入线程，解码线程不等待 fp16 转换和 fsync
+ * - 容量：按总字节数限制，超出时按最近访问时间（文件 mtime）淘汰
+ */
+class DecodedImageCache {
+public:
+    /**
+     * 缓存键
+     */
+    struct Key {
+        std::string filePath;
+        int64_t fileSize = 0;
+        int64_t modifiedTimeNs = 0;
+        uint32_t decodeSettings = 0;    // 去马赛克质量等影响解码结果的设置
+    };
+
+    /**
+     * 缓存统计
+     */
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writes = 0;
+        uint64_t writeFailures = 0;
+        uint64_t droppedWrites = 0;     // 后台写入队列已满时放弃的写入
+        uint64_t evictions = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t entryCount = 0;
+        uint64_t totalBytes = 0;
+    };
+
+    /**
+     * 获取单例
+     */
+    static DecodedImageCache& getInstance();
+
+    /**
+     * 根据源文件构造缓存键（stat 获取大小和修改时间）
+     *
+     * @return 文件不存在时返回 false
+     */
+    static bool makeKey(const char* filePath, uint32_t decodeSettings, Key& key);
+
+    /**
+     * 初始化缓存目录
+     *
+     * 扫描已有缓存文件建立索引，并清理崩溃残留的临时文件
+     *
+     * @param cacheDir 缓存目录（不存在时创建）
+     * @param maxSizeMB 最大磁盘占用（MB）
+     * @return 是否成功
+     */
+    bool initialize(const std::string& cacheDir, size_t maxSizeMB);
+
+    /**
+     * 是否已初始化
+     */
+    bool isEnabled() const;
+
+    /**
+     * 查找缓存
+     *
+     * @param key 缓存键
+     * @param image 输出图像（命中时）
+     * @param metadata 输出元数据（命中时）
+     * @return 是否命中
+     */
+    bool find(const Key& key, LinearImage& image, RawMetadata& metadata);
+
+    /**
+     * 写入缓存（写入后按容量淘汰旧条目）
+     */
+    bool store(const Key& key, const LinearImage& image, const RawMetadata& metadata);
+
+    /**
+     * 异步写入缓存：共享图像交给后台写入线程，不复制像素
+     *
+     * 每个待写入条目都持有一整幅全尺寸图像，队列已满时直接放弃这次写入
+     * （下次打开同一文件时重新解码再写入）
+     *
+     * @return 是否已加入写入队列
+     */
+    bool storeAsync(const Key& key, std::shared_ptr<const LinearImage> image, const RawMetadata& metadata);
+
+    /**
+     * 等待后台写入队列清空
+     */
+    void flush();
+
+    /**
+     * 删除全部缓存文件
+     */
+    void clear();
+
+    /**
+     * 配置
+     */
+    void setMaxSizeMB(size_t maxSizeMB);
+
+    /**
+     * 获取统计
+     */
+    Stats getStats() const;
+
+private:
+    /**
+     * 后台写入任务
+     */
+    struct WriteJob {
+        Key key;
+        std::shared_ptr<const LinearImage> image;
+        RawMetadata metadata;
+    };
+
+    static constexpr size_t kMaxPendingWrites = 1;
+
+    DecodedImageCache() = default;
+    ~DecodedImageCache();
+
+    // 禁止拷贝和赋值
+    DecodedImageCache(const DecodedImageCache&) = delete;
+    DecodedImageCache& operator=(const DecodedImageCache&) = delete;
+
+    /**
+     * 缓存文件名（键的 xxHash64）
+     */
+    std::string entryPath(const Key& key) const;
+
+    /**
+     * 淘汰最久未访问的条目直到满足容量限制（调用方持有锁）
+     *
+     * @return 需要删除的文件路径
+     */
+    std::vector<std::string> collectEvictionsLocked();
+
+    /**
+     * 后台写入线程
+     */
+    void writerLoop();
+
+    DiskCacheIndex m_index{1024ULL * 1024 * 1024};  // 1GB
+    Stats m_stats;
+    mutable std::mutex m_mutex;
+
+    // 后台写入
+    std::deque<WriteJob> m_writeQueue;
+    bool m_writing = false;
+    bool m_stopping = false;
+    std::thread m_writerThread;
+    std::condition_variable m_writeCondition;
+    std::condition_variable m_idleCondition;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_DECODED_IMAGE_CACHE_H
@@ -0,0 +1,135 @@
+#include "disk_cache_index.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <android/log.h>
+
+#define LOG_TAG "DiskCacheIndex"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+int64_t modifiedTimeNs(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+bool endsWith(const std::string& value, const char* suffix) {
+    size_t suffixLength = std::strlen(suffix);
+    return value.size() >= suffixLength &&
+           value.compare(value.size() - suffixLength, suffixLength, suffix) == 0;
+}
+
+} // namespace
+
+bool DiskCacheIndex::open(const std::string& directory, const char* extension, DiskCacheIndex& index) {
+    if (directory.empty()) {
+        return false;
+    }
+    if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOGE("open: Failed to create %s: %s", directory.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        LOGE("open: Failed to open %s: %s", directory.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    // 扫描目录：索引缓存文件，删除崩溃残留的临时文件
+    index.m_directory = directory;
+    index.m_entries.clear();
+    index.m_totalBytes = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        const std::string path = directory + "/" + name;
+        if (name.find(".tmp.") != std::string::npos) {
+            unlink(path.c_str());
+            continue;
+        }
+        if (!endsWith(name, extension)) {
+            continue;
+        }
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        index.m_entries[name] = {static_cast<uint64_t>(st.st_size), modifiedTimeNs(st)};
+        index.m_totalBytes += static_cast<size_t>(st.st_size);
+    }
+    closedir(dir);
+    return true;
+}
+
+int64_t DiskCacheIndex::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void DiskCacheIndex::touch(const std::string& name) {
+    auto it = m_entries.find(name);
+    if (it != m_entries.end()) {
+        it->second.lastAccessNs = nowNs();
+    }
+}
+
+void DiskCacheIndex::put(const std::string& name, uint64_t fileBytes) {
+    erase(name);
+    m_entries[name] = {fileBytes, nowNs()};
+    m_totalBytes += static_cast<size_t>(fileBytes);
+}
+
+void DiskCacheIndex::erase(const std::string& name) {
+    auto it = m_entries.find(name);
+    if (it != m_entries.end()) {
+        m_totalBytes -= std::min<size_t>(m_totalBytes, it->second.fileBytes);
+        m_entries.erase(it);
+    }
+}
+
+std::vector<std::string> DiskCacheIndex::clear() {
+    std::vector<std::string> paths;
+    paths.reserve(m_entries.size());
+    for (const auto& entry : m_entries) {
+        paths.push_back(pathOf(entry.first));
+    }
+    m_entries.clear();
+    m_totalBytes = 0;
+    return paths;
+}
+
+std::vector<std::string> DiskCacheIndex::collectEvictions() {
+    std::vector<std::string> evicted;
+    if (m_totalBytes <= m_maxBytes) {
+        return evicted;
+    }
+
+    // 按最近访问时间从旧到新排序
+    std::vector<std::pair<int64_t, std::string>> entries;
+    entries.reserve(m_entries.size());
+    for (const auto& entry : m_entries) {
+        entries.emplace_back(entry.second.lastAccessNs, entry.first);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (const auto& entry : entries) {
+        if (m_totalBytes <= m_maxBytes) {
+            break;
+        }
+        evicted.push_back(pathOf(entry.second));
+        erase(entry.second);
+    }
+
+    LOGI("%s: Evicted %zu entries, total size: %zu MB",
+         m_directory.c_str(), evicted.size(), m_totalBytes / (1024 * 1024));
+    return evicted;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,96 @@
+#ifndef FILMTRACKER_DISK_CACHE_INDEX_H
+#define FILMTRACKER_DISK_CACHE_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace filmtracker {
+
+/**
+ * 磁盘缓存目录的索引（DecodedImageCache、ResultSpillCache 共用）
+ *
+ * - 打开：创建目录，删除崩溃残留的临时文件（".tmp."），按扩展名索引已有的缓存文件
+ * - 记录每个文件的大小和最近访问时间（启动时取文件 mtime），按总字节数 LRU 淘汰
+ *
+ * 不加锁：由所属缓存在自己的锁内调用。需要删除的文件以路径返回，调用方在锁外 unlink。
+ */
+class DiskCacheIndex {
+public:
+    /**
+     * 索引条目
+     */
+    struct Entry {
+        uint64_t fileBytes;
+        int64_t lastAccessNs;
+    };
+
+    explicit DiskCacheIndex(size_t maxBytes = 0) : m_maxBytes(maxBytes) {}
+
+    /**
+     * 创建并扫描目录（只做目录 I/O，可以在调用方的锁外执行，完成后再交换进缓存）
+     *
+     * @param directory 缓存目录（不存在时创建）
+     * @param extension 缓存文件扩展名（例如 ".flc"）
+     * @param index 输出索引（容量上限保持不变）
+     * @return 是否成功
+     */
+    static bool open(const std::string& directory, const char* extension, DiskCacheIndex& index);
+
+    /**
+     * 当前时间（纳秒，与文件 mtime 同一时钟）
+     */
+    static int64_t nowNs();
+
+    bool isOpen() const { return !m_directory.empty(); }
+    const std::string& directory() const { return m_directory; }
+    std::string pathOf(const std::string& name) const { return m_directory + "/" + name; }
+
+    size_t size() const { return m_entries.size(); }
+    size_t totalBytes() const { return m_totalBytes; }
+    size_t maxBytes() const { return m_maxBytes; }
+    void setMaxBytes(size_t maxBytes) { m_maxBytes = maxBytes; }
+
+    bool contains(const std::string& name) const { return m_entries.find(name) != m_entries.end(); }
+
+    /**
+     * 更新最近访问时间（条目不存在时忽略）
+     */
+    void touch(const std::string& name);
+
+    /**
+     * 添加或替换条目
+     */
+    void put(const std::string& name, uint64_t fileBytes);
+
+    /**
+     * 删除条目（文件由调用方删除）
+     */
+    void erase(const std::string& name);
+
+    /**
+     * 清空索引
+     *
+     * @return 全部文件路径
+     */
+    std::vector<std::string> clear();
+
+    /**
+     * 淘汰最久未访问的条目直到满足容量限制
+     *
+     * @return 需要删除的文件路径
+     */
+    std::vector<std::string> collectEvictions();
+
+private:
+    std::string m_directory;
+    std::unordered_map<std::string, Entry> m_entries;    // 文件名 -> 条目
+    size_t m_totalBytes = 0;
+    size_t m_maxBytes = 0;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_DISK_CACHE_INDEX_H
@@ -0,0 +1,124 @@
+#ifndef FILMTRACKER_HALF_FLOAT_H
+#define FILMTRACKER_HALF_FLOAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace filmtracker {
+
+/**
+ * IEEE 754 半精度浮点（fp16）转换
+ *
+ * 用于磁盘缓存等需要减半存储的场景：线性光域 [0, 1] 内相对误差约 0.05%，
+ * 远低于 8/10 位输出的量化误差。
+ * 标量版本为就近舍入（round-to-nearest-even），AArch64 下批量转换使用 NEON fcvt。
+ */
+
+/**
+ * float -> fp16（就近舍入，溢出为 Inf，NaN 保持 NaN）
+ */
+inline uint16_t floatToHalf(float value) {
+    const uint32_t f32Infinity = 255u << 23;
+    const uint32_t f16Max = (127u + 16u) << 23;
+    const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t result;
+    if (bits >= f16Max) {
+        // 溢出或 Inf/NaN
+        result = (bits > f32Infinity) ? 0x7E00 : 0x7C00;
+    } else if (bits < (113u << 23)) {
+        // 结果为非规格化数或 0：借助浮点加法完成舍入
+        float f;
+        float magic;
+        std::memcpy(&f, &bits, sizeof(f));
+        std::memcpy(&magic, &denormMagic, sizeof(magic));
+        f += magic;
+        uint32_t rounded;
+        std::memcpy(&rounded, &f, sizeof(rounded));
+        result = static_cast<uint16_t>(rounded - denormMagic);
+    } else {
+        // 规格化数：调整指数偏移并就近舍入
+        const uint32_t mantissaOdd = (bits >> 13) & 1u;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu;
+        bits += mantissaOdd;
+        result = static_cast<uint16_t>(bits >> 13);
+    }
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+/**
+ * fp16 -> float（精确）
+ */
+inline float halfToFloat(uint16_t half) {
+    const uint32_t magic = 113u << 23;
+    const uint32_t shiftedExponent = 0x7C00u << 13;
+
+    uint32_t bits = (half & 0x7FFFu) << 13;
+    const uint32_t exponent = shiftedExponent & bits;
+    bits += (127u - 15u) << 23;
+
+    if (exponent == shiftedExponent) {
+        // Inf/NaN
+        bits += (128u - 16u) << 23;
+    } else if (exponent == 0) {
+        // 非规格化数
+        bits += 1u << 23;
+        float f;
+        float m;
+        std::memcpy(&f, &bits, sizeof(f));
+        std::memcpy(&m, &magic, sizeof(m));
+        f -= m;
+        std::memcpy(&bits, &f, sizeof(bits));
+    }
+
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/**
+ * 批量 float -> fp16
+ */
+inline void floatToHalfRow(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        float16x4_t h = vcvt_f16_f32(vld1q_f32(src + i));
+        vst1_u16(dst + i, vreinterpret_u16_f16(h));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = floatToHalf(src[i]);
+    }
+}
+
+/**
+ * 批量 fp16 -> float
+ */
+inline void halfToFloatRow(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        float16x4_t h = vreinterpret_f16_u16(vld1_u16(src + i));
+        vst1q_f32(dst + i, vcvt_f32_f16(h));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = halfToFloat(src[i]);
+    }
+}
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_HALF_FLOAT_H
@@ -0,0 +1,314 @@
+#include "half_image_file.h"
+#include "half_float.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <android/log.h>
+
+#define LOG_TAG "HalfImageFile"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+const size_t kPageSize = 4096;
+const size_t kUserDataOffset = 64;
+const size_t kWriteChunkPixels = 64 * 1024;
+
+/**
+ * 文件头（位于文件起始处，其后 kUserDataOffset 处为自定义数据）
+ */
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint64_t planeStride;     // 每个平面占用的字节数（页对齐）
+    uint32_t userDataSize;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) <= kUserDataOffset, "FileHeader too large");
+
+size_t alignToPage(size_t size) {
+    return (size + kPageSize - 1) & ~(kPageSize - 1);
+}
+
+bool writeAll(int fd, const void* data, size_t size, off_t offset) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, p, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+/**
+ * 读取指定区域：读到文件末尾（文件被截断）为 INVALID，读取出错为 UNAVAILABLE
+ */
+HalfImageFile::ReadStatus readAll(int fd, void* data, size_t size, off_t offset) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t got = pread(fd, p, size, offset);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return HalfImageFile::ReadStatus::UNAVAILABLE;
+        }
+        if (got == 0) {
+            return HalfImageFile::ReadStatus::INVALID;
+        }
+        p += got;
+        size -= static_cast<size_t>(got);
+        offset += got;
+    }
+    return HalfImageFile::ReadStatus::OK;
+}
+
+/**
+ * 读取并校验文件头
+ */
+HalfImageFile::ReadStatus readHeader(int fd, FileHeader& header, uint8_t* block, size_t userDataSize) {
+    const HalfImageFile::ReadStatus status = readAll(fd, block, HalfImageFile::kHeaderSize, 0);
+    if (status != HalfImageFile::ReadStatus::OK) {
+        return status;
+    }
+    std::memcpy(&header, block, sizeof(header));
+    const bool valid = header.magic == HalfImageFile::kMagic &&
+                       header.version == HalfImageFile::kVersion &&
+                       header.userDataSize == userDataSize &&
+                       header.userDataSize <= HalfImageFile::kMaxUserDataSize &&
+                       header.planeStride == alignToPage(static_cast<size_t>(header.width) * header.height * sizeof(uint16_t));
+    return valid ? HalfImageFile::ReadStatus::OK : HalfImageFile::ReadStatus::INVALID;
+}
+
+/**
+ * 打开文件失败的原因：文件不存在时条目无效，其余（EMFILE、EACCES 等）视为暂时无法读取
+ */
+HalfImageFile::ReadStatus openFailureStatus(int error) {
+    return (error == ENOENT || error == ENOTDIR) ? HalfImageFile::ReadStatus::INVALID
+                                                 : HalfImageFile::ReadStatus::UNAVAILABLE;
+}
+
+/**
+ * fsync 文件所在目录，保证 rename 持久化
+ */
+void syncParentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash);
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+} // namespace
+
+size_t HalfImageFile::fileSize(uint32_t width, uint32_t height) {
+    return kHeaderSize + 3 * alignToPage(static_cast<size_t>(width) * height * sizeof(uint16_t));
+}
+
+size_t HalfImageFile::write(const std::string& path,
+                            const LinearImage& image,
+                            const void* userData,
+                            size_t userDataSize) {
+    if (userDataSize > kMaxUserDataSize || (userDataSize > 0 && !userData)) {
+        LOGE("write: Invalid user data size %zu", userDataSize);
+        return 0;
+    }
+
+    // 临时文件名在进程内唯一
+    static std::atomic<uint32_t> s_tmpCounter(0);
+    const std::string tmpPath = path + ".tmp." + std::to_string(getpid()) + "." +
+                                std::to_string(s_tmpCounter.fetch_add(1));
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("write: Failed to create %s: %s", tmpPath.c_str(), std::strerror(errno));
+        return 0;
+    }
+
+    const size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    const size_t planeStride = alignToPage(pixelCount * sizeof(uint16_t));
+    const size_t totalSize = fileSize(image.width, image.height);
+
+    // 文件头 + 自定义数据
+    std::vector<uint8_t> block(kHeaderSize, 0);
+    FileHeader header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.width = image.width;
+    header.height = image.height;
+    header.planeStride = planeStride;
+    header.userDataSize = static_cast<uint32_t>(userDataSize);
+    header.reserved = 0;
+    std::memcpy(block.data(), &header, sizeof(header));
+    if (userDataSize > 0) {
+        std::memcpy(block.data() + kUserDataOffset, userData, userDataSize);
+    }
+
+    bool success = writeAll(fd, block.data(), block.size(), 0);
+
+    // 三个平面分块转换为 fp16 后写入
+    std::vector<uint16_t> chunk(kWriteChunkPixels);
+    const std::vector<float>* planes[3] = {&image.r, &image.g, &image.b};
+    for (int p = 0; p < 3 && success; ++p) {
+        const off_t planeOffset = static_cast<off_t>(kHeaderSize + p * planeStride);
+        for (size_t start = 0; start < pixelCount && success; start += kWriteChunkPixels) {
+            const size_t count = std::min(kWriteChunkPixels, pixelCount - start);
+            floatToHalfRow(planes[p]->data() + start, chunk.data(), count);
+            success = writeAll(fd, chunk.data(), count * sizeof(uint16_t),
+                               planeOffset + static_cast<off_t>(start * sizeof(uint16_t)));
+        }
+    }
+
+    // 平面之间的对齐填充
+    success = success && ftruncate(fd, static_cast<off_t>(totalSize)) == 0;
+    success = success && fsync(fd) == 0;
+    ::close(fd);
+
+    if (!success) {
+        LOGE("write: Failed to write %s: %s", tmpPath.c_str(), std::strerror(errno));
+        unlink(tmpPath.c_str());
+        return 0;
+    }
+
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOGE("write: Failed to rename to %s: %s", path.c_str(), std::strerror(errno));
+        unlink(tmpPath.c_str());
+        return 0;
+    }
+    syncParentDirectory(path);
+
+    LOGI("write: %s (%ux%u, %zu bytes)", path.c_str(), image.width, image.height, totalSize);
+    return totalSize;
+}
+
+HalfImageFile::ReadStatus HalfImageFile::readUserData(const std::string& path, void* userData, size_t userDataSize) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return openFailureStatus(errno);
+    }
+
+    uint8_t block[kHeaderSize];
+    FileHeader header;
+    const ReadStatus status = readHeader(fd, header, block, userDataSize);
+    ::close(fd);
+
+    if (status == ReadStatus::OK && userDataSize > 0) {
+        std::memcpy(userData, block + kUserDataOffset, userDataSize);
+    }
+    return status;
+}
+
+HalfImageFile::ReadStatus HalfImageFile::read(const std::string& path,
+                                              LinearImage& image,
+                                              void* userData,
+                                              size_t userDataSize,
+                                              size_t* bytesRead) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        const int error = errno;
+        LOGW("read: Failed to open %s: %s", path.c_str(), std::strerror(error));
+        return openFailureStatus(error);
+    }
+
+    uint8_t block[kHeaderSize];
+    FileHeader header;
+    struct stat st;
+    ReadStatus status = readHeader(fd, header, block, userDataSize);
+    if (status == ReadStatus::OK && fstat(fd, &st) != 0) {
+        status = ReadStatus::UNAVAILABLE;
+    }
+    if (status == ReadStatus::OK &&
+        static_cast<size_t>(st.st_size) != fileSize(header.width, header.height)) {
+        status = ReadStatus::INVALID;
+    }
+    if (status != ReadStatus::OK) {
+        LOGW("read: %s %s", status == ReadStatus::INVALID ? "Invalid or truncated file" : "Failed to read",
+             path.c_str());
+        ::close(fd);
+        return status;
+    }
+
+    // 先分配输出再映射：内存不足只算一次未命中，不影响文件
+    if (image.width != header.width || image.height != header.height) {
+        try {
+            image = LinearImage(header.width, header.height);
+        } catch (const std::bad_alloc&) {
+            LOGE("read: Out of memory for %ux%u from %s", header.width, header.height, path.c_str());
+            ::close(fd);
+            return ReadStatus::UNAVAILABLE;
+        }
+    }
+
+    const size_t totalSize = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, totalSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOGE("read: mmap failed for %s: %s", path.c_str(), std::strerror(errno));
+        return ReadStatus::UNAVAILABLE;
+    }
+    madvise(mapped, totalSize, MADV_SEQUENTIAL);
+
+    // 直接从映射区域把 fp16 平面转换为 float（按行分配给多个线程）
+    const uint8_t* base = static_cast<const uint8_t*>(mapped);
+    const uint16_t* planes[3] = {
+        reinterpret_cast<const uint16_t*>(base + kHeaderSize),
+        reinterpret_cast<const uint16_t*>(base + kHeaderSize + header.planeStride),
+        reinterpret_cast<const uint16_t*>(base + kHeaderSize + 2 * header.planeStride)
+    };
+    float* outputs[3] = {image.r.data(), image.g.data(), image.b.data()};
+
+    const uint32_t width = header.width;
+    const uint32_t height = header.height;
+    const uint32_t numThreads = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    const uint32_t rowsPerThread = height / numThreads;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t) {
+        uint32_t startRow = t * rowsPerThread;
+        uint32_t endRow = (t == numThreads - 1) ? height : (t + 1) * rowsPerThread;
+
+        threads.emplace_back([&planes, &outputs, width, startRow, endRow]() {
+            const size_t start = static_cast<size_t>(startRow) * width;
+            const size_t count = static_cast<size_t>(endRow - startRow) * width;
+            for (int p = 0; p < 3; ++p) {
+                halfToFloatRow(planes[p] + start, outputs[p] + start, count);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    munmap(mapped, totalSize);
+
+    if (userData && userDataSize > 0) {
+        std::memcpy(userData, block + kUserDataOffset, userDataSize);
+    }
+    if (bytesRead) {
+        *bytesRead = totalSize;
+    }
+    return ReadStatus::OK;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,81 @@
+#ifndef FILMTRACKER_HALF_IMAGE_FILE_H
+#define FILMTRACKER_HALF_IMAGE_FILE_H
+
+#include "raw_types.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace filmtracker {
+
+/**
+ * fp16 平面图像文件
+ *
+ * 文件布局：
+ *   [0, 4096)            文件头 + 调用方自定义数据（userData）
+ *   [4096, ...)          R、G、B 三个 fp16 平面，每个平面按页对齐
+ *
+ * 写入先写到同目录下的临时文件，fsync 后 rename 到目标路径，
+ * 崩溃时只会留下临时文件，不会出现半写的目标文件。
+ * 读取通过 mmap 映射文件，直接从映射区域把 fp16 平面转换为 float。
+ */
+class HalfImageFile {
+public:
+    static constexpr uint32_t kMagic = 0x46314846;      // "FH1F"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 4096;
+    static constexpr size_t kMaxUserDataSize = 3072;
+
+    /**
+     * 读取结果
+     */
+    enum class ReadStatus {
+        OK,
+        INVALID,        // 文件不存在、文件头不符或长度不符，文件本身不可用
+        UNAVAILABLE     // 暂时无法读取（打开 / 映射失败、内存不足），文件可能仍然有效
+    };
+
+    /**
+     * 写入图像（临时文件 + fsync + rename）
+     *
+     * @param path 目标路径
+     * @param image 图像
+     * @param userData 自定义数据（例如缓存键和元数据），写入文件头之后
+     * @param userDataSize 自定义数据大小（不超过 kMaxUserDataSize）
+     * @return 写入的字节数，失败返回 0
+     */
+    static size_t write(const std::string& path,
+                        const LinearImage& image,
+                        const void* userData,
+                        size_t userDataSize);
+
+    /**
+     * 读取自定义数据（只读文件头，不映射图像平面）
+     */
+    static ReadStatus readUserData(const std::string& path, void* userData, size_t userDataSize);
+
+    /**
+     * 读取图像
+     *
+     * @param path 文件路径
+     * @param image 输出图像（尺寸不符时重新分配）
+     * @param userData 输出自定义数据（可为 nullptr）
+     * @param userDataSize 期望的自定义数据大小，与文件不符时视为无效文件
+     * @param bytesRead 输出读取的字节数（可为 nullptr）
+     * @return 读取结果；只有 INVALID 表示文件应当删除
+     */
+    static ReadStatus read(const std::string& path,
+                           LinearImage& image,
+                           void* userData,
+                           size_t userDataSize,
+                           size_t* bytesRead = nullptr);
+
+    /**
+     * 文件总大小（字节）
+     */
+    static size_t fileSize(uint32_t width, uint32_t height);
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_HALF_IMAGE_FILE_H
@@ -1,18 +1,354 @@
 #include "image_converter.h"
 #include "error_diffusion_dithering.h"
 #include "dynamic_range_protection.h"
+#include "half_float.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <android/log.h>
 
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
 #define LOG_TAG "ImageConverter"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 namespace filmtracker {
 
+namespace {
+
+/**
+ * 按行分块并行执行 fn(startRow, endRow)，调用线程处理第一块
+ *
+ * @param maxThreads 线程数上限，0 = 自动（最多 4 个，不超过 CPU 核数）
+ */
+template <typename Fn>
+void parallelRows(uint32_t height, Fn fn, uint32_t maxThreads = 0) {
+    const uint32_t threadLimit = maxThreads > 0 ? maxThreads
+                                                : std::min(4u, std::thread::hardware_concurrency());
+    const uint32_t numThreads = std::max(1u, std::min(threadLimit, height));
+    const uint32_t rowsPerThread = (height + numThreads - 1) / numThreads;
+    
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < numThreads; ++t) {
+        uint32_t startRow = t * rowsPerThread;
+        uint32_t endRow = std::min(height, startRow + rowsPerThread);
+        if (startRow < endRow) {
+            threads.emplace_back(fn, startRow, endRow);
+        }
+    }
+    fn(0u, std::min(height, rowsPerThread));
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// 输出传递函数查找表的分段数：线性插值误差小于 16 位输出的 0.1 LSB
+const uint32_t kLutSegments = 16384;
+
+// 软裁剪查找表的输入上限：超过 2.0 时 tanh 尾部已饱和（差异 < 1e-7）
+const float kSoftClipDomain = 2.0f;
+
+// 每次编码的像素数（栈上缓冲区）
+const uint32_t kEncodeChunk = 64;
+
+/**
+ * 输出传递函数查找表：在 [0, domain] 上均匀采样，线性插值；
+ * 小于 0（以及 NaN）取 0，大于 domain 取端点值
+ */
+struct TransferLut {
+    float domain;
+    float scale;
+    std::vector<float> table;
+
+    template <typename Fn>
+    TransferLut(float inputDomain, Fn fn)
+        : domain(inputDomain), scale(kLutSegments / inputDomain), table(kLutSegments + 2) {
+        for (uint32_t i = 0; i < table.size(); ++i) {
+            table[i] = fn(std::min(domain, static_cast<float>(i) / scale));
+        }
+    }
+};
+
+/**
+ * sRGB 编码（可选先软裁剪），输出 [0, 1]
+ */
+const TransferLut& gammaLut(bool softClip) {
+    static const TransferLut gamma(1.0f, [](float x) {
+        return ImageConverter::linearToSRGB(x);
+    });
+    static const TransferLut softClipGamma(kSoftClipDomain, [](float x) {
+        return ImageConverter::linearToSRGB(DynamicRangeProtection::softClip(x));
+    });
+    return softClip ? softClipGamma : gamma;
+}
+
+/**
+ * 仅软裁剪（线性输出）
+ */
+const TransferLut& softClipLut() {
+    static const TransferLut lut(kSoftClipDomain, [](float x) {
+        return DynamicRangeProtection::softClip(x);
+    });
+    return lut;
+}
+
+/**
+ * 对 count 个值查表；lut 为空时只把负值截断为 0
+ */
+void applyTransfer(const TransferLut* lut, const float* in, float* out, uint32_t count) {
+    if (!lut) {
+        for (uint32_t i = 0; i < count; ++i) {
+            out[i] = in[i] > 0.0f ? in[i] : 0.0f;
+        }
+        return;
+    }
+    const float* table = lut->table.data();
+    uint32_t i = 0;
+#ifdef __ARM_NEON
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t domain = vdupq_n_f32(lut->domain);
+    const float32x4_t scale = vdupq_n_f32(lut->scale);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t t = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(in + i), zero), domain), scale);
+        const uint32x4_t index = vcvtq_u32_f32(t);
+        const float32x4_t frac = vsubq_f32(t, vcvtq_f32_u32(index));
+        uint32_t lanes[4];
+        vst1q_u32(lanes, index);
+        const float lo[4] = {table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]};
+        const float hi[4] = {table[lanes[0] + 1], table[lanes[1] + 1], table[lanes[2] + 1], table[lanes[3] + 1]};
+        const float32x4_t low = vld1q_f32(lo);
+        vst1q_f32(out + i, vmlaq_f32(low, vsubq_f32(vld1q_f32(hi), low), frac));
+    }
+#endif
+    for (; i < count; ++i) {
+        const float x = in[i] > 0.0f ? (in[i] < lut->domain ? in[i] : lut->domain) : 0.0f;
+        const float t = x * lut->scale;
+        const uint32_t index = static_cast<uint32_t>(t);
+        const float frac = t - static_cast<float>(index);
+        out[i] = table[index] + (table[index + 1] - table[index]) * frac;
+    }
+}
+
+/**
+ * 编码后的 [0, 1] 值 -> RGBA8（截断，与 linearToSRGB(float) * 255 一致）
+ */
+void packRGBA8(const float* r, const float* g, const float* b, uint32_t count, uint8_t* row, uint32_t x0) {
+    uint8_t* out = row + static_cast<size_t>(x0) * 4;
+    uint32_t i = 0;
+#ifdef __ARM_NEON
+    const float32x4_t k255 = vdupq_n_f32(255.0f);
+    auto narrow = [&k255](const float* v) {
+        const uint16x4_t lo = vmovn_u32(vcvtq_u32_f32(vmulq_f32(vld1q_f32(v), k255)));
+        const uint16x4_t hi = vmovn_u32(vcvtq_u32_f32(vmulq_f32(vld1q_f32(v + 4), k255)));
+        return vmovn_u16(vcombine_u16(lo, hi));
+    };
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t pixels;
+        pixels.val[0] = narrow(r + i);
+        pixels.val[1] = narrow(g + i);
+        pixels.val[2] = narrow(b + i);
+        pixels.val[3] = vdup_n_u8(255);
+        vst4_u8(out + i * 4, pixels);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i * 4 + 0] = static_cast<uint8_t>(r[i] * 255.0f);
+        out[i * 4 + 1] = static_cast<uint8_t>(g[i] * 255.0f);
+        out[i * 4 + 2] = static_cast<uint8_t>(b[i] * 255.0f);
+        out[i * 4 + 3] = 255;
+    }
+}
+
+/**
+ * 编码后的 [0, 1] 值 -> RGBA 16 位（就近舍入，本机字节序）
+ */
+void packRGBA16(const float* r, const float* g, const float* b, uint32_t count, uint8_t* row, uint32_t x0) {
+    uint16_t* out = reinterpret_cast<uint16_t*>(row) + static_cast<size_t>(x0) * 4;
+    uint32_t i = 0;
+#ifdef __ARM_NEON
+    const float32x4_t k65535 = vdupq_n_f32(65535.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (; i + 4 <= count; i += 4) {
+        uint16x4x4_t pixels;
+        pixels.val[0] = vmovn_u32(vcvtq_u32_f32(vmlaq_f32(half, vld1q_f32(r + i), k65535)));
+        pixels.val[1] = vmovn_u32(vcvtq_u32_f32(vmlaq_f32(half, vld1q_f32(g + i), k65535)));
+        pixels.val[2] = vmovn_u32(vcvtq_u32_f32(vmlaq_f32(half, vld1q_f32(b + i), k65535)));
+        pixels.val[3] = vdup_n_u16(65535);
+        vst4_u16(out + i * 4, pixels);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i * 4 + 0] = static_cast<uint16_t>(r[i] * 65535.0f + 0.5f);
+        out[i * 4 + 1] = static_cast<uint16_t>(g[i] * 65535.0f + 0.5f);
+        out[i * 4 + 2] = static_cast<uint16_t>(b[i] * 65535.0f + 0.5f);
+        out[i * 4 + 3] = 65535;
+    }
+}
+
+/**
+ * 编码后的 [0, 1] 值 -> RGBA_1010102（R 在低位，alpha 为 3）
+ */
+void packRGBA1010102(const float* r, const float* g, const float* b, uint32_t count, uint8_t* row, uint32_t x0) {
+    uint32_t* out = reinterpret_cast<uint32_t*>(row) + x0;
+    uint32_t i = 0;
+#ifdef __ARM_NEON
+    const float32x4_t k1023 = vdupq_n_f32(1023.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const uint32x4_t alpha = vdupq_n_u32(3u << 30);
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t rv = vcvtq_u32_f32(vmlaq_f32(half, vld1q_f32(r + i), k1023));
+        const uint32x4_t gv = vcvtq_u32_f32(vmlaq_f32(half, vld1q_f32(g + i), k1023));
+        const uint32x4_t bv = vcvtq_u32_f32(vmlaq_f32(half, vld1q_f32(b + i), k1023));
+        const uint32x4_t packed = vorrq_u32(vorrq_u32(rv, vshlq_n_u32(gv, 10)),
+                                            vorrq_u32(vshlq_n_u32(bv, 20), alpha));
+        vst1q_u32(out + i, packed);
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint32_t rv = static_cast<uint32_t>(r[i] * 1023.0f + 0.5f);
+        const uint32_t gv = static_cast<uint32_t>(g[i] * 1023.0f + 0.5f);
+        const uint32_t bv = static_cast<uint32_t>(b[i] * 1023.0f + 0.5f);
+        out[i] = rv | (gv << 10) | (bv << 20) | (3u << 30);
+    }
+}
+
+/**
+ * 线性值 -> fp16 RGBA（alpha = 1）
+ */
+void packRGBAHalf(const float* r, const float* g, const float* b, uint32_t count, uint8_t* row, uint32_t x0) {
+    float interleaved[kEncodeChunk * 4];
+    for (uint32_t i = 0; i < count; ++i) {
+        interleaved[i * 4 + 0] = r[i];
+        interleaved[i * 4 + 1] = g[i];
+        interleaved[i * 4 + 2] = b[i];
+        interleaved[i * 4 + 3] = 1.0f;
+    }
+    floatToHalfRow(interleaved, reinterpret_cast<uint16_t*>(row) + static_cast<size_t>(x0) * 4,
+                   static_cast<size_t>(count) * 4);
+}
+
+/**
+ * 按行并行编码：每行分段查表（传递函数 + 可选软裁剪）后交给格式打包函数
+ */
+template <typename Pack>
+void encodeRows(const LinearImage& linear, const TransferLut* lut, uint8_t* dst, size_t dstStride, Pack pack) {
+    const uint32_t width = linear.width;
+    if (!dst || width == 0 || linear.height == 0) {
+        return;
+    }
+    
+    parallelRows(linear.height, [&linear, lut, dst, dstStride, width, pack](uint32_t startRow, uint32_t endRow) {
+        float r[kEncodeChunk];
+        float g[kEncodeChunk];
+        float b[kEncodeChunk];
+        for (uint32_t y = startRow; y < endRow; ++y) {
+            const size_t rowOffset = static_cast<size_t>(y) * width;
+            uint8_t* row = dst + static_cast<size_t>(y) * dstStride;
+            for (uint32_t x0 = 0; x0 < width; x0 += kEncodeChunk) {
+                const uint32_t count = std::min(kEncodeChunk, width - x0);
+                applyTransfer(lut, linear.r.data() + rowOffset + x0, r, count);
+                applyTransfer(lut, linear.g.data() + rowOffset + x0, g, count);
+                applyTransfer(lut, linear.b.data() + rowOffset + x0, b, count);
+                pack(r, g, b, count, row, x0);
+            }
+        }
+    });
+}
+
+/**
+ * 对一段已 Gamma 编码的像素做 Floyd-Steinberg 量化并写入 RGBA8
+ *
+ * values 为交错的 [r, g, b, 0]；current / next 指向本段第一个像素的误差（每像素 4 个 float），
+ * 两侧各有一个像素的填充，边界像素无需分支（落在填充上的误差被丢弃）。
+ * 误差分配：
+ *        X   7/16
+ *    3/16 5/16 1/16
+ */
+void ditherPixels(const float* values, uint32_t count, float* current, float* next, uint8_t* out) {
+#ifdef __ARM_NEON
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t k255 = vdupq_n_f32(255.0f);
+    const float32x4_t inv255 = vdupq_n_f32(1.0f / 255.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (uint32_t i = 0; i < count; ++i) {
+        float* cur = current + i * 4;
+        float* nxt = next + i * 4;
+        float32x4_t v = vaddq_f32(vld1q_f32(values + i * 4), vld1q_f32(cur));
+        v = vminq_f32(vmaxq_f32(v, zero), one);
+        const uint32x4_t q = vcvtq_u32_f32(vmlaq_f32(half, v, k255));
+        const float32x4_t error = vmlsq_f32(v, vcvtq_f32_u32(q), inv255);
+        
+        vst1q_f32(cur + 4, vmlaq_n_f32(vld1q_f32(cur + 4), error, 7.0f / 16.0f));
+        vst1q_f32(nxt - 4, vmlaq_n_f32(vld1q_f32(nxt - 4), error, 3.0f / 16.0f));
+        vst1q_f32(nxt, vmlaq_n_f32(vld1q_f32(nxt), error, 5.0f / 16.0f));
+        vst1q_f32(nxt + 4, vmlaq_n_f32(vld1q_f32(nxt + 4), error, 1.0f / 16.0f));
+        
+        const uint16x4_t narrow = vmovn_u32(q);
+        const uint32_t rgba = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(narrow, narrow))), 0);
+        const uint32_t pixel = rgba | 0xFF000000u;   // 小端：第 4 字节为 alpha
+        std::memcpy(out + i * 4, &pixel, 4);
+    }
+#else
+    for (uint32_t i = 0; i < count; ++i) {
+        float* cur = current + i * 4;
+        float* nxt = next + i * 4;
+        for (int c = 0; c < 3; ++c) {
+            float v = values[i * 4 + c] + cur[c];
+            v = v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+            const int q = static_cast<int>(v * 255.0f + 0.5f);
+            const float error = v - q * (1.0f / 255.0f);
+            
+            cur[4 + c] += error * (7.0f / 16.0f);
+            nxt[-4 + c] += error * (3.0f / 16.0f);
+            nxt[c] += error * (5.0f / 16.0f);
+            nxt[4 + c] += error * (1.0f / 16.0f);
+            out[i * 4 + c] = static_cast<uint8_t>(q);
+        }
+        out[i * 4 + 3] = 255;
+    }
+#endif
+}
+
+/**
+ * 旧的多遍抖动输出（仅用于基准对比）：整帧复制 -> 软裁剪 -> 抖动到 RGB -> 重排为 RGBA
+ */
+void multiPassDitheredOutput(const LinearImage& linear, OutputImage& output) {
+    LinearImage processed = linear;
+    parallelRows(processed.height, [&processed](uint32_t startRow, uint32_t endRow) {
+        const size_t begin = static_cast<size_t>(startRow) * processed.width;
+        const size_t end = static_cast<size_t>(endRow) * processed.width;
+        for (size_t i = begin; i < end; ++i) {
+            processed.r[i] = DynamicRangeProtection::softClip(processed.r[i]);
+            processed.g[i] = DynamicRangeProtection::softClip(processed.g[i]);
+            processed.b[i] = DynamicRangeProtection::softClip(processed.b[i]);
+        }
+    });
+    
+    std::vector<uint8_t> rgbBuffer(static_cast<size_t>(processed.width) * processed.height * 3);
+    ErrorDiffusionDithering dithering;
+    dithering.applyFloydSteinberg(processed, rgbBuffer.data(), true);
+    
+    const size_t pixelCount = static_cast<size_t>(processed.width) * processed.height;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        output.data[i * 4 + 0] = rgbBuffer[i * 3 + 0];
+        output.data[i * 4 + 1] = rgbBuffer[i * 3 + 1];
+        output.data[i * 4 + 2] = rgbBuffer[i * 3 + 2];
+        output.data[i * 4 + 3] = 255;
+    }
+}
+
+} // namespace
+
 /**
  * sRGB Gamma 函数
  * 仅在输出阶段应用，核心算法始终在线性域
@@ -43,70 +379,164 @@ OutputImage ImageConverter::linearToSRGB(const LinearImage& linear) {
     OutputImage output(linear.width, linear.height);
     LOGI("linearToSRGB: Output image created, data size=%zu bytes", output.data.size());
     
-    const uint32_t pixelCount = linear.width * linear.height;
-    const uint32_t numThreads = std::min(4u, std::thread::hardware_concurrency());
-    const uint32_t pixelsPerThread = pixelCount / numThreads;
+    linearToSRGB(linear, output.data.data(), static_cast<size_t>(linear.width) * 4);
     
-    LOGI("linearToSRGB: Using %u threads, %u pixels per thread", numThreads, pixelsPerThread);
+    LOGI("linearToSRGB: All threads completed successfully");
+    return output;
+}
+
+/**
+ * 将线性 RGB 转换为 sRGB，写入带行跨度的 RGBA8 缓冲区
+ * 按行分配给多个线程，每行写入连续内存
+ */
+void ImageConverter::linearToSRGB(const LinearImage& linear, uint8_t* dst, size_t dstStride, bool softClip) {
+    encodeRows(linear, &gammaLut(softClip), reinterpret_cast<uint8_t*>(dst), dstStride, packRGBA8);
+}
+
+/**
+ * 将线性 RGB 转换为 16 位 sRGB（就近舍入）
+ */
+void ImageConverter::linearToSRGB16(const LinearImage& linear, uint16_t* dst, size_t dstStride, bool softClip) {
+    encodeRows(linear, &gammaLut(softClip), reinterpret_cast<uint8_t*>(dst), dstStride, packRGBA16);
+}
+
+/**
+ * 将线性 RGB 转换为 10-10-10-2 打包的 sRGB（就近舍入）
+ */
+void ImageConverter::linearToRGBA1010102(const LinearImage& linear, uint32_t* dst, size_t dstStride,
+                                         bool softClip) {
+    encodeRows(linear, &gammaLut(softClip), reinterpret_cast<uint8_t*>(dst), dstStride, packRGBA1010102);
+}
+
+/**
+ * 将线性 RGB 写为 fp16 RGBA
+ * 每次把一小段像素交错到栈上的 float 缓冲区，再批量转换（AArch64 下为 NEON fcvt）
+ */
+void ImageConverter::linearToHalf(const LinearImage& linear, uint16_t* dst, size_t dstStride, bool softClip) {
+    encodeRows(linear, softClip ? &softClipLut() : nullptr, reinterpret_cast<uint8_t*>(dst), dstStride,
+               packRGBAHalf);
+}
+
+size_t ImageConverter::bytesPerPixel(OutputPixelFormat format) {
+    switch (format) {
+        case OutputPixelFormat::RGBA_8888:    return 4;
+        case OutputPixelFormat::RGBA_16:      return 8;
+        case OutputPixelFormat::RGBA_F16:     return 8;
+        case OutputPixelFormat::RGBA_1010102: return 4;
+    }
+    return 0;
+}
+
+bool ImageConverter::writePixels(const LinearImage& linear, OutputPixelFormat format,
+                                 void* dst, size_t dstStride, bool softClip) {
+    const size_t bpp = bytesPerPixel(format);
+    const size_t alignment = format == OutputPixelFormat::RGBA_8888 ? 1 : (bpp > 4 ? 2 : 4);
+    if (!dst || bpp == 0 || linear.width == 0 || linear.height == 0 ||
+        dstStride < static_cast<size_t>(linear.width) * bpp || dstStride % alignment != 0) {
+        LOGE("writePixels: Invalid arguments (format=%d, %ux%u, stride=%zu)",
+             static_cast<int>(format), linear.width, linear.height, dstStride);
+        return false;
+    }
     
-    std::vector<std::thread> threads;
-    for (uint32_t t = 0; t < numThreads; ++t) {
-        uint32_t start = t * pixelsPerThread;
-        uint32_t end = (t == numThreads - 1) ? pixelCount : (t + 1) * pixelsPerThread;
-        
-        threads.emplace_back([&linear, &output, start, end, t]() {
-            LOGI("linearToSRGB: Thread %u processing pixels %u to %u", t, start, end);
-            for (uint32_t i = start; i < end; ++i) {
-        uint32_t idx = i * 4;
-        output.data[idx + 0] = static_cast<uint8_t>(linearToSRGB(linear.r[i]) * 255.0f);
-        output.data[idx + 1] = static_cast<uint8_t>(linearToSRGB(linear.g[i]) * 255.0f);
-        output.data[idx + 2] = static_cast<uint8_t>(linearToSRGB(linear.b[i]) * 255.0f);
-        output.data[idx + 3] = 255; // Alpha
-            }
-            LOGI("linearToSRGB: Thread %u completed", t);
-        });
+    switch (format) {
+        case OutputPixelFormat::RGBA_8888:
+            linearToSRGB(linear, static_cast<uint8_t*>(dst), dstStride, softClip);
+            break;
+        case OutputPixelFormat::RGBA_16:
+            linearToSRGB16(linear, static_cast<uint16_t*>(dst), dstStride, softClip);
+            break;
+        case OutputPixelFormat::RGBA_F16:
+            linearToHalf(linear, static_cast<uint16_t*>(dst), dstStride, softClip);
+            break;
+        case OutputPixelFormat::RGBA_1010102:
+            linearToRGBA1010102(linear, static_cast<uint32_t*>(dst), dstStride, softClip);
+            break;
+    }
+    return true;
+}
+
+/**
+ * 融合抖动输出
+ * 行按序号轮流分给各线程，按波前推进：第 y 行处理某段像素前，等待第 y - 1 行
+ * 已处理到该段之后两个像素（误差写入的最右位置），因此误差逐行完整传递，
+ * 结果与单线程逐行扫描一致，没有分块边界。
+ * 误差行是 线程数 + 1 行的环形缓冲区（带填充），每段像素查表（软裁剪 + Gamma）后
+ * 立即量化、扩散误差并写出
+ */
+void ImageConverter::linearToSRGBDithered(const LinearImage& linear, uint8_t* dst, size_t dstStride,
+                                          bool softClip, uint32_t maxThreads) {
+    const uint32_t width = linear.width;
+    const uint32_t height = linear.height;
+    if (!dst || width == 0 || height == 0) {
+        return;
     }
     
-    LOGI("linearToSRGB: Waiting for threads to complete");
-    for (auto& thread : threads) {
-        thread.join();
+    const TransferLut* lut = &gammaLut(softClip);
+    const uint32_t threadLimit = maxThreads > 0 ? maxThreads
+                                                : std::min(4u, std::thread::hardware_concurrency());
+    const uint32_t numThreads = std::max(1u, std::min(threadLimit, height));
+    const uint32_t ringRows = numThreads + 1;
+    const size_t errorFloats = (static_cast<size_t>(width) + 2) * 4;
+    std::vector<float> errors(errorFloats * ringRows, 0.0f);
+    // 每行已处理的像素数
+    std::unique_ptr<std::atomic<uint32_t>[]> progress(new std::atomic<uint32_t>[height]);
+    for (uint32_t y = 0; y < height; ++y) {
+        progress[y].store(0, std::memory_order_relaxed);
     }
     
-    LOGI("linearToSRGB: All threads completed successfully");
-    return output;
+    parallelRows(numThreads, [&linear, lut, dst, dstStride, width, height, numThreads, ringRows,
+                              errorFloats, &errors, &progress](uint32_t startLane, uint32_t endLane) {
+        float r[kEncodeChunk];
+        float g[kEncodeChunk];
+        float b[kEncodeChunk];
+        float values[kEncodeChunk * 4];
+        
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint32_t lane = y % numThreads;
+            if (lane < startLane || lane >= endLane) {
+                continue;
+            }
+            float* current = errors.data() + (y % ringRows) * errorFloats;
+            float* next = errors.data() + ((y + 1) % ringRows) * errorFloats;
+            // next 上次是第 y - numThreads 行的误差行，那一行由本线程处理，已经完成
+            std::fill(next, next + errorFloats, 0.0f);
+            const size_t rowOffset = static_cast<size_t>(y) * width;
+            uint8_t* row = dst + static_cast<size_t>(y) * dstStride;
+            
+            for (uint32_t x0 = 0; x0 < width; x0 += kEncodeChunk) {
+                const uint32_t count = std::min(kEncodeChunk, width - x0);
+                if (y > 0) {
+                    const uint32_t needed = std::min(width, x0 + count + 2);
+                    while (progress[y - 1].load(std::memory_order_acquire) < needed) {
+                        std::this_thread::yield();
+                    }
+                }
+                applyTransfer(lut, linear.r.data() + rowOffset + x0, r, count);
+                applyTransfer(lut, linear.g.data() + rowOffset + x0, g, count);
+                applyTransfer(lut, linear.b.data() + rowOffset + x0, b, count);
+                for (uint32_t i = 0; i < count; ++i) {
+                    values[i * 4 + 0] = r[i];
+                    values[i * 4 + 1] = g[i];
+                    values[i * 4 + 2] = b[i];
+                    values[i * 4 + 3] = 0.0f;
+                }
+                const size_t errorOffset = (static_cast<size_t>(x0) + 1) * 4;
+                ditherPixels(values, count, current + errorOffset, next + errorOffset,
+                             row + static_cast<size_t>(x0) * 4);
+                progress[y].store(x0 + count, std::memory_order_release);
+            }
+        }
+    }, numThreads);
 }
 
 /**
- * 将线性 RGB 转换为 sRGB 输出图像，使用误差扩散抖动
- * 
- * 这个版本使用 Floyd-Steinberg 误差扩散算法来减少色彩断层。
- * 推荐用于最终输出，特别是在渐变区域较多的图像。
+ * 将线性 RGB 转换为 sRGB 输出图像，使用误差扩散抖动（不做软裁剪）
  */
 OutputImage ImageConverter::linearToSRGBWithDithering(const LinearImage& linear) {
     LOGI("linearToSRGBWithDithering: Starting, image size=%dx%d", linear.width, linear.height);
     
     OutputImage output(linear.width, linear.height);
-    
-    // 创建误差扩散抖动器
-    ErrorDiffusionDithering dithering;
-    
-    // 创建临时缓冲区用于 RGB 数据（不包含 alpha）
-    std::vector<uint8_t> rgbBuffer(linear.width * linear.height * 3);
-    
-    // 应用 Floyd-Steinberg 抖动（包含 gamma 编码）
-    dithering.applyFloydSteinberg(linear, rgbBuffer.data(), true);
-    
-    // 将 RGB 数据复制到 RGBA 输出
-    const uint32_t pixelCount = linear.width * linear.height;
-    for (uint32_t i = 0; i < pixelCount; ++i) {
-        uint32_t rgbIdx = i * 3;
-        uint32_t rgbaIdx = i * 4;
-        
-        output.data[rgbaIdx + 0] = rgbBuffer[rgbIdx + 0];  // R
-        output.data[rgbaIdx + 1] = rgbBuffer[rgbIdx + 1];  // G
-        output.data[rgbaIdx + 2] = rgbBuffer[rgbIdx + 2];  // B
-        output.data[rgbaIdx + 3] = 255;                     // A
-    }
+    linearToSRGBDithered(linear, output.data.data(), static_cast<size_t>(linear.width) * 4, false);
     
     LOGI("linearToSRGBWithDithering: Completed successfully");
     return output;
@@ -115,14 +545,7 @@ OutputImage ImageConverter::linearToSRGBWithDithering(const LinearImage& linear)
 /**
  * 将线性 RGB 转换为 sRGB 输出图像，使用软裁剪和抖动
  * 
- * 这是推荐的最终输出方法，包含：
- * 1. 软裁剪：保护高光和阴影细节
- * 2. Gamma 编码：转换到 sRGB 空间
- * 3. 误差扩散抖动：消除色彩断层
- * 
- * @param linear 线性空间的图像数据
- * @param applySoftClip 是否应用软裁剪（默认 true）
- * @return sRGB 空间的 8-bit 输出图像
+ * 软裁剪、Gamma 编码和误差扩散抖动在融合输出阶段中一遍完成
  */
 OutputImage ImageConverter::linearToSRGBWithSoftClipAndDithering(
     const LinearImage& linear, 
@@ -131,64 +554,69 @@ OutputImage ImageConverter::linearToSRGBWithSoftClipAndDithering(
     LOGI("linearToSRGBWithSoftClipAndDithering: Starting, image size=%dx%d, softClip=%d", 
          linear.width, linear.height, applySoftClip);
     
-    // 创建临时图像用于软裁剪
-    LinearImage processed = linear;
+    OutputImage output(linear.width, linear.height);
+    linearToSRGBDithered(linear, output.data.data(), static_cast<size_t>(linear.width) * 4, applySoftClip);
     
-    // 应用软裁剪（如果启用）
-    if (applySoftClip) {
-        const uint32_t pixelCount = linear.width * linear.height;
-        const uint32_t numThreads = std::min(4u, std::thread::hardware_concurrency());
-        const uint32_t pixelsPerThread = pixelCount / numThreads;
-        
-        std::vector<std::thread> threads;
-        for (uint32_t t = 0; t < numThreads; ++t) {
-            uint32_t start = t * pixelsPerThread;
-            uint32_t end = (t == numThreads - 1) ? pixelCount : (t + 1) * pixelsPerThread;
-            
-            threads.emplace_back([&processed, start, end]() {
-                for (uint32_t i = start; i < end; ++i) {
-                    // 应用软裁剪到每个通道
-                    // 使用默认参数：threshold=0.8, knee=0.15, limit=1.0
-                    processed.r[i] = DynamicRangeProtection::softClip(processed.r[i]);
-                    processed.g[i] = DynamicRangeProtection::softClip(processed.g[i]);
-                    processed.b[i] = DynamicRangeProtection::softClip(processed.b[i]);
-                }
-            });
-        }
-        
-        for (auto& thread : threads) {
-            thread.join();
-        }
-        
-        LOGI("linearToSRGBWithSoftClipAndDithering: Soft clipping completed");
+    LOGI("linearToSRGBWithSoftClipAndDithering: Completed successfully");
+    return output;
+}
+
+DitherBenchmarkResult ImageConverter::benchmarkDitheredOutput(uint32_t width, uint32_t height,
+                                                              uint32_t iterations) {
+    DitherBenchmarkResult result;
+    if (width == 0 || height == 0 || iterations == 0) {
+        return result;
     }
     
-    // 应用 Gamma 编码和抖动
-    OutputImage output(processed.width, processed.height);
-    
-    // 创建误差扩散抖动器
-    ErrorDiffusionDithering dithering;
+    // 合成数据：水平渐变（容易出现断层）+ 超过 1 的高光区域 + 伪随机噪声
+    LinearImage linear(width, height);
+    uint32_t seed = 0x9E3779B9u;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const size_t i = static_cast<size_t>(y) * width + x;
+            const float base = static_cast<float>(x) / width * (y < height / 2 ? 1.0f : 1.8f);
+            const float noise = static_cast<float>(seed >> 24) / 255.0f * 0.01f;
+            linear.r[i] = base + noise;
+            linear.g[i] = base * 0.8f + noise;
+            linear.b[i] = base * 0.6f + noise;
+        }
+    }
     
-    // 创建临时缓冲区用于 RGB 数据
-    std::vector<uint8_t> rgbBuffer(processed.width * processed.height * 3);
+    OutputImage output(width, height);
+    const size_t stride = static_cast<size_t>(width) * 4;
     
-    // 应用 Floyd-Steinberg 抖动（包含 gamma 编码）
-    dithering.applyFloydSteinberg(processed, rgbBuffer.data(), true);
+    linearToSRGBDithered(linear, output.data.data(), stride, true);  // 预热（线程、查找表）
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        linearToSRGBDithered(linear, output.data.data(), stride, true);
+    }
+    result.fusedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / iterations;
     
-    // 将 RGB 数据复制到 RGBA 输出
-    const uint32_t pixelCount = processed.width * processed.height;
-    for (uint32_t i = 0; i < pixelCount; ++i) {
-        uint32_t rgbIdx = i * 3;
-        uint32_t rgbaIdx = i * 4;
-        
-        output.data[rgbaIdx + 0] = rgbBuffer[rgbIdx + 0];  // R
-        output.data[rgbaIdx + 1] = rgbBuffer[rgbIdx + 1];  // G
-        output.data[rgbaIdx + 2] = rgbBuffer[rgbIdx + 2];  // B
-        output.data[rgbaIdx + 3] = 255;                     // A
+    multiPassDitheredOutput(linear, output);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        multiPassDitheredOutput(linear, output);
     }
+    result.multiPassMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / iterations;
     
-    LOGI("linearToSRGBWithSoftClipAndDithering: Completed successfully");
-    return output;
+    // 每像素主存流量（字节，按每遍读写估算，未测量）：
+    //   融合：读 3 个 float 平面 12，写 RGBA 4
+    //   多遍：复制 12 + 12，软裁剪 12 + 12，抖动 12 + 3，重排 3 + 4
+    const double megapixels = static_cast<double>(width) * height / 1e6;
+    const uint32_t threads = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    result.fusedTrafficEstimateMB = megapixels * 16.0;
+    result.multiPassTrafficEstimateMB = megapixels * 70.0;
+    result.fusedScratchMB = (threads + 1) * (static_cast<double>(width) + 2) * 4 * sizeof(float) / 1e6 +
+                            static_cast<double>(height) * sizeof(uint32_t) / 1e6;
+    result.multiPassScratchMB = megapixels * 15.0;
+    
+    LOGI("benchmarkDitheredOutput: %ux%u x%u, fused %.1f ms (est. %.0f MB traffic), multi-pass %.1f ms (est. %.0f MB traffic, %.0f MB scratch)",
+         width, height, iterations, result.fusedMs, result.fusedTrafficEstimateMB,
+         result.multiPassMs, result.multiPassTrafficEstimateMB, result.multiPassScratchMB);
+    return result;
 }
 
 /**
@@ -196,6 +624,7 @@ OutputImage ImageConverter::linearToSRGBWithSoftClipAndDithering(
  */
 void ImageConverter::applyToneMapping(LinearImage& image, float exposure) {
     const uint32_t pixelCount = image.width * image.height;
+    image.provenance = 0;   // 就地修改，来源标识失效
     float exposureMultiplier = std::pow(2.0f, exposure);
     
     for (uint32_t i = 0; i < pixelCount; ++i) {
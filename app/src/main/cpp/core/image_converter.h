@@ -3,14 +3,43 @@
 
 #include "raw_types.h"
 #include "error_diffusion_dithering.h"
+#include <cstddef>
 
 namespace filmtracker {
 
+/**
+ * 输出像素格式（写入调用方缓冲区时使用，均为 RGBA 交错）
+ */
+enum class OutputPixelFormat {
+    RGBA_8888 = 0,  // sRGB 编码，每通道 8 位（Bitmap ARGB_8888）
+    RGBA_16 = 1,    // sRGB 编码，每通道 16 位无符号（16 位 PNG / TIFF 编码器）
+    RGBA_F16 = 2,   // 线性光 fp16（Bitmap RGBA_F16，线性扩展 sRGB，保留大于 1 的高光）
+    RGBA_1010102 = 3    // sRGB 编码，R/G/B 各 10 位 + 2 位 alpha 打包为 uint32，R 在低位（Bitmap RGBA_1010102）
+};
+
+/**
+ * 抖动输出基准测试结果（融合单遍 vs 旧的多遍流程）
+ *
+ * 只有耗时是实测值；流量是按每遍读写的固定字节数（每像素 16 / 70 字节）乘像素数得到的估算，
+ * 不是测量结果，也不含缓存命中的行缓冲区
+ */
+struct DitherBenchmarkResult {
+    double fusedMs = 0.0;                       // 融合输出阶段，每帧平均（实测）
+    double multiPassMs = 0.0;                   // 复制 -> 软裁剪 -> 抖动到 RGB -> 重排为 RGBA（实测）
+    double fusedTrafficEstimateMB = 0.0;        // 每帧主存流量（估算）
+    double multiPassTrafficEstimateMB = 0.0;
+    double fusedScratchMB = 0.0;                // 额外分配（误差行环形缓冲区 + 行进度）
+    double multiPassScratchMB = 0.0;            // 额外分配（整帧副本 + RGB 临时缓冲区）
+};
+
 /**
  * 图像转换器
  * 
- * 将线性域图像转换为输出格式（sRGB，8位）
+ * 将线性域图像转换为输出格式（sRGB 8 / 10 / 16 位，或线性 fp16）
  * 注意：这是唯一允许应用 Gamma 的地方（输出阶段）
+ *
+ * 写入调用方缓冲区的各格式共用一套行内核：传递函数（可选先软裁剪）用查找表插值，
+ * 再按格式向量化打包（NEON），高位深输出不经过 8 位中间结果。
  */
 class ImageConverter {
 public:
@@ -22,6 +51,84 @@ public:
      */
     static OutputImage linearToSRGB(const LinearImage& linear);
     
+    /**
+     * 将线性 RGB 转换为 sRGB，直接写入调用方提供的 RGBA8 缓冲区（例如锁定的 Bitmap 像素）
+     * 
+     * @param linear 线性域图像
+     * @param dst 输出缓冲区，至少 height 行，每行 width * 4 字节
+     * @param dstStride 输出行字节数
+     * @param softClip 编码前应用 DynamicRangeProtection::softClip
+     */
+    static void linearToSRGB(const LinearImage& linear, uint8_t* dst, size_t dstStride,
+                             bool softClip = false);
+    
+    /**
+     * 将线性 RGB 转换为 16 位 sRGB，直接写入调用方缓冲区
+     * 
+     * @param dst 输出缓冲区，每行 width * 4 个 uint16（本机字节序）
+     * @param dstStride 输出行字节数（必须为偶数）
+     */
+    static void linearToSRGB16(const LinearImage& linear, uint16_t* dst, size_t dstStride,
+                               bool softClip = false);
+    
+    /**
+     * 将线性 RGB 转换为 10-10-10-2 打包的 sRGB，直接写入调用方缓冲区
+     * 
+     * @param dst 输出缓冲区，每行 width 个 uint32
+     * @param dstStride 输出行字节数（必须为 4 的倍数）
+     */
+    static void linearToRGBA1010102(const LinearImage& linear, uint32_t* dst, size_t dstStride,
+                                    bool softClip = false);
+    
+    /**
+     * 将线性 RGB 写为 fp16 RGBA（不做 Gamma，负值截断为 0，alpha = 1）
+     * 
+     * @param dst 输出缓冲区，每行 width * 4 个 fp16
+     * @param dstStride 输出行字节数（必须为偶数）
+     * @param softClip 软裁剪高光（HDR 输出通常保持 false，保留大于 1 的值）
+     */
+    static void linearToHalf(const LinearImage& linear, uint16_t* dst, size_t dstStride,
+                             bool softClip = false);
+    
+    /**
+     * 按格式写入调用方缓冲区（锁定的 Bitmap 像素、编码器映射缓冲区等），无中间分配
+     * 
+     * @param dstStride 输出行字节数，不小于 width * bytesPerPixel(format)，并按样本大小对齐
+     * @param softClip 编码前应用软裁剪
+     * @return 参数无效时返回 false
+     */
+    static bool writePixels(const LinearImage& linear, OutputPixelFormat format,
+                            void* dst, size_t dstStride, bool softClip = false);
+    
+    /**
+     * 每像素字节数
+     */
+    static size_t bytesPerPixel(OutputPixelFormat format);
+    
+    /**
+     * 融合输出阶段：软裁剪 + Gamma + Floyd-Steinberg 抖动 + RGBA 写入，一遍完成
+     * 
+     * 每行读一次线性平面，直接写入调用方缓冲区，不分配整帧临时图像。
+     * 误差跨行连续传递（与串行扫描相同）：各线程按行轮流处理，以波前方式推进，
+     * 每行只等待上一行处理到当前位置右侧两个像素；误差行保存在 numThreads + 1 行的环形缓冲中。
+     * 输出与串行扫描逐位一致，与线程数无关。
+     * 
+     * @param dst 输出缓冲区，每行 width * 4 字节
+     * @param dstStride 输出行字节数
+     * @param softClip 编码前应用 DynamicRangeProtection::softClip
+     * @param maxThreads 最大线程数，0 = 自动（最多 4 个）
+     */
+    static void linearToSRGBDithered(const LinearImage& linear, uint8_t* dst, size_t dstStride,
+                                     bool softClip = true, uint32_t maxThreads = 0);
+    
+    /**
+     * 抖动输出基准测试（合成渐变 + 高光数据）
+     * 
+     * @param iterations 迭代次数（不含一次预热）
+     */
+    static DitherBenchmarkResult benchmarkDitheredOutput(uint32_t width, uint32_t height,
+                                                         uint32_t iterations);
+    
     /**
      * 将线性 RGB 转换为 sRGB（8位 RGBA），使用误差扩散抖动
      * 
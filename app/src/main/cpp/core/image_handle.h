@@ -0,0 +1,70 @@
+#ifndef FILMTRACKER_IMAGE_HANDLE_H
+#define FILMTRACKER_IMAGE_HANDLE_H
+
+#include "raw_types.h"
+#include "shared_image.h"
+#include <utility>
+
+namespace filmtracker {
+
+/**
+ * 交给 Kotlin 持有的图像句柄（引用计数 + 写时复制）
+ *
+ * 句柄只是一个 SharedImage：clone() 是 O(1)，撤销历史、阶段缓存等多个句柄共用同一份像素。
+ * 写入前调用 write()：缓冲区仍被其他句柄（或磁盘缓存写入队列等其他持有者）引用时先复制一份私有副本，
+ * 已是唯一持有者时直接修改。
+ *
+ * 写时复制按整幅图像进行：各调整阶段都读写全部三个平面，按平面或分块跟踪不会省下复制。
+ * 缓冲区登记在 IMAGES 分类下（缓冲区释放时注销），共享同一缓冲区的句柄不重复计算。
+ *
+ * 同一个句柄不能在多个线程上同时写入或克隆（与之前的裸指针相同）；不同句柄可以并发使用。
+ */
+class ImageHandle {
+public:
+    /**
+     * 接管图像，创建新句柄
+     */
+    static ImageHandle* create(LinearImage&& image) {
+        return new ImageHandle(SharedImage::create(std::move(image), MemoryCategory::IMAGES));
+    }
+
+    /**
+     * 包装已有的共享图像（不复制像素）
+     */
+    static ImageHandle* create(SharedImage image) {
+        return new ImageHandle(std::move(image));
+    }
+
+    /**
+     * 共享同一缓冲区的新句柄（不复制像素）
+     */
+    ImageHandle* clone() const {
+        return new ImageHandle(m_image);
+    }
+
+    /**
+     * 只读访问
+     */
+    const LinearImage& read() const { return m_image.get(); }
+
+    /**
+     * 可写访问：其他持有者仍在引用时先复制
+     */
+    LinearImage& write() { return m_image.mutableImage(); }
+
+    /**
+     * 缓冲区是否被其他句柄共享
+     */
+    bool isShared() const { return m_image.isShared(); }
+
+private:
+    explicit ImageHandle(SharedImage image)
+        : m_image(std::move(image)) {
+    }
+
+    SharedImage m_image;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_IMAGE_HANDLE_H
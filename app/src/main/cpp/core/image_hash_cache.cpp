@@ -1,5 +1,8 @@
 #include "image_hash_cache.h"
+#include "result_spill_cache.h"
+#include "provenance.h"
 #include <algorithm>
+#include <chrono>
 #include <android/log.h>
 
 #define LOG_TAG "ImageHashCache"
@@ -8,258 +11,398 @@
 
 namespace filmtracker {
 
-// xxHash64 常量
-static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
-static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
-static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
-static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
-static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
-
-/**
- * xxHash64 辅助函数
- */
-static inline uint64_t rotl64(uint64_t x, int r) {
-    return (x << r) | (x >> (64 - r));
+ImageHashCache& ImageHashCache::getInstance() {
+    static ImageHashCache instance;
+    return instance;
 }
 
-static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
-    acc += input * PRIME64_2;
-    acc = rotl64(acc, 31);
-    acc *= PRIME64_1;
-    return acc;
+ImageHashCache::ImageHashCache() {
+    MemoryGovernor::getInstance().registerTrimHandler(
+        "ImageHashCache", [this](TrimLevel level) { return onTrimMemory(level); });
 }
 
-static inline uint64_t xxh64_mergeRound(uint64_t acc, uint64_t val) {
-    val = xxh64_round(0, val);
-    acc ^= val;
-    acc = acc * PRIME64_1 + PRIME64_4;
-    return acc;
+uint64_t ImageHashCache::hashBytes(const void* data, size_t length, uint64_t seed) {
+    return xxh64::hash(data, length, seed);
 }
 
-/**
- * xxHash64 实现
- * 
- * 基于 xxHash 算法的快速哈希函数
- * 参考：https://github.com/Cyan4973/xxHash
- */
-static uint64_t xxhash64(const void* data, size_t len, uint64_t seed = 0) {
-    const uint8_t* p = static_cast<const uint8_t*>(data);
-    const uint8_t* const end = p + len;
-    uint64_t h64;
-    
-    if (len >= 32) {
-        const uint8_t* const limit = end - 32;
-        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
-        uint64_t v2 = seed + PRIME64_2;
-        uint64_t v3 = seed + 0;
-        uint64_t v4 = seed - PRIME64_1;
-        
-        do {
-            v1 = xxh64_round(v1, *reinterpret_cast<const uint64_t*>(p)); p += 8;
-            v2 = xxh64_round(v2, *reinterpret_cast<const uint64_t*>(p)); p += 8;
-            v3 = xxh64_round(v3, *reinterpret_cast<const uint64_t*>(p)); p += 8;
-            v4 = xxh64_round(v4, *reinterpret_cast<const uint64_t*>(p)); p += 8;
-        } while (p <= limit);
-        
-        h64 = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
-        h64 = xxh64_mergeRound(h64, v1);
-        h64 = xxh64_mergeRound(h64, v2);
-        h64 = xxh64_mergeRound(h64, v3);
-        h64 = xxh64_mergeRound(h64, v4);
-    } else {
-        h64 = seed + PRIME64_5;
-    }
-    
-    h64 += static_cast<uint64_t>(len);
+uint64_t ImageHashCache::computeImageHash(const LinearImage& image) {
+    // 计算图像数据的哈希
+    // 我们对 R、G、B 通道分别计算哈希，然后组合
+    const size_t pixelCount = image.width * image.height;
+    const size_t dataSize = pixelCount * sizeof(float);
     
-    while (p + 8 <= end) {
-        uint64_t k1 = xxh64_round(0, *reinterpret_cast<const uint64_t*>(p));
-        h64 ^= k1;
-        h64 = rotl64(h64, 27) * PRIME64_1 + PRIME64_4;
-        p += 8;
-    }
+    uint64_t hashR = xxh64::hash(image.r.data(), dataSize, 0);
+    uint64_t hashG = xxh64::hash(image.g.data(), dataSize, hashR);
+    uint64_t hashB = xxh64::hash(image.b.data(), dataSize, hashG);
     
-    if (p + 4 <= end) {
-        h64 ^= static_cast<uint64_t>(*reinterpret_cast<const uint32_t*>(p)) * PRIME64_1;
-        h64 = rotl64(h64, 23) * PRIME64_2 + PRIME64_3;
-        p += 4;
+    // 组合三个通道的哈希
+    return hashB;
+}
+
+uint64_t ImageHashCache::computeSampledHash(const LinearImage& image) {
+    const uint32_t width = image.width;
+    const uint32_t height = image.height;
+    if (static_cast<size_t>(width) * height <= static_cast<size_t>(kSampleRows) * kSamplesPerRow) {
+        // 小图像完整哈希的开销和采样相当
+        return computeImageHash(image);
     }
     
-    while (p < end) {
-        h64 ^= static_cast<uint64_t>(*p) * PRIME64_5;
-        h64 = rotl64(h64, 11) * PRIME64_1;
-        p++;
-    }
+    const uint32_t rows = std::min(kSampleRows, height);
+    const uint32_t samples = std::min(kSamplesPerRow, width);
+    const uint32_t step = width / samples;
     
-    h64 ^= h64 >> 33;
-    h64 *= PRIME64_2;
-    h64 ^= h64 >> 29;
-    h64 *= PRIME64_3;
-    h64 ^= h64 >> 32;
+    // 尺寸作为种子，不同尺寸的图像不会因为样本相同而碰撞
+    const uint32_t dims[2] = {width, height};
+    uint64_t hash = xxh64::hash(dims, sizeof(dims), xxh64::kPrime5);
     
-    return h64;
+    float buffer[kSamplesPerRow * 3];
+    for (uint32_t i = 0; i < rows; ++i) {
+        const uint32_t y = rows > 1 ? static_cast<uint32_t>(static_cast<uint64_t>(i) * (height - 1) / (rows - 1)) : 0;
+        // 每行的起始列错开，采样点不会总落在同一组列上
+        const uint32_t phase = (i * 7919u) % step;
+        const size_t rowBase = static_cast<size_t>(y) * width + phase;
+        for (uint32_t s = 0; s < samples; ++s) {
+            const size_t idx = rowBase + static_cast<size_t>(s) * step;
+            buffer[s] = image.r[idx];
+            buffer[samples + s] = image.g[idx];
+            buffer[2 * samples + s] = image.b[idx];
+        }
+        hash = xxh64::hash(buffer, samples * 3 * sizeof(float), hash);
+    }
+    return hash;
 }
 
-ImageHashCache& ImageHashCache::getInstance() {
-    static ImageHashCache instance;
-    return instance;
+uint64_t ImageHashCache::computeImageKey(const LinearImage& image, bool sampled) {
+    if (image.provenance != 0) {
+        // 来源标识已经覆盖源文件和上游参数，只需再区分尺寸；种子与内容哈希不同，两类键互不碰撞
+        const uint64_t fields[3] = {image.provenance, image.width, image.height};
+        return xxh64::hash(fields, sizeof(fields), xxh64::kPrime3);
+    }
+    return sampled ? computeSampledHash(image) : computeImageHash(image);
 }
 
-uint64_t ImageHashCache::computeImageHash(const LinearImage& image) {
-    // 计算图像数据的哈希
-    // 我们对 R、G、B 通道分别计算哈希，然后组合
-    const size_t pixelCount = image.width * image.height;
-    const size_t dataSize = pixelCount * sizeof(float);
-    
-    uint64_t hashR = xxhash64(image.r.data(), dataSize, 0);
-    uint64_t hashG = xxhash64(image.g.data(), dataSize, hashR);
-    uint64_t hashB = xxhash64(image.b.data(), dataSize, hashG);
-    
-    // 组合三个通道的哈希
-    return hashB;
+ImageHashCache::Shard& ImageHashCache::shardFor(const HashKey& key) {
+    // 用乘法散列的高位选分片，避免低位相关的键集中到同一分片
+    const uint64_t h = static_cast<uint64_t>(HashKeyHash{}(key)) * xxh64::kPrime1;
+    return m_shards[(h >> 59) & (kShardCount - 1)];
 }
 
-bool ImageHashCache::find(const HashKey& key, LinearImage& output) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+std::shared_ptr<const LinearImage> ImageHashCache::find(const HashKey& key) {
+    Shard& shard = shardFor(key);
+    std::shared_ptr<const LinearImage> image;
+    std::shared_ptr<const CompressedImage> compressed;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            // 移到表头并更新访问序号
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            it->second->lastAccess = ++m_accessCounter;
+            image = it->second->image;
+            compressed = it->second->compressed;
+        }
+    }
     
-    auto it = m_cache.find(key);
-    if (it != m_cache.end()) {
-        // 缓存命中
-        CacheEntry& entry = it->second;
-        
-        // 更新最后访问时间
-        entry.lastAccess = std::chrono::steady_clock::now();
-        
-        // 复制结果到输出
-        const uint32_t pixelCount = entry.result.width * entry.result.height;
-        
-        // 确保输出图像大小正确
-        if (output.width != entry.result.width || output.height != entry.result.height) {
-            output = LinearImage(entry.result.width, entry.result.height);
+    if (compressed) {
+        // 在锁外解压，条目本身保持压缩
+        auto decompressStart = std::chrono::steady_clock::now();
+        image = compressed->decompress();
+        m_decompressions++;
+        m_decompressNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - decompressStart).count());
+    }
+    
+    if (!image) {
+        // 内存未命中时查磁盘溢出层，命中后放回内存
+        image = ResultSpillCache::getInstance().find(key);
+        if (image) {
+            m_spillHits++;
+            m_bytesServed += image->r.size() * 3 * sizeof(float);
+            insert(key, image);
+            LOGI("Cache spill hit: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
+                 static_cast<unsigned long long>(key.imageHash), key.spatialSigma, key.rangeSigma);
+            return image;
         }
         
-        // 复制数据
-        std::copy(entry.result.r.begin(), entry.result.r.end(), output.r.begin());
-        std::copy(entry.result.g.begin(), entry.result.g.end(), output.g.begin());
-        std::copy(entry.result.b.begin(), entry.result.b.end(), output.b.begin());
-        
-        LOGI("Cache hit: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
+        // 缓存未命中
+        m_misses++;
+        LOGI("Cache miss: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
              static_cast<unsigned long long>(key.imageHash), key.spatialSigma, key.rangeSigma);
-        
-        return true;
+        return nullptr;
     }
     
-    // 缓存未命中
-    LOGI("Cache miss: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
+    m_hits++;
+    m_bytesServed += image->r.size() * 3 * sizeof(float);
+    
+    LOGI("Cache hit: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
          static_cast<unsigned long long>(key.imageHash), key.spatialSigma, key.rangeSigma);
+    return image;
+}
+
+bool ImageHashCache::find(const HashKey& key, LinearImage& output) {
+    std::shared_ptr<const LinearImage> image = find(key);
+    if (!image) {
+        return false;
+    }
     
-    return false;
+    // 条目不可变，在锁外复制到输出
+    if (output.width != image->width || output.height != image->height) {
+        output = LinearImage(image->width, image->height);
+    }
+    std::copy(image->r.begin(), image->r.end(), output.r.begin());
+    std::copy(image->g.begin(), image->g.end(), output.g.begin());
+    std::copy(image->b.begin(), image->b.end(), output.b.begin());
+    output.provenance = image->provenance;
+    return true;
 }
 
 void ImageHashCache::insert(const HashKey& key, const LinearImage& result) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    // 检查是否已存在
-    if (m_cache.find(key) != m_cache.end()) {
-        LOGI("Cache entry already exists, updating");
-        m_cache.erase(key);
-        m_currentMemoryBytes -= result.width * result.height * 3 * sizeof(float);
+    const size_t logicalSize = static_cast<size_t>(result.width) * result.height * 3 * sizeof(float);
+    const CacheCompression compression = getCompression();
+    if (compression != CacheCompression::NONE) {
+        // 直接从调用方的图像压缩，不需要先复制一份 fp32
+        std::shared_ptr<const CompressedImage> compressed = CompressedImage::compress(result, compression);
+        if (compressed->compressedBytes() < logicalSize) {
+            insertEntry(key, nullptr, std::move(compressed));
+            return;
+        }
     }
-    
-    // 创建新条目
-    CacheEntry entry(result.width, result.height);
-    
-    // 复制数据
-    std::copy(result.r.begin(), result.r.end(), entry.result.r.begin());
-    std::copy(result.g.begin(), result.g.end(), entry.result.g.begin());
-    std::copy(result.b.begin(), result.b.end(), entry.result.b.begin());
-    
-    // 检查内存限制
-    while (m_currentMemoryBytes + entry.memorySize > m_maxMemoryBytes && !m_cache.empty()) {
-        LOGW("Memory limit exceeded, evicting LRU entry");
-        evictLRU();
+    if (logicalSize > m_maxMemoryBytes) {
+        LOGW("Cache insert skipped: entry exceeds the %zu MB limit", m_maxMemoryBytes.load() / (1024 * 1024));
+        return;
+    }
+    insertEntry(key, std::make_shared<LinearImage>(result), nullptr);
+}
+
+void ImageHashCache::insert(const HashKey& key, std::shared_ptr<const LinearImage> image) {
+    if (!image) {
+        return;
+    }
+    const CacheCompression compression = getCompression();
+    if (compression != CacheCompression::NONE) {
+        // 缓存只保留压缩数据，fp32 缓冲区随调用方释放
+        std::shared_ptr<const CompressedImage> compressed = CompressedImage::compress(*image, compression);
+        if (compressed->compressedBytes() < compressed->uncompressedBytes()) {
+            insertEntry(key, nullptr, std::move(compressed));
+            return;
+        }
+    }
+    insertEntry(key, std::move(image), nullptr);
+}
+
+void ImageHashCache::insertEntry(const HashKey& key,
+                                 std::shared_ptr<const LinearImage> image,
+                                 std::shared_ptr<const CompressedImage> compressed) {
+    const size_t logicalSize = compressed
+        ? compressed->uncompressedBytes()
+        : static_cast<size_t>(image->width) * image->height * 3 * sizeof(float);
+    const size_t memorySize = compressed ? compressed->compressedBytes() : logicalSize;
+    if (memorySize > m_maxMemoryBytes) {
+        LOGW("Cache insert skipped: entry %zu MB exceeds the %zu MB limit",
+             memorySize / (1024 * 1024), m_maxMemoryBytes.load() / (1024 * 1024));
+        return;
     }
     
-    // 检查大小限制
-    while (m_cache.size() >= m_maxSize && !m_cache.empty()) {
-        LOGW("Size limit exceeded, evicting LRU entry");
-        evictLRU();
+    Shard& shard = shardFor(key);
+    Node replaced{};   // 被替换的旧条目在锁外释放
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        
+        // 检查是否已存在
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            LOGI("Cache entry already exists, updating");
+            m_currentMemoryBytes -= it->second->memorySize;
+            m_logicalBytes -= it->second->logicalSize;
+            MemoryGovernor::getInstance().release(MemoryCategory::CACHES, it->second->memorySize);
+            m_entryCount--;
+            replaced = std::move(*it->second);
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+        }
+        
+        shard.lru.push_front(Node{key, std::move(image), std::move(compressed), memorySize, logicalSize, ++m_accessCounter});
+        shard.index[key] = shard.lru.begin();
+        m_currentMemoryBytes += memorySize;
+        m_logicalBytes += logicalSize;
+        m_entryCount++;
     }
+    MemoryGovernor::getInstance().charge(MemoryCategory::CACHES, memorySize);
     
-    // 插入新条目
-    m_currentMemoryBytes += entry.memorySize;
-    m_cache.emplace(key, std::move(entry));
+    m_inserts++;
+    m_bytesInserted += logicalSize;
     
-    LOGI("Cache insert: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f, size=%zu, memory=%zu MB",
+    // 新条目访问序号最大，超限时先驱逐其他条目；全局预算超出时由各模块一起回收
+    enforceLimits();
+    MemoryGovernor::getInstance().enforceBudget();
+    
+    LOGI("Cache insert: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f, size=%zu, memory=%zu MB, entry=%zu KB / %zu KB",
          static_cast<unsigned long long>(key.imageHash), key.spatialSigma, key.rangeSigma,
-         m_cache.size(), m_currentMemoryBytes / (1024 * 1024));
+         m_entryCount.load(), m_currentMemoryBytes.load() / (1024 * 1024), memorySize / 1024, logicalSize / 1024);
 }
 
 void ImageHashCache::clear() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    LOGI("Clearing cache: %zu entries, %zu MB", m_cache.size(), m_currentMemoryBytes / (1024 * 1024));
+    LOGI("Clearing cache: %zu entries, %zu MB", m_entryCount.load(), m_currentMemoryBytes.load() / (1024 * 1024));
     
-    m_cache.clear();
-    m_currentMemoryBytes = 0;
+    for (Shard& shard : m_shards) {
+        LruList drained;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            drained.swap(shard.lru);
+            shard.index.clear();
+        }
+        // 在锁外释放图像内存
+        for (const Node& node : drained) {
+            m_currentMemoryBytes -= node.memorySize;
+            m_logicalBytes -= node.logicalSize;
+            MemoryGovernor::getInstance().release(MemoryCategory::CACHES, node.memorySize);
+            m_entryCount--;
+        }
+    }
 }
 
 size_t ImageHashCache::size() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_cache.size();
+    return m_entryCount;
 }
 
 size_t ImageHashCache::memoryUsage() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
     return m_currentMemoryBytes;
 }
 
+ImageHashCache::Stats ImageHashCache::getStats() const {
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.inserts = m_inserts;
+    stats.evictions = m_evictions;
+    stats.bytesServed = m_bytesServed;
+    stats.bytesInserted = m_bytesInserted;
+    stats.entries = m_entryCount;
+    stats.memoryBytes = m_currentMemoryBytes;
+    stats.spillHits = m_spillHits;
+    stats.logicalBytes = m_logicalBytes;
+    stats.decompressions = m_decompressions;
+    stats.decompressNs = m_decompressNs;
+    return stats;
+}
+
+void ImageHashCache::resetStats() {
+    m_hits = 0;
+    m_misses = 0;
+    m_inserts = 0;
+    m_evictions = 0;
+    m_bytesServed = 0;
+    m_bytesInserted = 0;
+    m_spillHits = 0;
+    m_decompressions = 0;
+    m_decompressNs = 0;
+}
+
 void ImageHashCache::setMaxSize(size_t maxSize) {
-    std::lock_guard<std::mutex> lock(m_mutex);
     m_maxSize = maxSize;
     
     // 如果当前大小超过新限制，驱逐条目
-    while (m_cache.size() > m_maxSize && !m_cache.empty()) {
-        evictLRU();
-    }
+    enforceLimits();
 }
 
 void ImageHashCache::setMaxMemoryMB(size_t maxMemoryMB) {
-    std::lock_guard<std::mutex> lock(m_mutex);
     m_maxMemoryBytes = maxMemoryMB * 1024 * 1024;
     
     // 如果当前内存使用超过新限制，驱逐条目
-    enforceMemoryLimit();
+    enforceLimits();
 }
 
-void ImageHashCache::evictLRU() {
-    if (m_cache.empty()) {
-        return;
+void ImageHashCache::setCompression(CacheCompression compression) {
+    m_compression = static_cast<int>(compression);
+}
+
+CacheCompression ImageHashCache::getCompression() const {
+    return static_cast<CacheCompression>(m_compression.load());
+}
+
+bool ImageHashCache::evictLRU() {
+    // 找到尾部访问序号最小的分片（每次只持有一把锁）
+    size_t oldestShard = kShardCount;
+    uint64_t oldestAccess = UINT64_MAX;
+    for (size_t i = 0; i < kShardCount; ++i) {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        if (!m_shards[i].lru.empty() && m_shards[i].lru.back().lastAccess < oldestAccess) {
+            oldestAccess = m_shards[i].lru.back().lastAccess;
+            oldestShard = i;
+        }
+    }
+    if (oldestShard == kShardCount) {
+        return false;
     }
     
-    // 找到最久未使用的条目
-    auto oldestIt = m_cache.begin();
-    auto oldestTime = oldestIt->second.lastAccess;
-    
-    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
-        if (it->second.lastAccess < oldestTime) {
-            oldestTime = it->second.lastAccess;
-            oldestIt = it;
+    Shard& shard = m_shards[oldestShard];
+    std::shared_ptr<const LinearImage> victim;
+    std::shared_ptr<const CompressedImage> compressedVictim;
+    HashKey victimKey{};
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.lru.empty()) {
+            // 已被其他线程驱逐，由调用方重新检查限制
+            return true;
         }
+        
+        Node& node = shard.lru.back();
+        LOGI("Evicting LRU entry: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
+             static_cast<unsigned long long>(node.key.imageHash),
+             node.key.spatialSigma, node.key.rangeSigma);
+        
+        m_currentMemoryBytes -= node.memorySize;
+        m_logicalBytes -= node.logicalSize;
+        MemoryGovernor::getInstance().release(MemoryCategory::CACHES, node.memorySize);
+        m_entryCount--;
+        victim = std::move(node.image);
+        compressedVictim = std::move(node.compressed);
+        victimKey = node.key;
+        shard.index.erase(node.key);
+        shard.lru.pop_back();
+    }
+    m_evictions++;
+    
+    // 交给磁盘溢出层异步写入（未初始化时直接丢弃；压缩条目由写入线程解压）
+    if (compressedVictim) {
+        ResultSpillCache::getInstance().spill(victimKey, std::move(compressedVictim));
+    } else {
+        ResultSpillCache::getInstance().spill(victimKey, std::move(victim));
+    }
+    return true;
+}
+
+size_t ImageHashCache::onTrimMemory(TrimLevel level) {
+    const size_t before = m_currentMemoryBytes;
+    if (before == 0) {
+        return 0;
     }
     
-    // 移除最久未使用的条目
-    LOGI("Evicting LRU entry: hash=0x%016llx, spatialSigma=%.2f, rangeSigma=%.2f",
-         static_cast<unsigned long long>(oldestIt->first.imageHash),
-         oldestIt->first.spatialSigma, oldestIt->first.rangeSigma);
+    if (level >= TrimLevel::RUNNING_CRITICAL && level != TrimLevel::UI_HIDDEN) {
+        clear();
+        return before;
+    }
     
-    m_currentMemoryBytes -= oldestIt->second.memorySize;
-    m_cache.erase(oldestIt);
+    size_t target = 0;   // UI_HIDDEN：全部驱逐（进入溢出层，返回界面时可以读回）
+    if (level == TrimLevel::RUNNING_MODERATE) {
+        target = before / 4 * 3;
+    } else if (level == TrimLevel::RUNNING_LOW) {
+        target = before / 2;
+    }
+    while (m_currentMemoryBytes > target) {
+        if (!evictLRU()) {
+            break;
+        }
+    }
+    const size_t after = m_currentMemoryBytes;
+    return before > after ? before - after : 0;
 }
 
-void ImageHashCache::enforceMemoryLimit() {
-    while (m_currentMemoryBytes > m_maxMemoryBytes && !m_cache.empty()) {
-        evictLRU();
+void ImageHashCache::enforceLimits() {
+    while (m_entryCount > m_maxSize || m_currentMemoryBytes > m_maxMemoryBytes) {
+        if (!evictLRU()) {
+            break;
+        }
     }
 }
 
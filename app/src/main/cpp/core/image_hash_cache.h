@@ -2,9 +2,14 @@
 #define FILMTRACKER_IMAGE_HASH_CACHE_H
 
 #include "raw_types.h"
+#include "memory_governor.h"
+#include "compressed_image.h"
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <memory>
 #include <unordered_map>
 #include <mutex>
-#include <chrono>
 #include <cstdint>
 
 namespace filmtracker {
@@ -12,23 +17,46 @@ namespace filmtracker {
 /**
  * 图像哈希缓存系统
  * 
- * 使用 xxHash64 算法计算图像内容哈希，实现 LRU 缓存管理
+ * 使用 xxHash64 算法计算图像键，实现 LRU 缓存管理
  * 用于避免重复计算双边滤波结果
+ * 
+ * 图像键优先使用来源标识（LinearImage::provenance，由源文件和上游参数派生，不读取像素），
+ * 匿名缓冲区使用稀疏采样哈希或完整内容哈希。
+ * 
+ * 条目按键哈希分布到多个分片，每个分片一把锁、一条 LRU 链表和一个索引，
+ * 访问和驱逐都是 O(1)。锁内只做链表/索引操作，预览和导出线程的查找不会互相串行化。
+ * 条目是不可变的共享缓冲区：命中时直接交出引用，插入时接管调用方的缓冲区，
+ * 缓存和使用者共用同一份内存。
+ * 条目数和内存上限是全局的：超限时比较各分片尾部的访问序号，驱逐全局最久未使用的条目。
+ * 被驱逐的条目交给 ResultSpillCache 异步写入磁盘，内存未命中时再从磁盘取回。
+ * 条目内存登记在 MemoryGovernor 的 CACHES 分类下，并响应其回收级别。
+ * 可选压缩存储（CompressedImage）：条目按压缩后的字节数计入上限，同样的内存放下更多条目，
+ * 命中时多线程解压为新的缓冲区；压缩后没有变小的条目仍按 fp32 保存。
  */
 class ImageHashCache {
 public:
     /**
      * 哈希键（包含图像内容和参数）
+     * 
+     * sigma 按 0.001 量化后参与比较和哈希，两者保持一致。
+     * configHash 区分算法版本和影响结果的配置（快速近似、GPU 等），
+     * 配置或实现改变后旧条目（包括磁盘溢出层中跨启动保留的条目）不会再命中。
      */
     struct HashKey {
-        uint64_t imageHash;      // 图像内容哈希（xxHash64）
+        uint64_t imageHash;      // 图像键（来源标识、稀疏采样或完整内容哈希，见 computeImageKey）
         float spatialSigma;
         float rangeSigma;
+        uint64_t configHash = 0; // 算法版本 + 影响结果的配置
+        
+        static int32_t quantize(float sigma) {
+            return static_cast<int32_t>(std::lround(sigma * 1000.0f));
+        }
         
         bool operator==(const HashKey& other) const {
             return imageHash == other.imageHash &&
-                   std::abs(spatialSigma - other.spatialSigma) < 0.001f &&
-                   std::abs(rangeSigma - other.rangeSigma) < 0.001f;
+                   configHash == other.configHash &&
+                   quantize(spatialSigma) == quantize(other.spatialSigma) &&
+                   quantize(rangeSigma) == quantize(other.rangeSigma);
         }
     };
     
@@ -39,24 +67,33 @@ public:
         size_t operator()(const HashKey& key) const {
             // 组合哈希：使用 imageHash 作为主要哈希，参数作为次要哈希
             size_t h1 = std::hash<uint64_t>{}(key.imageHash);
-            size_t h2 = std::hash<float>{}(key.spatialSigma);
-            size_t h3 = std::hash<float>{}(key.rangeSigma);
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
+            size_t h2 = std::hash<int32_t>{}(HashKey::quantize(key.spatialSigma));
+            size_t h3 = std::hash<int32_t>{}(HashKey::quantize(key.rangeSigma));
+            size_t h4 = std::hash<uint64_t>{}(key.configHash);
+            return h1 ^ (h2 << 1) ^ (h3 << 2) ^ (h4 << 3);
         }
     };
     
     /**
-     * 缓存条目
+     * 缓存统计
      */
-    struct CacheEntry {
-        LinearImage result;
-        size_t memorySize;
-        std::chrono::steady_clock::time_point lastAccess;
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;
+        uint64_t bytesServed = 0;     // 命中的条目字节数（共享返回时不复制）
+        uint64_t bytesInserted = 0;
+        uint64_t entries = 0;
+        uint64_t memoryBytes = 0;
+        uint64_t spillHits = 0;       // 内存未命中、从磁盘溢出层取回
+        uint64_t logicalBytes = 0;    // 当前条目解压后的字节数（与 memoryBytes 之比即压缩率）
+        uint64_t decompressions = 0;
+        uint64_t decompressNs = 0;    // 命中时解压的累计耗时
         
-        CacheEntry(uint32_t width, uint32_t height)
-            : result(width, height)
-            , memorySize(width * height * 3 * sizeof(float))
-            , lastAccess(std::chrono::steady_clock::now()) {
+        double hitRate() const {
+            const uint64_t lookups = hits + spillHits + misses;
+            return lookups > 0 ? static_cast<double>(hits + spillHits) / lookups : 0.0;
         }
     };
     
@@ -66,7 +103,18 @@ public:
     static ImageHashCache& getInstance();
     
     /**
-     * 查找缓存
+     * 查找缓存（零复制）
+     * 
+     * 返回缓存中的共享只读缓冲区，O(1)；需要修改时通过 SharedImage 写时复制。
+     * 内存未命中时查磁盘溢出层（mmap 读取），命中的条目放回内存
+     * 
+     * @param key 哈希键
+     * @return 缓存的图像，未命中时为 nullptr
+     */
+    std::shared_ptr<const LinearImage> find(const HashKey& key);
+    
+    /**
+     * 查找缓存并复制到调用方的图像
      * 
      * @param key 哈希键
      * @param output 输出图像（如果找到）
@@ -75,7 +123,15 @@ public:
     bool find(const HashKey& key, LinearImage& output);
     
     /**
-     * 插入缓存
+     * 插入共享缓冲区（零复制，调用方之后不得再修改该图像）
+     * 
+     * @param key 哈希键
+     * @param image 结果图像
+     */
+    void insert(const HashKey& key, std::shared_ptr<const LinearImage> image);
+    
+    /**
+     * 插入缓存（复制一份）
      * 
      * @param key 哈希键
      * @param result 结果图像
@@ -92,6 +148,8 @@ public:
      */
     size_t size() const;
     size_t memoryUsage() const;
+    Stats getStats() const;
+    void resetStats();
     
     /**
      * 配置
@@ -99,6 +157,12 @@ public:
     void setMaxSize(size_t maxSize);
     void setMaxMemoryMB(size_t maxMemoryMB);
     
+    /**
+     * 新插入条目的压缩方式（已有条目保持原样）
+     */
+    void setCompression(CacheCompression compression);
+    CacheCompression getCompression() const;
+    
     /**
      * 计算图像哈希（使用 xxHash64）
      * 
@@ -107,33 +171,125 @@ public:
      */
     static uint64_t computeImageHash(const LinearImage& image);
     
+    /**
+     * 稀疏采样哈希
+     * 
+     * 尺寸 + 均匀分布的 kSampleRows 行，每行按步长取 kSamplesPerRow 个像素（每行相位错开），
+     * 三个平面共约 5 万个样本，与分辨率无关，耗时为微秒级。
+     * 代价是只改动了采样点之间像素的局部修改可能碰撞；小图像退回完整哈希。
+     */
+    static uint64_t computeSampledHash(const LinearImage& image);
+    
+    /**
+     * 计算缓存用的图像键
+     * 
+     * 图像带有来源标识（provenance != 0）时直接由来源标识和尺寸得到，不读取像素；
+     * 匿名缓冲区按 sampled 选择稀疏采样哈希或完整哈希
+     * 
+     * @param image 输入图像
+     * @param sampled 匿名缓冲区使用稀疏采样哈希
+     * @return 64位键
+     */
+    static uint64_t computeImageKey(const LinearImage& image, bool sampled);
+    
+    /**
+     * 计算任意字节序列的 xxHash64
+     * 
+     * @param data 数据
+     * @param length 字节数
+     * @param seed 种子
+     * @return 64位哈希值
+     */
+    static uint64_t hashBytes(const void* data, size_t length, uint64_t seed = 0);
+    
 private:
-    ImageHashCache() = default;
+    ImageHashCache();
     ~ImageHashCache() = default;
     
     // 禁止拷贝和赋值
     ImageHashCache(const ImageHashCache&) = delete;
     ImageHashCache& operator=(const ImageHashCache&) = delete;
     
+    // 稀疏采样哈希的行数和每行样本数
+    static constexpr uint32_t kSampleRows = 64;
+    static constexpr uint32_t kSamplesPerRow = 256;
+    
+    // 分片数（2 的幂）
+    static constexpr size_t kShardCount = 8;
+    
+    /**
+     * LRU 节点
+     */
+    struct Node {
+        HashKey key;
+        std::shared_ptr<const LinearImage> image;            // 未压缩的条目
+        std::shared_ptr<const CompressedImage> compressed;   // 压缩的条目（与 image 二选一）
+        size_t memorySize;
+        size_t logicalSize;      // 解压后的字节数
+        uint64_t lastAccess;     // 全局访问序号
+    };
+    
+    using LruList = std::list<Node>;
+    
+    struct Shard {
+        LruList lru;             // 表头为最近使用
+        std::unordered_map<HashKey, LruList::iterator, HashKeyHash> index;
+        mutable std::mutex mutex;
+    };
+    
+    Shard& shardFor(const HashKey& key);
+    
+    /**
+     * 插入一个条目（image 与 compressed 二选一）
+     */
+    void insertEntry(const HashKey& key,
+                     std::shared_ptr<const LinearImage> image,
+                     std::shared_ptr<const CompressedImage> compressed);
+    
     /**
      * LRU 驱逐
      * 
-     * 移除最久未使用的条目
+     * 比较各分片尾部的访问序号，移除全局最久未使用的条目（不持有任何分片锁时调用）
+     * 
+     * @return 是否驱逐了条目
      */
-    void evictLRU();
+    bool evictLRU();
     
     /**
-     * 检查内存限制
+     * 内存回收回调（在 MemoryGovernor 注册）
+     * 
+     * RUNNING_MODERATE / RUNNING_LOW 驱逐到当前占用的 3/4 / 1/2，UI_HIDDEN 驱逐全部，
+     * 被驱逐的条目照常进入磁盘溢出层；RUNNING_CRITICAL 及后台级别直接清空，不再排队写盘
      * 
-     * 如果超过内存限制，驱逐条目直到满足限制
+     * @return 释放的字节数
      */
-    void enforceMemoryLimit();
+    size_t onTrimMemory(TrimLevel level);
+    
+    /**
+     * 检查条目数和内存限制
+     * 
+     * 如果超过限制，驱逐条目直到满足限制
+     */
+    void enforceLimits();
+    
+    Shard m_shards[kShardCount];
+    std::atomic<size_t> m_maxSize{10};
+    std::atomic<size_t> m_maxMemoryBytes{100 * 1024 * 1024};  // 100MB
+    std::atomic<size_t> m_currentMemoryBytes{0};
+    std::atomic<size_t> m_logicalBytes{0};
+    std::atomic<int> m_compression{static_cast<int>(CacheCompression::NONE)};
+    std::atomic<size_t> m_entryCount{0};
+    std::atomic<uint64_t> m_accessCounter{0};
     
-    std::unordered_map<HashKey, CacheEntry, HashKeyHash> m_cache;
-    size_t m_maxSize = 10;
-    size_t m_maxMemoryBytes = 100 * 1024 * 1024;  // 100MB
-    size_t m_currentMemoryBytes = 0;
-    mutable std::mutex m_mutex;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_inserts{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<uint64_t> m_bytesServed{0};
+    std::atomic<uint64_t> m_bytesInserted{0};
+    std::atomic<uint64_t> m_spillHits{0};
+    std::atomic<uint64_t> m_decompressions{0};
+    std::atomic<uint64_t> m_decompressNs{0};
 };
 
 } // namespace filmtracker
@@ -5,8 +5,11 @@
 #include "color_temperature.h"
 #include "color_grading.h"
 #include "bilateral_filter.h"
+#include "provenance.h"
+#include "memory_governor.h"
 #include <algorithm>
 #include <cmath>
+#include <initializer_list>
 #include <thread>
 #include <vector>
 #include <android/log.h>
@@ -17,6 +20,62 @@
 
 namespace filmtracker {
 
+namespace {
+
+/**
+ * 阶段结束时推进图像的来源标识（包括提前返回的路径）
+ * 
+ * 新标识 = 上游标识 + 阶段标记 + 本阶段参数。在析构时才更新，
+ * 阶段内部的双边滤波缓存看到的仍是本阶段输入的来源
+ */
+class ProvenanceScope {
+public:
+    ProvenanceScope(LinearImage& image, uint32_t stage) : m_image(image) {
+        m_fields.push_back(static_cast<float>(stage));
+    }
+    
+    ~ProvenanceScope() {
+        m_image.provenance = deriveProvenance(
+            m_image.provenance, m_fields.data(), m_fields.size() * sizeof(float));
+    }
+    
+    void add(std::initializer_list<float> values) {
+        m_fields.insert(m_fields.end(), values.begin(), values.end());
+    }
+    
+    void add(const float* values, size_t count) {
+        if (values) {
+            m_fields.insert(m_fields.end(), values, values + count);
+        }
+    }
+    
+    void addCurve(const ToneCurveParams::CurveData& curve) {
+        add({curve.enabled ? 1.0f : 0.0f, static_cast<float>(curve.pointCount)});
+        if (curve.pointCount > 0) {
+            add(curve.xCoords, curve.pointCount);
+            add(curve.yCoords, curve.pointCount);
+        }
+    }
+    
+private:
+    LinearImage& m_image;
+    std::vector<float> m_fields;
+};
+
+// 阶段标记
+enum ProvenanceStage : uint32_t {
+    kStageBasic = 0x10,
+    kStageTone,
+    kStagePresence,
+    kStageCurves,
+    kStageHSL,
+    kStageColor,
+    kStageEffects,
+    kStageDetails
+};
+
+} // namespace
+
 ImageProcessorEngine::ImageProcessorEngine() {
     LOGI("ImageProcessorEngine created");
 }
@@ -31,6 +90,9 @@ void ImageProcessorEngine::applyBasicAdjustments(LinearImage& image,
                                                  float exposure,
                                                  float contrast,
                                                  float saturation) {
+    ProvenanceScope provenance(image, kStageBasic);
+    provenance.add({exposure, contrast, saturation});
+    
     LOGI("applyBasicAdjustments: exposure=%.2f, contrast=%.2f, saturation=%.2f", 
          exposure, contrast, saturation);
     
@@ -93,6 +155,9 @@ void ImageProcessorEngine::applyToneAdjustments(LinearImage& image,
                                                float shadows,
                                                float whites,
                                                float blacks) {
+    ProvenanceScope provenance(image, kStageTone);
+    provenance.add({highlights, shadows, whites, blacks});
+    
     LOGI("applyToneAdjustments: highlights=%.2f, shadows=%.2f, whites=%.2f, blacks=%.2f",
          highlights, shadows, whites, blacks);
     
@@ -138,6 +203,9 @@ void ImageProcessorEngine::applyToneAdjustments(LinearImage& image,
 void ImageProcessorEngine::applyPresence(LinearImage& image,
                                         float clarity,
                                         float vibrance) {
+    ProvenanceScope provenance(image, kStagePresence);
+    provenance.add({clarity, vibrance});
+    
     LOGI("applyPresence: clarity=%.2f, vibrance=%.2f", clarity, vibrance);
     
     // 如果所有参数都是 0，直接返回
@@ -162,7 +230,8 @@ void ImageProcessorEngine::applyPresence(LinearImage& image,
         
         // 提取细节层
         LinearImage detail(image.width, image.height);
-        BilateralFilter::extractDetail(image, detail, spatialSigma, rangeSigma);
+        MemoryCharge detailCharge(MemoryCategory::SCRATCH, detail.r.size() * 3 * sizeof(float));
+        BilateralFilter::extractDetail(image, detail, spatialSigma, rangeSigma, m_detailCacheEnabled);
         
         // 应用清晰度调整
         // clarity > 0: 增强细节
@@ -261,6 +330,12 @@ void ImageProcessorEngine::applyPresence(LinearImage& image,
 // ========== 色调曲线模块 ==========
 
 void ImageProcessorEngine::applyToneCurves(LinearImage& image, const ToneCurveParams& curveParams) {
+    ProvenanceScope provenance(image, kStageCurves);
+    provenance.addCurve(curveParams.rgbCurve);
+    provenance.addCurve(curveParams.redCurve);
+    provenance.addCurve(curveParams.greenCurve);
+    provenance.addCurve(curveParams.blueCurve);
+    
     LOGI("applyToneCurves: RGB=%d, R=%d, G=%d, B=%d",
          curveParams.rgbCurve.enabled, curveParams.redCurve.enabled,
          curveParams.greenCurve.enabled, curveParams.blueCurve.enabled);
@@ -457,6 +532,12 @@ float ImageProcessorEngine::applyLUT(const float* lut, int lutSize, float x) con
 // ========== HSL 调整模块 ==========
 
 void ImageProcessorEngine::applyHSL(LinearImage& image, const HSLParams& hslParams) {
+    ProvenanceScope provenance(image, kStageHSL);
+    provenance.add({hslParams.enableHSL ? 1.0f : 0.0f});
+    provenance.add(hslParams.hueShift, 8);
+    provenance.add(hslParams.saturation, 8);
+    provenance.add(hslParams.luminance, 8);
+    
     LOGI("applyHSL: enabled=%d", hslParams.enableHSL);
     
     if (!hslParams.enableHSL) {
@@ -554,6 +635,13 @@ int ImageProcessorEngine::getHueSegment(float hue) const {
 // ========== 颜色调整模块 ==========
 
 void ImageProcessorEngine::applyColorAdjustments(LinearImage& image, const BasicAdjustmentParams& params) {
+    ProvenanceScope provenance(image, kStageColor);
+    provenance.add({params.saturation, params.temperature, params.tint,
+                    params.gradingHighlightsTemp, params.gradingHighlightsTint,
+                    params.gradingMidtonesTemp, params.gradingMidtonesTint,
+                    params.gradingShadowsTemp, params.gradingShadowsTint,
+                    params.gradingBlending, params.gradingBalance});
+    
     // 检查是否有任何颜色调整
     bool hasSaturation = std::abs(params.saturation - 1.0f) > 0.001f;
     bool hasTemperature = std::abs(params.temperature) > 0.01f || std::abs(params.tint) > 0.01f;
@@ -674,6 +762,9 @@ void ImageProcessorEngine::applyColorAdjustments(LinearImage& image, const Basic
 // ========== 效果模块 ==========
 
 void ImageProcessorEngine::applyEffects(LinearImage& image, const BasicAdjustmentParams& params) {
+    ProvenanceScope provenance(image, kStageEffects);
+    provenance.add({params.texture, params.dehaze, params.vignette, params.grain});
+    
     if (params.texture == 0.0f && params.dehaze == 0.0f && 
         params.vignette == 0.0f && params.grain == 0.0f) {
         return; // 没有调整，直接返回
@@ -696,7 +787,8 @@ void ImageProcessorEngine::applyEffects(LinearImage& image, const BasicAdjustmen
         
         // 提取细节层
         LinearImage detail(image.width, image.height);
-        BilateralFilter::extractDetail(image, detail, spatialSigma, rangeSigma);
+        MemoryCharge detailCharge(MemoryCategory::SCRATCH, detail.r.size() * 3 * sizeof(float));
+        BilateralFilter::extractDetail(image, detail, spatialSigma, rangeSigma, m_detailCacheEnabled);
         
         // 应用纹理调整
         const uint32_t numThreads = std::min(4u, std::thread::hardware_concurrency());
@@ -780,6 +872,9 @@ void ImageProcessorEngine::applyEffects(LinearImage& image, const BasicAdjustmen
 // ========== 细节模块 ==========
 
 void ImageProcessorEngine::applyDetails(LinearImage& image, const BasicAdjustmentParams& params) {
+    ProvenanceScope provenance(image, kStageDetails);
+    provenance.add({params.sharpening, params.noiseReduction});
+    
     if (params.sharpening == 0.0f && params.noiseReduction == 0.0f) {
         return; // 没有调整，直接返回
     }
@@ -803,6 +898,7 @@ void ImageProcessorEngine::applyDetails(LinearImage& image, const BasicAdjustmen
         
         // 使用快速双边滤波器
         LinearImage filtered(width, height);
+        MemoryCharge filteredCharge(MemoryCategory::SCRATCH, filtered.r.size() * 3 * sizeof(float));
         BilateralFilter::applyFast(image, filtered, spatialSigma, rangeSigma);
         
         // 混合原图和滤波结果
@@ -842,6 +938,7 @@ void ImageProcessorEngine::applyDetails(LinearImage& image, const BasicAdjustmen
         std::vector<float> blurR(pixelCount);
         std::vector<float> blurG(pixelCount);
         std::vector<float> blurB(pixelCount);
+        MemoryCharge blurCharge(MemoryCategory::SCRATCH, static_cast<size_t>(pixelCount) * 3 * sizeof(float));
         
         // 简单的 3x3 高斯模糊核
         // 1  2  1
@@ -930,4 +1027,45 @@ void ImageProcessorEngine::applyDetails(LinearImage& image, const BasicAdjustmen
     LOGI("applyDetails completed");
 }
 
+// ========== 完整管线 ==========
+
+void ImageProcessorEngine::applyAll(LinearImage& image, const BasicAdjustmentParams& params) {
+    applyBasicAdjustments(image, params.globalExposure, params.contrast, params.saturation);
+    applyToneAdjustments(image, params.highlights, params.shadows, params.whites, params.blacks);
+    applyPresence(image, params.clarity, params.vibrance);
+    
+    if (params.curveParams) {
+        applyToneCurves(image, *params.curveParams);
+    }
+    if (params.hslParams && params.hslParams->enableHSL) {
+        applyHSL(image, *params.hslParams);
+    }
+    
+    applyColorAdjustments(image, params);
+    applyEffects(image, params);
+    applyDetails(image, params);
+}
+
+uint32_t ImageProcessorEngine::spatialRadius(const BasicAdjustmentParams& params) {
+    // 双边滤波按 4 sigma 估计支撑范围（3 sigma 的核半径 + 快速近似降采样网格的插值邻域）
+    auto bilateralRadius = [](float spatialSigma) {
+        return static_cast<uint32_t>(std::ceil(4.0f * spatialSigma));
+    };
+    
+    uint32_t radius = 0;
+    if (std::abs(params.clarity) > 0.01f) {
+        radius += bilateralRadius(5.0f);
+    }
+    if (std::abs(params.texture) > 0.01f) {
+        radius += bilateralRadius(2.0f);
+    }
+    if (params.noiseReduction > 0.0f) {
+        radius += bilateralRadius(2.0f + params.noiseReduction / 100.0f * 3.0f);
+    }
+    if (params.sharpening > 0.0f) {
+        radius += 1;  // 3x3 模糊核
+    }
+    return radius;
+}
+
 } // namespace filmtracker
@@ -114,6 +114,30 @@ public:
      */
     void applyDetails(LinearImage& image, const BasicAdjustmentParams& params);
     
+    // ========== 完整管线 ==========
+    
+    /**
+     * 按预览管线的顺序应用全部调整：
+     * 基础 -> 色调 -> 清晰度/自然饱和度 -> 曲线 -> HSL -> 颜色 -> 效果 -> 细节
+     * 
+     * @param image 输入/输出图像
+     * @param params 调整参数（对比度、饱和度为乘数）
+     */
+    void applyAll(LinearImage& image, const BasicAdjustmentParams& params);
+    
+    /**
+     * 完整管线的空间依赖半径（像素）
+     * 
+     * 逐像素调整为 0；清晰度、纹理、降噪、锐化依次叠加各自滤波器的支撑半径。
+     * 条带处理时每个条带上下各需要这么多行 halo，有效行的结果才与整幅处理一致。
+     */
+    static uint32_t spatialRadius(const BasicAdjustmentParams& params);
+    
+    /**
+     * 清晰度/纹理的细节层是否使用双边滤波结果缓存（默认开启）
+     */
+    void setDetailCacheEnabled(bool enabled) { m_detailCacheEnabled = enabled; }
+    
 private:
     // 曲线相关辅助函数
     void buildLUTFromControlPoints(const ToneCurveParams::CurveData& curveData, float* lut, int lutSize) const;
@@ -124,6 +148,8 @@ private:
     void rgbToHSL(float r, float g, float b, float& h, float& s, float& l) const;
     void hslToRGB(float h, float s, float l, float& r, float& g, float& b) const;
     int getHueSegment(float hue) const;
+    
+    bool m_detailCacheEnabled = true;
 };
 
 } // namespace filmtracker
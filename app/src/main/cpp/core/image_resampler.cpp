@@ -0,0 +1,463 @@
+#include "image_resampler.h"
+#include "provenance.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <android/log.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#define LOG_TAG "ImageResampler"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+// 每个工作块的输出行数：块内源行只做一次水平滤波，块越大重复计算的 halo 越少
+const uint32_t kChunkRows = 32;
+
+const float kPi = 3.14159265358979f;
+
+/**
+ * 单个方向的预计算权重：每个输出位置从 start 开始读取 taps 个源像素
+ */
+struct AxisWeights {
+    uint32_t taps = 0;
+    std::vector<uint32_t> start;
+    std::vector<float> weights;     // 输出位置数 x taps
+};
+
+float cubicKernel(float x) {
+    const float a = -0.5f;
+    x = std::abs(x);
+    if (x < 1.0f) {
+        return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+    }
+    if (x < 2.0f) {
+        return ((a * x - 5.0f * a) * x + 8.0f * a) * x - 4.0f * a;
+    }
+    return 0.0f;
+}
+
+float sinc(float x) {
+    if (std::abs(x) < 1e-6f) {
+        return 1.0f;
+    }
+    x *= kPi;
+    return std::sin(x) / x;
+}
+
+float lanczos3Kernel(float x) {
+    if (std::abs(x) >= 3.0f) {
+        return 0.0f;
+    }
+    return sinc(x) * sinc(x / 3.0f);
+}
+
+/**
+ * 由每个输出位置的（起点，局部权重）生成固定长度的权重表
+ *
+ * 局部权重先归一化；起点向前移动使 start + taps 不越界，空出的位置权重为 0。
+ * taps 在源尺寸允许时补齐到 4 的倍数，便于向量化点积。
+ */
+void packWeights(uint32_t srcSize,
+                 const std::vector<uint32_t>& lo,
+                 const std::vector<std::vector<float>>& local,
+                 AxisWeights& axis) {
+    size_t maxTaps = 1;
+    for (const auto& w : local) {
+        maxTaps = std::max(maxTaps, w.size());
+    }
+    uint32_t taps = static_cast<uint32_t>(maxTaps);
+    const uint32_t padded = (taps + 3) & ~3u;
+    if (padded <= srcSize) {
+        taps = padded;
+    }
+
+    const size_t count = lo.size();
+    axis.taps = taps;
+    axis.start.resize(count);
+    axis.weights.assign(count * taps, 0.0f);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t start = std::min(lo[i], srcSize - taps);
+        axis.start[i] = start;
+
+        float sum = 0.0f;
+        for (float w : local[i]) {
+            sum += w;
+        }
+        const float norm = std::abs(sum) > 1e-8f ? 1.0f / sum : 0.0f;
+        float* dst = &axis.weights[i * taps + (lo[i] - start)];
+        for (size_t k = 0; k < local[i].size(); ++k) {
+            dst[k] = local[i][k] * norm;
+        }
+    }
+}
+
+/**
+ * 计算缩放权重（越界的采样折叠到边缘像素）
+ */
+AxisWeights buildWeights(uint32_t srcSize, uint32_t dstSize, ResampleFilter filter) {
+    std::vector<uint32_t> lo(dstSize);
+    std::vector<std::vector<float>> local(dstSize);
+    const double scale = static_cast<double>(srcSize) / dstSize;
+    const int last = static_cast<int>(srcSize) - 1;
+
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        if (filter == ResampleFilter::BOX) {
+            // 面积平均：权重为源像素与输出像素覆盖区间的重叠长度
+            const double begin = i * scale;
+            const double end = (i + 1) * scale;
+            const int j0 = std::min(static_cast<int>(std::floor(begin)), last);
+            const int j1 = std::max(std::min(static_cast<int>(std::ceil(end)), last + 1), j0 + 1);
+            lo[i] = static_cast<uint32_t>(j0);
+            local[i].resize(j1 - j0);
+            for (int j = j0; j < j1; ++j) {
+                const double overlap = std::min(end, j + 1.0) - std::max(begin, static_cast<double>(j));
+                local[i][j - j0] = static_cast<float>(std::max(overlap, 0.0));
+            }
+            if (j1 - j0 == 1) {
+                local[i][0] = 1.0f;
+            }
+            continue;
+        }
+
+        // 缩小时展宽滤波器（支撑按比例放大）
+        const double filterScale = std::max(scale, 1.0);
+        const double support = (filter == ResampleFilter::LANCZOS3 ? 3.0 : 2.0) * filterScale;
+        const double center = (i + 0.5) * scale;
+        const int j0 = static_cast<int>(std::floor(center - support));
+        const int j1 = static_cast<int>(std::ceil(center + support));
+        const int c0 = std::max(0, std::min(j0, last));
+        const int c1 = std::max(0, std::min(j1 - 1, last));
+        lo[i] = static_cast<uint32_t>(c0);
+        local[i].assign(c1 - c0 + 1, 0.0f);
+        for (int j = j0; j < j1; ++j) {
+            const float x = static_cast<float>((j + 0.5 - center) / filterScale);
+            const float w = filter == ResampleFilter::LANCZOS3 ? lanczos3Kernel(x) : cubicKernel(x);
+            const int idx = std::max(0, std::min(j, last));
+            local[i][idx - c0] += w;
+        }
+    }
+
+    AxisWeights axis;
+    packWeights(srcSize, lo, local, axis);
+    return axis;
+}
+
+/**
+ * 整数倍块平均权重（块与原点对齐，末尾不完整的块只平均有效像素）
+ */
+AxisWeights buildBlockWeights(uint32_t srcSize, uint32_t factor) {
+    const uint32_t dstSize = (srcSize + factor - 1) / factor;
+    std::vector<uint32_t> lo(dstSize);
+    std::vector<std::vector<float>> local(dstSize);
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        lo[i] = i * factor;
+        local[i].assign(std::min(factor, srcSize - lo[i]), 1.0f);
+    }
+    AxisWeights axis;
+    packWeights(srcSize, lo, local, axis);
+    return axis;
+}
+
+uint32_t chooseThreadCount(uint32_t maxThreads, uint32_t chunks) {
+    uint32_t threads = maxThreads > 0 ? maxThreads
+                                      : std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+    return std::max(1u, std::min(threads, chunks));
+}
+
+/**
+ * 按行块交错分配给多个线程（线程数为 1 时在当前线程执行）
+ */
+template <typename ChunkFn>
+void forEachChunk(uint32_t dstHeight, uint32_t maxThreads, ChunkFn fn) {
+    const uint32_t chunks = (dstHeight + kChunkRows - 1) / kChunkRows;
+    const uint32_t numThreads = chooseThreadCount(maxThreads, chunks);
+
+    auto worker = [&fn, chunks, numThreads, dstHeight](uint32_t t) {
+        std::vector<float> scratch;
+        for (uint32_t chunk = t; chunk < chunks; chunk += numThreads) {
+            const uint32_t y0 = chunk * kChunkRows;
+            fn(y0, std::min(dstHeight, y0 + kChunkRows), scratch);
+        }
+    };
+
+    if (numThreads == 1) {
+        worker(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * 点积（水平方向，平面数据）
+ */
+inline float dot(const float* src, const float* weights, uint32_t taps) {
+#ifdef __ARM_NEON
+    if ((taps & 3) == 0) {
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (uint32_t k = 0; k < taps; k += 4) {
+            acc = vmlaq_f32(acc, vld1q_f32(src + k), vld1q_f32(weights + k));
+        }
+        float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        return vget_lane_f32(vpadd_f32(sum, sum), 0);
+    }
+#endif
+    float acc = 0.0f;
+    for (uint32_t k = 0; k < taps; ++k) {
+        acc += src[k] * weights[k];
+    }
+    return acc;
+}
+
+/**
+ * dst = row * w（first）或 dst += row * w（垂直方向）
+ */
+inline void accumulateRow(float* dst, const float* row, float w, size_t n, bool first) {
+    size_t i = 0;
+#ifdef __ARM_NEON
+    const float32x4_t vw = vdupq_n_f32(w);
+    if (first) {
+        for (; i + 4 <= n; i += 4) {
+            vst1q_f32(dst + i, vmulq_f32(vld1q_f32(row + i), vw));
+        }
+    } else {
+        for (; i + 4 <= n; i += 4) {
+            vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(row + i), vw));
+        }
+    }
+#endif
+    if (first) {
+        for (; i < n; ++i) {
+            dst[i] = row[i] * w;
+        }
+    } else {
+        for (; i < n; ++i) {
+            dst[i] += row[i] * w;
+        }
+    }
+}
+
+/**
+ * 平面 float 图像重采样（3 个通道）
+ */
+void resamplePlanar(const float* const src[3], uint32_t srcWidth,
+                    float* const dst[3], uint32_t dstWidth, uint32_t dstHeight,
+                    const AxisWeights& wx, const AxisWeights& wy, uint32_t maxThreads) {
+    forEachChunk(dstHeight, maxThreads,
+        [&](uint32_t y0, uint32_t y1, std::vector<float>& tmp) {
+            // 本块用到的源行区间（起点随输出位置单调不减）
+            const uint32_t r0 = wy.start[y0];
+            const uint32_t r1 = wy.start[y1 - 1] + wy.taps;
+            const size_t plane = static_cast<size_t>(r1 - r0) * dstWidth;
+            tmp.resize(plane * 3);
+
+            for (uint32_t r = r0; r < r1; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    const float* row = src[c] + static_cast<size_t>(r) * srcWidth;
+                    float* out = &tmp[c * plane + static_cast<size_t>(r - r0) * dstWidth];
+                    for (uint32_t x = 0; x < dstWidth; ++x) {
+                        out[x] = dot(row + wx.start[x], &wx.weights[static_cast<size_t>(x) * wx.taps], wx.taps);
+                    }
+                }
+            }
+
+            for (uint32_t y = y0; y < y1; ++y) {
+                const float* w = &wy.weights[static_cast<size_t>(y) * wy.taps];
+                const uint32_t base = wy.start[y] - r0;
+                for (int c = 0; c < 3; ++c) {
+                    float* out = dst[c] + static_cast<size_t>(y) * dstWidth;
+                    for (uint32_t k = 0; k < wy.taps; ++k) {
+                        accumulateRow(out, &tmp[c * plane + static_cast<size_t>(base + k) * dstWidth],
+                                      w[k], dstWidth, k == 0);
+                    }
+                }
+            }
+        });
+}
+
+/**
+ * RGBA8 像素 * 权重累加到 4 个 float
+ */
+inline void accumulatePixel(float* acc, const uint8_t* pixel, float w) {
+    acc[0] += pixel[0] * w;
+    acc[1] += pixel[1] * w;
+    acc[2] += pixel[2] * w;
+    acc[3] += pixel[3] * w;
+}
+
+/**
+ * RGBA8 交错图像重采样
+ */
+void resampleRgba8(const uint8_t* src, size_t srcStride,
+                   uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, size_t dstStride,
+                   const AxisWeights& wx, const AxisWeights& wy, uint32_t maxThreads) {
+    const size_t rowFloats = static_cast<size_t>(dstWidth) * 4;
+
+    forEachChunk(dstHeight, maxThreads,
+        [&](uint32_t y0, uint32_t y1, std::vector<float>& tmp) {
+            const uint32_t r0 = wy.start[y0];
+            const uint32_t r1 = wy.start[y1 - 1] + wy.taps;
+            // 水平滤波结果 + 一行垂直累加缓冲
+            tmp.resize(static_cast<size_t>(r1 - r0 + 1) * rowFloats);
+            float* acc = &tmp[static_cast<size_t>(r1 - r0) * rowFloats];
+
+            for (uint32_t r = r0; r < r1; ++r) {
+                const uint8_t* row = src + static_cast<size_t>(r) * srcStride;
+                float* out = &tmp[static_cast<size_t>(r - r0) * rowFloats];
+                for (uint32_t x = 0; x < dstWidth; ++x) {
+                    const uint8_t* pixels = row + static_cast<size_t>(wx.start[x]) * 4;
+                    const float* w = &wx.weights[static_cast<size_t>(x) * wx.taps];
+#ifdef __ARM_NEON
+                    float32x4_t sum = vdupq_n_f32(0.0f);
+                    for (uint32_t k = 0; k < wx.taps; ++k) {
+                        uint32_t packed;
+                        std::memcpy(&packed, pixels + k * 4, 4);
+                        const uint16x4_t wide = vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(packed))));
+                        sum = vmlaq_n_f32(sum, vcvtq_f32_u32(vmovl_u16(wide)), w[k]);
+                    }
+                    vst1q_f32(out + x * 4, sum);
+#else
+                    float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                    for (uint32_t k = 0; k < wx.taps; ++k) {
+                        accumulatePixel(sum, pixels + k * 4, w[k]);
+                    }
+                    std::memcpy(out + x * 4, sum, sizeof(sum));
+#endif
+                }
+            }
+
+            for (uint32_t y = y0; y < y1; ++y) {
+                const float* w = &wy.weights[static_cast<size_t>(y) * wy.taps];
+                const uint32_t base = wy.start[y] - r0;
+                for (uint32_t k = 0; k < wy.taps; ++k) {
+                    accumulateRow(acc, &tmp[static_cast<size_t>(base + k) * rowFloats], w[k], rowFloats, k == 0);
+                }
+                uint8_t* out = dst + static_cast<size_t>(y) * dstStride;
+                for (size_t i = 0; i < rowFloats; ++i) {
+                    const float v = std::min(std::max(acc[i] + 0.5f, 0.0f), 255.0f);
+                    out[i] = static_cast<uint8_t>(v);
+                }
+            }
+        });
+}
+
+/**
+ * 缩放结果的来源标识：源图像来源 + 输出尺寸和重采样方式（源匿名时结果也匿名）
+ */
+uint64_t resampledProvenance(const LinearImage& src, uint32_t width, uint32_t height, uint32_t mode) {
+    const uint32_t stage[4] = {2u, width, height, mode};   // 首项为阶段标记
+    return deriveProvenance(src.provenance, stage, sizeof(stage));
+}
+
+} // namespace
+
+void ImageResampler::resize(const LinearImage& src,
+                            LinearImage& dst,
+                            ResampleFilter filter,
+                            uint32_t maxThreads) {
+    if (src.width == 0 || src.height == 0 || dst.width == 0 || dst.height == 0) {
+        LOGE("resize: Invalid size %ux%u -> %ux%u", src.width, src.height, dst.width, dst.height);
+        return;
+    }
+    const size_t pixelCount = static_cast<size_t>(dst.width) * dst.height;
+    dst.r.resize(pixelCount);
+    dst.g.resize(pixelCount);
+    dst.b.resize(pixelCount);
+
+    if (src.width == dst.width && src.height == dst.height) {
+        dst.r = src.r;
+        dst.g = src.g;
+        dst.b = src.b;
+        dst.provenance = src.provenance;
+        return;
+    }
+    dst.provenance = resampledProvenance(src, dst.width, dst.height, static_cast<uint32_t>(filter));
+
+    const AxisWeights wx = buildWeights(src.width, dst.width, filter);
+    const AxisWeights wy = buildWeights(src.height, dst.height, filter);
+    const float* srcPlanes[3] = {src.r.data(), src.g.data(), src.b.data()};
+    float* dstPlanes[3] = {dst.r.data(), dst.g.data(), dst.b.data()};
+    resamplePlanar(srcPlanes, src.width, dstPlanes, dst.width, dst.height, wx, wy, maxThreads);
+}
+
+LinearImage ImageResampler::resize(const LinearImage& src,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   ResampleFilter filter,
+                                   uint32_t maxThreads) {
+    LinearImage dst(width, height);
+    resize(src, dst, filter, maxThreads);
+    return dst;
+}
+
+void ImageResampler::resizeRgba8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcStride,
+                                 uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, size_t dstStride,
+                                 ResampleFilter filter,
+                                 uint32_t maxThreads) {
+    if (!src || !dst || srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0) {
+        LOGE("resizeRgba8: Invalid arguments %ux%u -> %ux%u", srcWidth, srcHeight, dstWidth, dstHeight);
+        return;
+    }
+
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        for (uint32_t y = 0; y < dstHeight; ++y) {
+            std::memcpy(dst + y * dstStride, src + y * srcStride, static_cast<size_t>(dstWidth) * 4);
+        }
+        return;
+    }
+
+    const AxisWeights wx = buildWeights(srcWidth, dstWidth, filter);
+    const AxisWeights wy = buildWeights(srcHeight, dstHeight, filter);
+    resampleRgba8(src, srcStride, dst, dstWidth, dstHeight, dstStride, wx, wy, maxThreads);
+}
+
+void ImageResampler::downsampleBlocks(const LinearImage& input,
+                                      LinearImage& output,
+                                      uint32_t factor,
+                                      uint32_t maxThreads) {
+    factor = std::max(factor, 1u);
+    const uint32_t outputWidth = (input.width + factor - 1) / factor;
+    const uint32_t outputHeight = (input.height + factor - 1) / factor;
+    if (output.width != outputWidth || output.height != outputHeight) {
+        output = LinearImage(outputWidth, outputHeight);
+    }
+    if (outputWidth == 0 || outputHeight == 0) {
+        return;
+    }
+    output.provenance = resampledProvenance(input, outputWidth, outputHeight, 0x100u + factor);
+
+    const AxisWeights wx = buildBlockWeights(input.width, factor);
+    const AxisWeights wy = buildBlockWeights(input.height, factor);
+    const float* srcPlanes[3] = {input.r.data(), input.g.data(), input.b.data()};
+    float* dstPlanes[3] = {output.r.data(), output.g.data(), output.b.data()};
+    resamplePlanar(srcPlanes, input.width, dstPlanes, outputWidth, outputHeight, wx, wy, maxThreads);
+}
+
+void ImageResampler::fitSize(uint32_t width, uint32_t height, uint32_t maxEdge,
+                             uint32_t& outWidth, uint32_t& outHeight) {
+    const uint32_t longEdge = std::max(width, height);
+    if (maxEdge == 0 || longEdge <= maxEdge) {
+        outWidth = width;
+        outHeight = height;
+        return;
+    }
+    const double scale = static_cast<double>(maxEdge) / longEdge;
+    outWidth = std::max(1u, static_cast<uint32_t>(std::lround(width * scale)));
+    outHeight = std::max(1u, static_cast<uint32_t>(std::lround(height * scale)));
+}
+
+} // namespace filmtracker
@@ -0,0 +1,193 @@
+#include "memory_governor.h"
+#include <algorithm>
+#include <android/log.h>
+
+#define LOG_TAG "MemoryGovernor"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+// 超出预算时依次尝试的级别
+const TrimLevel kBudgetTrimLevels[] = {
+    TrimLevel::RUNNING_MODERATE,
+    TrimLevel::RUNNING_LOW,
+    TrimLevel::RUNNING_CRITICAL
+};
+
+const char* const kCategoryNames[kMemoryCategoryCount] = {
+    "images", "caches", "scratch", "gpuStaging"
+};
+
+} // namespace
+
+MemoryGovernor& MemoryGovernor::getInstance() {
+    // 不析构：其他单例（渲染管线的工作图像等）在退出析构时仍会释放登记
+    static MemoryGovernor* instance = new MemoryGovernor();
+    return *instance;
+}
+
+void MemoryGovernor::charge(MemoryCategory category, size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    const size_t index = static_cast<size_t>(category);
+    const size_t current = m_current[index].fetch_add(bytes) + bytes;
+    m_charges[index]++;
+
+    size_t peak = m_peak[index].load();
+    while (current > peak && !m_peak[index].compare_exchange_weak(peak, current)) {
+    }
+}
+
+void MemoryGovernor::release(MemoryCategory category, size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    const size_t index = static_cast<size_t>(category);
+    size_t current = m_current[index].load();
+    size_t next;
+    do {
+        // 登记不对称时截断为 0，不让计数下溢
+        next = current > bytes ? current - bytes : 0;
+    } while (!m_current[index].compare_exchange_weak(current, next));
+}
+
+size_t MemoryGovernor::usage(MemoryCategory category) const {
+    return m_current[static_cast<size_t>(category)];
+}
+
+size_t MemoryGovernor::totalUsage() const {
+    size_t total = 0;
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        total += m_current[i];
+    }
+    return total;
+}
+
+void MemoryGovernor::setBudgetMB(size_t budgetMB) {
+    m_budgetBytes = budgetMB * 1024 * 1024;
+    LOGI("setBudgetMB: %zu MB (current usage %zu MB)", budgetMB, totalUsage() / (1024 * 1024));
+}
+
+size_t MemoryGovernor::budgetBytes() const {
+    return m_budgetBytes;
+}
+
+bool MemoryGovernor::isOverBudget() const {
+    const size_t budget = m_budgetBytes;
+    return budget > 0 && totalUsage() > budget;
+}
+
+int MemoryGovernor::registerTrimHandler(const std::string& name, TrimHandler handler) {
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    const int id = m_nextHandlerId++;
+    m_handlers.push_back({id, name, std::move(handler)});
+    return id;
+}
+
+void MemoryGovernor::unregisterTrimHandler(int id) {
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    m_handlers.erase(std::remove_if(m_handlers.begin(), m_handlers.end(),
+                                    [id](const HandlerEntry& entry) { return entry.id == id; }),
+                     m_handlers.end());
+}
+
+size_t MemoryGovernor::runHandlers(TrimLevel level) {
+    std::vector<HandlerEntry> handlers;
+    {
+        std::lock_guard<std::mutex> lock(m_handlerMutex);
+        handlers = m_handlers;
+    }
+
+    size_t released = 0;
+    for (const auto& entry : handlers) {
+        const size_t bytes = entry.handler(level);
+        if (bytes > 0) {
+            LOGI("trim(%d): %s released %zu KB", static_cast<int>(level), entry.name.c_str(), bytes / 1024);
+        }
+        released += bytes;
+    }
+
+    m_trims++;
+    m_bytesTrimmed += released;
+    m_lastTrimLevel = static_cast<int>(level);
+    return released;
+}
+
+size_t MemoryGovernor::trim(TrimLevel level) {
+    if (level == TrimLevel::NONE) {
+        return 0;
+    }
+    const size_t before = totalUsage();
+    const size_t released = runHandlers(level);
+    LOGI("trim(%d): %zu MB -> %zu MB", static_cast<int>(level),
+         before / (1024 * 1024), totalUsage() / (1024 * 1024));
+    return released;
+}
+
+size_t MemoryGovernor::enforceBudget() {
+    if (!isOverBudget()) {
+        return 0;
+    }
+    // 回调释放内存时可能再次触发检查，只允许一个线程执行
+    bool expected = false;
+    if (!m_enforcing.compare_exchange_strong(expected, true)) {
+        return 0;
+    }
+
+    size_t released = 0;
+    for (TrimLevel level : kBudgetTrimLevels) {
+        const size_t total = totalUsage();
+        const size_t budget = budgetBytes();
+        if (budget == 0 || total <= budget) {
+            break;
+        }
+        // 句柄持有的图像不会被回调释放；可回收的部分已不足以抵消超出量时不再升级，
+        // 否则只会白白清空缓存
+        const size_t images = usage(MemoryCategory::IMAGES);
+        const size_t trimmable = total - std::min(total, images);
+        if (total - budget > trimmable) {
+            LOGW("enforceBudget: Overage %zu MB exceeds trimmable %zu MB (images %zu MB), stop at level %d",
+                 (total - budget) / (1024 * 1024), trimmable / (1024 * 1024),
+                 images / (1024 * 1024), static_cast<int>(level));
+            break;
+        }
+        m_budgetTrims++;
+        released += runHandlers(level);
+    }
+    if (isOverBudget()) {
+        LOGW("enforceBudget: Still over budget after trimming (%zu MB / %zu MB)",
+             totalUsage() / (1024 * 1024), budgetBytes() / (1024 * 1024));
+    }
+
+    m_enforcing = false;
+    return released;
+}
+
+MemoryGovernor::Stats MemoryGovernor::getStats() const {
+    Stats stats;
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        stats.categories[i].currentBytes = m_current[i];
+        stats.categories[i].peakBytes = m_peak[i];
+        stats.categories[i].charges = m_charges[i];
+        stats.totalBytes += stats.categories[i].currentBytes;
+    }
+    stats.budgetBytes = m_budgetBytes;
+    stats.trims = m_trims;
+    stats.budgetTrims = m_budgetTrims;
+    stats.bytesTrimmed = m_bytesTrimmed;
+    stats.lastTrimLevel = m_lastTrimLevel;
+    return stats;
+}
+
+void MemoryGovernor::resetPeaks() {
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        m_peak[i] = m_current[i].load();
+        LOGI("resetPeaks: %s %zu KB", kCategoryNames[i], m_current[i].load() / 1024);
+    }
+}
+
+} // namespace filmtracker
@@ -0,0 +1,232 @@
+#ifndef FILMTRACKER_MEMORY_GOVERNOR_H
+#define FILMTRACKER_MEMORY_GOVERNOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 内存分类
+ */
+enum class MemoryCategory {
+    IMAGES = 0,        // 交给 Kotlin 的 LinearImage 句柄
+    CACHES = 1,        // ImageHashCache、溢出写入队列、缩略图内存缓存
+    SCRATCH = 2,       // 渲染工作图像、细节层等阶段临时缓冲区
+    GPU_STAGING = 3    // Vulkan 主机可见的输入 / 输出缓冲区
+};
+
+constexpr size_t kMemoryCategoryCount = 4;
+
+/**
+ * 回收级别（数值与 Android ComponentCallbacks2 的 TRIM_MEMORY_* 常量一致，可直接转发 onTrimMemory）
+ */
+enum class TrimLevel : int {
+    NONE = 0,
+    RUNNING_MODERATE = 5,
+    RUNNING_LOW = 10,
+    RUNNING_CRITICAL = 15,
+    UI_HIDDEN = 20,
+    BACKGROUND = 40,
+    MODERATE = 60,
+    COMPLETE = 80
+};
+
+/**
+ * Native 内存预算管理
+ *
+ * 各模块按分类登记自己持有的大块内存（charge / release 或 MemoryCharge），
+ * 总量对照可配置的预算。缓存和池注册回收回调，按回收级别释放内存：
+ * - 系统 onTrimMemory 通过 trim(level) 转发给所有回调
+ * - 登记后总量超出预算时，调用方在不持有自身锁的位置调用 enforceBudget()，
+ *   从 RUNNING_MODERATE 起逐级回收，直到回到预算内；超出量大于可回收部分
+ *   （IMAGES 之外的分类）时不再升级，句柄持有的图像回调释放不了
+ *
+ * 计数都是原子操作，charge / release 可以在任意线程和锁内调用；回调在锁外执行。
+ */
+class MemoryGovernor {
+public:
+    /**
+     * 回收回调
+     *
+     * @return 释放的字节数（估计值，用于统计）
+     */
+    using TrimHandler = std::function<size_t(TrimLevel level)>;
+
+    /**
+     * 单个分类的用量
+     */
+    struct CategoryUsage {
+        uint64_t currentBytes = 0;
+        uint64_t peakBytes = 0;
+        uint64_t charges = 0;       // 登记次数
+    };
+
+    /**
+     * 统计
+     */
+    struct Stats {
+        CategoryUsage categories[kMemoryCategoryCount];
+        uint64_t totalBytes = 0;
+        uint64_t budgetBytes = 0;
+        uint64_t trims = 0;             // 执行回收的次数（含超预算触发）
+        uint64_t budgetTrims = 0;       // 其中由超预算触发的次数
+        uint64_t bytesTrimmed = 0;
+        int lastTrimLevel = 0;
+    };
+
+    /**
+     * 获取单例
+     */
+    static MemoryGovernor& getInstance();
+
+    /**
+     * 登记 / 释放内存
+     */
+    void charge(MemoryCategory category, size_t bytes);
+    void release(MemoryCategory category, size_t bytes);
+
+    /**
+     * 当前用量
+     */
+    size_t usage(MemoryCategory category) const;
+    size_t totalUsage() const;
+
+    /**
+     * 预算（0 表示不限制）
+     */
+    void setBudgetMB(size_t budgetMB);
+    size_t budgetBytes() const;
+
+    /**
+     * 是否超出预算
+     */
+    bool isOverBudget() const;
+
+    /**
+     * 注册回收回调
+     *
+     * @param name 名称（日志用）
+     * @param handler 回调
+     * @return 回调 ID
+     */
+    int registerTrimHandler(const std::string& name, TrimHandler handler);
+    void unregisterTrimHandler(int id);
+
+    /**
+     * 按级别回收（转发 onTrimMemory）
+     *
+     * @return 释放的字节数
+     */
+    size_t trim(TrimLevel level);
+
+    /**
+     * 超出预算时逐级回收
+     *
+     * 不得在持有会被回收回调获取的锁时调用
+     *
+     * @return 释放的字节数
+     */
+    size_t enforceBudget();
+
+    /**
+     * 获取统计
+     */
+    Stats getStats() const;
+    void resetPeaks();
+
+private:
+    MemoryGovernor() = default;
+    ~MemoryGovernor() = default;
+
+    // 禁止拷贝和赋值
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    struct HandlerEntry {
+        int id;
+        std::string name;
+        TrimHandler handler;
+    };
+
+    /**
+     * 依次调用所有回调（不持有 m_handlerMutex）
+     */
+    size_t runHandlers(TrimLevel level);
+
+    std::atomic<size_t> m_current[kMemoryCategoryCount] = {};
+    std::atomic<size_t> m_peak[kMemoryCategoryCount] = {};
+    std::atomic<uint64_t> m_charges[kMemoryCategoryCount] = {};
+    std::atomic<size_t> m_budgetBytes{1024ULL * 1024 * 1024};   // 1GB
+    std::atomic<bool> m_enforcing{false};
+
+    std::atomic<uint64_t> m_trims{0};
+    std::atomic<uint64_t> m_budgetTrims{0};
+    std::atomic<uint64_t> m_bytesTrimmed{0};
+    std::atomic<int> m_lastTrimLevel{0};
+
+    std::vector<HandlerEntry> m_handlers;
+    int m_nextHandlerId = 1;
+    mutable std::mutex m_handlerMutex;
+};
+
+/**
+ * 作用域内存登记（RAII），析构时释放
+ */
+class MemoryCharge {
+public:
+    MemoryCharge() = default;
+
+    MemoryCharge(MemoryCategory category, size_t bytes)
+        : m_category(category), m_bytes(bytes) {
+        MemoryGovernor::getInstance().charge(m_category, m_bytes);
+    }
+
+    ~MemoryCharge() { reset(0); }
+
+    MemoryCharge(MemoryCharge&& other) noexcept
+        : m_category(other.m_category), m_bytes(other.m_bytes) {
+        other.m_bytes = 0;
+    }
+
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept {
+        if (this != &other) {
+            reset(0);
+            m_category = other.m_category;
+            m_bytes = other.m_bytes;
+            other.m_bytes = 0;
+        }
+        return *this;
+    }
+
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    /**
+     * 改为登记 bytes（缓冲区扩容或释放时调用）
+     */
+    void reset(size_t bytes) {
+        MemoryGovernor& governor = MemoryGovernor::getInstance();
+        if (bytes > m_bytes) {
+            governor.charge(m_category, bytes - m_bytes);
+        } else if (bytes < m_bytes) {
+            governor.release(m_category, m_bytes - bytes);
+        }
+        m_bytes = bytes;
+    }
+
+    size_t bytes() const { return m_bytes; }
+
+private:
+    MemoryCategory m_category = MemoryCategory::SCRATCH;
+    size_t m_bytes = 0;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_MEMORY_GOVERNOR_H
@@ -39,6 +39,9 @@ void ParallelProcessor::process(
     int height = input.height;
     int rowsPerThread = height / numThreads;
     
+    // 这里的调整不经过 ImageProcessorEngine，输出视为匿名缓冲区
+    output.provenance = 0;
+    
     std::vector<std::thread> threads;
     threads.reserve(numThreads);
     
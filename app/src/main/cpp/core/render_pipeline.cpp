@@ -0,0 +1,282 @@
+#include "render_pipeline.h"
+#include "image_converter.h"
+#include "image_resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <android/log.h>
+
+#define LOG_TAG "RenderPipeline"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+/**
+ * 打包参数顺序读取（越界后所有读取失败）
+ */
+class ParamsReader {
+public:
+    ParamsReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    bool readU32(uint32_t& value) {
+        if (m_offset + 4 > m_size) {
+            return false;
+        }
+        std::memcpy(&value, m_data + m_offset, 4);
+        m_offset += 4;
+        return true;
+    }
+
+    bool readFloats(float* values, size_t count) {
+        if (m_offset + count * 4 > m_size) {
+            return false;
+        }
+        std::memcpy(values, m_data + m_offset, count * 4);
+        m_offset += count * 4;
+        return true;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+bool RenderPipeline::unpackParams(const uint8_t* data, size_t size,
+                                  BasicAdjustmentParams& params, uint32_t& flags) {
+    if (!data || size < RenderParamsLayout::kHeaderBytes) {
+        LOGE("unpackParams: Buffer too small (%zu bytes)", size);
+        return false;
+    }
+
+    uint32_t header[4];
+    std::memcpy(header, data, sizeof(header));
+    const uint32_t magic = header[0];
+    const uint32_t version = header[1];
+    const uint32_t totalSize = header[2];
+    if (magic != RenderParamsLayout::kMagic) {
+        LOGE("unpackParams: Bad magic 0x%08x", magic);
+        return false;
+    }
+    if (version == 0 || version > RenderParamsLayout::kVersion) {
+        LOGE("unpackParams: Unsupported version %u", version);
+        return false;
+    }
+    if (totalSize < RenderParamsLayout::kHeaderBytes || totalSize > size) {
+        LOGE("unpackParams: Declared size %u invalid for buffer size %zu", totalSize, size);
+        return false;
+    }
+    flags = header[3];
+    ParamsReader reader(data + RenderParamsLayout::kHeaderBytes,
+                        totalSize - RenderParamsLayout::kHeaderBytes);
+
+    // 标量（与 BasicAdjustmentParams 字段顺序一致）
+    float* scalars[RenderParamsLayout::kScalarCount] = {
+        &params.globalExposure, &params.contrast, &params.saturation,
+        &params.highlights, &params.shadows, &params.whites, &params.blacks,
+        &params.clarity, &params.vibrance,
+        &params.temperature, &params.tint,
+        &params.gradingHighlightsTemp, &params.gradingHighlightsTint,
+        &params.gradingMidtonesTemp, &params.gradingMidtonesTint,
+        &params.gradingShadowsTemp, &params.gradingShadowsTint,
+        &params.gradingBlending, &params.gradingBalance,
+        &params.texture, &params.dehaze, &params.vignette, &params.grain,
+        &params.sharpening, &params.noiseReduction
+    };
+    float values[RenderParamsLayout::kScalarCount];
+    if (!reader.readFloats(values, RenderParamsLayout::kScalarCount)) {
+        LOGE("unpackParams: Truncated scalar block");
+        return false;
+    }
+    for (uint32_t i = 0; i < RenderParamsLayout::kScalarCount; ++i) {
+        *scalars[i] = values[i];
+    }
+
+    // HSL
+    uint32_t hslEnabled = 0;
+    if (!reader.readU32(hslEnabled)) {
+        LOGE("unpackParams: Truncated HSL block");
+        return false;
+    }
+    if (!params.hslParams) {
+        params.hslParams = new HSLParams();
+    }
+    if (!reader.readFloats(params.hslParams->hueShift, 8) ||
+        !reader.readFloats(params.hslParams->saturation, 8) ||
+        !reader.readFloats(params.hslParams->luminance, 8)) {
+        LOGE("unpackParams: Truncated HSL block");
+        params.hslParams->enableHSL = false;
+        return false;
+    }
+    params.hslParams->enableHSL = hslEnabled != 0;
+
+    // 曲线
+    if (!params.curveParams) {
+        params.curveParams = new ToneCurveParams();
+    }
+    ToneCurveParams::CurveData* curves[4] = {
+        &params.curveParams->rgbCurve,
+        &params.curveParams->redCurve,
+        &params.curveParams->greenCurve,
+        &params.curveParams->blueCurve
+    };
+    std::vector<float> xs;
+    std::vector<float> ys;
+    for (ToneCurveParams::CurveData* curve : curves) {
+        uint32_t enabled = 0;
+        uint32_t count = 0;
+        if (!reader.readU32(enabled) || !reader.readU32(count) ||
+            count > RenderParamsLayout::kMaxCurvePoints) {
+            LOGE("unpackParams: Invalid curve block");
+            return false;
+        }
+        xs.resize(count);
+        ys.resize(count);
+        if (!reader.readFloats(xs.data(), count) || !reader.readFloats(ys.data(), count)) {
+            LOGE("unpackParams: Truncated curve points");
+            return false;
+        }
+        curve->setPoints(static_cast<int>(count), xs.data(), ys.data());
+        curve->enabled = enabled != 0 && count > 0;
+    }
+    return true;
+}
+
+bool RenderPipeline::render(const LinearImage& view,
+                            const BasicAdjustmentParams& params,
+                            const RenderBuffer& output,
+                            uint32_t flags) {
+    if (view.width == 0 || view.height == 0 || !output.pixels ||
+        output.width == 0 || output.height == 0 ||
+        output.stride < static_cast<size_t>(output.width) * ImageConverter::bytesPerPixel(output.format)) {
+        LOGE("render: Invalid arguments %ux%u -> %ux%u (stride=%zu)",
+             view.width, view.height, output.width, output.height, output.stride);
+        return false;
+    }
+
+    // 在加锁前回收
+    MemoryGovernor::getInstance().enforceBudget();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 1. 源图像 -> 工作图像（同尺寸时只是复制，已分配的内存在多次渲染之间复用）
+    m_working.width = output.width;
+    m_working.height = output.height;
+    const bool shrinking = output.width <= view.width && output.height <= view.height;
+    ImageResampler::resize(view, m_working,
+                           shrinking ? ResampleFilter::BOX : ResampleFilter::BICUBIC);
+    m_workingCharge.reset(m_working.r.capacity() * 3 * sizeof(float));
+    const double prepareMs = elapsedMs(startTime);
+
+    // 2. 调整
+    auto adjustStart = std::chrono::steady_clock::now();
+    m_engine.applyAll(m_working, params);
+    const double adjustMs = elapsedMs(adjustStart);
+
+    // 3. sRGB 编码直接写入输出缓冲区
+    auto outputStart = std::chrono::steady_clock::now();
+    if ((flags & RENDER_FLAG_DITHER) && output.format == OutputPixelFormat::RGBA_8888) {
+        ImageConverter::linearToSRGBDithered(m_working, output.pixels, output.stride, true);
+    } else {
+        // 高位深输出没有抖动，只保留软裁剪；fp16 保持线性高光
+        const bool softClip = (flags & RENDER_FLAG_DITHER) && output.format != OutputPixelFormat::RGBA_F16;
+        ImageConverter::writePixels(m_working, output.format, output.pixels, output.stride, softClip);
+    }
+    const double outputMs = elapsedMs(outputStart);
+
+    m_stats.renders++;
+    m_stats.prepareMs = prepareMs;
+    m_stats.adjustMs = adjustMs;
+    m_stats.outputMs = outputMs;
+    m_stats.totalMs = elapsedMs(startTime);
+
+    LOGI("render: %ux%u -> %ux%u, prepare=%.1fms, adjust=%.1fms, output=%.1fms, flags=0x%x",
+         view.width, view.height, output.width, output.height,
+         prepareMs, adjustMs, outputMs, flags);
+    return true;
+}
+
+RenderPipeline::Stats RenderPipeline::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+size_t RenderPipeline::trimMemory() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t released = m_workingCharge.bytes();
+    m_working = LinearImage(0, 0);
+    m_workingCharge.reset(0);
+    return released;
+}
+
+RenderPipelinePool& RenderPipelinePool::getInstance() {
+    static RenderPipelinePool instance;
+    // 空闲管线的工作图像在下一次渲染时重新分配，RUNNING_CRITICAL 及界面隐藏后释放
+    static const int trimHandlerId = MemoryGovernor::getInstance().registerTrimHandler(
+        "RenderPipeline", [](TrimLevel level) -> size_t {
+            return level >= TrimLevel::RUNNING_CRITICAL ? instance.trimMemory() : 0;
+        });
+    (void)trimHandlerId;
+    return instance;
+}
+
+bool RenderPipelinePool::render(const LinearImage& view,
+                                const BasicAdjustmentParams& params,
+                                const RenderBuffer& output,
+                                uint32_t flags) {
+    std::unique_ptr<RenderPipeline> pipeline;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idle.empty()) {
+            pipeline = std::move(m_idle.back());
+            m_idle.pop_back();
+        }
+    }
+    if (!pipeline) {
+        pipeline.reset(new RenderPipeline());
+    }
+
+    const bool success = pipeline->render(view, params, output, flags);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (success) {
+        const uint64_t renders = m_lastStats.renders + 1;
+        m_lastStats = pipeline->getStats();
+        m_lastStats.renders = renders;
+    }
+    if (m_idle.size() < kMaxIdlePipelines) {
+        m_idle.push_back(std::move(pipeline));
+    }
+    return success;
+}
+
+RenderPipeline::Stats RenderPipelinePool::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastStats;
+}
+
+size_t RenderPipelinePool::trimMemory() {
+    std::vector<std::unique_ptr<RenderPipeline>> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        idle.swap(m_idle);
+    }
+    size_t released = 0;
+    for (auto& pipeline : idle) {
+        released += pipeline->trimMemory();
+    }
+    return released;
+}
+
+} // namespace filmtracker
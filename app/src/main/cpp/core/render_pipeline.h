@@ -0,0 +1,174 @@
+#ifndef FILMTRACKER_RENDER_PIPELINE_H
+#define FILMTRACKER_RENDER_PIPELINE_H
+
+#include "raw_types.h"
+#include "basic_adjustment_params.h"
+#include "image_processor_engine.h"
+#include "image_converter.h"
+#include "memory_governor.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 打包参数布局（小端，所有字段 4 字节）
+ *
+ * 头部 16 字节：magic 'FTRP' | version | totalSize（字节）| flags（RenderFlags）
+ * 标量：kScalarCount 个 float，顺序与 BasicAdjustmentParams 的字段一致
+ *       （globalExposure ... noiseReduction，对比度、饱和度为乘数）
+ * HSL：enable(uint32) | hueShift[8] | saturation[8] | luminance[8]
+ * 曲线：RGB、R、G、B 依次为 enabled(uint32) | count(uint32) | x[count] | y[count]
+ *
+ * 增加字段时提升 kVersion，旧版本的缓冲区仍按旧布局解析
+ */
+struct RenderParamsLayout {
+    static constexpr uint32_t kMagic = 0x50525446;   // "FTRP"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kHeaderBytes = 16;
+    static constexpr uint32_t kScalarCount = 25;
+    static constexpr uint32_t kMaxCurvePoints = 256;
+};
+
+/**
+ * 渲染选项标志
+ */
+enum RenderFlags : uint32_t {
+    RENDER_FLAG_DITHER = 1u << 0   // 软裁剪 + 误差扩散抖动输出（导出用，较慢）；
+                                   // RGBA_16 / RGBA_1010102 只做软裁剪，RGBA_F16 不受影响
+};
+
+/**
+ * 渲染输出缓冲区（不持有内存）
+ */
+struct RenderBuffer {
+    uint8_t* pixels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t stride = 0;      // 行字节数，至少 width * 每像素字节数
+    OutputPixelFormat format = OutputPixelFormat::RGBA_8888;
+};
+
+/**
+ * 单次调用的完整渲染管线
+ *
+ * 源图像 -> （尺寸不同时重采样到输出尺寸）-> 全部调整 -> sRGB 编码直接写入输出缓冲区。
+ * 替代 Java 层逐个设置参数、逐个阶段调用再复制 jbyteArray 的流程：
+ * 参数以打包缓冲区一次传入，中间结果只在 Native 层，工作图像在多次渲染之间复用。
+ *
+ * 每个实例持有自己的工作图像，同一实例的 render 串行执行；并发调用方各用一个实例
+ * （JNI 通过 RenderPipelinePool 分配）。
+ * 不依赖 JNI，可以直接在桌面环境调用 render 做基准测试。
+ */
+class RenderPipeline {
+public:
+    /**
+     * 单次渲染耗时统计
+     */
+    struct Stats {
+        uint64_t renders = 0;
+        double prepareMs = 0.0;     // 复制 / 重采样到工作图像
+        double adjustMs = 0.0;      // 调整管线
+        double outputMs = 0.0;      // sRGB 编码写出
+        double totalMs = 0.0;
+    };
+
+    RenderPipeline() = default;
+
+    /**
+     * 解析打包参数
+     *
+     * @param data 参数缓冲区
+     * @param size 缓冲区字节数
+     * @param params 输出参数（曲线和 HSL 按需分配）
+     * @param flags 输出渲染标志
+     * @return 魔数、版本或长度不符时返回 false
+     */
+    static bool unpackParams(const uint8_t* data, size_t size,
+                             BasicAdjustmentParams& params, uint32_t& flags);
+
+    /**
+     * 渲染
+     *
+     * @param view 源线性图像（不修改）
+     * @param params 调整参数
+     * @param output 输出缓冲区，尺寸与源图像不同时先把源图像重采样到输出尺寸
+     * @param flags RenderFlags 组合
+     */
+    bool render(const LinearImage& view,
+                const BasicAdjustmentParams& params,
+                const RenderBuffer& output,
+                uint32_t flags = 0);
+
+    /**
+     * 最近一次渲染的统计
+     */
+    Stats getStats() const;
+
+    /**
+     * 释放工作图像（内存紧张时调用）
+     *
+     * @return 释放的字节数
+     */
+    size_t trimMemory();
+
+private:
+    RenderPipeline(const RenderPipeline&) = delete;
+    RenderPipeline& operator=(const RenderPipeline&) = delete;
+
+    ImageProcessorEngine m_engine;
+    LinearImage m_working{0, 0};
+    MemoryCharge m_workingCharge{MemoryCategory::SCRATCH, 0};
+    Stats m_stats;
+    mutable std::mutex m_mutex;
+};
+
+/**
+ * 渲染管线池（JNI 使用）
+ *
+ * 每次渲染取一个空闲管线（没有时新建），渲染结束后放回，预览和导出等并发调用
+ * 各用各的工作图像，不再互相等待。最多保留 kMaxIdlePipelines 个空闲管线，
+ * 回收只释放空闲管线，正在渲染的管线不受影响（回收回调在渲染线程内触发时也不会重入）。
+ */
+class RenderPipelinePool {
+public:
+    static RenderPipelinePool& getInstance();
+
+    /**
+     * 渲染（参数同 RenderPipeline::render）
+     */
+    bool render(const LinearImage& view,
+                const BasicAdjustmentParams& params,
+                const RenderBuffer& output,
+                uint32_t flags = 0);
+
+    /**
+     * 最近一次完成的渲染的统计（renders 为池内累计次数）
+     */
+    RenderPipeline::Stats getStats() const;
+
+    /**
+     * 释放空闲管线
+     *
+     * @return 释放的字节数
+     */
+    size_t trimMemory();
+
+private:
+    RenderPipelinePool() = default;
+    RenderPipelinePool(const RenderPipelinePool&) = delete;
+    RenderPipelinePool& operator=(const RenderPipelinePool&) = delete;
+
+    static constexpr size_t kMaxIdlePipelines = 2;
+
+    std::vector<std::unique_ptr<RenderPipeline>> m_idle;
+    RenderPipeline::Stats m_lastStats;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_RENDER_PIPELINE_H
@@ -0,0 +1,483 @@
+#include "result_spill_cache.h"
+#include "half_image_file.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <android/log.h>
+
+#define LOG_TAG "ResultSpillCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+const char* const kEntryExtension = ".fsc";
+const char* const kMarkerName = "spill.version";
+
+// 溢出文件格式版本：文件名或 StoredEntry 布局改变时递增，旧目录整体清空
+const uint32_t kSpillFormatVersion = 2;
+const uint32_t kMarkerMagic = 0x46535043;     // "FSPC"
+
+/**
+ * 写入文件头之后的自定义数据：完整的键（用于校验文件名碰撞）+ 结果的来源标识
+ */
+struct StoredEntry {
+    uint32_t formatVersion;
+    uint32_t reserved;
+    uint64_t imageHash;
+    uint64_t configHash;
+    int32_t spatialSigma;     // 量化后的 sigma
+    int32_t rangeSigma;
+    uint64_t provenance;
+};
+
+/**
+ * 目录标记：格式版本 + 目录中条目对应的结果配置哈希
+ */
+struct DirectoryMarker {
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint64_t configHash;
+};
+
+bool readMarker(const std::string& path, DirectoryMarker& marker) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = read(fd, &marker, sizeof(marker)) == static_cast<ssize_t>(sizeof(marker)) &&
+                    marker.magic == kMarkerMagic;
+    close(fd);
+    return ok;
+}
+
+bool writeMarker(const std::string& path, uint64_t configHash) {
+    const DirectoryMarker marker = {kMarkerMagic, kSpillFormatVersion, configHash};
+    const std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = write(fd, &marker, sizeof(marker)) == static_cast<ssize_t>(sizeof(marker));
+    close(fd);
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+static_assert(sizeof(StoredEntry) <= HalfImageFile::kMaxUserDataSize, "StoredEntry too large");
+
+bool keyMatches(const StoredEntry& stored, const ImageHashCache::HashKey& key) {
+    return stored.formatVersion == kSpillFormatVersion &&
+           stored.imageHash == key.imageHash &&
+           stored.configHash == key.configHash &&
+           stored.spatialSigma == ImageHashCache::HashKey::quantize(key.spatialSigma) &&
+           stored.rangeSigma == ImageHashCache::HashKey::quantize(key.rangeSigma);
+}
+
+size_t imageBytes(const LinearImage& image) {
+    return static_cast<size_t>(image.width) * image.height * 3 * sizeof(float);
+}
+
+} // namespace
+
+ResultSpillCache& ResultSpillCache::getInstance() {
+    static ResultSpillCache instance;
+    return instance;
+}
+
+ResultSpillCache::ResultSpillCache() {
+    MemoryGovernor::getInstance().registerTrimHandler(
+        "ResultSpillCache", [this](TrimLevel level) { return onTrimMemory(level); });
+}
+
+ResultSpillCache::~ResultSpillCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_queueCondition.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+bool ResultSpillCache::initialize(const std::string& cacheDir, size_t maxSizeMB) {
+    DiskCacheIndex index(maxSizeMB * 1024 * 1024);
+    if (!DiskCacheIndex::open(cacheDir, kEntryExtension, index)) {
+        return false;
+    }
+
+    // 格式版本不一致（或没有标记）的目录整体清空：旧条目的键和文件头都不再兼容
+    const std::string markerPath = index.pathOf(kMarkerName);
+    DirectoryMarker marker;
+    std::vector<std::string> evicted;
+    if (!readMarker(markerPath, marker) || marker.formatVersion != kSpillFormatVersion) {
+        evicted = index.clear();
+        marker.configHash = 0;
+        if (!writeMarker(markerPath, 0)) {
+            LOGE("initialize: Failed to write %s", markerPath.c_str());
+            return false;
+        }
+        LOGI("initialize: Spill format changed, %zu stale entries removed", evicted.size());
+    }
+
+    const size_t entryCount = index.size();
+    const size_t totalBytes = index.totalBytes();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index = std::move(index);
+        m_configHash = marker.configHash;
+        std::vector<std::string> overflow = collectEvictionsLocked();
+        evicted.insert(evicted.end(), overflow.begin(), overflow.end());
+        if (!m_writer.joinable()) {
+            m_writer = std::thread(&ResultSpillCache::writerLoop, this);
+        }
+    }
+    for (const auto& path : evicted) {
+        unlink(path.c_str());
+    }
+
+    LOGI("initialize: %s, %zu entries (%zu evicted), %zu MB / %zu MB",
+         cacheDir.c_str(), entryCount, evicted.size(), totalBytes / (1024 * 1024), maxSizeMB);
+    return true;
+}
+
+bool ResultSpillCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.isOpen() && m_index.maxBytes() > 0;
+}
+
+std::string ResultSpillCache::entryName(const ImageHashCache::HashKey& key) {
+    char name[72];
+    snprintf(name, sizeof(name), "%016" PRIx64 "-%016" PRIx64 "-%" PRIx32 "-%" PRIx32 "%s",
+             key.imageHash, key.configHash,
+             static_cast<uint32_t>(ImageHashCache::HashKey::quantize(key.spatialSigma)),
+             static_cast<uint32_t>(ImageHashCache::HashKey::quantize(key.rangeSigma)),
+             kEntryExtension);
+    return name;
+}
+
+void ResultSpillCache::spill(const ImageHashCache::HashKey& key, std::shared_ptr<const LinearImage> image) {
+    if (!image || image->width == 0 || image->height == 0) {
+        return;
+    }
+    const uint32_t width = image->width;
+    const uint32_t height = image->height;
+    const size_t bytes = imageBytes(*image);
+    enqueue({key, std::move(image), nullptr, bytes}, width, height);
+}
+
+void ResultSpillCache::spill(const ImageHashCache::HashKey& key, std::shared_ptr<const CompressedImage> compressed) {
+    if (!compressed || compressed->width() == 0 || compressed->height() == 0) {
+        return;
+    }
+    const uint32_t width = compressed->width();
+    const uint32_t height = compressed->height();
+    const size_t bytes = compressed->compressedBytes();
+    enqueue({key, nullptr, std::move(compressed), bytes}, width, height);
+}
+
+void ResultSpillCache::enqueue(PendingEntry entry, uint32_t width, uint32_t height) {
+    const std::string name = entryName(entry.key);
+    const size_t bytes = entry.bytes;
+
+    resetForConfig(entry.key.configHash);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_index.isOpen() || m_index.maxBytes() == 0 || m_stop) {
+            return;
+        }
+        if (m_index.contains(name)) {
+            // 内容由键决定，已在磁盘上的条目不重复写入
+            m_index.touch(name);
+            return;
+        }
+        if (m_pending.find(name) != m_pending.end()) {
+            return;
+        }
+        // 单个条目超过总容量时不溢出
+        if (HalfImageFile::fileSize(width, height) > m_index.maxBytes()) {
+            return;
+        }
+        if (m_pendingBytes + bytes > m_maxPendingBytes) {
+            m_stats.dropped++;
+            LOGW("spill: Write-behind queue full (%zu MB), entry dropped", m_pendingBytes / (1024 * 1024));
+            return;
+        }
+        // 先登记再发布：条目一进入队列，写入线程或内存回收就可能 release 这部分字节
+        MemoryGovernor::getInstance().charge(MemoryCategory::CACHES, bytes);
+        m_pending[name] = std::move(entry);
+        m_queue.push_back(name);
+        m_pendingBytes += bytes;
+    }
+    m_queueCondition.notify_one();
+}
+
+void ResultSpillCache::resetForConfig(uint64_t configHash) {
+    std::vector<std::string> paths;
+    size_t released = 0;
+    std::string markerPath;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_index.isOpen() || configHash == m_configHash) {
+            return;
+        }
+        released = clearLocked(paths);
+        m_configHash = configHash;
+        markerPath = m_index.pathOf(kMarkerName);
+    }
+    MemoryGovernor::getInstance().release(MemoryCategory::CACHES, released);
+    m_idleCondition.notify_all();
+    for (const auto& path : paths) {
+        unlink(path.c_str());
+    }
+    if (!writeMarker(markerPath, configHash)) {
+        LOGE("resetForConfig: Failed to write %s", markerPath.c_str());
+    }
+    LOGI("Result config changed, %zu stale spill entries removed", paths.size());
+}
+
+std::shared_ptr<const LinearImage> ResultSpillCache::find(const ImageHashCache::HashKey& key) {
+    const std::string name = entryName(key);
+    std::string path;
+    std::shared_ptr<const CompressedImage> pendingCompressed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_index.isOpen()) {
+            return nullptr;
+        }
+        // 仍在写入队列中：直接交出共享缓冲区（压缩条目在锁外解压）
+        auto pending = m_pending.find(name);
+        if (pending != m_pending.end()) {
+            m_stats.pendingHits++;
+            if (pending->second.image) {
+                return pending->second.image;
+            }
+            pendingCompressed = pending->second.compressed;
+        }
+        if (!pendingCompressed) {
+            if (!m_index.contains(name)) {
+                m_stats.misses++;
+                return nullptr;
+            }
+            path = m_index.pathOf(name);
+        }
+    }
+    if (pendingCompressed) {
+        return pendingCompressed->decompress();
+    }
+
+    // 文件 I/O 在锁外进行（mmap 映射后转换为 float）
+    StoredEntry stored;
+    std::shared_ptr<LinearImage> image = std::make_shared<LinearImage>(0, 0);
+    size_t bytesRead = 0;
+    HalfImageFile::ReadStatus status = HalfImageFile::readUserData(path, &stored, sizeof(stored));
+    if (status == HalfImageFile::ReadStatus::OK && !keyMatches(stored, key)) {
+        status = HalfImageFile::ReadStatus::INVALID;
+    }
+    if (status == HalfImageFile::ReadStatus::OK) {
+        status = HalfImageFile::read(path, *image, nullptr, sizeof(stored), &bytesRead);
+    }
+    if (status == HalfImageFile::ReadStatus::OK) {
+        image->provenance = stored.provenance;
+        // 更新 mtime，作为下次启动时的 LRU 依据
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (status == HalfImageFile::ReadStatus::OK) {
+        m_stats.hits++;
+        m_stats.bytesRead += bytesRead;
+        m_index.touch(name);
+        return image;
+    }
+
+    m_stats.misses++;
+    // 损坏或键不匹配的文件直接删除；打开 / 映射失败或内存不足只算未命中，条目保留
+    if (status == HalfImageFile::ReadStatus::INVALID) {
+        m_index.erase(name);
+        unlink(path.c_str());
+        LOGW("find: Invalid spill entry %s removed", name.c_str());
+    }
+    return nullptr;
+}
+
+void ResultSpillCache::writerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_queueCondition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+        if (m_stop) {
+            break;
+        }
+
+        const std::string name = m_queue.front();
+        m_queue.pop_front();
+        auto it = m_pending.find(name);
+        if (it == m_pending.end()) {
+            continue;
+        }
+        // 写入期间条目留在 m_pending 中，查找仍可命中
+        const PendingEntry entry = it->second;
+        m_writing = true;
+
+        lock.unlock();
+        writeEntry(name, entry);
+        lock.lock();
+
+        m_writing = false;
+        m_idleCondition.notify_all();
+    }
+}
+
+void ResultSpillCache::writeEntry(const std::string& name, const PendingEntry& entry) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        path = m_index.pathOf(name);
+    }
+
+    StoredEntry stored;
+    std::memset(&stored, 0, sizeof(stored));
+    stored.formatVersion = kSpillFormatVersion;
+    stored.imageHash = entry.key.imageHash;
+    stored.configHash = entry.key.configHash;
+    stored.spatialSigma = ImageHashCache::HashKey::quantize(entry.key.spatialSigma);
+    stored.rangeSigma = ImageHashCache::HashKey::quantize(entry.key.rangeSigma);
+    std::shared_ptr<const LinearImage> image = entry.image ? entry.image : entry.compressed->decompress();
+    stored.provenance = image->provenance;
+
+    const size_t bytesWritten = HalfImageFile::write(path, *image, &stored, sizeof(stored));
+
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto pending = m_pending.find(name);
+        const bool cleared = pending == m_pending.end() ||
+                             pending->second.image != entry.image ||
+                             pending->second.compressed != entry.compressed;
+        if (!cleared) {
+            m_pendingBytes -= std::min(m_pendingBytes, pending->second.bytes);
+            m_pending.erase(pending);
+            MemoryGovernor::getInstance().release(MemoryCategory::CACHES, entry.bytes);
+        }
+
+        if (bytesWritten == 0) {
+            m_stats.writeFailures++;
+            return;
+        }
+        if (cleared) {
+            // 写入期间调用了 clear()，丢弃刚写好的文件
+            evicted.push_back(path);
+        } else {
+            m_stats.writes++;
+            m_stats.bytesWritten += bytesWritten;
+            m_index.put(name, bytesWritten);
+            evicted = collectEvictionsLocked();
+        }
+    }
+    for (const auto& evictedPath : evicted) {
+        unlink(evictedPath.c_str());
+    }
+}
+
+void ResultSpillCache::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_writer.joinable()) {
+        return;
+    }
+    m_idleCondition.wait(lock, [this] { return m_stop || (m_queue.empty() && !m_writing); });
+}
+
+std::vector<std::string> ResultSpillCache::collectEvictionsLocked() {
+    std::vector<std::string> evicted = m_index.collectEvictions();
+    m_stats.evictions += evicted.size();
+    return evicted;
+}
+
+size_t ResultSpillCache::onTrimMemory(TrimLevel level) {
+    if (level < TrimLevel::RUNNING_CRITICAL || level == TrimLevel::UI_HIDDEN) {
+        return 0;
+    }
+
+    // 正在写入的条目保留，队列中其余条目直接丢弃
+    size_t released = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& name : m_queue) {
+            auto it = m_pending.find(name);
+            if (it != m_pending.end()) {
+                released += it->second.bytes;
+                m_pending.erase(it);
+                m_stats.dropped++;
+            }
+        }
+        m_queue.clear();
+        m_pendingBytes -= std::min(m_pendingBytes, released);
+    }
+    MemoryGovernor::getInstance().release(MemoryCategory::CACHES, released);
+    m_idleCondition.notify_all();
+    return released;
+}
+
+size_t ResultSpillCache::clearLocked(std::vector<std::string>& paths) {
+    paths = m_index.clear();
+    m_pending.clear();
+    m_queue.clear();
+    const size_t released = m_pendingBytes;
+    m_pendingBytes = 0;
+    return released;
+}
+
+void ResultSpillCache::clear() {
+    size_t released = 0;
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        released = clearLocked(paths);
+    }
+    MemoryGovernor::getInstance().release(MemoryCategory::CACHES, released);
+    m_idleCondition.notify_all();
+    for (const auto& path : paths) {
+        unlink(path.c_str());
+    }
+    LOGI("Spill cache cleared, %zu files removed", paths.size());
+}
+
+void ResultSpillCache::setMaxSizeMB(size_t maxSizeMB) {
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index.setMaxBytes(maxSizeMB * 1024 * 1024);
+        evicted = collectEvictionsLocked();
+    }
+    for (const auto& path : evicted) {
+        unlink(path.c_str());
+    }
+}
+
+void ResultSpillCache::setMaxPendingMB(size_t maxPendingMB) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxPendingBytes = maxPendingMB * 1024 * 1024;
+}
+
+ResultSpillCache::Stats ResultSpillCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.entryCount = m_index.size();
+    stats.totalBytes = m_index.totalBytes();
+    stats.pendingBytes = m_pendingBytes;
+    return stats;
+}
+
+} // namespace filmtracker
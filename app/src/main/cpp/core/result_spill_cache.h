@@ -0,0 +1,204 @@
+#ifndef FILMTRACKER_RESULT_SPILL_CACHE_H
+#define FILMTRACKER_RESULT_SPILL_CACHE_H
+
+#include "raw_types.h"
+#include "image_hash_cache.h"
+#include "memory_governor.h"
+#include "disk_cache_index.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace filmtracker {
+
+/**
+ * 结果缓存的磁盘溢出层
+ *
+ * ImageHashCache 驱逐的条目（双边滤波结果）不直接丢弃，而是以 fp16 平面格式
+ * （HalfImageFile，体积为 float 的一半）写入应用私有目录。内存层未命中时先查这里，
+ * 命中后通过 mmap 读取并放回内存层，回到之前的编辑状态时从闪存加载而不是重新计算。
+ *
+ * - 写入：后台线程异步写入（write-behind），驱逐路径只把共享缓冲区放进队列，不做 I/O；
+ *   排队中的条目可以直接从队列命中
+ * - 队列按字节数限制，写入跟不上时丢弃新的溢出条目，不会无限占用内存；
+ *   排队的缓冲区登记在 MemoryGovernor 的 CACHES 分类下，RUNNING_CRITICAL 及后台级别回收时丢弃尚未写入的条目
+ * - 键：ImageHashCache::HashKey（来源标识或内容哈希 + 量化的 sigma + 结果配置哈希），跨启动保持有效；
+ *   目录标记记录文件格式版本和条目的结果配置哈希，格式版本不符时初始化清空目录，
+ *   结果配置（或滤波实现版本）改变后第一次溢出时清空旧配置的条目
+ * - 容量：按总字节数限制，超出时按最近访问时间淘汰
+ *
+ * fp16 有约 3 位有效数字，读回的结果与原结果有半精度舍入误差（基础层用于细节提取，误差不可见）。
+ */
+class ResultSpillCache {
+public:
+    /**
+     * 溢出层统计
+     */
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t pendingHits = 0;      // 命中仍在写入队列中的条目
+        uint64_t misses = 0;
+        uint64_t writes = 0;
+        uint64_t writeFailures = 0;
+        uint64_t dropped = 0;          // 队列已满或内存回收时放弃的溢出
+        uint64_t evictions = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t entryCount = 0;
+        uint64_t totalBytes = 0;
+        uint64_t pendingBytes = 0;
+    };
+
+    /**
+     * 获取单例
+     */
+    static ResultSpillCache& getInstance();
+
+    /**
+     * 初始化溢出目录并启动写入线程
+     *
+     * 扫描已有文件建立索引，并清理崩溃残留的临时文件
+     *
+     * @param cacheDir 缓存目录（不存在时创建）
+     * @param maxSizeMB 最大磁盘占用（MB），0 表示禁用
+     * @return 是否成功
+     */
+    bool initialize(const std::string& cacheDir, size_t maxSizeMB);
+
+    /**
+     * 是否已初始化
+     */
+    bool isEnabled() const;
+
+    /**
+     * 溢出一个条目（异步写入，立即返回）
+     *
+     * 已在磁盘上的键只更新访问时间，不重复写入
+     *
+     * @param key 哈希键
+     * @param image 不可变的结果图像（写入完成前由队列持有）
+     */
+    void spill(const ImageHashCache::HashKey& key, std::shared_ptr<const LinearImage> image);
+    
+    /**
+     * 溢出一个压缩条目（写入线程解压后按 fp16 写盘，排队期间只占压缩后的内存）
+     */
+    void spill(const ImageHashCache::HashKey& key, std::shared_ptr<const CompressedImage> compressed);
+
+    /**
+     * 查找条目
+     *
+     * 先查写入队列，再 mmap 读取磁盘文件
+     *
+     * @return 图像，未命中时为 nullptr
+     */
+    std::shared_ptr<const LinearImage> find(const ImageHashCache::HashKey& key);
+
+    /**
+     * 等待写入队列清空
+     */
+    void flush();
+
+    /**
+     * 删除全部溢出文件（排队中的条目一并丢弃）
+     */
+    void clear();
+
+    /**
+     * 配置
+     */
+    void setMaxSizeMB(size_t maxSizeMB);
+    void setMaxPendingMB(size_t maxPendingMB);
+
+    /**
+     * 获取统计
+     */
+    Stats getStats() const;
+
+private:
+    ResultSpillCache();
+    ~ResultSpillCache();
+
+    // 禁止拷贝和赋值
+    ResultSpillCache(const ResultSpillCache&) = delete;
+    ResultSpillCache& operator=(const ResultSpillCache&) = delete;
+
+    /**
+     * 写入队列中的条目
+     */
+    struct PendingEntry {
+        ImageHashCache::HashKey key;
+        std::shared_ptr<const LinearImage> image;
+        std::shared_ptr<const CompressedImage> compressed;   // 与 image 二选一
+        size_t bytes;
+    };
+
+    /**
+     * 文件名（键的十六进制表示）
+     */
+    static std::string entryName(const ImageHashCache::HashKey& key);
+
+    /**
+     * 加入写入队列
+     */
+    void enqueue(PendingEntry entry, uint32_t width, uint32_t height);
+
+    /**
+     * 结果配置哈希与目录中的条目不一致时清空目录并更新目录标记
+     */
+    void resetForConfig(uint64_t configHash);
+
+    /**
+     * 清空索引和写入队列（调用方持有锁）
+     *
+     * @param paths 输出需要删除的文件路径
+     * @return 释放的排队字节数
+     */
+    size_t clearLocked(std::vector<std::string>& paths);
+
+    /**
+     * 内存回收回调：丢弃尚未开始写入的排队条目
+     */
+    size_t onTrimMemory(TrimLevel level);
+
+    /**
+     * 写入线程主循环
+     */
+    void writerLoop();
+
+    /**
+     * 写入一个条目并更新索引
+     */
+    void writeEntry(const std::string& name, const PendingEntry& entry);
+
+    /**
+     * 淘汰最久未访问的条目直到满足容量限制（调用方持有锁）
+     *
+     * @return 需要删除的文件路径
+     */
+    std::vector<std::string> collectEvictionsLocked();
+
+    DiskCacheIndex m_index{512ULL * 1024 * 1024};             // 512MB
+    std::unordered_map<std::string, PendingEntry> m_pending;  // 文件名 -> 待写条目
+    std::deque<std::string> m_queue;                          // 写入顺序
+    uint64_t m_configHash = 0;    // 目录中条目的结果配置哈希
+    size_t m_maxPendingBytes = 192ULL * 1024 * 1024;   // 192MB
+    size_t m_pendingBytes = 0;
+    bool m_writing = false;       // 写入线程正在处理队列外的一个条目
+    bool m_stop = false;
+    Stats m_stats;
+    std::thread m_writer;
+    std::condition_variable m_queueCondition;
+    std::condition_variable m_idleCondition;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_RESULT_SPILL_CACHE_H
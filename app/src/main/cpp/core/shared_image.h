@@ -0,0 +1,96 @@
+#ifndef FILMTRACKER_SHARED_IMAGE_H
+#define FILMTRACKER_SHARED_IMAGE_H
+
+#include "raw_types.h"
+#include "memory_governor.h"
+#include <memory>
+#include <utility>
+
+namespace filmtracker {
+
+/**
+ * 写时复制的图像引用
+ *
+ * 持有不可变的共享图像缓冲区（例如 ImageHashCache 的条目、交给 Kotlin 的 ImageHandle），只读访问不复制。
+ * 需要就地修改时调用 mutableImage()：仍有其他持有者（缓存或其他引用）时先复制一份私有副本，
+ * 已是唯一持有者时直接修改原缓冲区。
+ *
+ * 共享缓冲区必须以非 const 的 LinearImage 创建（std::make_shared<LinearImage> 或 create()），
+ * 唯一持有时的就地修改才是合法的。
+ *
+ * create() 创建的缓冲区按分类登记到 MemoryGovernor（最后一个持有者释放时注销），
+ * 写时复制出的副本登记在同一分类下；直接包装的外部缓冲区（缓存条目由缓存自己登记）不登记。
+ */
+class SharedImage {
+public:
+    SharedImage() = default;
+
+    explicit SharedImage(std::shared_ptr<const LinearImage> image)
+        : m_image(std::move(image)) {
+    }
+
+    /**
+     * 接管图像，新缓冲区按 category 登记；超出预算时回收缓存
+     */
+    static SharedImage create(LinearImage&& image, MemoryCategory category) {
+        SharedImage shared(makeBuffer(std::move(image), category));
+        shared.m_charged = true;
+        shared.m_category = category;
+        return shared;
+    }
+
+    bool empty() const { return !m_image; }
+
+    const LinearImage& get() const { return *m_image; }
+    const LinearImage* operator->() const { return m_image.get(); }
+
+    /**
+     * 共享的只读缓冲区（可以再交给缓存或其他阶段）
+     */
+    const std::shared_ptr<const LinearImage>& share() const { return m_image; }
+
+    /**
+     * 缓冲区是否还有其他持有者
+     */
+    bool isShared() const { return m_image.use_count() > 1; }
+
+    /**
+     * 可写访问：其他持有者仍在使用时先复制
+     */
+    LinearImage& mutableImage() {
+        if (m_image.use_count() != 1) {
+            m_image = m_charged ? makeBuffer(LinearImage(*m_image), m_category)
+                                : std::make_shared<LinearImage>(*m_image);
+        }
+        return const_cast<LinearImage&>(*m_image);
+    }
+
+    /**
+     * 图像缓冲区占用的字节数
+     */
+    static size_t bufferBytes(const LinearImage& image) {
+        return (image.r.size() + image.g.size() + image.b.size()) * sizeof(float);
+    }
+
+private:
+    static std::shared_ptr<const LinearImage> makeBuffer(LinearImage&& image, MemoryCategory category) {
+        const size_t bytes = bufferBytes(image);
+        MemoryGovernor& governor = MemoryGovernor::getInstance();
+        governor.charge(category, bytes);
+        // 非 const 对象，唯一持有时 mutableImage() 的就地修改才是合法的
+        std::shared_ptr<const LinearImage> buffer(new LinearImage(std::move(image)), [bytes, category](const LinearImage* ptr) {
+            MemoryGovernor::getInstance().release(category, bytes);
+            delete ptr;
+        });
+        governor.enforceBudget();
+        return buffer;
+    }
+
+    std::shared_ptr<const LinearImage> m_image;
+    bool m_charged = false;
+    MemoryCategory m_category = MemoryCategory::IMAGES;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_SHARED_IMAGE_H
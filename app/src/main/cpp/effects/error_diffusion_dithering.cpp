@@ -149,6 +149,7 @@ void ErrorDiffusionDithering::applyFloydSteinbergInPlace(LinearImage& image, int
     const int maxValue = (1 << bitDepth) - 1;  // 例如 8-bit: 255
     
     LOGI("Applying Floyd-Steinberg in-place: %dx%d, bitDepth=%d", width, height, bitDepth);
+    image.provenance = 0;   // 就地修改，来源标识失效
     
     // 为每个颜色通道创建误差缓冲区
     std::vector<float> errorBufferR(width * 2, 0.0f);
@@ -0,0 +1,276 @@
+#include "icc_profile.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace filmtracker {
+
+namespace {
+
+// PCS 白点（ICC 规定的 D50）
+const double kD50[3] = {0.9642, 1.0, 0.8249};
+const double kD65xy[2] = {0.3127, 0.3290};
+
+const double kBradford[9] = {
+     0.8951,  0.2664, -0.1614,
+    -0.7502,  1.7135,  0.0367,
+     0.0389, -0.0685,  1.0296
+};
+
+/**
+ * 色彩空间描述：原色 xy、传递函数（ICC parametricCurve 参数）
+ */
+struct ColorSpaceDesc {
+    const char* description;
+    double primaries[6];        // Rx Ry Gx Gy Bx By
+    uint16_t curveType;         // 0: Y = X^g；3: sRGB 型分段曲线
+    double curve[5];            // g a b c d
+};
+
+bool describe(EncodeColorSpace colorSpace, ColorSpaceDesc& desc) {
+    const double srgbCurve[5] = {2.4, 1.0 / 1.055, 0.055 / 1.055, 1.0 / 12.92, 0.04045};
+    switch (colorSpace) {
+        case EncodeColorSpace::SRGB:
+            desc = {"sRGB IEC61966-2.1", {0.64, 0.33, 0.30, 0.60, 0.15, 0.06}, 3, {}};
+            std::memcpy(desc.curve, srgbCurve, sizeof(srgbCurve));
+            return true;
+        case EncodeColorSpace::DISPLAY_P3:
+            desc = {"Display P3", {0.680, 0.320, 0.265, 0.690, 0.150, 0.060}, 3, {}};
+            std::memcpy(desc.curve, srgbCurve, sizeof(srgbCurve));
+            return true;
+        case EncodeColorSpace::ADOBE_RGB:
+            desc = {"Adobe RGB (1998) compatible", {0.64, 0.33, 0.21, 0.71, 0.15, 0.06}, 0, {563.0 / 256.0}};
+            return true;
+        case EncodeColorSpace::LINEAR_SRGB:
+            desc = {"Linear sRGB", {0.64, 0.33, 0.30, 0.60, 0.15, 0.06}, 0, {1.0}};
+            return true;
+        default:
+            return false;
+    }
+}
+
+void multiply(const double* a, const double* b, double* out) {
+    double result[9];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            result[i * 3 + j] = a[i * 3] * b[j] + a[i * 3 + 1] * b[3 + j] + a[i * 3 + 2] * b[6 + j];
+        }
+    }
+    std::memcpy(out, result, sizeof(result));
+}
+
+void invert(const double* m, double* out) {
+    const double det = m[0] * (m[4] * m[8] - m[5] * m[7]) -
+                       m[1] * (m[3] * m[8] - m[5] * m[6]) +
+                       m[2] * (m[3] * m[7] - m[4] * m[6]);
+    const double inv = 1.0 / det;
+    out[0] = (m[4] * m[8] - m[5] * m[7]) * inv;
+    out[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+    out[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+    out[3] = (m[5] * m[6] - m[3] * m[8]) * inv;
+    out[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+    out[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+    out[6] = (m[3] * m[7] - m[4] * m[6]) * inv;
+    out[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+    out[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+}
+
+void xyToXYZ(double x, double y, double* xyz) {
+    xyz[0] = x / y;
+    xyz[1] = 1.0;
+    xyz[2] = (1.0 - x - y) / y;
+}
+
+/**
+ * D65 -> D50 的 Bradford 适配矩阵
+ */
+void bradfordD65ToD50(double* chad) {
+    double white[3];
+    xyToXYZ(kD65xy[0], kD65xy[1], white);
+    double src[3], dst[3];
+    for (int i = 0; i < 3; ++i) {
+        src[i] = kBradford[i * 3] * white[0] + kBradford[i * 3 + 1] * white[1] + kBradford[i * 3 + 2] * white[2];
+        dst[i] = kBradford[i * 3] * kD50[0] + kBradford[i * 3 + 1] * kD50[1] + kBradford[i * 3 + 2] * kD50[2];
+    }
+    const double scale[9] = {dst[0] / src[0], 0, 0, 0, dst[1] / src[1], 0, 0, 0, dst[2] / src[2]};
+    double inverse[9];
+    invert(kBradford, inverse);
+    multiply(scale, kBradford, chad);
+    multiply(inverse, chad, chad);
+}
+
+/**
+ * 线性 RGB -> XYZ(D50)，列为 R、G、B 三个原色
+ */
+void rgbToXYZD50(const ColorSpaceDesc& desc, const double* chad, double* out) {
+    double primaries[9];
+    for (int c = 0; c < 3; ++c) {
+        double xyz[3];
+        xyToXYZ(desc.primaries[c * 2], desc.primaries[c * 2 + 1], xyz);
+        primaries[c] = xyz[0];
+        primaries[3 + c] = xyz[1];
+        primaries[6 + c] = xyz[2];
+    }
+    double white[3];
+    xyToXYZ(kD65xy[0], kD65xy[1], white);
+    double inverse[9];
+    invert(primaries, inverse);
+    double m[9];
+    for (int i = 0; i < 3; ++i) {
+        const double s = inverse[i * 3] * white[0] + inverse[i * 3 + 1] * white[1] + inverse[i * 3 + 2] * white[2];
+        for (int row = 0; row < 3; ++row) {
+            m[row * 3 + i] = primaries[row * 3 + i] * s;
+        }
+    }
+    multiply(chad, m, out);
+}
+
+// ICC 数据均为大端
+
+void appendU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+}
+
+void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void appendSig(std::vector<uint8_t>& out, const char sig[5]) {
+    out.insert(out.end(), sig, sig + 4);
+}
+
+void appendFixed(std::vector<uint8_t>& out, double value) {
+    appendU32(out, static_cast<uint32_t>(static_cast<int32_t>(std::lround(value * 65536.0))));
+}
+
+void putU32(std::vector<uint8_t>& out, size_t offset, uint32_t value) {
+    out[offset] = static_cast<uint8_t>(value >> 24);
+    out[offset + 1] = static_cast<uint8_t>(value >> 16);
+    out[offset + 2] = static_cast<uint8_t>(value >> 8);
+    out[offset + 3] = static_cast<uint8_t>(value);
+}
+
+std::vector<uint8_t> mlucTag(const std::string& text) {
+    std::vector<uint8_t> tag;
+    appendSig(tag, "mluc");
+    appendU32(tag, 0);
+    appendU32(tag, 1);                  // 记录数
+    appendU32(tag, 12);                 // 记录大小
+    appendSig(tag, "enUS");
+    appendU32(tag, static_cast<uint32_t>(text.size() * 2));
+    appendU32(tag, 28);                 // 字符串相对标签起始的偏移
+    for (char c : text) {
+        appendU16(tag, static_cast<uint8_t>(c));   // ASCII -> UTF-16BE
+    }
+    return tag;
+}
+
+std::vector<uint8_t> xyzTag(double x, double y, double z) {
+    std::vector<uint8_t> tag;
+    appendSig(tag, "XYZ ");
+    appendU32(tag, 0);
+    appendFixed(tag, x);
+    appendFixed(tag, y);
+    appendFixed(tag, z);
+    return tag;
+}
+
+std::vector<uint8_t> curveTag(const ColorSpaceDesc& desc) {
+    std::vector<uint8_t> tag;
+    appendSig(tag, "para");
+    appendU32(tag, 0);
+    appendU16(tag, desc.curveType);
+    appendU16(tag, 0);
+    const int count = desc.curveType == 3 ? 5 : 1;
+    for (int i = 0; i < count; ++i) {
+        appendFixed(tag, desc.curve[i]);
+    }
+    return tag;
+}
+
+std::vector<uint8_t> sf32Tag(const double* matrix) {
+    std::vector<uint8_t> tag;
+    appendSig(tag, "sf32");
+    appendU32(tag, 0);
+    for (int i = 0; i < 9; ++i) {
+        appendFixed(tag, matrix[i]);
+    }
+    return tag;
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> IccProfile::create(EncodeColorSpace colorSpace) {
+    ColorSpaceDesc desc;
+    if (!describe(colorSpace, desc)) {
+        return {};
+    }
+
+    double chad[9];
+    bradfordD65ToD50(chad);
+    double toXYZ[9];
+    rgbToXYZD50(desc, chad, toXYZ);
+
+    struct Tag {
+        const char* signature;
+        std::vector<uint8_t> data;
+    };
+    const std::vector<uint8_t> curve = curveTag(desc);
+    const Tag tags[] = {
+        {"desc", mlucTag(desc.description)},
+        {"cprt", mlucTag("No copyright, use freely")},
+        {"wtpt", xyzTag(kD50[0], kD50[1], kD50[2])},
+        {"chad", sf32Tag(chad)},
+        {"rXYZ", xyzTag(toXYZ[0], toXYZ[3], toXYZ[6])},
+        {"gXYZ", xyzTag(toXYZ[1], toXYZ[4], toXYZ[7])},
+        {"bXYZ", xyzTag(toXYZ[2], toXYZ[5], toXYZ[8])},
+        {"rTRC", curve},
+        {"gTRC", curve},
+        {"bTRC", curve},
+    };
+    const uint32_t tagCount = sizeof(tags) / sizeof(tags[0]);
+
+    std::vector<uint8_t> out(128, 0);
+    putU32(out, 8, 0x04300000);                         // 版本 4.3
+    std::memcpy(out.data() + 12, "mntrRGB XYZ ", 12);   // 设备类别、数据色彩空间、PCS
+    const uint16_t date[6] = {2024, 1, 1, 0, 0, 0};     // 固定日期，输出可重复
+    for (int i = 0; i < 6; ++i) {
+        out[24 + i * 2] = static_cast<uint8_t>(date[i] >> 8);
+        out[25 + i * 2] = static_cast<uint8_t>(date[i] & 0xFF);
+    }
+    std::memcpy(out.data() + 36, "acsp", 4);
+    for (int i = 0; i < 3; ++i) {
+        putU32(out, 68 + i * 4, static_cast<uint32_t>(static_cast<int32_t>(std::lround(kD50[i] * 65536.0))));
+    }
+
+    // 标签表，之后是 4 字节对齐的标签数据；rTRC / gTRC / bTRC 共用同一份数据
+    appendU32(out, tagCount);
+    const size_t tableOffset = out.size();
+    out.resize(out.size() + tagCount * 12);
+    size_t curveOffset = 0;
+    for (uint32_t i = 0; i < tagCount; ++i) {
+        const bool isCurve = std::strcmp(tags[i].signature + 1, "TRC") == 0;
+        size_t offset = out.size();
+        if (isCurve && curveOffset != 0) {
+            offset = curveOffset;
+        } else {
+            out.insert(out.end(), tags[i].data.begin(), tags[i].data.end());
+            out.resize((out.size() + 3) & ~static_cast<size_t>(3), 0);
+            if (isCurve) {
+                curveOffset = offset;
+            }
+        }
+        const size_t entry = tableOffset + i * 12;
+        std::memcpy(out.data() + entry, tags[i].signature, 4);
+        putU32(out, entry + 4, static_cast<uint32_t>(offset));
+        putU32(out, entry + 8, static_cast<uint32_t>(tags[i].data.size()));
+    }
+    putU32(out, 0, static_cast<uint32_t>(out.size()));
+    return out;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,39 @@
+#ifndef FILMTRACKER_ICC_PROFILE_H
+#define FILMTRACKER_ICC_PROFILE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 嵌入输出文件的色彩空间（与 Kotlin ImageEncoderNative.ColorSpaceTag 一致）
+ */
+enum class EncodeColorSpace {
+    NONE = 0,           // 不嵌入 ICC（查看器按 sRGB 处理）
+    SRGB = 1,           // sRGB / 扩展 sRGB
+    DISPLAY_P3 = 2,     // Display P3（P3 原色，D65，sRGB 传递函数）
+    ADOBE_RGB = 3,      // Adobe RGB (1998)
+    LINEAR_SRGB = 4     // 线性 sRGB / 线性扩展 sRGB（fp16 输出）
+};
+
+/**
+ * 矩阵 + TRC 型 ICC v4 显示设备配置文件
+ *
+ * 原色按 Bradford 适配到 D50（PCS 白点），chad 标签记录 D65 -> D50 适配矩阵；
+ * 三个通道共用一条 parametricCurve。生成的文件约 500 字节，
+ * 小于 JPEG 单个 APP2 段的容量，不需要分段。
+ */
+class IccProfile {
+public:
+    /**
+     * 生成配置文件
+     *
+     * @return NONE 或未知色彩空间时返回空
+     */
+    static std::vector<uint8_t> create(EncodeColorSpace colorSpace);
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_ICC_PROFILE_H
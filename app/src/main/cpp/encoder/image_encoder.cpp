@@ -0,0 +1,307 @@
+#include "image_encoder.h"
+#include "jpeg_writer.h"
+#include "png_writer.h"
+#include "tiff_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <android/log.h>
+
+#define LOG_TAG "ImageEncoder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+ImageEncoder::ImageEncoder(const EncodeOptions& options, ByteWriter writer)
+    : m_options(options), m_writer(std::move(writer)) {
+}
+
+ImageEncoder::~ImageEncoder() {
+    // 工作线程使用本对象的队列、锁和 m_encodeBlock，成员析构前必须先停止并 join
+    stopWorkers();
+}
+
+ByteWriter ImageEncoder::fdWriter(int fd) {
+    return [fd](const uint8_t* data, size_t size) {
+        while (size > 0) {
+            const ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOGE("write failed: %s", strerror(errno));
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+}
+
+bool ImageEncoder::begin(uint32_t width, uint32_t height) {
+    if (m_started || width == 0 || height == 0 || !m_writer) {
+        LOGE("begin: Invalid state or size %ux%u", width, height);
+        return false;
+    }
+
+    const OutputPixelFormat pixelFormat = m_options.pixelFormat;
+    std::vector<uint8_t> iccProfile = IccProfile::create(m_options.colorSpace);
+    m_blockWritten = nullptr;
+
+    switch (m_options.format) {
+        case EncodeFormat::JPEG: {
+            if (pixelFormat != OutputPixelFormat::RGBA_8888 || width > 65535 || height > 65535) {
+                LOGE("begin: JPEG requires RGBA_8888 and at most 65535x65535");
+                return false;
+            }
+            auto jpeg = std::make_shared<JpegWriter>(width, height, m_options.quality, std::move(iccProfile));
+            m_blockRows = jpeg->blockRows();
+            m_header = [jpeg]() { return jpeg->header(); };
+            m_encodeBlock = [jpeg](const uint8_t* rows, size_t stride, uint32_t rowCount,
+                                   uint32_t blockIndex, bool last, const uint8_t*) {
+                return jpeg->encodeBlock(rows, stride, rowCount, blockIndex, last);
+            };
+            m_trailer = [jpeg]() { return jpeg->trailer(); };
+            break;
+        }
+        case EncodeFormat::PNG: {
+            if (pixelFormat != OutputPixelFormat::RGBA_8888 && pixelFormat != OutputPixelFormat::RGBA_16) {
+                LOGE("begin: PNG requires RGBA_8888 or RGBA_16");
+                return false;
+            }
+            auto png = std::make_shared<PngWriter>(width, height, pixelFormat == OutputPixelFormat::RGBA_16,
+                                                   m_options.compressionLevel, std::move(iccProfile));
+            m_blockRows = png->blockRows();
+            m_header = [png]() { return png->header(); };
+            m_encodeBlock = [png](const uint8_t* rows, size_t stride, uint32_t rowCount,
+                                  uint32_t blockIndex, bool last, const uint8_t* previousRow) {
+                return png->encodeBlock(rows, stride, rowCount, blockIndex, last, previousRow);
+            };
+            m_blockWritten = [png](const EncodedBlock& block) { png->blockWritten(block); };
+            m_trailer = [png]() { return png->trailer(); };
+            break;
+        }
+        case EncodeFormat::TIFF: {
+            if (pixelFormat == OutputPixelFormat::RGBA_1010102) {
+                LOGE("begin: TIFF does not accept packed RGBA_1010102 rows");
+                return false;
+            }
+            auto tiff = std::make_shared<TiffWriter>(width, height, pixelFormat, std::move(iccProfile));
+            if (!tiff->isValid()) {
+                LOGE("begin: TIFF larger than 4GB");
+                return false;
+            }
+            m_blockRows = tiff->blockRows();
+            m_header = [tiff]() { return tiff->header(); };
+            m_encodeBlock = [tiff](const uint8_t* rows, size_t stride, uint32_t rowCount,
+                                   uint32_t, bool, const uint8_t*) {
+                return tiff->encodeBlock(rows, stride, rowCount);
+            };
+            m_trailer = []() { return std::vector<uint8_t>(); };
+            break;
+        }
+        default:
+            LOGE("begin: Unknown format %d", static_cast<int>(m_options.format));
+            return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_rowBytes = static_cast<size_t>(width) * ImageConverter::bytesPerPixel(pixelFormat);
+    const uint32_t threads = m_options.maxThreads > 0
+                                 ? m_options.maxThreads
+                                 : std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+    m_maxInFlight = std::max(1u, threads);
+    // 块数少于线程数时不启动多余的线程
+    const uint32_t blockCount = (height + m_blockRows - 1) / m_blockRows;
+    const uint32_t workerCount = std::min(m_maxInFlight, blockCount);
+    stopWorkers();
+    m_stopWorkers = false;
+    for (uint32_t t = 0; t < workerCount; ++t) {
+        m_workers.emplace_back(&ImageEncoder::workerLoop, this);
+    }
+    m_rowsReceived = 0;
+    m_nextBlock = 0;
+    m_pending.clear();
+    m_pendingRows = 0;
+    m_previousRow.clear();
+    m_inFlightBytes = 0;
+    m_stats = EncodeStats();
+    m_stats.blockRows = m_blockRows;
+    m_failed = false;
+    m_started = true;
+
+    LOGI("begin: format=%d %ux%u, %u rows/block, %u blocks in flight, %u workers",
+         static_cast<int>(m_options.format), width, height, m_blockRows, m_maxInFlight, workerCount);
+    return write(m_header());
+}
+
+bool ImageEncoder::writeRows(const uint8_t* rows, uint32_t rowCount, size_t stride) {
+    if (!m_started || m_failed || !rows) {
+        return false;
+    }
+    if (rowCount > m_height - m_rowsReceived) {
+        LOGE("writeRows: %u rows past the end of a %u-row image", rowCount, m_height);
+        m_failed = true;
+        return false;
+    }
+
+    for (uint32_t y = 0; y < rowCount; ++y) {
+        if (m_pendingRows == 0) {
+            m_pending.resize(m_rowBytes * std::min(m_blockRows, m_height - m_rowsReceived));
+        }
+        std::memcpy(m_pending.data() + m_rowBytes * m_pendingRows,
+                    rows + static_cast<size_t>(y) * stride, m_rowBytes);
+        ++m_pendingRows;
+        ++m_rowsReceived;
+
+        const bool last = m_rowsReceived == m_height;
+        if (m_pendingRows == m_blockRows || last) {
+            if (!submitBlock(last)) {
+                m_failed = true;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ImageEncoder::submitBlock(bool last) {
+    while (m_inFlight.size() >= m_maxInFlight) {
+        if (!drainOne()) {
+            return false;
+        }
+    }
+
+    std::unique_ptr<BlockJob> job = std::make_unique<BlockJob>();
+    job->input.swap(m_pending);
+    job->previousRow.swap(m_previousRow);
+    m_previousRow.assign(job->input.end() - static_cast<std::ptrdiff_t>(m_rowBytes), job->input.end());
+    job->rowCount = m_pendingRows;
+    job->blockIndex = m_nextBlock++;
+    job->last = last;
+    job->inputBytes = job->input.size();
+    m_inFlightBytes += job->inputBytes;
+    m_pendingRows = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(job.get());
+        m_inFlight.push_back(std::move(job));
+    }
+    m_queueCondition.notify_one();
+    return true;
+}
+
+bool ImageEncoder::drainOne() {
+    std::unique_ptr<BlockJob> job;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_inFlight.front()->done; });
+        job = std::move(m_inFlight.front());
+        m_inFlight.pop_front();
+    }
+    const EncodedBlock& block = job->result;
+
+    m_stats.peakBufferBytes = std::max(m_stats.peakBufferBytes, m_inFlightBytes + block.bytes.size());
+    m_inFlightBytes -= job->inputBytes;
+    m_stats.encodeSeconds += block.encodeSeconds;
+    ++m_stats.blocks;
+
+    if (block.bytes.empty()) {
+        LOGE("drainOne: Block %u failed to encode", m_stats.blocks - 1);
+        m_failed = true;
+        return false;
+    }
+    if (m_blockWritten) {
+        m_blockWritten(block);
+    }
+    return write(block.bytes);
+}
+
+void ImageEncoder::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_queueCondition.wait(lock, [this] { return m_stopWorkers || !m_queue.empty(); });
+        if (m_stopWorkers) {
+            break;
+        }
+        BlockJob* job = m_queue.front();
+        m_queue.pop_front();
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        EncodedBlock block = m_encodeBlock(job->input.data(), m_rowBytes, job->rowCount, job->blockIndex, job->last,
+                                           job->previousRow.empty() ? nullptr : job->previousRow.data());
+        block.encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // 输入在写出前不再需要，尽早释放
+        std::vector<uint8_t>().swap(job->input);
+
+        lock.lock();
+        job->result = std::move(block);
+        job->done = true;
+        m_doneCondition.notify_all();
+    }
+}
+
+void ImageEncoder::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopWorkers = true;
+        m_queue.clear();
+    }
+    m_queueCondition.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    m_inFlight.clear();
+    m_inFlightBytes = 0;
+}
+
+bool ImageEncoder::finish() {
+    if (!m_started) {
+        return false;
+    }
+    m_started = false;
+    if (m_failed || m_rowsReceived != m_height) {
+        LOGE("finish: Incomplete image (%u of %u rows)", m_rowsReceived, m_height);
+        stopWorkers();
+        return false;
+    }
+    while (!m_inFlight.empty()) {
+        if (!drainOne()) {
+            stopWorkers();
+            return false;
+        }
+    }
+    stopWorkers();
+    if (!write(m_trailer())) {
+        return false;
+    }
+
+    LOGI("finish: %llu bytes, %u blocks, encode %.1f ms (worker total), peak %.1f MB",
+         static_cast<unsigned long long>(m_stats.bytesWritten), m_stats.blocks,
+         m_stats.encodeSeconds * 1000.0, m_stats.peakBufferBytes / (1024.0 * 1024.0));
+    return true;
+}
+
+bool ImageEncoder::write(const std::vector<uint8_t>& bytes) {
+    if (bytes.empty()) {
+        return true;
+    }
+    if (!m_writer(bytes.data(), bytes.size())) {
+        LOGE("write: Output rejected %zu bytes", bytes.size());
+        m_failed = true;
+        return false;
+    }
+    m_stats.bytesWritten += bytes.size();
+    return true;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,165 @@
+#ifndef FILMTRACKER_IMAGE_ENCODER_H
+#define FILMTRACKER_IMAGE_ENCODER_H
+
+#include "image_converter.h"
+#include "icc_profile.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 编码格式
+ */
+enum class EncodeFormat {
+    JPEG = 0,   // 基线 JPEG，输入 RGBA_8888
+    PNG = 1,    // RGB，输入 RGBA_8888（8 位）或 RGBA_16（16 位）
+    TIFF = 2    // 未压缩 RGB，输入 RGBA_8888 / RGBA_16 / RGBA_F16（半精度浮点）
+};
+
+/**
+ * 编码配置
+ */
+struct EncodeOptions {
+    EncodeFormat format = EncodeFormat::JPEG;
+    OutputPixelFormat pixelFormat = OutputPixelFormat::RGBA_8888;   // 输入行的像素格式
+    int quality = 95;               // JPEG 质量（1-100），90 及以上不做色度降采样
+    int compressionLevel = 6;       // PNG deflate 级别（1-9）
+    EncodeColorSpace colorSpace = EncodeColorSpace::NONE;          // 像素所在色彩空间，嵌入对应的 ICC 配置文件
+    uint32_t maxThreads = 0;        // 0 = 自动
+};
+
+/**
+ * 编码统计
+ */
+struct EncodeStats {
+    uint64_t bytesWritten = 0;
+    uint32_t blocks = 0;            // 独立压缩的块数
+    uint32_t blockRows = 0;         // 每块行数
+    size_t peakBufferBytes = 0;     // 在途块（输入 + 压缩结果）占用的峰值内存
+    double encodeSeconds = 0.0;     // 工作线程累计压缩时间
+};
+
+/**
+ * 一个行块的压缩结果（由各格式的 writer 产生）
+ */
+struct EncodedBlock {
+    std::vector<uint8_t> bytes;     // 按顺序写入输出的字节
+    uint32_t checksum = 0;          // PNG：块内未压缩数据的 Adler-32
+    size_t rawBytes = 0;            // PNG：块内未压缩数据长度
+    double encodeSeconds = 0.0;     // 由 ImageEncoder 填写
+};
+
+/**
+ * 输出字节流，返回 false 表示写入失败
+ */
+using ByteWriter = std::function<bool(const uint8_t* data, size_t size)>;
+
+/**
+ * 流式图像编码器
+ *
+ * 按行接收像素（通常来自条带导出），攒满一个行块就交给工作线程独立压缩，
+ * 压缩结果按块顺序写出：
+ * - JPEG：每块是一个 restart interval（DRI + RSTn），块之间没有熵编码依赖
+ * - PNG：每块是一段以 sync flush 结束的独立 deflate 流，写成一个 IDAT，Adler-32 按块合并
+ * - TIFF：未压缩条带，文件头和 IFD 可以预先算出，无需回写
+ *
+ * begin 启动固定数量的工作线程，依次领取排队的块；在途块数不超过线程数，
+ * 内存占用与图像高度无关；调用方计算下一个条带时，前面的块在后台压缩。
+ */
+class ImageEncoder {
+public:
+    ImageEncoder(const EncodeOptions& options, ByteWriter writer);
+    ~ImageEncoder();
+
+    /**
+     * 开始编码（写出文件头）
+     */
+    bool begin(uint32_t width, uint32_t height);
+
+    /**
+     * 按顺序写入若干行（格式为 options.pixelFormat）
+     *
+     * @param stride 相邻行的字节间隔
+     */
+    bool writeRows(const uint8_t* rows, uint32_t rowCount, size_t stride);
+
+    /**
+     * 等待所有块压缩完成并写出文件尾；行数不足时返回 false
+     */
+    bool finish();
+
+    const EncodeStats& getStats() const { return m_stats; }
+
+    /**
+     * 写入文件描述符的 ByteWriter（处理部分写入和 EINTR，不关闭 fd）
+     */
+    static ByteWriter fdWriter(int fd);
+
+private:
+    ImageEncoder(const ImageEncoder&) = delete;
+    ImageEncoder& operator=(const ImageEncoder&) = delete;
+
+    bool submitBlock(bool last);
+    bool drainOne();
+    bool write(const std::vector<uint8_t>& bytes);
+    void workerLoop();
+    void stopWorkers();
+
+    /**
+     * 一个待压缩 / 已压缩的块（input 和 result 在 done 之前只由领取它的工作线程访问）
+     */
+    struct BlockJob {
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> previousRow;
+        uint32_t rowCount = 0;
+        uint32_t blockIndex = 0;
+        bool last = false;
+        size_t inputBytes = 0;
+        EncodedBlock result;
+        bool done = false;
+    };
+
+    EncodeOptions m_options;
+    ByteWriter m_writer;
+    EncodeStats m_stats;
+
+    // 由 begin 按格式设置
+    std::function<std::vector<uint8_t>()> m_header;
+    std::function<EncodedBlock(const uint8_t* rows, size_t stride, uint32_t rowCount,
+                               uint32_t blockIndex, bool last, const uint8_t* previousRow)> m_encodeBlock;
+    std::function<void(const EncodedBlock& block)> m_blockWritten;
+    std::function<std::vector<uint8_t>()> m_trailer;
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    size_t m_rowBytes = 0;
+    uint32_t m_blockRows = 0;
+    uint32_t m_maxInFlight = 1;
+    uint32_t m_rowsReceived = 0;
+    uint32_t m_nextBlock = 0;
+    std::vector<uint8_t> m_pending;         // 当前正在攒的块
+    uint32_t m_pendingRows = 0;
+    std::vector<uint8_t> m_previousRow;     // 上一块最后一行（PNG 行滤波需要）
+    std::deque<std::unique_ptr<BlockJob>> m_inFlight;   // 按块顺序，队首最先写出
+    std::deque<BlockJob*> m_queue;                      // 尚未被工作线程领取的块
+    size_t m_inFlightBytes = 0;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_queueCondition;
+    std::condition_variable m_doneCondition;
+    bool m_stopWorkers = false;
+    bool m_started = false;
+    bool m_failed = false;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_IMAGE_ENCODER_H
@@ -0,0 +1,437 @@
+#include "jpeg_writer.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace filmtracker {
+
+namespace {
+
+// 每块的目标输入字节数：足够大以摊薄 RST 标记和线程调度，又不至于让在途内存过大
+const size_t kTargetBlockBytes = 1u << 20;
+
+// 自然顺序 -> zigzag 位置
+const uint8_t kZigZag[64] = {
+     0,  1,  5,  6, 14, 15, 27, 28,
+     2,  4,  7, 13, 16, 26, 29, 42,
+     3,  8, 12, 17, 25, 30, 41, 43,
+     9, 11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54,
+    20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61,
+    35, 36, 48, 49, 57, 58, 62, 63
+};
+
+// ITU T.81 Annex K 标准量化表（自然顺序）
+const uint8_t kBaseQuantLuma[64] = {
+    16,  11,  10,  16,  24,  40,  51,  61,
+    12,  12,  14,  19,  26,  58,  60,  55,
+    14,  13,  16,  24,  40,  57,  69,  56,
+    14,  17,  22,  29,  51,  87,  80,  62,
+    18,  22,  37,  56,  68, 109, 103,  77,
+    24,  35,  55,  64,  81, 104, 113,  92,
+    49,  64,  78,  87, 103, 121, 120, 101,
+    72,  92,  95,  98, 112, 100, 103,  99
+};
+
+const uint8_t kBaseQuantChroma[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// ITU T.81 Annex K 标准 Huffman 表：各码长的码字数 + 符号
+const uint8_t kDcLumaBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t kDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+const uint8_t kDcValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+const uint8_t kAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+const uint8_t kAcLumaValues[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+const uint8_t kAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+const uint8_t kAcChromaValues[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+// AAN 浮点 DCT 的行 / 列缩放因子（libjpeg jfdctflt 的约定）
+const float kAanScale[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+template <typename Code>
+void buildHuffmanCodes(const uint8_t bits[16], const uint8_t* values, Code* codes) {
+    uint16_t code = 0;
+    int k = 0;
+    for (int length = 1; length <= 16; ++length) {
+        for (int i = 0; i < bits[length - 1]; ++i) {
+            codes[values[k]].code = code++;
+            codes[values[k]].length = static_cast<uint8_t>(length);
+            ++k;
+        }
+        code <<= 1;
+    }
+}
+
+void buildQuantTable(const uint8_t base[64], int quality, uint8_t zigzag[64], float divisors[64]) {
+    const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    for (int i = 0; i < 64; ++i) {
+        const int q = std::min(255, std::max(1, (base[i] * scale + 50) / 100));
+        zigzag[kZigZag[i]] = static_cast<uint8_t>(q);
+        divisors[i] = 1.0f / (static_cast<float>(q) * kAanScale[i / 8] * kAanScale[i % 8] * 8.0f);
+    }
+}
+
+/**
+ * 一维 8 点 AAN 前向 DCT（原地，step 为元素间隔）
+ */
+inline void forwardDct8(float* d, int step) {
+    const float tmp0 = d[0] + d[7 * step];
+    const float tmp7 = d[0] - d[7 * step];
+    const float tmp1 = d[step] + d[6 * step];
+    const float tmp6 = d[step] - d[6 * step];
+    const float tmp2 = d[2 * step] + d[5 * step];
+    const float tmp5 = d[2 * step] - d[5 * step];
+    const float tmp3 = d[3 * step] + d[4 * step];
+    const float tmp4 = d[3 * step] - d[4 * step];
+
+    // 偶数部分
+    float tmp10 = tmp0 + tmp3;
+    const float tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2;
+    float tmp12 = tmp1 - tmp2;
+
+    d[0] = tmp10 + tmp11;
+    d[4 * step] = tmp10 - tmp11;
+    const float z1 = (tmp12 + tmp13) * 0.707106781f;
+    d[2 * step] = tmp13 + z1;
+    d[6 * step] = tmp13 - z1;
+
+    // 奇数部分
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    const float z5 = (tmp10 - tmp12) * 0.382683433f;
+    const float z2 = 0.541196100f * tmp10 + z5;
+    const float z4 = 1.306562965f * tmp12 + z5;
+    const float z3 = tmp11 * 0.707106781f;
+    const float z11 = tmp7 + z3;
+    const float z13 = tmp7 - z3;
+
+    d[5 * step] = z13 + z2;
+    d[3 * step] = z13 - z2;
+    d[step] = z11 + z4;
+    d[7 * step] = z11 - z4;
+}
+
+void appendMarker(std::vector<uint8_t>& out, uint8_t marker, uint16_t length) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    out.push_back(static_cast<uint8_t>(length >> 8));
+    out.push_back(static_cast<uint8_t>(length & 0xFF));
+}
+
+void appendHuffmanTable(std::vector<uint8_t>& out, uint8_t tableClassId,
+                        const uint8_t bits[16], const uint8_t* values, size_t count) {
+    out.push_back(tableClassId);
+    out.insert(out.end(), bits, bits + 16);
+    out.insert(out.end(), values, values + count);
+}
+
+} // anonymous namespace
+
+/**
+ * 熵编码位流（0xFF 后补 0x00）
+ */
+class JpegWriter::BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void put(uint32_t code, uint32_t length) {
+        m_buffer = (m_buffer << length) | (code & ((1u << length) - 1));
+        m_count += length;
+        while (m_count >= 8) {
+            const uint8_t byte = static_cast<uint8_t>(m_buffer >> (m_count - 8));
+            m_out.push_back(byte);
+            if (byte == 0xFF) {
+                m_out.push_back(0x00);
+            }
+            m_count -= 8;
+        }
+        m_buffer &= (1u << m_count) - 1;
+    }
+
+    /**
+     * 用 1 填充到字节边界（RST / EOI 之前要求）
+     */
+    void flush() {
+        if (m_count > 0) {
+            put((1u << (8 - m_count)) - 1, 8 - m_count);
+        }
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint32_t m_buffer = 0;
+    uint32_t m_count = 0;
+};
+
+JpegWriter::JpegWriter(uint32_t width, uint32_t height, int quality, std::vector<uint8_t> iccProfile)
+    : m_width(width), m_height(height), m_iccProfile(std::move(iccProfile)) {
+    quality = std::min(100, std::max(1, quality));
+    // 高质量导出保留全分辨率色度
+    m_sampling = quality >= 90 ? 1 : 2;
+
+    buildQuantTable(kBaseQuantLuma, quality, m_quantLuma, m_divisorLuma);
+    buildQuantTable(kBaseQuantChroma, quality, m_quantChroma, m_divisorChroma);
+    buildHuffmanCodes(kDcLumaBits, kDcValues, m_dcLuma);
+    buildHuffmanCodes(kDcChromaBits, kDcValues, m_dcChroma);
+    buildHuffmanCodes(kAcLumaBits, kAcLumaValues, m_acLuma);
+    buildHuffmanCodes(kAcChromaBits, kAcChromaValues, m_acChroma);
+
+    // 块高度取 MCU 高度的整数倍，restart interval（MCU 数）不能超过 16 位
+    const uint32_t mcuSize = 8 * m_sampling;
+    const uint32_t mcusPerRow = std::max(1u, (width + mcuSize - 1) / mcuSize);
+    const size_t rowBytes = std::max<size_t>(1, static_cast<size_t>(width) * 4);
+    uint32_t mcuRows = static_cast<uint32_t>((kTargetBlockBytes / rowBytes + mcuSize - 1) / mcuSize);
+    mcuRows = std::max(1u, std::min(mcuRows, 65535u / mcusPerRow));
+    m_blockRows = mcuRows * mcuSize;
+    m_restartInterval = mcuRows * mcusPerRow;
+}
+
+std::vector<uint8_t> JpegWriter::header() const {
+    std::vector<uint8_t> out;
+    out.reserve(700);
+
+    // SOI
+    out.push_back(0xFF);
+    out.push_back(0xD8);
+
+    // APP0 JFIF 1.01，无密度单位
+    appendMarker(out, 0xE0, 16);
+    const uint8_t jfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    out.insert(out.end(), jfif, jfif + sizeof(jfif));
+
+    // APP2 ICC_PROFILE：配置文件只有几百字节，单段写完（序号 1 / 共 1 段）
+    if (!m_iccProfile.empty() && m_iccProfile.size() <= 65535 - 16) {
+        appendMarker(out, 0xE2, static_cast<uint16_t>(2 + 14 + m_iccProfile.size()));
+        const uint8_t iccHeader[] = {'I', 'C', 'C', '_', 'P', 'R', 'O', 'F', 'I', 'L', 'E', 0, 1, 1};
+        out.insert(out.end(), iccHeader, iccHeader + sizeof(iccHeader));
+        out.insert(out.end(), m_iccProfile.begin(), m_iccProfile.end());
+    }
+
+    // DQT：0 = 亮度，1 = 色度
+    appendMarker(out, 0xDB, 2 + 2 * 65);
+    out.push_back(0x00);
+    out.insert(out.end(), m_quantLuma, m_quantLuma + 64);
+    out.push_back(0x01);
+    out.insert(out.end(), m_quantChroma, m_quantChroma + 64);
+
+    // SOF0
+    appendMarker(out, 0xC0, 17);
+    out.push_back(8);
+    out.push_back(static_cast<uint8_t>(m_height >> 8));
+    out.push_back(static_cast<uint8_t>(m_height & 0xFF));
+    out.push_back(static_cast<uint8_t>(m_width >> 8));
+    out.push_back(static_cast<uint8_t>(m_width & 0xFF));
+    out.push_back(3);
+    const uint8_t components[] = {
+        1, static_cast<uint8_t>((m_sampling << 4) | m_sampling), 0,
+        2, 0x11, 1,
+        3, 0x11, 1
+    };
+    out.insert(out.end(), components, components + sizeof(components));
+
+    // DHT
+    appendMarker(out, 0xC4, 2 + 4 * 17 + 12 + 12 + 162 + 162);
+    appendHuffmanTable(out, 0x00, kDcLumaBits, kDcValues, 12);
+    appendHuffmanTable(out, 0x10, kAcLumaBits, kAcLumaValues, 162);
+    appendHuffmanTable(out, 0x01, kDcChromaBits, kDcValues, 12);
+    appendHuffmanTable(out, 0x11, kAcChromaBits, kAcChromaValues, 162);
+
+    // DRI：每块一个 restart interval
+    if (m_height > m_blockRows) {
+        appendMarker(out, 0xDD, 4);
+        out.push_back(static_cast<uint8_t>(m_restartInterval >> 8));
+        out.push_back(static_cast<uint8_t>(m_restartInterval & 0xFF));
+    }
+
+    // SOS
+    appendMarker(out, 0xDA, 12);
+    const uint8_t scan[] = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    out.insert(out.end(), scan, scan + sizeof(scan));
+    return out;
+}
+
+void JpegWriter::encodeUnit(float* unit, int& dcPredictor, const float* divisors,
+                            const HuffmanCode* dcTable, const HuffmanCode* acTable,
+                            BitWriter& bits) const {
+    for (int i = 0; i < 8; ++i) {
+        forwardDct8(unit + i * 8, 1);
+    }
+    for (int i = 0; i < 8; ++i) {
+        forwardDct8(unit + i, 8);
+    }
+
+    int coefficients[64];
+    for (int i = 0; i < 64; ++i) {
+        const float v = unit[i] * divisors[i];
+        coefficients[kZigZag[i]] = static_cast<int>(v < 0.0f ? v - 0.5f : v + 0.5f);
+    }
+
+    auto putValue = [&bits](const HuffmanCode& symbol, int value, uint32_t magnitudeBits) {
+        bits.put(symbol.code, symbol.length);
+        if (magnitudeBits > 0) {
+            bits.put(static_cast<uint32_t>(value < 0 ? value - 1 : value), magnitudeBits);
+        }
+    };
+    auto bitLength = [](int value) {
+        uint32_t magnitude = static_cast<uint32_t>(value < 0 ? -value : value);
+        uint32_t length = 0;
+        while (magnitude) {
+            ++length;
+            magnitude >>= 1;
+        }
+        return length;
+    };
+
+    // DC 差分
+    const int diff = coefficients[0] - dcPredictor;
+    dcPredictor = coefficients[0];
+    const uint32_t dcBits = bitLength(diff);
+    putValue(dcTable[dcBits], diff, dcBits);
+
+    // AC 游程
+    int lastNonZero = 63;
+    while (lastNonZero > 0 && coefficients[lastNonZero] == 0) {
+        --lastNonZero;
+    }
+    int run = 0;
+    for (int i = 1; i <= lastNonZero; ++i) {
+        if (coefficients[i] == 0) {
+            ++run;
+            continue;
+        }
+        while (run >= 16) {
+            bits.put(acTable[0xF0].code, acTable[0xF0].length);
+            run -= 16;
+        }
+        const uint32_t acBits = bitLength(coefficients[i]);
+        putValue(acTable[(run << 4) | acBits], coefficients[i], acBits);
+        run = 0;
+    }
+    if (lastNonZero < 63) {
+        bits.put(acTable[0x00].code, acTable[0x00].length);
+    }
+}
+
+EncodedBlock JpegWriter::encodeBlock(const uint8_t* rows, size_t stride, uint32_t rowCount,
+                                     uint32_t blockIndex, bool last) const {
+    EncodedBlock block;
+    block.bytes.reserve(static_cast<size_t>(m_width) * rowCount / 2 + 16);
+    BitWriter bits(block.bytes);
+
+    const uint32_t mcuSize = 8 * m_sampling;
+    const uint32_t mcusPerRow = (m_width + mcuSize - 1) / mcuSize;
+    const uint32_t mcuRows = (rowCount + mcuSize - 1) / mcuSize;
+
+    // restart interval 开始时 DC 预测清零
+    int dcY = 0;
+    int dcCb = 0;
+    int dcCr = 0;
+
+    float lumaPlane[256];
+    float cbPlane[256];
+    float crPlane[256];
+    float unit[64];
+
+    for (uint32_t my = 0; my < mcuRows; ++my) {
+        for (uint32_t mx = 0; mx < mcusPerRow; ++mx) {
+            // RGB -> YCbCr（JFIF），超出图像的像素复制边缘
+            for (uint32_t yy = 0; yy < mcuSize; ++yy) {
+                const uint32_t sy = std::min(my * mcuSize + yy, rowCount - 1);
+                const uint8_t* row = rows + static_cast<size_t>(sy) * stride;
+                for (uint32_t xx = 0; xx < mcuSize; ++xx) {
+                    const uint32_t sx = std::min(mx * mcuSize + xx, m_width - 1);
+                    const uint8_t* p = row + static_cast<size_t>(sx) * 4;
+                    const float r = p[0];
+                    const float g = p[1];
+                    const float b = p[2];
+                    const uint32_t i = yy * mcuSize + xx;
+                    lumaPlane[i] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                    cbPlane[i] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+                    crPlane[i] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+                }
+            }
+
+            for (uint32_t by = 0; by < m_sampling; ++by) {
+                for (uint32_t bx = 0; bx < m_sampling; ++bx) {
+                    for (uint32_t y = 0; y < 8; ++y) {
+                        for (uint32_t x = 0; x < 8; ++x) {
+                            unit[y * 8 + x] = lumaPlane[(by * 8 + y) * mcuSize + bx * 8 + x];
+                        }
+                    }
+                    encodeUnit(unit, dcY, m_divisorLuma, m_dcLuma, m_acLuma, bits);
+                }
+            }
+
+            for (int component = 0; component < 2; ++component) {
+                const float* plane = component == 0 ? cbPlane : crPlane;
+                if (m_sampling == 1) {
+                    std::copy(plane, plane + 64, unit);
+                } else {
+                    // 4:2:0：2x2 平均
+                    for (uint32_t y = 0; y < 8; ++y) {
+                        for (uint32_t x = 0; x < 8; ++x) {
+                            const float* p = plane + (y * 2) * 16 + x * 2;
+                            unit[y * 8 + x] = 0.25f * (p[0] + p[1] + p[16] + p[17]);
+                        }
+                    }
+                }
+                encodeUnit(unit, component == 0 ? dcCb : dcCr, m_divisorChroma,
+                           m_dcChroma, m_acChroma, bits);
+            }
+        }
+    }
+
+    bits.flush();
+    if (!last) {
+        block.bytes.push_back(0xFF);
+        block.bytes.push_back(static_cast<uint8_t>(0xD0 + (blockIndex & 7)));
+    }
+    return block;
+}
+
+std::vector<uint8_t> JpegWriter::trailer() const {
+    return {0xFF, 0xD9};
+}
+
+} // namespace filmtracker
@@ -0,0 +1,76 @@
+#ifndef FILMTRACKER_JPEG_WRITER_H
+#define FILMTRACKER_JPEG_WRITER_H
+
+#include "image_encoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 基线 JPEG 写入器（YCbCr，标准 Huffman 表）
+ *
+ * 每个行块对应一个 restart interval：块首 DC 预测清零，块尾按字节对齐并写 RSTn，
+ * 因此各块可以在不同线程上独立做 DCT、量化和熵编码，结果直接拼接。
+ * 块高度是 MCU 高度的整数倍，最后一块可以更短。
+ */
+class JpegWriter {
+public:
+    /**
+     * @param quality 1-100，映射方式与 libjpeg 的 jpeg_set_quality 一致
+     * @param iccProfile 嵌入的 ICC 配置文件（APP2），为空时不写
+     */
+    JpegWriter(uint32_t width, uint32_t height, int quality, std::vector<uint8_t> iccProfile = {});
+
+    /**
+     * 每块行数
+     */
+    uint32_t blockRows() const { return m_blockRows; }
+
+    /**
+     * SOI ... SOS（含 APP2 ICC_PROFILE）
+     */
+    std::vector<uint8_t> header() const;
+
+    /**
+     * 编码一个行块（RGBA_8888，线程安全）
+     */
+    EncodedBlock encodeBlock(const uint8_t* rows, size_t stride, uint32_t rowCount,
+                             uint32_t blockIndex, bool last) const;
+
+    /**
+     * EOI
+     */
+    std::vector<uint8_t> trailer() const;
+
+private:
+    struct HuffmanCode {
+        uint16_t code = 0;
+        uint8_t length = 0;
+    };
+
+    class BitWriter;
+
+    void encodeUnit(float* unit, int& dcPredictor, const float* divisors,
+                    const HuffmanCode* dcTable, const HuffmanCode* acTable, BitWriter& bits) const;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<uint8_t> m_iccProfile;
+    uint32_t m_sampling;            // 亮度采样因子：1 = 4:4:4，2 = 4:2:0
+    uint32_t m_blockRows;
+    uint32_t m_restartInterval;     // 每块 MCU 数
+    uint8_t m_quantLuma[64];        // zigzag 顺序，写入 DQT
+    uint8_t m_quantChroma[64];
+    float m_divisorLuma[64];        // 自然顺序，已并入 AAN 缩放
+    float m_divisorChroma[64];
+    HuffmanCode m_dcLuma[12];
+    HuffmanCode m_dcChroma[12];
+    HuffmanCode m_acLuma[256];
+    HuffmanCode m_acChroma[256];
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_JPEG_WRITER_H
@@ -0,0 +1,223 @@
+#include "png_writer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <zlib.h>
+
+namespace filmtracker {
+
+namespace {
+
+// 每块的目标未压缩字节数
+const size_t kTargetBlockBytes = 1u << 20;
+
+void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * 追加一个 chunk：length | type | data | CRC(type + data)
+ */
+void appendChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size) {
+    appendU32(out, static_cast<uint32_t>(size));
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size > 0) {
+        out.insert(out.end(), data, data + size);
+    }
+    const uLong crc = crc32(0L, out.data() + typeOffset, static_cast<uInt>(4 + size));
+    appendU32(out, static_cast<uint32_t>(crc));
+}
+
+inline uint8_t paethPredictor(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    if (pb <= pc) return static_cast<uint8_t>(b);
+    return static_cast<uint8_t>(c);
+}
+
+/**
+ * 对一行做指定滤波，返回有符号字节绝对值之和（libpng 的自适应选择启发式）
+ */
+uint32_t filterRow(int type, const uint8_t* row, const uint8_t* prior, size_t size, size_t bpp, uint8_t* out) {
+    uint32_t cost = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = prior[i];
+        const int c = i >= bpp ? prior[i - bpp] : 0;
+        int predicted = 0;
+        switch (type) {
+            case 1: predicted = a; break;
+            case 2: predicted = b; break;
+            case 3: predicted = (a + b) >> 1; break;
+            case 4: predicted = paethPredictor(a, b, c); break;
+            default: break;
+        }
+        const uint8_t value = static_cast<uint8_t>(row[i] - predicted);
+        out[i] = value;
+        cost += value < 128 ? value : 256 - value;
+    }
+    return cost;
+}
+
+} // anonymous namespace
+
+PngWriter::PngWriter(uint32_t width, uint32_t height, bool sixteenBit, int compressionLevel,
+                     std::vector<uint8_t> iccProfile)
+    : m_width(width), m_height(height), m_sixteenBit(sixteenBit),
+      m_level(std::min(9, std::max(1, compressionLevel))),
+      m_iccProfile(std::move(iccProfile)),
+      m_packedRowBytes(static_cast<size_t>(width) * 3 * (sixteenBit ? 2 : 1)),
+      m_adler(static_cast<uint32_t>(adler32(0L, Z_NULL, 0))) {
+    const size_t rowBytes = std::max<size_t>(1, m_packedRowBytes + 1);
+    m_blockRows = static_cast<uint32_t>(std::max<size_t>(8, kTargetBlockBytes / rowBytes));
+}
+
+std::vector<uint8_t> PngWriter::header() const {
+    std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::vector<uint8_t> ihdr;
+    appendU32(ihdr, m_width);
+    appendU32(ihdr, m_height);
+    ihdr.push_back(m_sixteenBit ? 16 : 8);  // bit depth
+    ihdr.push_back(2);                      // color type: RGB
+    ihdr.push_back(0);                      // compression
+    ihdr.push_back(0);                      // filter
+    ihdr.push_back(0);                      // interlace
+    appendChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+    // iCCP：配置文件名 + NUL + 压缩方式 0 + zlib 压缩的配置文件
+    if (!m_iccProfile.empty()) {
+        const char name[] = "ICC profile";
+        std::vector<uint8_t> iccp(name, name + sizeof(name));
+        iccp.push_back(0);
+        uLongf compressedSize = compressBound(static_cast<uLong>(m_iccProfile.size()));
+        const size_t prefix = iccp.size();
+        iccp.resize(prefix + compressedSize);
+        if (compress2(iccp.data() + prefix, &compressedSize, m_iccProfile.data(),
+                      static_cast<uLong>(m_iccProfile.size()), Z_BEST_COMPRESSION) == Z_OK) {
+            iccp.resize(prefix + compressedSize);
+            appendChunk(out, "iCCP", iccp.data(), iccp.size());
+        }
+    }
+    return out;
+}
+
+void PngWriter::packRow(const uint8_t* src, uint8_t* dst) const {
+    if (m_sixteenBit) {
+        // PNG 16 位样本为大端
+        const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+        for (uint32_t x = 0; x < m_width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                const uint16_t v = in[x * 4 + c];
+                dst[(x * 3 + c) * 2] = static_cast<uint8_t>(v >> 8);
+                dst[(x * 3 + c) * 2 + 1] = static_cast<uint8_t>(v & 0xFF);
+            }
+        }
+    } else {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            dst[x * 3] = src[x * 4];
+            dst[x * 3 + 1] = src[x * 4 + 1];
+            dst[x * 3 + 2] = src[x * 4 + 2];
+        }
+    }
+}
+
+EncodedBlock PngWriter::encodeBlock(const uint8_t* rows, size_t stride, uint32_t rowCount,
+                                    uint32_t blockIndex, bool last, const uint8_t* previousRow) const {
+    EncodedBlock block;
+    const size_t bpp = m_sixteenBit ? 6 : 3;
+    const size_t filteredRowBytes = m_packedRowBytes + 1;
+
+    // 行滤波：每行在 5 种滤波中选代价最小的
+    std::vector<uint8_t> filtered(filteredRowBytes * rowCount);
+    std::vector<uint8_t> prior(m_packedRowBytes, 0);
+    std::vector<uint8_t> current(m_packedRowBytes);
+    std::vector<uint8_t> candidate(m_packedRowBytes);
+    if (previousRow != nullptr) {
+        packRow(previousRow, prior.data());
+    }
+
+    for (uint32_t y = 0; y < rowCount; ++y) {
+        packRow(rows + static_cast<size_t>(y) * stride, current.data());
+        uint8_t* out = filtered.data() + filteredRowBytes * y;
+
+        uint32_t bestCost = filterRow(0, current.data(), prior.data(), m_packedRowBytes, bpp, out + 1);
+        out[0] = 0;
+        for (int type = 1; type <= 4; ++type) {
+            const uint32_t cost = filterRow(type, current.data(), prior.data(), m_packedRowBytes, bpp,
+                                            candidate.data());
+            if (cost < bestCost) {
+                bestCost = cost;
+                out[0] = static_cast<uint8_t>(type);
+                std::memcpy(out + 1, candidate.data(), m_packedRowBytes);
+            }
+        }
+        prior.swap(current);
+    }
+
+    block.checksum = static_cast<uint32_t>(adler32(1L, filtered.data(), static_cast<uInt>(filtered.size())));
+    block.rawBytes = filtered.size();
+
+    // 独立的 raw deflate 流
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, m_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return block;
+    }
+    std::vector<uint8_t> compressed;
+    if (blockIndex == 0) {
+        // zlib 头：deflate，32K 窗口，默认压缩级别
+        compressed.push_back(0x78);
+        compressed.push_back(0x9C);
+    }
+    const size_t headerBytes = compressed.size();
+    compressed.resize(headerBytes + deflateBound(&stream, static_cast<uLong>(filtered.size())) + 16);
+
+    stream.next_in = filtered.data();
+    stream.avail_in = static_cast<uInt>(filtered.size());
+    stream.next_out = compressed.data() + headerBytes;
+    stream.avail_out = static_cast<uInt>(compressed.size() - headerBytes);
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int status = deflate(&stream, flush);
+    while (status == Z_OK && (stream.avail_in > 0 || stream.avail_out == 0)) {
+        const size_t used = compressed.size() - stream.avail_out;
+        compressed.resize(compressed.size() * 2);
+        stream.next_out = compressed.data() + used;
+        stream.avail_out = static_cast<uInt>(compressed.size() - used);
+        status = deflate(&stream, flush);
+    }
+    const bool ok = last ? status == Z_STREAM_END : status == Z_OK;
+    compressed.resize(compressed.size() - stream.avail_out);
+    deflateEnd(&stream);
+    if (!ok) {
+        return block;
+    }
+
+    block.bytes.reserve(compressed.size() + 12);
+    appendChunk(block.bytes, "IDAT", compressed.data(), compressed.size());
+    return block;
+}
+
+void PngWriter::blockWritten(const EncodedBlock& block) {
+    m_adler = static_cast<uint32_t>(adler32_combine(m_adler, block.checksum,
+                                                    static_cast<z_off_t>(block.rawBytes)));
+}
+
+std::vector<uint8_t> PngWriter::trailer() const {
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> adler;
+    appendU32(adler, m_adler);
+    appendChunk(out, "IDAT", adler.data(), adler.size());
+    appendChunk(out, "IEND", nullptr, 0);
+    return out;
+}
+
+} // namespace filmtracker
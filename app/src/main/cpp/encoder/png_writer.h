@@ -0,0 +1,69 @@
+#ifndef FILMTRACKER_PNG_WRITER_H
+#define FILMTRACKER_PNG_WRITER_H
+
+#include "image_encoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * PNG 写入器（RGB，8 / 16 位）
+ *
+ * 每个行块独立做行滤波并用一个新的 deflate 流压缩，非最后一块以 Z_SYNC_FLUSH 结束
+ * （字节对齐、无 BFINAL），各块输出直接拼接仍是合法的 deflate 流；
+ * 每块写成一个 IDAT，zlib 头放在第一块，Adler-32 由各块校验和按顺序合并后写在最后一个 IDAT。
+ * 块首行的 Up / Avg / Paeth 滤波需要上一块最后一行，由调用方传入。
+ */
+class PngWriter {
+public:
+    /**
+     * @param sixteenBit true 时输入为 RGBA_16，输出 16 位 PNG
+     * @param compressionLevel deflate 级别 1-9
+     * @param iccProfile 嵌入的 ICC 配置文件（iCCP），为空时不写
+     */
+    PngWriter(uint32_t width, uint32_t height, bool sixteenBit, int compressionLevel,
+              std::vector<uint8_t> iccProfile = {});
+
+    uint32_t blockRows() const { return m_blockRows; }
+
+    /**
+     * 签名 + IHDR（+ iCCP）
+     */
+    std::vector<uint8_t> header() const;
+
+    /**
+     * 编码一个行块（线程安全）
+     *
+     * @param previousRow 上一块最后一行（输入格式），第一块传 nullptr
+     */
+    EncodedBlock encodeBlock(const uint8_t* rows, size_t stride, uint32_t rowCount,
+                             uint32_t blockIndex, bool last, const uint8_t* previousRow) const;
+
+    /**
+     * 块按顺序写出后调用，合并 Adler-32
+     */
+    void blockWritten(const EncodedBlock& block);
+
+    /**
+     * 含 Adler-32 的 IDAT + IEND
+     */
+    std::vector<uint8_t> trailer() const;
+
+private:
+    void packRow(const uint8_t* src, uint8_t* dst) const;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    bool m_sixteenBit;
+    int m_level;
+    std::vector<uint8_t> m_iccProfile;
+    size_t m_packedRowBytes;    // 不含滤波类型字节
+    uint32_t m_blockRows;
+    uint32_t m_adler;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_PNG_WRITER_H
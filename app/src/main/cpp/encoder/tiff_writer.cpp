@@ -0,0 +1,158 @@
+#include "tiff_writer.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace filmtracker {
+
+namespace {
+
+// 每个条带的目标字节数
+const size_t kTargetStripBytes = 1u << 20;
+
+const uint32_t kIfdOffset = 8;
+
+enum TiffType : uint16_t {
+    TIFF_SHORT = 3,
+    TIFF_LONG = 4,
+    TIFF_RATIONAL = 5,
+    TIFF_UNDEFINED = 7
+};
+
+void appendU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 24));
+}
+
+/**
+ * IFD 条目；值不超过 4 字节时 value 为值本身（左对齐），否则为偏移
+ */
+void appendEntry(std::vector<uint8_t>& out, uint16_t tag, uint16_t type, uint32_t count, uint32_t value) {
+    appendU16(out, tag);
+    appendU16(out, type);
+    appendU32(out, count);
+    appendU32(out, value);
+}
+
+} // anonymous namespace
+
+TiffWriter::TiffWriter(uint32_t width, uint32_t height, OutputPixelFormat format, std::vector<uint8_t> iccProfile)
+    : m_width(width), m_height(height), m_format(format), m_iccProfile(std::move(iccProfile)) {
+    m_sampleBytes = format == OutputPixelFormat::RGBA_8888 ? 1 : 2;
+    m_packedRowBytes = static_cast<size_t>(width) * 3 * m_sampleBytes;
+    m_blockRows = static_cast<uint32_t>(std::max<size_t>(
+        1, std::min<size_t>(height, kTargetStripBytes / std::max<size_t>(1, m_packedRowBytes))));
+    m_stripCount = (height + m_blockRows - 1) / m_blockRows;
+}
+
+bool TiffWriter::isValid() const {
+    const uint64_t tables = m_stripCount > 1 ? 8ull * m_stripCount : 0;
+    const uint64_t total = kIfdOffset + ifdBytes() + 28 + m_iccProfile.size() + tables +
+                           static_cast<uint64_t>(m_packedRowBytes) * m_height;
+    return m_width > 0 && m_height > 0 && total <= 0xFFFFFFFFull;
+}
+
+std::vector<uint8_t> TiffWriter::header() const {
+    // IFD 之后依次是：BitsPerSample[3] | SampleFormat[3] | XResolution | YResolution | ICC 配置文件 |
+    // StripOffsets[n] | StripByteCounts[n]（n = 1 时直接放在条目里）| 像素数据
+    // ICC 配置文件长度是 4 的倍数，之后的偏移仍按字对齐
+    const uint32_t bitsOffset = kIfdOffset + ifdBytes();
+    const uint32_t sampleFormatOffset = bitsOffset + 6;
+    const uint32_t xResolutionOffset = sampleFormatOffset + 6;
+    const uint32_t yResolutionOffset = xResolutionOffset + 8;
+    const uint32_t iccOffset = yResolutionOffset + 8;
+    const uint32_t stripOffsetsOffset = iccOffset + static_cast<uint32_t>(m_iccProfile.size());
+    const uint32_t tableBytes = m_stripCount > 1 ? 4 * m_stripCount : 0;
+    const uint32_t stripByteCountsOffset = stripOffsetsOffset + tableBytes;
+    const uint32_t dataOffset = stripByteCountsOffset + tableBytes;
+
+    const uint32_t stripBytes = static_cast<uint32_t>(m_packedRowBytes * m_blockRows);
+    const uint32_t lastStripBytes = static_cast<uint32_t>(
+        m_packedRowBytes * (m_height - (m_stripCount - 1) * m_blockRows));
+
+    std::vector<uint8_t> out;
+    out.reserve(dataOffset);
+
+    // "II" 42 | IFD 偏移
+    out.push_back('I');
+    out.push_back('I');
+    appendU16(out, 42);
+    appendU32(out, kIfdOffset);
+
+    const uint16_t bitsPerSample = static_cast<uint16_t>(m_sampleBytes * 8);
+    const uint16_t sampleFormat = m_format == OutputPixelFormat::RGBA_F16 ? 3 : 1;
+
+    // 标签必须升序
+    appendU16(out, static_cast<uint16_t>(entryCount()));
+    appendEntry(out, 256, TIFF_LONG, 1, m_width);                   // ImageWidth
+    appendEntry(out, 257, TIFF_LONG, 1, m_height);                  // ImageLength
+    appendEntry(out, 258, TIFF_SHORT, 3, bitsOffset);               // BitsPerSample
+    appendEntry(out, 259, TIFF_SHORT, 1, 1);                        // Compression: none
+    appendEntry(out, 262, TIFF_SHORT, 1, 2);                        // Photometric: RGB
+    appendEntry(out, 273, TIFF_LONG, m_stripCount,
+                m_stripCount > 1 ? stripOffsetsOffset : dataOffset); // StripOffsets
+    appendEntry(out, 277, TIFF_SHORT, 1, 3);                        // SamplesPerPixel
+    appendEntry(out, 278, TIFF_LONG, 1, m_blockRows);               // RowsPerStrip
+    appendEntry(out, 279, TIFF_LONG, m_stripCount,
+                m_stripCount > 1 ? stripByteCountsOffset : lastStripBytes); // StripByteCounts
+    appendEntry(out, 282, TIFF_RATIONAL, 1, xResolutionOffset);     // XResolution
+    appendEntry(out, 283, TIFF_RATIONAL, 1, yResolutionOffset);     // YResolution
+    appendEntry(out, 284, TIFF_SHORT, 1, 1);                        // PlanarConfiguration: chunky
+    appendEntry(out, 296, TIFF_SHORT, 1, 2);                        // ResolutionUnit: inch
+    appendEntry(out, 339, TIFF_SHORT, 3, sampleFormatOffset);       // SampleFormat
+    if (!m_iccProfile.empty()) {
+        appendEntry(out, 34675, TIFF_UNDEFINED, static_cast<uint32_t>(m_iccProfile.size()),
+                    iccOffset);                                     // InterColorProfile
+    }
+    appendU32(out, 0);                                              // 没有下一个 IFD
+
+    for (int i = 0; i < 3; ++i) appendU16(out, bitsPerSample);
+    for (int i = 0; i < 3; ++i) appendU16(out, sampleFormat);
+    appendU32(out, 72);
+    appendU32(out, 1);
+    appendU32(out, 72);
+    appendU32(out, 1);
+    out.insert(out.end(), m_iccProfile.begin(), m_iccProfile.end());
+
+    if (m_stripCount > 1) {
+        for (uint32_t i = 0; i < m_stripCount; ++i) {
+            appendU32(out, dataOffset + i * stripBytes);
+        }
+        for (uint32_t i = 0; i < m_stripCount; ++i) {
+            appendU32(out, i + 1 < m_stripCount ? stripBytes : lastStripBytes);
+        }
+    }
+    return out;
+}
+
+EncodedBlock TiffWriter::encodeBlock(const uint8_t* rows, size_t stride, uint32_t rowCount) const {
+    EncodedBlock block;
+    block.bytes.resize(m_packedRowBytes * rowCount);
+
+    // 去掉 alpha；16 位整数和半精度都按本机（小端）字节序原样写出
+    for (uint32_t y = 0; y < rowCount; ++y) {
+        const uint8_t* src = rows + static_cast<size_t>(y) * stride;
+        uint8_t* dst = block.bytes.data() + m_packedRowBytes * y;
+        if (m_sampleBytes == 1) {
+            for (uint32_t x = 0; x < m_width; ++x) {
+                dst[x * 3] = src[x * 4];
+                dst[x * 3 + 1] = src[x * 4 + 1];
+                dst[x * 3 + 2] = src[x * 4 + 2];
+            }
+        } else {
+            for (uint32_t x = 0; x < m_width; ++x) {
+                std::memcpy(dst + x * 6, src + x * 8, 6);
+            }
+        }
+    }
+    return block;
+}
+
+} // namespace filmtracker
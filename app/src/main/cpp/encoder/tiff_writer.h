@@ -0,0 +1,57 @@
+#ifndef FILMTRACKER_TIFF_WRITER_H
+#define FILMTRACKER_TIFF_WRITER_H
+
+#include "image_encoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * TIFF 写入器（小端，未压缩 RGB 条带）
+ *
+ * RGBA_8888 -> 8 位，RGBA_16 -> 16 位整数，RGBA_F16 -> 16 位浮点（SampleFormat = 3，线性）。
+ * 条带大小固定，文件头、IFD 和条带偏移在开始时就能算出，整个文件顺序写出，不需要回写。
+ */
+class TiffWriter {
+public:
+    /**
+     * @param iccProfile 嵌入的 ICC 配置文件（InterColorProfile 标签），为空时不写
+     */
+    TiffWriter(uint32_t width, uint32_t height, OutputPixelFormat format, std::vector<uint8_t> iccProfile = {});
+
+    /**
+     * 文件不超过 4GB（经典 TIFF 的 32 位偏移）
+     */
+    bool isValid() const;
+
+    uint32_t blockRows() const { return m_blockRows; }
+
+    /**
+     * 文件头 + IFD + 条带偏移表
+     */
+    std::vector<uint8_t> header() const;
+
+    /**
+     * 一个条带的像素数据（线程安全）
+     */
+    EncodedBlock encodeBlock(const uint8_t* rows, size_t stride, uint32_t rowCount) const;
+
+private:
+    uint32_t m_width;
+    uint32_t m_height;
+    OutputPixelFormat m_format;
+    std::vector<uint8_t> m_iccProfile;
+    size_t m_sampleBytes;
+    size_t m_packedRowBytes;
+    uint32_t m_blockRows;
+    uint32_t m_stripCount;
+
+    uint32_t entryCount() const { return m_iccProfile.empty() ? 14 : 15; }
+    uint32_t ifdBytes() const { return 2 + entryCount() * 12 + 4; }
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_TIFF_WRITER_H
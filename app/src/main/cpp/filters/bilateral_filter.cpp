@@ -2,6 +2,7 @@
 #include "fast_bilateral_filter.h"
 #include "vulkan_bilateral_filter.h"
 #include "image_hash_cache.h"
+#include "provenance.h"
 #include <cmath>
 #include <algorithm>
 #include <thread>
@@ -21,6 +22,26 @@ namespace filmtracker {
 BilateralFilter::Config BilateralFilter::s_config;
 BilateralFilter::Stats BilateralFilter::s_stats;
 
+// 滤波结果版本：实现改变输出时递增，使旧的缓存条目（包括磁盘溢出层中跨启动保留的条目）失效
+// 2：快速近似路径改用联合双边上采样
+static const int64_t kResultVersion = 2;
+
+/**
+ * 结果配置哈希（ImageHashCache::HashKey::configHash）
+ * 
+ * 只包含影响滤波输出的字段；缓存开关、容量和键方式不影响结果，不参与
+ */
+static uint64_t resultConfigHash(const BilateralFilter::Config& config) {
+    const int64_t fields[5] = {
+        kResultVersion,
+        config.enableFastApproximation ? 1 : 0,
+        config.enableGPU ? 1 : 0,
+        ImageHashCache::HashKey::quantize(config.fastApproxThreshold),
+        static_cast<int64_t>(config.gpuThresholdPixels)
+    };
+    return ImageHashCache::hashBytes(fields, sizeof(fields));
+}
+
 /**
  * 计算高斯权重
  */
@@ -52,6 +73,10 @@ static void applyInternal(const LinearImage& input,
     usedFastApprox = false;
     usedGPU = false;
     
+    // 结果的来源标识：输入来源 + 滤波参数（输入匿名时结果也匿名）
+    const float sigmas[3] = {1.0f, spatialSigma, rangeSigma};   // 首项为阶段标记
+    output.provenance = deriveProvenance(input.provenance, sigmas, sizeof(sigmas));
+    
     // 计算图像像素数
     const uint32_t pixelCount = input.width * input.height;
     
@@ -282,65 +307,103 @@ void BilateralFilter::apply(const LinearImage& input,
 
 /**
  * 应用带缓存的双边滤波器
+ * 
+ * 缓存启用时结果来自共享缓冲区，复制到调用方的 output；
+ * 不需要独立副本的调用方应使用 applyShared
  */
 void BilateralFilter::applyWithCache(const LinearImage& input,
                                     LinearImage& output,
                                     float spatialSigma,
                                     float rangeSigma,
                                     bool enableCache) {
+    if (enableCache && s_config.enableCache) {
+        std::shared_ptr<const LinearImage> result = applyShared(input, spatialSigma, rangeSigma, true);
+        if (output.width != result->width || output.height != result->height) {
+            output = LinearImage(result->width, result->height);
+        }
+        std::copy(result->r.begin(), result->r.end(), output.r.begin());
+        std::copy(result->g.begin(), result->g.end(), output.g.begin());
+        std::copy(result->b.begin(), result->b.end(), output.b.begin());
+        output.provenance = result->provenance;
+        return;
+    }
+    
+    // 缓存禁用，直接写入 output
+    auto startTime = std::chrono::high_resolution_clock::now();
+    s_stats.totalCalls++;
+    
+    bool usedFastApprox = false;
+    bool usedGPU = false;
+    applyInternal(input, output, spatialSigma, rangeSigma, usedFastApprox, usedGPU, s_config);
+    if (usedGPU) {
+        s_stats.gpuCalls++;
+    } else if (usedFastApprox) {
+        s_stats.fastApproxCalls++;
+    } else {
+        s_stats.standardCalls++;
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    
+    s_stats.avgProcessingTimeMs = (s_stats.avgProcessingTimeMs * (s_stats.totalCalls - 1) + duration.count()) / s_stats.totalCalls;
+    
+    LOGI("applyWithCache: Completed in %lld ms", static_cast<long long>(duration.count()));
+}
+
+/**
+ * 带缓存的双边滤波，返回共享的只读结果
+ * 
+ * 命中时直接返回缓存缓冲区（O(1)，不复制）；
+ * 未命中时计算到新缓冲区，并把同一缓冲区交给缓存，内存只占一份
+ */
+std::shared_ptr<const LinearImage> BilateralFilter::applyShared(const LinearImage& input,
+                                                               float spatialSigma,
+                                                               float rangeSigma,
+                                                               bool enableCache) {
     auto startTime = std::chrono::high_resolution_clock::now();
     
     s_stats.totalCalls++;
     
-    if (enableCache && s_config.enableCache) {
-        // 计算图像哈希
-        uint64_t imageHash = ImageHashCache::computeImageHash(input);
-        
-        // 创建缓存键
-        ImageHashCache::HashKey key{imageHash, spatialSigma, rangeSigma};
+    const bool useCache = enableCache && s_config.enableCache;
+    ImageHashCache::HashKey key{0, spatialSigma, rangeSigma, resultConfigHash(s_config)};
+    if (useCache) {
+        // 图像键：有来源标识时不读取像素，匿名缓冲区按配置稀疏采样或完整哈希
+        key.imageHash = ImageHashCache::computeImageKey(input, s_config.sampledImageHash);
         
         // 查找缓存
-        ImageHashCache& cache = ImageHashCache::getInstance();
-        if (cache.find(key, output)) {
+        std::shared_ptr<const LinearImage> cached = ImageHashCache::getInstance().find(key);
+        if (cached) {
             // 缓存命中
             s_stats.cacheHits++;
             
             auto endTime = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
             
-            LOGI("applyWithCache: Cache hit, completed in %lld ms", static_cast<long long>(duration.count()));
-            return;
+            LOGI("applyShared: Cache hit, completed in %lld ms", static_cast<long long>(duration.count()));
+            return cached;
         }
         
         // 缓存未命中
         s_stats.cacheMisses++;
-        
-        // 执行双边滤波（使用内部实现）
-        bool usedFastApprox = false;
-        bool usedGPU = false;
-        applyInternal(input, output, spatialSigma, rangeSigma, usedFastApprox, usedGPU, s_config);
-        if (usedGPU) {
-            s_stats.gpuCalls++;
-        } else if (usedFastApprox) {
-            s_stats.fastApproxCalls++;
-        } else {
-            s_stats.standardCalls++;
-        }
-        
-        // 插入缓存
-        cache.insert(key, output);
+    }
+    
+    // 执行双边滤波（使用内部实现）
+    std::shared_ptr<LinearImage> result = std::make_shared<LinearImage>(input.width, input.height);
+    bool usedFastApprox = false;
+    bool usedGPU = false;
+    applyInternal(input, *result, spatialSigma, rangeSigma, usedFastApprox, usedGPU, s_config);
+    if (usedGPU) {
+        s_stats.gpuCalls++;
+    } else if (usedFastApprox) {
+        s_stats.fastApproxCalls++;
     } else {
-        // 缓存禁用，直接执行
-        bool usedFastApprox = false;
-        bool usedGPU = false;
-        applyInternal(input, output, spatialSigma, rangeSigma, usedFastApprox, usedGPU, s_config);
-        if (usedGPU) {
-            s_stats.gpuCalls++;
-        } else if (usedFastApprox) {
-            s_stats.fastApproxCalls++;
-        } else {
-            s_stats.standardCalls++;
-        }
+        s_stats.standardCalls++;
+    }
+    
+    // 插入缓存（共享同一缓冲区）
+    if (useCache) {
+        ImageHashCache::getInstance().insert(key, result);
     }
     
     auto endTime = std::chrono::high_resolution_clock::now();
@@ -348,7 +411,8 @@ void BilateralFilter::applyWithCache(const LinearImage& input,
     
     s_stats.avgProcessingTimeMs = (s_stats.avgProcessingTimeMs * (s_stats.totalCalls - 1) + duration.count()) / s_stats.totalCalls;
     
-    LOGI("applyWithCache: Completed in %lld ms", static_cast<long long>(duration.count()));
+    LOGI("applyShared: Completed in %lld ms", static_cast<long long>(duration.count()));
+    return result;
 }
 
 /**
@@ -386,7 +450,8 @@ void BilateralFilter::applyFast(const LinearImage& input,
 void BilateralFilter::extractDetail(const LinearImage& input,
                                    LinearImage& detail,
                                    float spatialSigma,
-                                   float rangeSigma) {
+                                   float rangeSigma,
+                                   bool enableCache) {
     LOGI("extractDetail: spatialSigma=%.2f, rangeSigma=%.2f", spatialSigma, rangeSigma);
     
     // 确保细节图像大小正确
@@ -394,9 +459,9 @@ void BilateralFilter::extractDetail(const LinearImage& input,
         detail = LinearImage(input.width, input.height);
     }
     
-    // 创建基础层（双边滤波结果）
-    LinearImage base(input.width, input.height);
-    applyWithCache(input, base, spatialSigma, rangeSigma, s_config.enableCache);
+    // 基础层（双边滤波结果）：缓存命中时直接读取共享缓冲区，不复制
+    std::shared_ptr<const LinearImage> sharedBase = applyShared(input, spatialSigma, rangeSigma, enableCache);
+    const LinearImage& base = *sharedBase;
     
     // 计算细节层 = 原图 - 基础层
     const uint32_t pixelCount = input.width * input.height;
@@ -440,6 +505,8 @@ void BilateralFilter::setConfig(const Config& config) {
     LOGI("  - maxCacheMemoryMB: %zu", s_config.maxCacheMemoryMB);
     LOGI("  - fastApproxThreshold: %.2f", s_config.fastApproxThreshold);
     LOGI("  - gpuThresholdPixels: %u", s_config.gpuThresholdPixels);
+    LOGI("  - sampledImageHash: %d", s_config.sampledImageHash);
+    LOGI("  - cacheCompression: %d", static_cast<int>(s_config.cacheCompression));
     
     // 验证新配置
     Config validatedConfig = config;
@@ -447,9 +514,9 @@ void BilateralFilter::setConfig(const Config& config) {
     
     // 验证 fastApproxThreshold
     if (validatedConfig.fastApproxThreshold < 0.0f || validatedConfig.fastApproxThreshold > 100.0f) {
-        LOGW("setConfig: Invalid fastApproxThreshold=%.2f, using default 4.5", 
+        LOGW("setConfig: Invalid fastApproxThreshold=%.2f, using default 3.0", 
              validatedConfig.fastApproxThreshold);
-        validatedConfig.fastApproxThreshold = 4.5f;
+        validatedConfig.fastApproxThreshold = 3.0f;
         configModified = true;
     }
     
@@ -470,6 +537,15 @@ void BilateralFilter::setConfig(const Config& config) {
         LOGW("setConfig: maxCacheMemoryMB is 0, cache will be effectively disabled");
     }
     
+    // 验证 cacheCompression
+    const int compression = static_cast<int>(validatedConfig.cacheCompression);
+    if (compression < static_cast<int>(CacheCompression::NONE) ||
+        compression > static_cast<int>(CacheCompression::LOSSLESS_DELTA)) {
+        LOGW("setConfig: Invalid cacheCompression=%d, using NONE", compression);
+        validatedConfig.cacheCompression = CacheCompression::NONE;
+        configModified = true;
+    }
+    
     if (configModified) {
         LOGI("setConfig: Configuration was modified during validation");
     } else {
@@ -483,6 +559,7 @@ void BilateralFilter::setConfig(const Config& config) {
     ImageHashCache& cache = ImageHashCache::getInstance();
     cache.setMaxSize(validatedConfig.maxCacheSize);
     cache.setMaxMemoryMB(validatedConfig.maxCacheMemoryMB);
+    cache.setCompression(validatedConfig.cacheCompression);
     
     // 记录新配置
     LOGI("setConfig: New configuration applied:");
@@ -493,6 +570,8 @@ void BilateralFilter::setConfig(const Config& config) {
     LOGI("  - maxCacheMemoryMB: %zu", s_config.maxCacheMemoryMB);
     LOGI("  - fastApproxThreshold: %.2f", s_config.fastApproxThreshold);
     LOGI("  - gpuThresholdPixels: %u", s_config.gpuThresholdPixels);
+    LOGI("  - sampledImageHash: %d", s_config.sampledImageHash);
+    LOGI("  - cacheCompression: %d", static_cast<int>(s_config.cacheCompression));
     
     // 记录配置变更摘要
     LOGI("setConfig: Configuration summary:");
@@ -531,8 +610,10 @@ void BilateralFilter::initializeDefaultConfig() {
     defaultConfig.enableGPU = true;
     defaultConfig.maxCacheSize = 100;
     defaultConfig.maxCacheMemoryMB = 512;
-    defaultConfig.fastApproxThreshold = 4.5f;
+    defaultConfig.fastApproxThreshold = 3.0f;
     defaultConfig.gpuThresholdPixels = 1500000;
+    defaultConfig.sampledImageHash = false;
+    defaultConfig.cacheCompression = CacheCompression::NONE;      // 有损压缩需调用方显式开启
     
     setConfig(defaultConfig);
     
@@ -544,6 +625,8 @@ void BilateralFilter::initializeDefaultConfig() {
     LOGI("  - maxCacheMemoryMB: %zu", defaultConfig.maxCacheMemoryMB);
     LOGI("  - fastApproxThreshold: %.2f", defaultConfig.fastApproxThreshold);
     LOGI("  - gpuThresholdPixels: %u", defaultConfig.gpuThresholdPixels);
+    LOGI("  - sampledImageHash: %d", defaultConfig.sampledImageHash);
+    LOGI("  - cacheCompression: %d", static_cast<int>(defaultConfig.cacheCompression));
 }
 
 std::string BilateralFilter::getConfigString() {
@@ -556,6 +639,8 @@ std::string BilateralFilter::getConfigString() {
     oss << "  maxCacheMemoryMB: " << s_config.maxCacheMemoryMB << "\n";
     oss << "  fastApproxThreshold: " << s_config.fastApproxThreshold << "\n";
     oss << "  gpuThresholdPixels: " << s_config.gpuThresholdPixels << "\n";
+    oss << "  sampledImageHash: " << (s_config.sampledImageHash ? "true" : "false") << "\n";
+    oss << "  cacheCompression: " << static_cast<int>(s_config.cacheCompression) << "\n";
     
     // Add statistics
     oss << "\nStatistics:\n";
@@ -579,6 +664,7 @@ BilateralFilter::Stats BilateralFilter::getStats() {
 
 void BilateralFilter::resetStats() {
     s_stats = Stats();
+    ImageHashCache::getInstance().resetStats();
     LOGI("resetStats: Statistics reset");
 }
 
@@ -2,7 +2,9 @@
 #define FILMTRACKER_BILATERAL_FILTER_H
 
 #include "raw_types.h"
+#include "compressed_image.h"
 #include <cstdint>
+#include <memory>
 #include <string>
 
 namespace filmtracker {
@@ -30,8 +32,10 @@ public:
         size_t maxCacheMemoryMB = 512;  // 最大缓存内存 512MB
         
         // 可调整的阈值
-        float fastApproxThreshold = 4.5f;     // 快速近似触发阈值（降低从5.0到4.5）
+        float fastApproxThreshold = 3.0f;     // 快速近似触发阈值（联合双边上采样后从4.5降到3.0）
         uint32_t gpuThresholdPixels = 1500000; // GPU加速触发阈值（降低从2MP到1.5MP）
+        bool sampledImageHash = false;         // 无来源标识的图像改用稀疏采样哈希作缓存键（默认完整哈希，采样可能误命中）
+        CacheCompression cacheCompression = CacheCompression::NONE;   // 缓存条目的压缩方式
     };
     
     /**
@@ -75,6 +79,23 @@ public:
                               float rangeSigma,
                               bool enableCache = true);
     
+    /**
+     * 应用带缓存的双边滤波器，返回共享的只读结果（零复制）
+     * 
+     * 命中时直接返回 ImageHashCache 中的缓冲区；未命中时计算结果并把同一缓冲区插入缓存。
+     * 需要就地修改结果时用 SharedImage::mutableImage() 写时复制。
+     * 
+     * @param input 输入图像
+     * @param spatialSigma 空间域标准差
+     * @param rangeSigma 强度域标准差
+     * @param enableCache 是否启用缓存（关闭时每次计算新缓冲区）
+     * @return 滤波结果（不为空）
+     */
+    static std::shared_ptr<const LinearImage> applyShared(const LinearImage& input,
+                                                          float spatialSigma,
+                                                          float rangeSigma,
+                                                          bool enableCache = true);
+    
     /**
      * 应用快速双边滤波器（使用可分离近似）
      * 
@@ -101,11 +122,13 @@ public:
      * @param detail 输出细节层（必须预先分配）
      * @param spatialSigma 空间域标准差
      * @param rangeSigma 强度域标准差
+     * @param enableCache 是否使用结果缓存（条带导出时关闭，避免缓存大量一次性条带）
      */
     static void extractDetail(const LinearImage& input,
                              LinearImage& detail,
                              float spatialSigma,
-                             float rangeSigma);
+                             float rangeSigma,
+                             bool enableCache = true);
     
     /**
      * 配置管理
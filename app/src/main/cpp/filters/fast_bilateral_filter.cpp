@@ -1,4 +1,5 @@
 #include "fast_bilateral_filter.h"
+#include "image_resampler.h"
 #include <cmath>
 #include <algorithm>
 #include <thread>
@@ -14,19 +15,20 @@ namespace filmtracker {
  * 计算降采样因子
  * 
  * 基于 spatialSigma 计算合适的降采样因子
- * 规则：spatialSigma / factor 应该在 2-4 的范围内，以保持滤波质量
+ * 规则：spatialSigma / factor 保持在 1.5-3 的范围内
+ * 上采样使用联合双边插值，边缘由全分辨率引导图恢复，因此可以更激进地降采样
  */
 int FastBilateralFilter::calculateDownsampleFactor(float spatialSigma) {
-    // 目标：降采样后的 spatialSigma 应该在 2-4 之间
-    // 这样可以保持滤波质量，同时减少计算量
+    // 目标：降采样后的 spatialSigma 应该在 1.5-3 之间
+    // 联合双边上采样不会跨边缘混合，8x/16x 降采样也不会产生光晕
     
-    if (spatialSigma <= 4.0f) {
+    if (spatialSigma < 3.0f) {
         return 1;  // 不降采样
-    } else if (spatialSigma <= 8.0f) {
+    } else if (spatialSigma < 6.0f) {
         return 2;
-    } else if (spatialSigma <= 16.0f) {
+    } else if (spatialSigma < 12.0f) {
         return 4;
-    } else if (spatialSigma <= 32.0f) {
+    } else if (spatialSigma < 24.0f) {
         return 8;
     } else {
         return 16;  // 最大降采样因子
@@ -36,101 +38,88 @@ int FastBilateralFilter::calculateDownsampleFactor(float spatialSigma) {
 /**
  * 降采样图像（使用区域平均）
  * 
- * 对每个 factor x factor 的区域计算平均值
+ * 对每个 factor x factor 的区域计算平均值（与图像原点对齐，边缘不完整的块只平均有效像素）
  */
 void FastBilateralFilter::downsample(
     const LinearImage& input,
     LinearImage& output,
     int factor
 ) {
-    const uint32_t inputWidth = input.width;
-    const uint32_t inputHeight = input.height;
-    const uint32_t outputWidth = (inputWidth + factor - 1) / factor;
-    const uint32_t outputHeight = (inputHeight + factor - 1) / factor;
-    
-    LOGI("downsample: %ux%u -> %ux%u (factor=%d)", 
-         inputWidth, inputHeight, outputWidth, outputHeight, factor);
-    
-    // 确保输出图像大小正确
-    if (output.width != outputWidth || output.height != outputHeight) {
-        output = LinearImage(outputWidth, outputHeight);
-    }
-    
-    const uint32_t numThreads = std::min(4u, std::thread::hardware_concurrency());
-    const uint32_t rowsPerThread = outputHeight / numThreads;
-    
-    std::vector<std::thread> threads;
-    for (uint32_t t = 0; t < numThreads; ++t) {
-        uint32_t startRow = t * rowsPerThread;
-        uint32_t endRow = (t == numThreads - 1) ? outputHeight : (t + 1) * rowsPerThread;
-        
-        threads.emplace_back([&input, &output, inputWidth, inputHeight, outputWidth, factor, startRow, endRow]() {
-            for (uint32_t outY = startRow; outY < endRow; ++outY) {
-                for (uint32_t outX = 0; outX < outputWidth; ++outX) {
-                    // 计算输入图像中对应的区域
-                    uint32_t inStartX = outX * factor;
-                    uint32_t inStartY = outY * factor;
-                    uint32_t inEndX = std::min(inStartX + factor, inputWidth);
-                    uint32_t inEndY = std::min(inStartY + factor, inputHeight);
-                    
-                    // 计算区域平均值
-                    float sumR = 0.0f, sumG = 0.0f, sumB = 0.0f;
-                    uint32_t count = 0;
-                    
-                    for (uint32_t inY = inStartY; inY < inEndY; ++inY) {
-                        for (uint32_t inX = inStartX; inX < inEndX; ++inX) {
-                            uint32_t inIdx = inY * inputWidth + inX;
-                            sumR += input.r[inIdx];
-                            sumG += input.g[inIdx];
-                            sumB += input.b[inIdx];
-                            count++;
-                        }
-                    }
-                    
-                    // 写入输出
-                    uint32_t outIdx = outY * outputWidth + outX;
-                    if (count > 0) {
-                        output.r[outIdx] = sumR / count;
-                        output.g[outIdx] = sumG / count;
-                        output.b[outIdx] = sumB / count;
-                    } else {
-                        output.r[outIdx] = 0.0f;
-                        output.g[outIdx] = 0.0f;
-                        output.b[outIdx] = 0.0f;
-                    }
-                }
-            }
-        });
-    }
-    
-    for (auto& thread : threads) {
-        thread.join();
-    }
+    LOGI("downsample: %ux%u (factor=%d)", input.width, input.height, factor);
+    ImageResampler::downsampleBlocks(input, output, static_cast<uint32_t>(std::max(factor, 1)));
 }
 
 /**
- * 上采样图像（使用双线性插值）
+ * 联合双边上采样
+ * 
+ * 低分辨率坐标 lx = (x + 0.5) / scale - 0.5，取 floor(lx)-1 .. floor(lx)+2 共 4x4 个采样点
+ * 空间权重可分离且只依赖列/行，预先按列、按行计算；强度权重使用查找表
  */
-void FastBilateralFilter::upsample(
-    const LinearImage& input,
+void FastBilateralFilter::jointBilateralUpsample(
+    const LinearImage& lowResult,
+    const LinearImage& lowGuide,
+    const LinearImage& fullGuide,
     LinearImage& output,
-    uint32_t targetWidth,
-    uint32_t targetHeight
+    float rangeSigma
 ) {
-    const uint32_t inputWidth = input.width;
-    const uint32_t inputHeight = input.height;
+    const uint32_t lowWidth = lowResult.width;
+    const uint32_t lowHeight = lowResult.height;
+    const uint32_t targetWidth = fullGuide.width;
+    const uint32_t targetHeight = fullGuide.height;
     
-    LOGI("upsample: %ux%u -> %ux%u", 
-         inputWidth, inputHeight, targetWidth, targetHeight);
+    LOGI("jointBilateralUpsample: %ux%u -> %ux%u, rangeSigma=%.3f", 
+         lowWidth, lowHeight, targetWidth, targetHeight, rangeSigma);
     
     // 确保输出图像大小正确
     if (output.width != targetWidth || output.height != targetHeight) {
         output = LinearImage(targetWidth, targetHeight);
     }
     
-    // 计算缩放比例
-    const float scaleX = static_cast<float>(inputWidth) / targetWidth;
-    const float scaleY = static_cast<float>(inputHeight) / targetHeight;
+    // 空间权重：低分辨率网格上的高斯，sigma 取 1 个低分辨率像素
+    const int kTaps = 4;
+    const float kSpatialSigma = 1.0f;
+    const float spatialDenom = 1.0f / (2.0f * kSpatialSigma * kSpatialSigma);
+    
+    auto buildAxis = [&](uint32_t target, uint32_t low,
+                         std::vector<uint32_t>& taps, std::vector<float>& weights) {
+        const float scale = static_cast<float>(low) / target;
+        taps.resize(static_cast<size_t>(target) * kTaps);
+        weights.resize(static_cast<size_t>(target) * kTaps);
+        for (uint32_t i = 0; i < target; ++i) {
+            float pos = (i + 0.5f) * scale - 0.5f;
+            int base = static_cast<int>(std::floor(pos)) - 1;
+            for (int k = 0; k < kTaps; ++k) {
+                int tap = base + k;
+                float d = pos - static_cast<float>(tap);
+                tap = std::max(0, std::min(tap, static_cast<int>(low) - 1));
+                taps[i * kTaps + k] = static_cast<uint32_t>(tap);
+                weights[i * kTaps + k] = std::exp(-d * d * spatialDenom);
+            }
+        }
+    };
+    
+    std::vector<uint32_t> tapX, tapY;
+    std::vector<float> weightX, weightY;
+    buildAxis(targetWidth, lowWidth, tapX, weightX);
+    buildAxis(targetHeight, lowHeight, tapY, weightY);
+    
+    // 低分辨率引导图亮度
+    std::vector<float> lowLuminance(static_cast<size_t>(lowWidth) * lowHeight);
+    for (size_t i = 0; i < lowLuminance.size(); ++i) {
+        lowLuminance[i] = 0.2126f * lowGuide.r[i] + 0.7152f * lowGuide.g[i] + 0.0722f * lowGuide.b[i];
+    }
+    
+    // 强度权重查找表：覆盖 [0, 4 * rangeSigma]，超出范围的权重视为 0
+    const int kLutSize = 256;
+    const float safeRangeSigma = std::max(rangeSigma, 1e-4f);
+    const float lutRange = 4.0f * safeRangeSigma;
+    const float lutScale = (kLutSize - 1) / lutRange;
+    std::vector<float> rangeLut(kLutSize + 1);
+    for (int i = 0; i < kLutSize; ++i) {
+        float d = i / lutScale;
+        rangeLut[i] = std::exp(-(d * d) / (2.0f * safeRangeSigma * safeRangeSigma));
+    }
+    rangeLut[kLutSize] = 0.0f;
     
     const uint32_t numThreads = std::min(4u, std::thread::hardware_concurrency());
     const uint32_t rowsPerThread = targetHeight / numThreads;
@@ -140,65 +129,51 @@ void FastBilateralFilter::upsample(
         uint32_t startRow = t * rowsPerThread;
         uint32_t endRow = (t == numThreads - 1) ? targetHeight : (t + 1) * rowsPerThread;
         
-        threads.emplace_back([&input, &output, inputWidth, inputHeight, targetWidth, scaleX, scaleY, startRow, endRow]() {
-            for (uint32_t outY = startRow; outY < endRow; ++outY) {
-                for (uint32_t outX = 0; outX < targetWidth; ++outX) {
-                    // 计算输入图像中的浮点坐标
-                    float srcX = (outX + 0.5f) * scaleX - 0.5f;
-                    float srcY = (outY + 0.5f) * scaleY - 0.5f;
-                    
-                    // 限制在有效范围内
-                    srcX = std::max(0.0f, std::min(srcX, static_cast<float>(inputWidth - 1)));
-                    srcY = std::max(0.0f, std::min(srcY, static_cast<float>(inputHeight - 1)));
-                    
-                    // 计算整数坐标和小数部分
-                    uint32_t x0 = static_cast<uint32_t>(srcX);
-                    uint32_t y0 = static_cast<uint32_t>(srcY);
-                    uint32_t x1 = std::min(x0 + 1, inputWidth - 1);
-                    uint32_t y1 = std::min(y0 + 1, inputHeight - 1);
-                    
-                    float fx = srcX - x0;
-                    float fy = srcY - y0;
-                    
-                    // 双线性插值
-                    uint32_t idx00 = y0 * inputWidth + x0;
-                    uint32_t idx01 = y0 * inputWidth + x1;
-                    uint32_t idx10 = y1 * inputWidth + x0;
-                    uint32_t idx11 = y1 * inputWidth + x1;
-                    
-                    float r00 = input.r[idx00];
-                    float r01 = input.r[idx01];
-                    float r10 = input.r[idx10];
-                    float r11 = input.r[idx11];
-                    
-                    float g00 = input.g[idx00];
-                    float g01 = input.g[idx01];
-                    float g10 = input.g[idx10];
-                    float g11 = input.g[idx11];
-                    
-                    float b00 = input.b[idx00];
-                    float b01 = input.b[idx01];
-                    float b10 = input.b[idx10];
-                    float b11 = input.b[idx11];
+        threads.emplace_back([&, startRow, endRow]() {
+            for (uint32_t y = startRow; y < endRow; ++y) {
+                const uint32_t* ty = &tapY[y * kTaps];
+                const float* wy = &weightY[y * kTaps];
+                
+                for (uint32_t x = 0; x < targetWidth; ++x) {
+                    const uint32_t* tx = &tapX[x * kTaps];
+                    const float* wx = &weightX[x * kTaps];
                     
-                    // 插值计算
-                    float r0 = r00 * (1.0f - fx) + r01 * fx;
-                    float r1 = r10 * (1.0f - fx) + r11 * fx;
-                    float r = r0 * (1.0f - fy) + r1 * fy;
+                    uint32_t outIdx = y * targetWidth + x;
+                    float guideLuminance = 0.2126f * fullGuide.r[outIdx] +
+                                           0.7152f * fullGuide.g[outIdx] +
+                                           0.0722f * fullGuide.b[outIdx];
                     
-                    float g0 = g00 * (1.0f - fx) + g01 * fx;
-                    float g1 = g10 * (1.0f - fx) + g11 * fx;
-                    float g = g0 * (1.0f - fy) + g1 * fy;
+                    float sumR = 0.0f, sumG = 0.0f, sumB = 0.0f;
+                    float sumWeight = 0.0f;
                     
-                    float b0 = b00 * (1.0f - fx) + b01 * fx;
-                    float b1 = b10 * (1.0f - fx) + b11 * fx;
-                    float b = b0 * (1.0f - fy) + b1 * fy;
+                    for (int j = 0; j < kTaps; ++j) {
+                        const uint32_t rowOffset = ty[j] * lowWidth;
+                        for (int i = 0; i < kTaps; ++i) {
+                            uint32_t lowIdx = rowOffset + tx[i];
+                            
+                            float rangeDist = std::abs(lowLuminance[lowIdx] - guideLuminance);
+                            int lutIdx = static_cast<int>(std::min(rangeDist * lutScale, static_cast<float>(kLutSize)));
+                            float weight = wx[i] * wy[j] * rangeLut[lutIdx];
+                            
+                            sumR += lowResult.r[lowIdx] * weight;
+                            sumG += lowResult.g[lowIdx] * weight;
+                            sumB += lowResult.b[lowIdx] * weight;
+                            sumWeight += weight;
+                        }
+                    }
                     
-                    // 写入输出
-                    uint32_t outIdx = outY * targetWidth + outX;
-                    output.r[outIdx] = r;
-                    output.g[outIdx] = g;
-                    output.b[outIdx] = b;
+                    if (sumWeight > 1e-6f) {
+                        float invWeight = 1.0f / sumWeight;
+                        output.r[outIdx] = sumR * invWeight;
+                        output.g[outIdx] = sumG * invWeight;
+                        output.b[outIdx] = sumB * invWeight;
+                    } else {
+                        // 引导像素与所有采样点差异都很大（孤立的细节），使用最近的采样点
+                        uint32_t nearestIdx = ty[1] * lowWidth + tx[1];
+                        output.r[outIdx] = lowResult.r[nearestIdx];
+                        output.g[outIdx] = lowResult.g[nearestIdx];
+                        output.b[outIdx] = lowResult.b[nearestIdx];
+                    }
                 }
             }
         });
@@ -316,7 +291,7 @@ void FastBilateralFilter::applyStandard(
  * 1. 根据 spatialSigma 计算降采样因子
  * 2. 降采样输入图像
  * 3. 在降采样图像上应用标准双边滤波（使用调整后的 spatialSigma）
- * 4. 上采样结果到原始分辨率
+ * 4. 以原始输入为引导图，联合双边上采样到原始分辨率
  */
 void FastBilateralFilter::apply(
     const LinearImage& input,
@@ -350,8 +325,8 @@ void FastBilateralFilter::apply(
     LinearImage filtered(downsampledWidth, downsampledHeight);
     applyStandard(downsampled, filtered, adjustedSpatialSigma, rangeSigma);
     
-    // 上采样到原始分辨率
-    upsample(filtered, output, input.width, input.height);
+    // 以原始输入为引导图上采样到原始分辨率
+    jointBilateralUpsample(filtered, downsampled, input, output, rangeSigma);
     
     LOGI("apply: Completed successfully");
 }
@@ -9,11 +9,13 @@ namespace filmtracker {
  * 快速近似双边滤波器
  * 
  * 基于 Paris & Durand (2006) 的降采样方法
- * 通过在降采样图像上应用标准双边滤波，然后上采样回原始分辨率
- * 在保持视觉质量的前提下实现 2-4 倍加速
+ * 通过在降采样图像上应用标准双边滤波，然后以全分辨率输入为引导图
+ * 做联合双边上采样（JBU），避免普通双线性上采样在边缘处产生光晕
+ * 因此可以使用 8x/16x 的大降采样因子，快速路径可覆盖绝大多数 sigma
  * 
  * 参考：
  * - Paris & Durand (2006) "A Fast Approximation of the Bilateral Filter"
+ * - Kopf et al. (2007) "Joint Bilateral Upsampling"
  */
 class FastBilateralFilter {
 public:
@@ -40,7 +42,7 @@ private:
      * spatialSigma 越大，可以使用更大的降采样因子
      * 
      * @param spatialSigma 空间域标准差
-     * @return 降采样因子（1, 2, 4, 8 等）
+     * @return 降采样因子（1, 2, 4, 8, 16）
      */
     static int calculateDownsampleFactor(float spatialSigma);
     
@@ -58,18 +60,24 @@ private:
     );
     
     /**
-     * 上采样图像（使用双线性插值）
+     * 联合双边上采样（以全分辨率输入为引导图）
      * 
-     * @param input 输入图像
-     * @param output 输出图像
-     * @param targetWidth 目标宽度
-     * @param targetHeight 目标高度
+     * 每个输出像素取低分辨率结果中 4x4 邻域的加权平均：
+     * 空间权重基于低分辨率网格距离，强度权重基于全分辨率引导像素亮度
+     * 与低分辨率引导像素亮度之差，因此不会跨越边缘混合
+     * 
+     * @param lowResult 低分辨率滤波结果
+     * @param lowGuide 低分辨率引导图（降采样后的输入）
+     * @param fullGuide 全分辨率引导图（原始输入）
+     * @param output 输出图像（尺寸与 fullGuide 相同）
+     * @param rangeSigma 强度域标准差
      */
-    static void upsample(
-        const LinearImage& input,
+    static void jointBilateralUpsample(
+        const LinearImage& lowResult,
+        const LinearImage& lowGuide,
+        const LinearImage& fullGuide,
         LinearImage& output,
-        uint32_t targetWidth,
-        uint32_t targetHeight
+        float rangeSigma
     );
     
     /**
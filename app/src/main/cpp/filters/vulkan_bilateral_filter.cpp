@@ -1,4 +1,5 @@
 #include "vulkan_bilateral_filter.h"
+#include "memory_governor.h"
 #include <android/log.h>
 #include <vector>
 #include <cstring>
@@ -790,6 +791,8 @@ bool VulkanBilateralFilter::executeComputeShader(
         vkFreeMemory(s_resources.device, inputMemory, nullptr);
         return false;
     }
+    // 主机可见的输入 / 输出缓冲区在函数返回前释放
+    MemoryCharge stagingCharge(MemoryCategory::GPU_STAGING, static_cast<size_t>(bufferSize) * 2);
     
     // 4. 将输入数据传输到 GPU
     void* data;
@@ -1,5 +1,7 @@
 #include "jni_common.h"
 #include "../filters/bilateral_filter.h"
+#include "../core/image_hash_cache.h"
+#include "../core/result_spill_cache.h"
 
 using namespace filmtracker;
 
@@ -17,7 +19,9 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeSetConfig(
     jint maxCacheSize,
     jint maxCacheMemoryMB,
     jfloat fastApproxThreshold,
-    jint gpuThresholdPixels) {
+    jint gpuThresholdPixels,
+    jboolean sampledImageHash,
+    jint cacheCompression) {
     
     LOGI("========== JNI: BilateralFilter Configuration Request ==========");
     LOGI("nativeSetConfig: Received configuration from Kotlin layer:");
@@ -28,6 +32,8 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeSetConfig(
     LOGI("  - maxCacheMemoryMB: %d", maxCacheMemoryMB);
     LOGI("  - fastApproxThreshold: %.2f", fastApproxThreshold);
     LOGI("  - gpuThresholdPixels: %d", gpuThresholdPixels);
+    LOGI("  - sampledImageHash: %d", sampledImageHash);
+    LOGI("  - cacheCompression: %d", cacheCompression);
     
     BilateralFilter::Config config;
     config.enableCache = enableCache;
@@ -37,6 +43,8 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeSetConfig(
     config.maxCacheMemoryMB = static_cast<size_t>(maxCacheMemoryMB);
     config.fastApproxThreshold = fastApproxThreshold;
     config.gpuThresholdPixels = static_cast<uint32_t>(gpuThresholdPixels);
+    config.sampledImageHash = sampledImageHash;
+    config.cacheCompression = static_cast<CacheCompression>(cacheCompression);
     
     LOGI("nativeSetConfig: Passing configuration to C++ layer...");
     BilateralFilter::setConfig(config);
@@ -62,7 +70,7 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeGetConfig(
     }
     
     // 尝试查找全参数构造函数
-    jmethodID constructor = env->GetMethodID(configClass, "<init>", "(ZZZIIIFI)V");
+    jmethodID constructor = env->GetMethodID(configClass, "<init>", "(ZZZIIIFIZI)V");
     
     if (constructor) {
         // 如果找到了构造函数，直接使用
@@ -73,7 +81,9 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeGetConfig(
             static_cast<jint>(config.maxCacheSize),
             static_cast<jint>(config.maxCacheMemoryMB),
             static_cast<jfloat>(config.fastApproxThreshold),
-            static_cast<jint>(config.gpuThresholdPixels));
+            static_cast<jint>(config.gpuThresholdPixels),
+            static_cast<jboolean>(config.sampledImageHash),
+            static_cast<jint>(config.cacheCompression));
         return configObj;
     }
     
@@ -99,10 +109,12 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeGetConfig(
     jfieldID maxCacheMemoryMBField = env->GetFieldID(configClass, "maxCacheMemoryMB", "I");
     jfieldID fastApproxThresholdField = env->GetFieldID(configClass, "fastApproxThreshold", "F");
     jfieldID gpuThresholdPixelsField = env->GetFieldID(configClass, "gpuThresholdPixels", "I");
+    jfieldID sampledImageHashField = env->GetFieldID(configClass, "sampledImageHash", "Z");
+    jfieldID cacheCompressionField = env->GetFieldID(configClass, "cacheCompression", "I");
     
     if (!enableCacheField || !enableFastApproxField || !enableGPUField || 
         !maxCacheSizeField || !maxCacheMemoryMBField || !fastApproxThresholdField || 
-        !gpuThresholdPixelsField) {
+        !gpuThresholdPixelsField || !sampledImageHashField || !cacheCompressionField) {
         LOGE("Failed to find one or more Config fields");
         return nullptr;
     }
@@ -114,6 +126,8 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeGetConfig(
     env->SetIntField(configObj, maxCacheMemoryMBField, config.maxCacheMemoryMB);
     env->SetFloatField(configObj, fastApproxThresholdField, config.fastApproxThreshold);
     env->SetIntField(configObj, gpuThresholdPixelsField, config.gpuThresholdPixels);
+    env->SetBooleanField(configObj, sampledImageHashField, config.sampledImageHash);
+    env->SetIntField(configObj, cacheCompressionField, static_cast<jint>(config.cacheCompression));
     
     return configObj;
 }
@@ -165,6 +179,103 @@ Java_com_filmtracker_app_native_BilateralFilterNative_nativeResetStats(
     LOGI("BilateralFilter stats reset");
 }
 
+/**
+ * 获取结果缓存统计
+ * 返回 [hits, misses, inserts, evictions, bytesServed, bytesInserted, entries, memoryBytes, spillHits,
+ *       logicalBytes, decompressions, decompressNs]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_BilateralFilterNative_nativeGetCacheStats(
+    JNIEnv *env, jclass clazz) {
+    
+    ImageHashCache::Stats stats = ImageHashCache::getInstance().getStats();
+    jlong values[12] = {
+        static_cast<jlong>(stats.hits),
+        static_cast<jlong>(stats.misses),
+        static_cast<jlong>(stats.inserts),
+        static_cast<jlong>(stats.evictions),
+        static_cast<jlong>(stats.bytesServed),
+        static_cast<jlong>(stats.bytesInserted),
+        static_cast<jlong>(stats.entries),
+        static_cast<jlong>(stats.memoryBytes),
+        static_cast<jlong>(stats.spillHits),
+        static_cast<jlong>(stats.logicalBytes),
+        static_cast<jlong>(stats.decompressions),
+        static_cast<jlong>(stats.decompressNs)
+    };
+    
+    jlongArray result = env->NewLongArray(12);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result, 0, 12, values);
+    return result;
+}
+
+/**
+ * 初始化结果缓存的磁盘溢出层
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_BilateralFilterNative_nativeInitSpillCache(
+    JNIEnv *env, jclass clazz, jstring cacheDir, jint maxSizeMB) {
+    
+    if (cacheDir == nullptr || maxSizeMB < 0) {
+        LOGE("nativeInitSpillCache: Invalid arguments");
+        return JNI_FALSE;
+    }
+    
+    const char* dir = env->GetStringUTFChars(cacheDir, nullptr);
+    if (dir == nullptr) {
+        LOGE("Failed to get string chars");
+        return JNI_FALSE;
+    }
+    
+    bool success = ResultSpillCache::getInstance().initialize(dir, static_cast<size_t>(maxSizeMB));
+    env->ReleaseStringUTFChars(cacheDir, dir);
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 获取磁盘溢出层统计
+ * 返回 [hits, pendingHits, misses, writes, writeFailures, dropped, evictions,
+ *       bytesRead, bytesWritten, entryCount, totalBytes, pendingBytes]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_BilateralFilterNative_nativeGetSpillCacheStats(
+    JNIEnv *env, jclass clazz) {
+    
+    ResultSpillCache::Stats stats = ResultSpillCache::getInstance().getStats();
+    jlong values[12] = {
+        static_cast<jlong>(stats.hits),
+        static_cast<jlong>(stats.pendingHits),
+        static_cast<jlong>(stats.misses),
+        static_cast<jlong>(stats.writes),
+        static_cast<jlong>(stats.writeFailures),
+        static_cast<jlong>(stats.dropped),
+        static_cast<jlong>(stats.evictions),
+        static_cast<jlong>(stats.bytesRead),
+        static_cast<jlong>(stats.bytesWritten),
+        static_cast<jlong>(stats.entryCount),
+        static_cast<jlong>(stats.totalBytes),
+        static_cast<jlong>(stats.pendingBytes)
+    };
+    
+    jlongArray result = env->NewLongArray(12);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 12, values);
+    }
+    return result;
+}
+
+/**
+ * 清空磁盘溢出层
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_BilateralFilterNative_nativeClearSpillCache(
+    JNIEnv *env, jclass clazz) {
+    ResultSpillCache::getInstance().clear();
+}
+
 /**
  * 清除双边滤波器缓存
  */
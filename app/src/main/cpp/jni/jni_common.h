@@ -3,6 +3,8 @@
 
 #include <jni.h>
 #include <android/log.h>
+#include "../core/image_handle.h"
+#include <utility>
 
 #define LOG_TAG "FilmTracker"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -30,6 +32,27 @@ inline void setNativeHandle(JNIEnv* env, jobject obj, jlong handle, const char*
     env->SetLongField(obj, fieldID, handle);
 }
 
+/**
+ * 把图像交给 Java 层持有（新建写时复制句柄）
+ */
+inline jlong toImageHandle(LinearImage&& image) {
+    return reinterpret_cast<jlong>(ImageHandle::create(std::move(image)));
+}
+
+/**
+ * 把共享图像交给 Java 层持有（不复制像素）
+ */
+inline jlong toImageHandle(SharedImage image) {
+    return reinterpret_cast<jlong>(ImageHandle::create(std::move(image)));
+}
+
+/**
+ * Java 层持有的图像句柄
+ */
+inline ImageHandle* imageHandle(jlong handle) {
+    return reinterpret_cast<ImageHandle*>(handle);
+}
+
 } // namespace jni
 } // namespace filmtracker
 
@@ -14,7 +14,8 @@ JNIEXPORT jintArray JNICALL
 Java_com_filmtracker_app_native_ImageConverterNative_nativeGetImageSize(
     JNIEnv *env, jobject thiz, jlong imagePtr) {
     
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* handle = jni::imageHandle(imagePtr);
+    const LinearImage* image = handle ? &handle->read() : nullptr;
     if (!image) {
         return nullptr;
     }
@@ -34,7 +35,8 @@ Java_com_filmtracker_app_native_ImageConverterNative_nativeLinearToSRGB(
     
     LOGI("nativeLinearToSRGB: Starting");
     
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* handle = jni::imageHandle(imagePtr);
+    const LinearImage* image = handle ? &handle->read() : nullptr;
     if (!image) {
         LOGE("nativeLinearToSRGB: Image pointer is null");
         return nullptr;
@@ -69,6 +71,86 @@ Java_com_filmtracker_app_native_ImageConverterNative_nativeLinearToSRGB(
     }
 }
 
+/**
+ * 直接写入 Bitmap 像素（ARGB_8888 写 sRGB 8 位，RGBA_1010102 写 sRGB 10 位，RGBA_F16 写线性 fp16），
+ * 不经过中间 OutputImage 和 jbyteArray
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_ImageConverterNative_nativeLinearToBitmap(
+    JNIEnv *env, jobject thiz, jlong imagePtr, jobject bitmap) {
+    
+    ImageHandle* handle = jni::imageHandle(imagePtr);
+    const LinearImage* image = handle ? &handle->read() : nullptr;
+    if (!image || bitmap == nullptr) {
+        LOGE("nativeLinearToBitmap: Invalid arguments");
+        return JNI_FALSE;
+    }
+    
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("nativeLinearToBitmap: Failed to get bitmap info");
+        return JNI_FALSE;
+    }
+    if (info.width != image->width || info.height != image->height) {
+        LOGE("nativeLinearToBitmap: Size mismatch %ux%u vs %ux%u",
+             info.width, info.height, image->width, image->height);
+        return JNI_FALSE;
+    }
+    
+    OutputPixelFormat format;
+    if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        format = OutputPixelFormat::RGBA_8888;
+    } else if (info.format == ANDROID_BITMAP_FORMAT_RGBA_F16) {
+        format = OutputPixelFormat::RGBA_F16;
+    } else if (info.format == ANDROID_BITMAP_FORMAT_RGBA_1010102) {
+        format = OutputPixelFormat::RGBA_1010102;
+    } else {
+        LOGE("nativeLinearToBitmap: Unsupported bitmap format: %d", info.format);
+        return JNI_FALSE;
+    }
+    
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("nativeLinearToBitmap: Failed to lock bitmap pixels");
+        return JNI_FALSE;
+    }
+    bool success = ImageConverter::writePixels(*image, format, pixels, info.stride);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 直接写入调用方的直接 ByteBuffer（例如编码器输入缓冲区）
+ * 
+ * @param format OutputPixelFormat（0 = RGBA_8888，1 = RGBA_16，2 = RGBA_F16，3 = RGBA_1010102）
+ * @param rowStride 行字节数，0 表示紧密排列
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_ImageConverterNative_nativeLinearToBuffer(
+    JNIEnv *env, jobject thiz, jlong imagePtr, jobject buffer, jint format, jint rowStride) {
+    
+    ImageHandle* handle = jni::imageHandle(imagePtr);
+    const LinearImage* image = handle ? &handle->read() : nullptr;
+    if (!image || buffer == nullptr || format < 0 || format > static_cast<jint>(OutputPixelFormat::RGBA_1010102) || rowStride < 0) {
+        LOGE("nativeLinearToBuffer: Invalid arguments");
+        return JNI_FALSE;
+    }
+    
+    const OutputPixelFormat pixelFormat = static_cast<OutputPixelFormat>(format);
+    const size_t rowBytes = static_cast<size_t>(image->width) * ImageConverter::bytesPerPixel(pixelFormat);
+    const size_t stride = rowStride > 0 ? static_cast<size_t>(rowStride) : rowBytes;
+    void* address = env->GetDirectBufferAddress(buffer);
+    const jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (!address || image->height == 0 || capacity < 0 ||
+        static_cast<size_t>(capacity) < stride * (image->height - 1) + rowBytes) {
+        LOGE("nativeLinearToBuffer: Buffer is not direct or too small (capacity=%lld)",
+             static_cast<long long>(capacity));
+        return JNI_FALSE;
+    }
+    
+    return ImageConverter::writePixels(*image, pixelFormat, address, stride) ? JNI_TRUE : JNI_FALSE;
+}
+
 /**
  * 转换为输出图像（sRGB），使用误差扩散抖动
  * 
@@ -81,7 +163,8 @@ Java_com_filmtracker_app_native_ImageConverterNative_nativeLinearToSRGBWithDithe
     
     LOGI("nativeLinearToSRGBWithDithering: Starting");
     
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* handle = jni::imageHandle(imagePtr);
+    const LinearImage* image = handle ? &handle->read() : nullptr;
     if (!image) {
         LOGE("nativeLinearToSRGBWithDithering: Image pointer is null");
         return nullptr;
@@ -116,6 +199,42 @@ Java_com_filmtracker_app_native_ImageConverterNative_nativeLinearToSRGBWithDithe
     }
 }
 
+/**
+ * 抖动输出基准测试：融合输出阶段 vs 多遍流程
+ * 返回 [fusedMs, multiPassMs, fusedTrafficEstimateMB, multiPassTrafficEstimateMB, fusedScratchMB, multiPassScratchMB]
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_filmtracker_app_native_ImageConverterNative_nativeBenchmarkDitheredOutput(
+    JNIEnv *env, jobject thiz, jint width, jint height, jint iterations) {
+    
+    if (width <= 0 || height <= 0 || iterations <= 0) {
+        LOGE("nativeBenchmarkDitheredOutput: Invalid arguments");
+        return nullptr;
+    }
+    
+    try {
+        DitherBenchmarkResult result = ImageConverter::benchmarkDitheredOutput(
+            static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(iterations));
+        jdouble values[6] = {
+            result.fusedMs,
+            result.multiPassMs,
+            result.fusedTrafficEstimateMB,
+            result.multiPassTrafficEstimateMB,
+            result.fusedScratchMB,
+            result.multiPassScratchMB
+        };
+        jdoubleArray array = env->NewDoubleArray(6);
+        if (array == nullptr) {
+            return nullptr;
+        }
+        env->SetDoubleArrayRegion(array, 0, 6, values);
+        return array;
+    } catch (const std::exception& e) {
+        LOGE("Exception in dithered output benchmark: %s", e.what());
+        return nullptr;
+    }
+}
+
 /**
  * 克隆线性图像
  */
@@ -123,27 +242,14 @@ JNIEXPORT jlong JNICALL
 Java_com_filmtracker_app_native_ImageConverterNative_nativeCloneLinearImage(
     JNIEnv *env, jobject thiz, jlong imagePtr) {
     
-    LinearImage* source = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* source = jni::imageHandle(imagePtr);
     if (!source) {
         LOGE("Source image pointer is null");
         return 0;
     }
     
-    try {
-        // 创建新的 LinearImage 并复制数据
-        LinearImage* cloned = new LinearImage(source->width, source->height);
-        
-        // 复制像素数据
-        uint32_t pixelCount = source->width * source->height;
-        std::copy(source->r.begin(), source->r.end(), cloned->r.begin());
-        std::copy(source->g.begin(), source->g.end(), cloned->g.begin());
-        std::copy(source->b.begin(), source->b.end(), cloned->b.begin());
-        
-        return reinterpret_cast<jlong>(cloned);
-    } catch (const std::exception& e) {
-        LOGE("Failed to clone image: %s", e.what());
-        return 0;
-    }
+    // 只增加引用计数：两个句柄共用像素，任一方首次写入时才复制
+    return reinterpret_cast<jlong>(source->clone());
 }
 
 /**
@@ -153,10 +259,7 @@ JNIEXPORT void JNICALL
 Java_com_filmtracker_app_native_ImageConverterNative_nativeReleaseImage(
     JNIEnv *env, jobject thiz, jlong imagePtr) {
     
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
-    if (image) {
-        delete image;
-    }
+    delete jni::imageHandle(imagePtr);
 }
 
 /**
@@ -219,8 +322,7 @@ Java_com_filmtracker_app_native_ImageConverterNative_nativeBitmapToLinear(
             
             AndroidBitmap_unlockPixels(env, bitmap);
             
-            LinearImage* linearPtr = new LinearImage(std::move(linear));
-            return reinterpret_cast<jlong>(linearPtr);
+            return jni::toImageHandle(std::move(linear));
         } else {
             LinearImage linear = ImageConverter::sRGBToLinear(
                 pixelData,
@@ -230,8 +332,7 @@ Java_com_filmtracker_app_native_ImageConverterNative_nativeBitmapToLinear(
             
             AndroidBitmap_unlockPixels(env, bitmap);
             
-            LinearImage* linearPtr = new LinearImage(std::move(linear));
-            return reinterpret_cast<jlong>(linearPtr);
+            return jni::toImageHandle(std::move(linear));
         }
     } catch (const std::exception& e) {
         AndroidBitmap_unlockPixels(env, bitmap);
@@ -0,0 +1,86 @@
+#include "jni_common.h"
+#include "../encoder/image_encoder.h"
+#include <android/bitmap.h>
+#include <exception>
+
+using namespace filmtracker;
+
+extern "C" {
+
+/**
+ * 把 Bitmap 像素流式编码写入文件描述符（同步）
+ *
+ * 直接读取锁定的像素，不复制整幅图像；行块在编码器工作线程上并行压缩。
+ * ARGB_8888 可编码为 JPEG / PNG / TIFF（8 位），RGBA_F16 只能编码为浮点 TIFF。
+ * 输出文件嵌入 Bitmap 色彩空间对应的 ICC 配置文件（例如 Display P3 的 Bitmap 不会被当作 sRGB 显示）。
+ *
+ * @param fd 可写文件描述符（由调用方持有和关闭）
+ * @param format EncodeFormat（0 = JPEG，1 = PNG，2 = TIFF）
+ * @param quality JPEG 质量 1-100
+ * @param colorSpace EncodeColorSpace（由 Kotlin 层根据 Bitmap.getColorSpace() 确定）
+ * @return [bytesWritten, blocks, encodeMicros]，失败返回 null
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_ImageEncoderNative_nativeEncodeBitmap(
+    JNIEnv *env, jobject thiz, jobject bitmap, jint fd, jint format, jint quality, jint colorSpace) {
+
+    if (bitmap == nullptr || fd < 0 || format < 0 || format > static_cast<jint>(EncodeFormat::TIFF) ||
+        colorSpace < 0 || colorSpace > static_cast<jint>(EncodeColorSpace::LINEAR_SRGB)) {
+        LOGE("nativeEncodeBitmap: Invalid arguments");
+        return nullptr;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("nativeEncodeBitmap: Failed to get bitmap info");
+        return nullptr;
+    }
+
+    EncodeOptions options;
+    options.format = static_cast<EncodeFormat>(format);
+    options.quality = quality;
+    options.colorSpace = static_cast<EncodeColorSpace>(colorSpace);
+    if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        options.pixelFormat = OutputPixelFormat::RGBA_8888;
+    } else if (info.format == ANDROID_BITMAP_FORMAT_RGBA_F16) {
+        options.pixelFormat = OutputPixelFormat::RGBA_F16;
+    } else {
+        LOGE("nativeEncodeBitmap: Unsupported bitmap format: %d", info.format);
+        return nullptr;
+    }
+
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("nativeEncodeBitmap: Failed to lock bitmap pixels");
+        return nullptr;
+    }
+
+    ImageEncoder encoder(options, ImageEncoder::fdWriter(fd));
+    bool success = false;
+    try {
+        success = encoder.begin(info.width, info.height) &&
+                  encoder.writeRows(static_cast<const uint8_t*>(pixels), info.height, info.stride) &&
+                  encoder.finish();
+    } catch (const std::exception& e) {
+        LOGE("nativeEncodeBitmap: Exception: %s", e.what());
+        success = false;
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+    if (!success) {
+        return nullptr;
+    }
+
+    const EncodeStats& stats = encoder.getStats();
+    jlong values[3] = {
+        static_cast<jlong>(stats.bytesWritten),
+        static_cast<jlong>(stats.blocks),
+        static_cast<jlong>(stats.encodeSeconds * 1e6)
+    };
+    jlongArray result = env->NewLongArray(3);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+} // extern "C"
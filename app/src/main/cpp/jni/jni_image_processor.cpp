@@ -24,14 +24,14 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyBasicAdjus
     jfloat exposure, jfloat contrast, jfloat saturation) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     
     if (!engine || !image) {
         LOGE("Invalid pointers in nativeApplyBasicAdjustments");
         return;
     }
     
-    engine->applyBasicAdjustments(*image, exposure, contrast, saturation);
+    engine->applyBasicAdjustments(image->write(), exposure, contrast, saturation);
 }
 
 /**
@@ -43,14 +43,14 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyToneAdjust
     jfloat highlights, jfloat shadows, jfloat whites, jfloat blacks) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     
     if (!engine || !image) {
         LOGE("Invalid pointers in nativeApplyToneAdjustments");
         return;
     }
     
-    engine->applyToneAdjustments(*image, highlights, shadows, whites, blacks);
+    engine->applyToneAdjustments(image->write(), highlights, shadows, whites, blacks);
 }
 
 /**
@@ -62,14 +62,14 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyPresence(
     jfloat clarity, jfloat vibrance) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     
     if (!engine || !image) {
         LOGE("Invalid pointers in nativeApplyPresence");
         return;
     }
     
-    engine->applyPresence(*image, clarity, vibrance);
+    engine->applyPresence(image->write(), clarity, vibrance);
 }
 
 /**
@@ -80,7 +80,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyToneCurves
     JNIEnv *env, jobject thiz, jlong enginePtr, jlong imagePtr, jlong paramsPtr) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsPtr);
     
     if (!engine || !image) {
@@ -99,7 +99,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyToneCurves
     }
     
     LOGI("nativeApplyToneCurves: Applying curves");
-    engine->applyToneCurves(*image, *params->curveParams);
+    engine->applyToneCurves(image->write(), *params->curveParams);
 }
 
 /**
@@ -110,7 +110,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyHSL(
     JNIEnv *env, jobject thiz, jlong enginePtr, jlong imagePtr, jlong paramsPtr) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsPtr);
     
     if (!engine || !image || !params) {
@@ -129,7 +129,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyHSL(
     }
     
     LOGI("nativeApplyHSL: Applying HSL adjustments");
-    engine->applyHSL(*image, *params->hslParams);
+    engine->applyHSL(image->write(), *params->hslParams);
 }
 
 /**
@@ -140,7 +140,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyColorAdjus
     JNIEnv *env, jobject thiz, jlong enginePtr, jlong imagePtr, jlong paramsPtr) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsPtr);
     
     if (!engine || !image || !params) {
@@ -148,7 +148,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyColorAdjus
         return;
     }
     
-    engine->applyColorAdjustments(*image, *params);
+    engine->applyColorAdjustments(image->write(), *params);
 }
 
 /**
@@ -159,7 +159,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyEffects(
     JNIEnv *env, jobject thiz, jlong enginePtr, jlong imagePtr, jlong paramsPtr) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsPtr);
     
     if (!engine || !image || !params) {
@@ -167,7 +167,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyEffects(
         return;
     }
     
-    engine->applyEffects(*image, *params);
+    engine->applyEffects(image->write(), *params);
 }
 
 /**
@@ -178,7 +178,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyDetails(
     JNIEnv *env, jobject thiz, jlong enginePtr, jlong imagePtr, jlong paramsPtr) {
     
     ImageProcessorEngine* engine = reinterpret_cast<ImageProcessorEngine*>(enginePtr);
-    LinearImage* image = reinterpret_cast<LinearImage*>(imagePtr);
+    ImageHandle* image = jni::imageHandle(imagePtr);
     BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsPtr);
     
     if (!engine || !image || !params) {
@@ -186,7 +186,7 @@ Java_com_filmtracker_app_native_ImageProcessorEngineNative_nativeApplyDetails(
         return;
     }
     
-    engine->applyDetails(*image, *params);
+    engine->applyDetails(image->write(), *params);
 }
 
 /**
@@ -0,0 +1,94 @@
+#include "jni_common.h"
+#include "../core/image_resampler.h"
+#include <android/bitmap.h>
+#include <exception>
+
+using namespace filmtracker;
+
+namespace {
+
+ResampleFilter toFilter(jint filter) {
+    switch (filter) {
+        case static_cast<jint>(ResampleFilter::BOX):
+            return ResampleFilter::BOX;
+        case static_cast<jint>(ResampleFilter::BICUBIC):
+            return ResampleFilter::BICUBIC;
+        default:
+            return ResampleFilter::LANCZOS3;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+/**
+ * 缩放 Bitmap（RGBA_8888 -> RGBA_8888，目标 Bitmap 由调用方创建）
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_ImageResamplerNative_nativeResizeBitmap(
+    JNIEnv *env, jobject thiz, jobject source, jobject target, jint filter) {
+
+    if (source == nullptr || target == nullptr) {
+        LOGE("nativeResizeBitmap: Bitmap is null");
+        return JNI_FALSE;
+    }
+
+    AndroidBitmapInfo srcInfo;
+    AndroidBitmapInfo dstInfo;
+    if (AndroidBitmap_getInfo(env, source, &srcInfo) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        AndroidBitmap_getInfo(env, target, &dstInfo) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("nativeResizeBitmap: Failed to get bitmap info");
+        return JNI_FALSE;
+    }
+    if (srcInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888 ||
+        dstInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("nativeResizeBitmap: Unsupported bitmap format %d -> %d", srcInfo.format, dstInfo.format);
+        return JNI_FALSE;
+    }
+
+    void* srcPixels = nullptr;
+    void* dstPixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, source, &srcPixels) != ANDROID_BITMAP_RESULT_SUCCESS || !srcPixels) {
+        LOGE("nativeResizeBitmap: Failed to lock source pixels");
+        return JNI_FALSE;
+    }
+    if (AndroidBitmap_lockPixels(env, target, &dstPixels) != ANDROID_BITMAP_RESULT_SUCCESS || !dstPixels) {
+        LOGE("nativeResizeBitmap: Failed to lock target pixels");
+        AndroidBitmap_unlockPixels(env, source);
+        return JNI_FALSE;
+    }
+
+    ImageResampler::resizeRgba8(static_cast<const uint8_t*>(srcPixels), srcInfo.width, srcInfo.height, srcInfo.stride,
+                                static_cast<uint8_t*>(dstPixels), dstInfo.width, dstInfo.height, dstInfo.stride,
+                                toFilter(filter));
+
+    AndroidBitmap_unlockPixels(env, target);
+    AndroidBitmap_unlockPixels(env, source);
+    return JNI_TRUE;
+}
+
+/**
+ * 缩放线性图像，返回新的图像句柄（调用方负责释放）
+ */
+JNIEXPORT jlong JNICALL
+Java_com_filmtracker_app_native_ImageResamplerNative_nativeResizeLinear(
+    JNIEnv *env, jobject thiz, jlong imagePtr, jint width, jint height, jint filter) {
+
+    ImageHandle* source = jni::imageHandle(imagePtr);
+    if (!source || width <= 0 || height <= 0) {
+        LOGE("nativeResizeLinear: Invalid arguments");
+        return 0;
+    }
+
+    try {
+        LinearImage resized(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+        ImageResampler::resize(source->read(), resized, toFilter(filter));
+        return jni::toImageHandle(std::move(resized));
+    } catch (const std::exception& e) {
+        LOGE("nativeResizeLinear: %s", e.what());
+        return 0;
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,75 @@
+#include "jni_common.h"
+#include "../core/memory_governor.h"
+#include <algorithm>
+
+using namespace filmtracker;
+
+namespace {
+
+// 每个分类 3 个值（current / peak / charges），之后是汇总字段
+constexpr jsize kStatsLength = static_cast<jsize>(kMemoryCategoryCount * 3 + 6);
+
+} // namespace
+
+extern "C" {
+
+/**
+ * 设置预算（MB，0 表示不限制），超出时立即回收
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_MemoryGovernorNative_nativeSetBudgetMB(
+    JNIEnv *env, jobject thiz, jint budgetMB) {
+    MemoryGovernor& governor = MemoryGovernor::getInstance();
+    governor.setBudgetMB(static_cast<size_t>(std::max(0, budgetMB)));
+    governor.enforceBudget();
+}
+
+/**
+ * 按级别回收（转发 ComponentCallbacks2.onTrimMemory）
+ *
+ * @return 释放的字节数
+ */
+JNIEXPORT jlong JNICALL
+Java_com_filmtracker_app_native_MemoryGovernorNative_nativeTrim(
+    JNIEnv *env, jobject thiz, jint level) {
+    return static_cast<jlong>(MemoryGovernor::getInstance().trim(static_cast<TrimLevel>(level)));
+}
+
+/**
+ * 获取统计
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_MemoryGovernorNative_nativeGetStats(
+    JNIEnv *env, jobject thiz) {
+    MemoryGovernor::Stats stats = MemoryGovernor::getInstance().getStats();
+    jlong values[kStatsLength];
+    jsize index = 0;
+    for (const auto& category : stats.categories) {
+        values[index++] = static_cast<jlong>(category.currentBytes);
+        values[index++] = static_cast<jlong>(category.peakBytes);
+        values[index++] = static_cast<jlong>(category.charges);
+    }
+    values[index++] = static_cast<jlong>(stats.totalBytes);
+    values[index++] = static_cast<jlong>(stats.budgetBytes);
+    values[index++] = static_cast<jlong>(stats.trims);
+    values[index++] = static_cast<jlong>(stats.budgetTrims);
+    values[index++] = static_cast<jlong>(stats.bytesTrimmed);
+    values[index++] = static_cast<jlong>(stats.lastTrimLevel);
+
+    jlongArray result = env->NewLongArray(kStatsLength);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kStatsLength, values);
+    }
+    return result;
+}
+
+/**
+ * 把峰值重置为当前用量
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_MemoryGovernorNative_nativeResetPeaks(
+    JNIEnv *env, jobject thiz) {
+    MemoryGovernor::getInstance().resetPeaks();
+}
+
+} // extern "C"
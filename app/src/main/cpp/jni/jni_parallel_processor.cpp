@@ -25,8 +25,8 @@ Java_com_filmtracker_app_native_ParallelProcessorNative_nativeProcess(
     jlong outputImagePtr, jlong paramsPtr) {
     
     ParallelProcessor* processor = reinterpret_cast<ParallelProcessor*>(processorPtr);
-    filmtracker::LinearImage* inputImage = reinterpret_cast<filmtracker::LinearImage*>(inputImagePtr);
-    filmtracker::LinearImage* outputImage = reinterpret_cast<filmtracker::LinearImage*>(outputImagePtr);
+    filmtracker::ImageHandle* inputImage = filmtracker::jni::imageHandle(inputImagePtr);
+    filmtracker::ImageHandle* outputImage = filmtracker::jni::imageHandle(outputImagePtr);
     filmtracker::BasicAdjustmentParams* params = reinterpret_cast<filmtracker::BasicAdjustmentParams*>(paramsPtr);
     
     if (!processor || !inputImage || !outputImage || !params) {
@@ -34,7 +34,9 @@ Java_com_filmtracker_app_native_ParallelProcessorNative_nativeProcess(
         return;
     }
     
-    processor->process(*inputImage, *outputImage, *params);
+    // 先取得输出的私有副本：输入输出是同一句柄时，写时复制不会让输入引用失效
+    filmtracker::LinearImage& output = outputImage->write();
+    processor->process(inputImage->read(), output, *params);
 }
 
 /**
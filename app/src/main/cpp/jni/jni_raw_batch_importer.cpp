@@ -0,0 +1,251 @@
+#include "jni_common.h"
+#include "../raw/raw_batch_importer.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+/**
+ * Native 句柄：导入器 + Java 监听器
+ */
+struct BatchImporterHandle {
+    std::unique_ptr<RawBatchImporter> importer;
+    JavaVM* vm = nullptr;
+    jobject listener = nullptr;         // 全局引用
+    JNIEnv* deliveryEnv = nullptr;      // 交付线程的 JNIEnv
+    jmethodID onFileImported = nullptr;
+    jmethodID onFileFailed = nullptr;
+    jmethodID onProgress = nullptr;
+    jmethodID onFinished = nullptr;
+    bool releasePending = false;        // 回调中请求了释放，交付线程退出时再释放
+};
+
+void clearPendingException(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        LOGE("Exception in batch import listener");
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+/**
+ * RGBA8 -> Java byte[]（Kotlin 侧用 copyPixelsFromBuffer 生成 Bitmap）
+ */
+jbyteArray toByteArray(JNIEnv* env, const OutputImage& image) {
+    jbyteArray array = env->NewByteArray(static_cast<jsize>(image.data.size()));
+    if (array != nullptr) {
+        env->SetByteArrayRegion(array, 0, static_cast<jsize>(image.data.size()),
+                                reinterpret_cast<const jbyte*>(image.data.data()));
+    }
+    return array;
+}
+
+} // namespace
+
+extern "C" {
+
+/**
+ * 创建批量导入器
+ */
+JNIEXPORT jlong JNICALL
+Java_com_filmtracker_app_native_RawBatchImporterNative_nativeCreate(
+    JNIEnv *env, jobject thiz, jint maxWorkers, jint memoryBudgetMB, jint thumbnailSize, jint proxySize) {
+
+    BatchImportOptions options;
+    options.maxWorkers = static_cast<uint32_t>(std::max(0, maxWorkers));
+    options.memoryBudgetMB = static_cast<size_t>(std::max(1, memoryBudgetMB));
+    options.thumbnailSize = static_cast<uint32_t>(std::max(0, thumbnailSize));
+    options.proxySize = static_cast<uint32_t>(std::max(0, proxySize));
+
+    BatchImporterHandle* handle = new BatchImporterHandle();
+    handle->importer.reset(new RawBatchImporter(options));
+    env->GetJavaVM(&handle->vm);
+    return reinterpret_cast<jlong>(handle);
+}
+
+/**
+ * 开始批量导入（异步，回调在 Native 交付线程上执行）
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_RawBatchImporterNative_nativeStart(
+    JNIEnv *env, jobject thiz, jlong nativePtr, jobjectArray filePaths, jobject listener) {
+
+    BatchImporterHandle* handle = reinterpret_cast<BatchImporterHandle*>(nativePtr);
+    if (!handle || filePaths == nullptr || listener == nullptr) {
+        LOGE("nativeStart: Invalid arguments");
+        return JNI_FALSE;
+    }
+    if (handle->importer->isRunning()) {
+        LOGE("nativeStart: Import already running");
+        return JNI_FALSE;
+    }
+
+    std::vector<std::string> paths;
+    const jsize count = env->GetArrayLength(filePaths);
+    paths.reserve(count);
+    for (jsize i = 0; i < count; ++i) {
+        jstring path = static_cast<jstring>(env->GetObjectArrayElement(filePaths, i));
+        const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+        paths.emplace_back(chars ? chars : "");
+        if (chars) {
+            env->ReleaseStringUTFChars(path, chars);
+        }
+        env->DeleteLocalRef(path);
+    }
+
+    // 回收上一次导入后再替换监听器
+    handle->importer->wait();
+    if (handle->listener) {
+        env->DeleteGlobalRef(handle->listener);
+    }
+    handle->listener = env->NewGlobalRef(listener);
+
+    jclass listenerClass = env->GetObjectClass(listener);
+    handle->onFileImported = env->GetMethodID(listenerClass, "onFileImported", "(ILjava/lang/String;[BIIJJ)V");
+    handle->onFileFailed = env->GetMethodID(listenerClass, "onFileFailed", "(ILjava/lang/String;Ljava/lang/String;)V");
+    handle->onProgress = env->GetMethodID(listenerClass, "onProgress", "(II)V");
+    handle->onFinished = env->GetMethodID(listenerClass, "onFinished", "(IIDZ)V");
+    env->DeleteLocalRef(listenerClass);
+    if (!handle->onFileImported || !handle->onFileFailed || !handle->onProgress || !handle->onFinished) {
+        LOGE("nativeStart: Listener methods not found");
+        env->ExceptionClear();
+        return JNI_FALSE;
+    }
+
+    RawBatchImporter::Callbacks callbacks;
+    callbacks.onThreadStart = [handle]() {
+        handle->vm->AttachCurrentThread(&handle->deliveryEnv, nullptr);
+    };
+    callbacks.onResult = [handle](BatchImportResult& result) {
+        JNIEnv* cbEnv = handle->deliveryEnv;
+        if (!cbEnv) return;
+        jstring path = cbEnv->NewStringUTF(result.filePath.c_str());
+        if (result.success) {
+            jbyteArray thumbnail = result.thumbnail ? toByteArray(cbEnv, *result.thumbnail) : nullptr;
+            jint thumbWidth = result.thumbnail ? static_cast<jint>(result.thumbnail->width) : 0;
+            jint thumbHeight = result.thumbnail ? static_cast<jint>(result.thumbnail->height) : 0;
+            // 代理图和元数据的所有权交给 Java 层
+            jlong proxyPtr = result.proxy ? jni::toImageHandle(std::move(*result.proxy)) : 0;
+            jlong metadataPtr = reinterpret_cast<jlong>(new RawMetadata(result.metadata));
+            cbEnv->CallVoidMethod(handle->listener, handle->onFileImported,
+                                  static_cast<jint>(result.index), path, thumbnail,
+                                  thumbWidth, thumbHeight, proxyPtr, metadataPtr);
+            if (cbEnv->ExceptionCheck()) {
+                // 监听器抛出异常时 Java 层未接管所有权，由这里释放
+                delete jni::imageHandle(proxyPtr);
+                delete reinterpret_cast<RawMetadata*>(metadataPtr);
+            }
+            if (thumbnail) cbEnv->DeleteLocalRef(thumbnail);
+        } else {
+            jstring error = cbEnv->NewStringUTF(result.error.c_str());
+            cbEnv->CallVoidMethod(handle->listener, handle->onFileFailed,
+                                  static_cast<jint>(result.index), path, error);
+            cbEnv->DeleteLocalRef(error);
+        }
+        cbEnv->DeleteLocalRef(path);
+        clearPendingException(cbEnv);
+    };
+    callbacks.onProgress = [handle](uint32_t completed, uint32_t total) {
+        JNIEnv* cbEnv = handle->deliveryEnv;
+        if (!cbEnv) return;
+        cbEnv->CallVoidMethod(handle->listener, handle->onProgress,
+                              static_cast<jint>(completed), static_cast<jint>(total));
+        clearPendingException(cbEnv);
+    };
+    callbacks.onFinished = [handle](const BatchImportStats& stats) {
+        JNIEnv* cbEnv = handle->deliveryEnv;
+        if (!cbEnv) return;
+        cbEnv->CallVoidMethod(handle->listener, handle->onFinished,
+                              static_cast<jint>(stats.completed - stats.failed),
+                              static_cast<jint>(stats.failed),
+                              static_cast<jdouble>(stats.filesPerSecond),
+                              stats.cancelled ? JNI_TRUE : JNI_FALSE);
+        clearPendingException(cbEnv);
+    };
+    callbacks.onThreadExit = [handle]() {
+        if (handle->releasePending && handle->deliveryEnv && handle->listener) {
+            handle->deliveryEnv->DeleteGlobalRef(handle->listener);
+            handle->listener = nullptr;
+        }
+        if (handle->deliveryEnv) {
+            handle->vm->DetachCurrentThread();
+            handle->deliveryEnv = nullptr;
+        }
+        if (handle->releasePending) {
+            delete handle;  // 析构导入器时分离交付线程（当前线程）
+        }
+    };
+
+    return handle->importer->start(paths, callbacks) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 取消导入
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_RawBatchImporterNative_nativeCancel(
+    JNIEnv *env, jobject thiz, jlong nativePtr) {
+    BatchImporterHandle* handle = reinterpret_cast<BatchImporterHandle*>(nativePtr);
+    if (handle) {
+        handle->importer->cancel();
+    }
+}
+
+/**
+ * 获取统计
+ * 返回 [total, completed, failed, workers, elapsedSeconds, filesPerSecond, peakMemoryMB]
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_filmtracker_app_native_RawBatchImporterNative_nativeGetStats(
+    JNIEnv *env, jobject thiz, jlong nativePtr) {
+    BatchImporterHandle* handle = reinterpret_cast<BatchImporterHandle*>(nativePtr);
+    if (!handle) {
+        return nullptr;
+    }
+
+    BatchImportStats stats = handle->importer->getStats();
+    jdouble values[7] = {
+        static_cast<jdouble>(stats.total),
+        static_cast<jdouble>(stats.completed),
+        static_cast<jdouble>(stats.failed),
+        static_cast<jdouble>(stats.workers),
+        stats.elapsedSeconds,
+        stats.filesPerSecond,
+        static_cast<jdouble>(stats.peakMemoryBytes) / (1024.0 * 1024.0)
+    };
+    jdoubleArray result = env->NewDoubleArray(7);
+    if (result != nullptr) {
+        env->SetDoubleArrayRegion(result, 0, 7, values);
+    }
+    return result;
+}
+
+/**
+ * 释放导入器（取消未完成的导入并等待线程退出）
+ *
+ * 在监听器回调中调用时交付线程不能等待自己：只取消导入，句柄在交付线程退出时释放
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_RawBatchImporterNative_nativeRelease(
+    JNIEnv *env, jobject thiz, jlong nativePtr) {
+    BatchImporterHandle* handle = reinterpret_cast<BatchImporterHandle*>(nativePtr);
+    if (handle) {
+        if (handle->importer->isDeliveryThread()) {
+            handle->releasePending = true;
+            handle->importer->cancel();
+            return;
+        }
+        handle->importer->cancel();
+        handle->importer->wait();
+        if (handle->listener) {
+            env->DeleteGlobalRef(handle->listener);
+        }
+        delete handle;
+    }
+}
+
+} // extern "C"
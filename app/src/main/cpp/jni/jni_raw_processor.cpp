@@ -1,6 +1,8 @@
 #include "jni_common.h"
 #include "../raw/raw_processor.h"
 #include "../raw/raw_decoder.h"
+#include "../raw/raw_header_parser.h"
+#include "../core/decoded_image_cache.h"
 #include <string>
 #include <vector>
 
@@ -17,6 +19,137 @@ Java_com_filmtracker_app_native_RawProcessorNative_nativeInit(JNIEnv *env, jobje
     return reinterpret_cast<jlong>(processor);
 }
 
+/**
+ * 设置去马赛克质量（0 = 双线性，1 = PPG）
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeSetDemosaicQuality(
+    JNIEnv *env, jobject thiz, jlong nativePtr, jint quality) {
+    
+    RawProcessor* processor = reinterpret_cast<RawProcessor*>(nativePtr);
+    if (!processor) {
+        LOGE("RawProcessor is null");
+        return;
+    }
+    
+    RawProcessor::Config config = processor->getConfig();
+    config.demosaicQuality = (quality == static_cast<jint>(DemosaicQuality::PPG))
+                                 ? DemosaicQuality::PPG
+                                 : DemosaicQuality::BILINEAR;
+    processor->setConfig(config);
+    LOGI("nativeSetDemosaicQuality: quality=%d", static_cast<int>(config.demosaicQuality));
+}
+
+/**
+ * 设置相机色彩处理（白平衡 + 色彩矩阵）和目标工作空间（0 = Rec.709，1 = ProPhoto）
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeSetColorProcessing(
+    JNIEnv *env, jobject thiz, jlong nativePtr, jboolean applyCameraColor, jint colorSpace) {
+    
+    RawProcessor* processor = reinterpret_cast<RawProcessor*>(nativePtr);
+    if (!processor) {
+        LOGE("RawProcessor is null");
+        return;
+    }
+    
+    RawProcessor::Config config = processor->getConfig();
+    config.applyCameraColor = applyCameraColor == JNI_TRUE;
+    config.colorSpace = (colorSpace == static_cast<jint>(WorkingColorSpace::PROPHOTO))
+                            ? WorkingColorSpace::PROPHOTO
+                            : WorkingColorSpace::REC709;
+    processor->setConfig(config);
+    LOGI("nativeSetColorProcessing: applyCameraColor=%d, colorSpace=%d",
+         config.applyCameraColor, static_cast<int>(config.colorSpace));
+}
+
+/**
+ * 去马赛克吞吐量基准测试
+ * 
+ * @return 吞吐量（MP/s）
+ */
+JNIEXPORT jdouble JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeBenchmarkDemosaic(
+    JNIEnv *env, jobject thiz, jint quality, jint width, jint height, jint iterations) {
+    
+    if (width <= 0 || height <= 0 || iterations <= 0) {
+        LOGE("nativeBenchmarkDemosaic: Invalid arguments");
+        return 0.0;
+    }
+    
+    DemosaicQuality demosaicQuality = (quality == static_cast<jint>(DemosaicQuality::PPG))
+                                          ? DemosaicQuality::PPG
+                                          : DemosaicQuality::BILINEAR;
+    try {
+        return BayerDemosaic::benchmark(demosaicQuality, static_cast<uint32_t>(width),
+                                        static_cast<uint32_t>(height), static_cast<uint32_t>(iterations));
+    } catch (const std::exception& e) {
+        LOGE("Exception in demosaic benchmark: %s", e.what());
+        return 0.0;
+    }
+}
+
+/**
+ * 初始化解码图像磁盘缓存
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeInitDiskCache(
+    JNIEnv *env, jclass clazz, jstring cacheDir, jint maxSizeMB) {
+    
+    if (cacheDir == nullptr || maxSizeMB < 0) {
+        LOGE("nativeInitDiskCache: Invalid arguments");
+        return JNI_FALSE;
+    }
+    
+    const char* dir = env->GetStringUTFChars(cacheDir, nullptr);
+    if (dir == nullptr) {
+        LOGE("Failed to get string chars");
+        return JNI_FALSE;
+    }
+    
+    bool success = DecodedImageCache::getInstance().initialize(dir, static_cast<size_t>(maxSizeMB));
+    env->ReleaseStringUTFChars(cacheDir, dir);
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 获取磁盘缓存统计
+ * 返回 [hits, misses, writes, writeFailures, evictions, bytesRead, bytesWritten, entryCount, totalBytes, droppedWrites]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeGetDiskCacheStats(
+    JNIEnv *env, jclass clazz) {
+    
+    DecodedImageCache::Stats stats = DecodedImageCache::getInstance().getStats();
+    jlong values[10] = {
+        static_cast<jlong>(stats.hits),
+        static_cast<jlong>(stats.misses),
+        static_cast<jlong>(stats.writes),
+        static_cast<jlong>(stats.writeFailures),
+        static_cast<jlong>(stats.evictions),
+        static_cast<jlong>(stats.bytesRead),
+        static_cast<jlong>(stats.bytesWritten),
+        static_cast<jlong>(stats.entryCount),
+        static_cast<jlong>(stats.totalBytes),
+        static_cast<jlong>(stats.droppedWrites)
+    };
+    
+    jlongArray result = env->NewLongArray(10);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 10, values);
+    }
+    return result;
+}
+
+/**
+ * 清空磁盘缓存
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeClearDiskCache(
+    JNIEnv *env, jclass clazz) {
+    DecodedImageCache::getInstance().clear();
+}
+
 /**
  * 加载 RAW 图像
  */
@@ -47,15 +180,13 @@ Java_com_filmtracker_app_native_RawProcessorNative_nativeLoadRaw(
     
     try {
         LOGI("nativeLoadRaw: Calling processor->loadRaw");
-        LinearImage image = processor->loadRaw(path, metadata);
-        LOGI("nativeLoadRaw: loadRaw completed, image size=%dx%d", image.width, image.height);
+        SharedImage image = processor->loadRawShared(path, metadata);
+        LOGI("nativeLoadRaw: loadRaw completed, image size=%dx%d", image->width, image->height);
         
         env->ReleaseStringUTFChars(filePath, path);
         
-        LOGI("nativeLoadRaw: Creating LinearImage pointer");
-        LinearImage* imagePtr = new LinearImage(std::move(image));
-        LOGI("nativeLoadRaw: Successfully created LinearImage pointer");
-        return reinterpret_cast<jlong>(imagePtr);
+        LOGI("nativeLoadRaw: Creating image handle");
+        return jni::toImageHandle(std::move(image));
     } catch (const std::exception& e) {
         env->ReleaseStringUTFChars(filePath, path);
         LOGE("Exception loading RAW: %s", e.what());
@@ -97,12 +228,12 @@ Java_com_filmtracker_app_native_RawProcessorNative_nativeLoadRawWithMetadata(
     
     try {
         LOGI("nativeLoadRawWithMetadata: Calling processor->loadRaw");
-        LinearImage image = processor->loadRaw(path, *metadata);
-        LOGI("nativeLoadRawWithMetadata: loadRaw completed, image size=%dx%d", image.width, image.height);
+        SharedImage image = processor->loadRawShared(path, *metadata);
+        LOGI("nativeLoadRawWithMetadata: loadRaw completed, image size=%dx%d", image->width, image->height);
         
         env->ReleaseStringUTFChars(filePath, path);
         
-        LinearImage* imagePtr = new LinearImage(std::move(image));
+        ImageHandle* imagePtr = ImageHandle::create(std::move(image));
         RawMetadata* metadataPtr = metadata;
         
         jlongArray result = env->NewLongArray(2);
@@ -124,6 +255,114 @@ Java_com_filmtracker_app_native_RawProcessorNative_nativeLoadRawWithMetadata(
     }
 }
 
+/**
+ * 从文件描述符加载 RAW 图像并返回元数据
+ * 
+ * 文件通过 mmap 映射后直接交给 LibRaw，内容不经过 Java 堆。
+ * fd 由调用方持有并关闭。
+ * 
+ * @param length 长度，< 0 表示到文件末尾
+ * @return [LinearImage 指针, RawMetadata 指针]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeLoadRawFromFd(
+    JNIEnv *env, jobject thiz, jlong nativePtr, jint fd, jlong offset, jlong length) {
+    
+    RawProcessor* processor = reinterpret_cast<RawProcessor*>(nativePtr);
+    if (!processor) {
+        LOGE("RawProcessor is null");
+        return nullptr;
+    }
+    
+    if (fd < 0) {
+        LOGE("Invalid file descriptor");
+        return nullptr;
+    }
+    
+    LOGI("nativeLoadRawFromFd: Starting, fd=%d, offset=%lld, length=%lld",
+         fd, static_cast<long long>(offset), static_cast<long long>(length));
+    
+    RawMetadata* metadata = new RawMetadata();
+    
+    try {
+        LinearImage image = processor->loadRawFromFd(fd, offset, length, *metadata);
+        
+        ImageHandle* imagePtr = ImageHandle::create(std::move(image));
+        
+        jlongArray result = env->NewLongArray(2);
+        jlong ptrs[2] = {reinterpret_cast<jlong>(imagePtr), reinterpret_cast<jlong>(metadata)};
+        env->SetLongArrayRegion(result, 0, 2, ptrs);
+        
+        LOGI("nativeLoadRawFromFd: Image size=%ux%u", imagePtr->read().width, imagePtr->read().height);
+        return result;
+    } catch (const std::exception& e) {
+        delete metadata;
+        LOGE("Exception loading RAW from fd: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        delete metadata;
+        LOGE("Unknown exception loading RAW from fd");
+        return nullptr;
+    }
+}
+
+/**
+ * 快速加载 RAW 预览（超像素降采样，不做去马赛克）
+ * 
+ * @param downscale 2 = 半尺寸，4 = 四分之一尺寸
+ * @return [LinearImage 指针, RawMetadata 指针]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeLoadRawPreview(
+    JNIEnv *env, jobject thiz, jlong nativePtr, jstring filePath, jint downscale) {
+    
+    RawProcessor* processor = reinterpret_cast<RawProcessor*>(nativePtr);
+    if (!processor) {
+        LOGE("RawProcessor is null");
+        return nullptr;
+    }
+    
+    if (filePath == nullptr) {
+        LOGE("File path is null");
+        return nullptr;
+    }
+    
+    const char* path = env->GetStringUTFChars(filePath, nullptr);
+    if (path == nullptr) {
+        LOGE("Failed to get string chars");
+        return nullptr;
+    }
+    
+    LOGI("nativeLoadRawPreview: Starting, path=%s, downscale=%d", path, downscale);
+    
+    RawMetadata* metadata = new RawMetadata();
+    
+    try {
+        LinearImage image = processor->loadRawPreview(path, *metadata, static_cast<uint32_t>(downscale));
+        
+        env->ReleaseStringUTFChars(filePath, path);
+        
+        ImageHandle* imagePtr = ImageHandle::create(std::move(image));
+        
+        jlongArray result = env->NewLongArray(2);
+        jlong ptrs[2] = {reinterpret_cast<jlong>(imagePtr), reinterpret_cast<jlong>(metadata)};
+        env->SetLongArrayRegion(result, 0, 2, ptrs);
+        
+        LOGI("nativeLoadRawPreview: Preview size=%ux%u", imagePtr->read().width, imagePtr->read().height);
+        return result;
+    } catch (const std::exception& e) {
+        env->ReleaseStringUTFChars(filePath, path);
+        delete metadata;
+        LOGE("Exception loading RAW preview: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        env->ReleaseStringUTFChars(filePath, path);
+        delete metadata;
+        LOGE("Unknown exception loading RAW preview");
+        return nullptr;
+    }
+}
+
 /**
  * 提取 RAW 文件的嵌入式 JPEG 预览
  */
@@ -163,6 +402,80 @@ Java_com_filmtracker_app_native_RawProcessorNative_nativeExtractPreview(
     return result;
 }
 
+/**
+ * 批量扫描 RAW 文件头（尺寸、方向、拍摄参数、嵌入式预览位置），不经过 LibRaw
+ * 返回与输入一一对应的 RawFileInfo 数组，无法识别的文件为 null
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_com_filmtracker_app_native_RawProcessorNative_nativeScanRawFiles(
+    JNIEnv *env, jobject thiz, jobjectArray filePaths) {
+    
+    if (filePaths == nullptr) {
+        LOGE("File paths are null");
+        return nullptr;
+    }
+    
+    jclass infoClass = env->FindClass("com/filmtracker/app/native/RawProcessorNative$RawFileInfo");
+    if (!infoClass) {
+        LOGE("Failed to find RawProcessorNative$RawFileInfo class");
+        return nullptr;
+    }
+    jmethodID constructor = env->GetMethodID(infoClass, "<init>",
+        "(Ljava/lang/String;IIIFFFFLjava/lang/String;Ljava/lang/String;JJII)V");
+    if (!constructor) {
+        LOGE("Failed to find RawFileInfo constructor");
+        return nullptr;
+    }
+    
+    const jsize count = env->GetArrayLength(filePaths);
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (jsize i = 0; i < count; ++i) {
+        jstring path = static_cast<jstring>(env->GetObjectArrayElement(filePaths, i));
+        const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+        paths.emplace_back(chars ? chars : "");
+        if (chars) {
+            env->ReleaseStringUTFChars(path, chars);
+        }
+        env->DeleteLocalRef(path);
+    }
+    
+    std::vector<RawFileInfo> infos;
+    std::vector<bool> success = RawHeaderParser::parseFiles(paths, infos);
+    
+    jobjectArray result = env->NewObjectArray(count, infoClass, nullptr);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    for (jsize i = 0; i < count; ++i) {
+        if (!success[i]) {
+            continue;
+        }
+        const RawFileInfo& info = infos[i];
+        jstring format = env->NewStringUTF(info.format);
+        jstring make = env->NewStringUTF(info.make);
+        jstring model = env->NewStringUTF(info.model);
+        jobject item = env->NewObject(infoClass, constructor,
+                                      format,
+                                      static_cast<jint>(info.width),
+                                      static_cast<jint>(info.height),
+                                      static_cast<jint>(info.orientation),
+                                      info.iso, info.exposureTime, info.aperture, info.focalLength,
+                                      make, model,
+                                      static_cast<jlong>(info.previewOffset),
+                                      static_cast<jlong>(info.previewLength),
+                                      static_cast<jint>(info.previewWidth),
+                                      static_cast<jint>(info.previewHeight));
+        env->SetObjectArrayElement(result, i, item);
+        env->DeleteLocalRef(item);
+        env->DeleteLocalRef(format);
+        env->DeleteLocalRef(make);
+        env->DeleteLocalRef(model);
+    }
+    
+    return result;
+}
+
 /**
  * 获取 RAW 文件的原图尺寸
  */
@@ -278,6 +591,22 @@ Java_com_filmtracker_app_native_RawMetadataNative_getColorSpace(JNIEnv *env, job
     return env->NewStringUTF(metadata->colorSpace);
 }
 
+/**
+ * 相机 RGB -> 工作空间色彩矩阵（3x3，行优先；未应用时为单位矩阵）
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_filmtracker_app_native_RawMetadataNative_nativeGetColorMatrix(JNIEnv *env, jobject thiz, jlong nativePtr) {
+    RawMetadata* metadata = reinterpret_cast<RawMetadata*>(nativePtr);
+    if (!metadata) {
+        return nullptr;
+    }
+    jfloatArray result = env->NewFloatArray(9);
+    if (result != nullptr) {
+        env->SetFloatArrayRegion(result, 0, 9, metadata->colorMatrix);
+    }
+    return result;
+}
+
 JNIEXPORT jfloat JNICALL
 Java_com_filmtracker_app_native_RawMetadataNative_getBlackLevel(JNIEnv *env, jobject thiz, jlong nativePtr) {
     RawMetadata* metadata = reinterpret_cast<RawMetadata*>(nativePtr);
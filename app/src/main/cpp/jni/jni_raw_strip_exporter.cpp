@@ -0,0 +1,232 @@
+#include "jni_common.h"
+#include "../raw/raw_strip_exporter.h"
+#include "../encoder/image_encoder.h"
+#include <exception>
+#include <string>
+
+using namespace filmtracker;
+
+namespace {
+
+void clearPendingException(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        LOGE("Exception in strip export sink");
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+StripExportOptions makeOptions(jint quality, jint stripHeight, jboolean softClip) {
+    StripExportOptions options;
+    options.quality = quality == static_cast<jint>(DemosaicQuality::BILINEAR)
+        ? DemosaicQuality::BILINEAR : DemosaicQuality::PPG;
+    options.stripHeight = static_cast<uint32_t>(stripHeight);
+    options.softClip = softClip == JNI_TRUE;
+    return options;
+}
+
+bool getPath(JNIEnv* env, jstring filePath, std::string& out) {
+    const char* path = env->GetStringUTFChars(filePath, nullptr);
+    if (!path) {
+        LOGE("Failed to get file path string");
+        return false;
+    }
+    out = path;
+    env->ReleaseStringUTFChars(filePath, path);
+    return true;
+}
+
+/**
+ * [width, height, strips, haloRows, peakStripMB, elapsedSeconds]，
+ * 带编码统计时追加 [bytesWritten, encodeSeconds]
+ */
+jdoubleArray makeStats(JNIEnv* env, const StripExportStats& stats, const EncodeStats* encodeStats) {
+    jdouble values[8] = {
+        static_cast<jdouble>(stats.width),
+        static_cast<jdouble>(stats.height),
+        static_cast<jdouble>(stats.strips),
+        static_cast<jdouble>(stats.haloRows),
+        static_cast<jdouble>(stats.peakStripBytes) / (1024.0 * 1024.0),
+        stats.elapsedSeconds,
+        encodeStats ? static_cast<jdouble>(encodeStats->bytesWritten) : 0.0,
+        encodeStats ? encodeStats->encodeSeconds : 0.0
+    };
+    const jsize count = encodeStats ? 8 : 6;
+    jdoubleArray result = env->NewDoubleArray(count);
+    if (result != nullptr) {
+        env->SetDoubleArrayRegion(result, 0, count, values);
+    }
+    return result;
+}
+
+} // namespace
+
+extern "C" {
+
+/**
+ * 条带流式导出 RAW（同步，在调用线程上回调 sink）
+ *
+ * sink 方法：
+ * - begin(width, height): Boolean
+ * - writeRows(rows: ByteBuffer, firstRow, rowCount, rowStride): Boolean
+ *   rows 为直接缓冲区，只在回调期间有效
+ * - finish(): Boolean
+ *
+ * 返回 [width, height, strips, haloRows, peakStripMB, elapsedSeconds]，失败或中止返回 null
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_filmtracker_app_native_RawStripExporterNative_nativeExport(
+    JNIEnv *env, jobject thiz, jstring filePath, jlong paramsHandle,
+    jint quality, jint stripHeight, jboolean softClip, jobject sink) {
+
+    BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsHandle);
+    if (filePath == nullptr || params == nullptr || sink == nullptr || stripHeight <= 0) {
+        LOGE("nativeExport: Invalid arguments");
+        return nullptr;
+    }
+
+    jclass sinkClass = env->GetObjectClass(sink);
+    jmethodID begin = env->GetMethodID(sinkClass, "begin", "(II)Z");
+    jmethodID writeRows = env->GetMethodID(sinkClass, "writeRows", "(Ljava/nio/ByteBuffer;III)Z");
+    jmethodID finish = env->GetMethodID(sinkClass, "finish", "()Z");
+    env->DeleteLocalRef(sinkClass);
+    if (!begin || !writeRows || !finish) {
+        LOGE("nativeExport: Sink methods not found");
+        env->ExceptionClear();
+        return nullptr;
+    }
+
+    RawStripExporter::RowSink rowSink;
+    rowSink.begin = [env, sink, begin](uint32_t width, uint32_t height) {
+        jboolean ok = env->CallBooleanMethod(sink, begin,
+                                             static_cast<jint>(width), static_cast<jint>(height));
+        if (env->ExceptionCheck()) {
+            clearPendingException(env);
+            return false;
+        }
+        return ok == JNI_TRUE;
+    };
+    rowSink.writeRows = [env, sink, writeRows](const uint8_t* rgba, uint32_t firstRow,
+                                               uint32_t rowCount, size_t stride) {
+        // 零拷贝：直接把条带输出包装成 ByteBuffer
+        jobject buffer = env->NewDirectByteBuffer(const_cast<uint8_t*>(rgba),
+                                                  static_cast<jlong>(stride * rowCount));
+        if (buffer == nullptr) {
+            clearPendingException(env);
+            return false;
+        }
+        jboolean ok = env->CallBooleanMethod(sink, writeRows, buffer,
+                                             static_cast<jint>(firstRow),
+                                             static_cast<jint>(rowCount),
+                                             static_cast<jint>(stride));
+        env->DeleteLocalRef(buffer);
+        if (env->ExceptionCheck()) {
+            clearPendingException(env);
+            return false;
+        }
+        return ok == JNI_TRUE;
+    };
+    rowSink.finish = [env, sink, finish]() {
+        jboolean ok = env->CallBooleanMethod(sink, finish);
+        if (env->ExceptionCheck()) {
+            clearPendingException(env);
+            return false;
+        }
+        return ok == JNI_TRUE;
+    };
+
+    StripExportOptions options = makeOptions(quality, stripHeight, softClip);
+    std::string pathStr;
+    if (!getPath(env, filePath, pathStr)) {
+        return nullptr;
+    }
+
+    RawStripExporter exporter(options);
+    RawMetadata metadata = {};
+    bool success = false;
+    try {
+        success = exporter.exportFile(pathStr.c_str(), *params, rowSink, metadata);
+    } catch (const std::exception& e) {
+        LOGE("nativeExport: Exception: %s", e.what());
+        success = false;
+    }
+    if (!success) {
+        return nullptr;
+    }
+
+    return makeStats(env, exporter.getStats(), nullptr);
+}
+
+/**
+ * 条带流式导出 RAW 并直接编码写入文件描述符（同步）
+ *
+ * 每个条带完成后行数据直接交给 Native 流式编码器，压缩在编码器工作线程上与下一个条带的
+ * 去马赛克 / 调整重叠进行，全程不经过 Java 层。
+ *
+ * @param fd 可写文件描述符（由调用方持有和关闭）
+ * @param encodeFormat EncodeFormat（0 = JPEG，1 = PNG，2 = TIFF）
+ * @param pixelFormat OutputPixelFormat（0 = RGBA_8888，1 = RGBA_16，2 = RGBA_F16）
+ * @param encodeQuality JPEG 质量 1-100
+ * @return [width, height, strips, haloRows, peakStripMB, elapsedSeconds, bytesWritten, encodeSeconds]，
+ *         失败返回 null
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_filmtracker_app_native_RawStripExporterNative_nativeExportToFile(
+    JNIEnv *env, jobject thiz, jstring filePath, jlong paramsHandle,
+    jint quality, jint stripHeight, jboolean softClip,
+    jint fd, jint encodeFormat, jint pixelFormat, jint encodeQuality) {
+
+    BasicAdjustmentParams* params = reinterpret_cast<BasicAdjustmentParams*>(paramsHandle);
+    if (filePath == nullptr || params == nullptr || stripHeight <= 0 || fd < 0 ||
+        encodeFormat < 0 || encodeFormat > static_cast<jint>(EncodeFormat::TIFF) ||
+        pixelFormat < 0 || pixelFormat > static_cast<jint>(OutputPixelFormat::RGBA_F16)) {
+        LOGE("nativeExportToFile: Invalid arguments");
+        return nullptr;
+    }
+
+    StripExportOptions options = makeOptions(quality, stripHeight, softClip);
+    options.pixelFormat = static_cast<OutputPixelFormat>(pixelFormat);
+
+    EncodeOptions encodeOptions;
+    encodeOptions.format = static_cast<EncodeFormat>(encodeFormat);
+    encodeOptions.pixelFormat = options.pixelFormat;
+    encodeOptions.quality = encodeQuality;
+    // 条带导出输出 sRGB；RGBA_F16 为线性光
+    encodeOptions.colorSpace = options.pixelFormat == OutputPixelFormat::RGBA_F16 ? EncodeColorSpace::LINEAR_SRGB
+                                                                                   : EncodeColorSpace::SRGB;
+    ImageEncoder encoder(encodeOptions, ImageEncoder::fdWriter(fd));
+
+    RawStripExporter::RowSink rowSink;
+    rowSink.begin = [&encoder](uint32_t width, uint32_t height) {
+        return encoder.begin(width, height);
+    };
+    // 编码器按顺序追加行，不需要起始行号
+    rowSink.writeRows = [&encoder](const uint8_t* rows, uint32_t /*firstRow*/,
+                                   uint32_t rowCount, size_t stride) {
+        return encoder.writeRows(rows, rowCount, stride);
+    };
+    rowSink.finish = [&encoder]() {
+        return encoder.finish();
+    };
+
+    std::string pathStr;
+    if (!getPath(env, filePath, pathStr)) {
+        return nullptr;
+    }
+
+    RawStripExporter exporter(options);
+    RawMetadata metadata = {};
+    bool success = false;
+    try {
+        success = exporter.exportFile(pathStr.c_str(), *params, rowSink, metadata);
+    } catch (const std::exception& e) {
+        LOGE("nativeExportToFile: Exception: %s", e.what());
+        success = false;
+    }
+    if (!success) {
+        return nullptr;
+    }
+    return makeStats(env, exporter.getStats(), &encoder.getStats());
+}
+
+} // extern "C"
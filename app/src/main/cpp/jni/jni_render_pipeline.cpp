@@ -0,0 +1,109 @@
+#include "jni_common.h"
+#include "../core/render_pipeline.h"
+#include <android/bitmap.h>
+
+using namespace filmtracker;
+
+extern "C" {
+
+/**
+ * 单次调用完整渲染：解析打包参数 -> 调整管线 -> sRGB 直接写入 Bitmap 像素
+ *
+ * @param paramsBuffer 打包参数（直接 ByteBuffer，布局见 RenderParamsLayout）
+ * @param paramsSize 参数有效字节数
+ * @param bitmap 输出 ARGB_8888 / RGBA_1010102 / RGBA_F16 Bitmap，尺寸与源图像不同时先重采样
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_RenderPipelineNative_nativeRender(
+    JNIEnv *env, jobject thiz, jlong imagePtr, jobject paramsBuffer, jint paramsSize, jobject bitmap) {
+
+    ImageHandle* handle = jni::imageHandle(imagePtr);
+    const LinearImage* image = handle ? &handle->read() : nullptr;
+    if (!image || !paramsBuffer || !bitmap || paramsSize <= 0) {
+        LOGE("nativeRender: Invalid arguments");
+        return JNI_FALSE;
+    }
+
+    const uint8_t* paramsData = static_cast<const uint8_t*>(env->GetDirectBufferAddress(paramsBuffer));
+    const jlong capacity = env->GetDirectBufferCapacity(paramsBuffer);
+    if (!paramsData || capacity < paramsSize) {
+        LOGE("nativeRender: Params must be a direct ByteBuffer of at least %d bytes", paramsSize);
+        return JNI_FALSE;
+    }
+
+    BasicAdjustmentParams params;
+    uint32_t flags = 0;
+    if (!RenderPipeline::unpackParams(paramsData, static_cast<size_t>(paramsSize), params, flags)) {
+        return JNI_FALSE;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 && info.format != ANDROID_BITMAP_FORMAT_RGBA_F16 &&
+         info.format != ANDROID_BITMAP_FORMAT_RGBA_1010102)) {
+        LOGE("nativeRender: Output bitmap must be ARGB_8888, RGBA_1010102 or RGBA_F16");
+        return JNI_FALSE;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("nativeRender: Failed to lock bitmap pixels");
+        return JNI_FALSE;
+    }
+
+    RenderBuffer output;
+    output.pixels = static_cast<uint8_t*>(pixels);
+    output.width = info.width;
+    output.height = info.height;
+    output.stride = info.stride;
+    if (info.format == ANDROID_BITMAP_FORMAT_RGBA_F16) {
+        output.format = OutputPixelFormat::RGBA_F16;
+    } else if (info.format == ANDROID_BITMAP_FORMAT_RGBA_1010102) {
+        output.format = OutputPixelFormat::RGBA_1010102;
+    } else {
+        output.format = OutputPixelFormat::RGBA_8888;
+    }
+
+    bool success = false;
+    try {
+        success = RenderPipelinePool::getInstance().render(*image, params, output, flags);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRender: %s", e.what());
+    } catch (...) {
+        LOGE("Unknown exception in nativeRender");
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 获取最近一次渲染的统计
+ * 返回 [renders, prepareMs, adjustMs, outputMs, totalMs]
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_filmtracker_app_native_RenderPipelineNative_nativeGetStats(
+    JNIEnv *env, jobject thiz) {
+    RenderPipeline::Stats stats = RenderPipelinePool::getInstance().getStats();
+    jdouble values[5] = {
+        static_cast<jdouble>(stats.renders),
+        stats.prepareMs,
+        stats.adjustMs,
+        stats.outputMs,
+        stats.totalMs
+    };
+    jdoubleArray result = env->NewDoubleArray(5);
+    if (result != nullptr) {
+        env->SetDoubleArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+/**
+ * 释放空闲渲染管线的工作图像
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_RenderPipelineNative_nativeTrimMemory(
+    JNIEnv *env, jobject thiz) {
+    RenderPipelinePool::getInstance().trimMemory();
+}
+
+} // extern "C"
@@ -0,0 +1,231 @@
+#include "jni_common.h"
+#include "../raw/thumbnail_service.h"
+#include "../raw/raw_decoder.h"
+#include <android/bitmap.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+/**
+ * 缩略图 -> ARGB_8888 Bitmap（Bitmap.createBitmap + lockPixels，按行复制以适配 stride）
+ */
+jobject toBitmap(JNIEnv* env, const Thumbnail& thumbnail) {
+    jclass bitmapClass = env->FindClass("android/graphics/Bitmap");
+    jclass configClass = env->FindClass("android/graphics/Bitmap$Config");
+    if (!bitmapClass || !configClass) {
+        LOGE("toBitmap: Bitmap classes not found");
+        return nullptr;
+    }
+    jmethodID createBitmap = env->GetStaticMethodID(bitmapClass, "createBitmap",
+        "(IILandroid/graphics/Bitmap$Config;)Landroid/graphics/Bitmap;");
+    jfieldID argb8888 = env->GetStaticFieldID(configClass, "ARGB_8888", "Landroid/graphics/Bitmap$Config;");
+    if (!createBitmap || !argb8888) {
+        LOGE("toBitmap: Bitmap.createBitmap not found");
+        env->ExceptionClear();
+        return nullptr;
+    }
+
+    jobject config = env->GetStaticObjectField(configClass, argb8888);
+    jobject bitmap = env->CallStaticObjectMethod(bitmapClass, createBitmap,
+                                                 static_cast<jint>(thumbnail.width),
+                                                 static_cast<jint>(thumbnail.height), config);
+    env->DeleteLocalRef(config);
+    env->DeleteLocalRef(configClass);
+    env->DeleteLocalRef(bitmapClass);
+    if (!bitmap || env->ExceptionCheck()) {
+        LOGE("toBitmap: Failed to create %ux%u bitmap", thumbnail.width, thumbnail.height);
+        env->ExceptionClear();
+        return nullptr;
+    }
+
+    AndroidBitmapInfo info;
+    void* pixels = nullptr;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("toBitmap: Failed to lock bitmap pixels");
+        env->DeleteLocalRef(bitmap);
+        return nullptr;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(thumbnail.width) * 4;
+    for (uint32_t y = 0; y < thumbnail.height; ++y) {
+        std::memcpy(static_cast<uint8_t*>(pixels) + static_cast<size_t>(y) * info.stride,
+                    thumbnail.rgba.data() + y * rowBytes, rowBytes);
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return bitmap;
+}
+
+/**
+ * jstring -> std::string（null 返回空串）
+ */
+std::string toString(JNIEnv* env, jstring value) {
+    if (value == nullptr) {
+        return std::string();
+    }
+    const char* chars = env->GetStringUTFChars(value, nullptr);
+    std::string result(chars ? chars : "");
+    if (chars) {
+        env->ReleaseStringUTFChars(value, chars);
+    }
+    return result;
+}
+
+} // namespace
+
+extern "C" {
+
+/**
+ * 初始化缩略图服务
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeInit(
+    JNIEnv *env, jobject thiz, jstring cacheDir, jint memoryCacheMB, jint diskCacheMB) {
+    bool success = ThumbnailService::getInstance().initialize(
+        toString(env, cacheDir),
+        static_cast<size_t>(std::max(1, memoryCacheMB)),
+        static_cast<size_t>(std::max(0, diskCacheMB)));
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 获取缩略图（缓存未命中时解码嵌入式预览）
+ */
+JNIEXPORT jobject JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeGetThumbnail(
+    JNIEnv *env, jobject thiz, jstring filePath, jint maxSize) {
+    const std::string path = toString(env, filePath);
+    if (path.empty() || maxSize <= 0) {
+        LOGE("nativeGetThumbnail: Invalid arguments");
+        return nullptr;
+    }
+    std::shared_ptr<const Thumbnail> thumbnail =
+        ThumbnailService::getInstance().getThumbnail(path.c_str(), static_cast<uint32_t>(maxSize));
+    return thumbnail ? toBitmap(env, *thumbnail) : nullptr;
+}
+
+/**
+ * 只查缓存，不解码
+ */
+JNIEXPORT jobject JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeFindCached(
+    JNIEnv *env, jobject thiz, jstring filePath, jint maxSize) {
+    const std::string path = toString(env, filePath);
+    if (path.empty() || maxSize <= 0) {
+        return nullptr;
+    }
+    std::shared_ptr<const Thumbnail> thumbnail =
+        ThumbnailService::getInstance().findCached(path.c_str(), static_cast<uint32_t>(maxSize));
+    return thumbnail ? toBitmap(env, *thumbnail) : nullptr;
+}
+
+/**
+ * 写入 Java 层解码的预览（缩小 + 按 EXIF 方向旋转），返回缓存的缩略图
+ */
+JNIEXPORT jobject JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativePutThumbnail(
+    JNIEnv *env, jobject thiz, jstring filePath, jint maxSize, jobject bitmap) {
+    const std::string path = toString(env, filePath);
+    if (path.empty() || maxSize <= 0 || bitmap == nullptr) {
+        LOGE("nativePutThumbnail: Invalid arguments");
+        return nullptr;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("nativePutThumbnail: Unsupported bitmap format");
+        return nullptr;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("nativePutThumbnail: Failed to lock bitmap pixels");
+        return nullptr;
+    }
+    std::shared_ptr<const Thumbnail> thumbnail = ThumbnailService::getInstance().putThumbnail(
+        path.c_str(), static_cast<uint32_t>(maxSize), static_cast<const uint8_t*>(pixels),
+        info.width, info.height, info.stride);
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    return thumbnail ? toBitmap(env, *thumbnail) : nullptr;
+}
+
+/**
+ * 提取嵌入式 JPEG 预览（Java 层解码回退路径使用）
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeGetPreviewJpeg(
+    JNIEnv *env, jobject thiz, jstring filePath) {
+    const std::string path = toString(env, filePath);
+    std::vector<uint8_t> jpegData;
+    if (path.empty() || !extractRawPreview(path.c_str(), jpegData) || jpegData.empty()) {
+        return nullptr;
+    }
+    jbyteArray result = env->NewByteArray(static_cast<jsize>(jpegData.size()));
+    if (result != nullptr) {
+        env->SetByteArrayRegion(result, 0, static_cast<jsize>(jpegData.size()),
+                                reinterpret_cast<const jbyte*>(jpegData.data()));
+    }
+    return result;
+}
+
+/**
+ * 本机是否支持 Native JPEG 解码（API 30+）
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeIsNativeDecodeSupported(
+    JNIEnv *env, jobject thiz) {
+    return ThumbnailService::isNativeDecodeSupported() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 获取统计
+ * 返回 [memoryHits, diskHits, misses, decodes, decodeFailures,
+ *       memoryEntries, memoryBytes, diskEntries, diskBytes]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeGetStats(
+    JNIEnv *env, jobject thiz) {
+    ThumbnailService::Stats stats = ThumbnailService::getInstance().getStats();
+    jlong values[9] = {
+        static_cast<jlong>(stats.memoryHits),
+        static_cast<jlong>(stats.diskHits),
+        static_cast<jlong>(stats.misses),
+        static_cast<jlong>(stats.decodes),
+        static_cast<jlong>(stats.decodeFailures),
+        static_cast<jlong>(stats.memoryEntries),
+        static_cast<jlong>(stats.memoryBytes),
+        static_cast<jlong>(stats.diskEntries),
+        static_cast<jlong>(stats.diskBytes)
+    };
+    jlongArray result = env->NewLongArray(9);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 9, values);
+    }
+    return result;
+}
+
+/**
+ * 清空内存缓存
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeClearMemory(
+    JNIEnv *env, jobject thiz) {
+    ThumbnailService::getInstance().clearMemory();
+}
+
+/**
+ * 清空内存和磁盘缓存
+ */
+JNIEXPORT void JNICALL
+Java_com_filmtracker_app_native_ThumbnailServiceNative_nativeClear(
+    JNIEnv *env, jobject thiz) {
+    ThumbnailService::getInstance().clear();
+}
+
+} // extern "C"
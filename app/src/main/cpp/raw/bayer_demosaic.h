@@ -0,0 +1,128 @@
+#ifndef FILMTRACKER_BAYER_DEMOSAIC_H
+#define FILMTRACKER_BAYER_DEMOSAIC_H
+
+#include "raw_types.h"
+#include <cstdint>
+
+namespace filmtracker {
+
+/**
+ * 未归一化的 Bayer 数据视图（直接引用 LibRaw 的 raw_image，不复制）
+ *
+ * 黑电平和归一化系数按 2x2 四元组位置给出，下标为 (y & 1) * 2 + (x & 1)，
+ * 加载时计算 clamp((raw - black) * scale, 0, 1)（白平衡系数可直接乘进 scale）。
+ * 设置 hasColorMatrix 时，每个条带写回输出后立即乘以 colorMatrix（数据仍在缓存中），
+ * 负值截断为 0。
+ */
+struct BayerRawView {
+    const uint16_t* data = nullptr;   // 第一个可见像素
+    uint32_t stride = 0;              // 行跨度（像素数）
+    uint32_t width = 0;               // 可见区域宽度
+    uint32_t height = 0;              // 可见区域高度
+    uint32_t cfaPattern = 0;          // 0=RGGB, 1=GRBG, 2=GBRG, 3=BGGR
+    float black[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float scale[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    bool hasColorMatrix = false;      // 输出前应用 3x3 色彩矩阵
+    float colorMatrix[9] = {1.0f, 0.0f, 0.0f,
+                            0.0f, 1.0f, 0.0f,
+                            0.0f, 0.0f, 1.0f};  // 相机 RGB -> 工作空间（行优先）
+};
+
+/**
+ * 去马赛克质量档位
+ */
+enum class DemosaicQuality {
+    BILINEAR = 0,   // 双线性插值：最快，用于预览
+    PPG = 1         // Patterned Pixel Grouping：边缘感知，用于导出
+};
+
+/**
+ * Bayer 去马赛克
+ *
+ * 图像按行带（偶数行对齐）分配给多个线程处理，行带之间通过上下 halo 行共享邻域。
+ * 内层循环按 CFA 模式（RGGB/GRBG/GBRG/BGGR）在编译期特化，
+ * 每个 2x2 四元组的插值公式在编译期确定，无逐像素分支；
+ * 支持 NEON 时每次处理 8 个像素。
+ *
+ * 边界像素（首尾列、首尾行）越界邻域按 0 处理，与原 demosaicBayerNormalized 结果一致。
+ */
+class BayerDemosaic {
+public:
+    /**
+     * 双线性插值去马赛克（归一化 float 数据）
+     *
+     * @param bayer 归一化的 Bayer 数据（0-1范围，行优先，width x height）
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param cfaPattern CFA 模式（0=RGGB, 1=GRBG, 2=GBRG, 3=BGGR）
+     * @param output 输出图像（尺寸不符时重新分配）
+     */
+    static void bilinear(const float* bayer,
+                         uint32_t width,
+                         uint32_t height,
+                         uint32_t cfaPattern,
+                         LinearImage& output);
+
+    /**
+     * 双线性插值去马赛克（直接读取 uint16 RAW 数据）
+     *
+     * 黑电平扣除、按通道归一化与去马赛克在同一遍中完成：
+     * 每个线程按条带（含上下 2 行 halo）把 RAW 行转换到线程私有的 float 缓冲区，
+     * 随后立即插值，不再分配整幅的中间缓冲区。
+     *
+     * @param raw RAW 数据视图
+     * @param output 输出图像（raw.width x raw.height）
+     */
+    static void bilinear(const BayerRawView& raw, LinearImage& output);
+
+    /**
+     * PPG (Patterned Pixel Grouping) 去马赛克（直接读取 uint16 RAW 数据）
+     *
+     * 按梯度选择插值方向并使用色差插值，边缘处的拉链和伪色明显少于双线性。
+     * 与双线性相同的行带/条带并行方式（halo 为 4 行），
+     * 方向选择以 select 实现，NEON 下每次处理 4 个同色位置。
+     * 距离边界 3 像素以内的像素使用双线性结果。
+     *
+     * @param raw RAW 数据视图
+     * @param output 输出图像（raw.width x raw.height）
+     */
+    static void ppg(const BayerRawView& raw, LinearImage& output);
+
+    /**
+     * 按质量档位去马赛克
+     */
+    static void demosaic(const BayerRawView& raw, DemosaicQuality quality, LinearImage& output);
+
+    /**
+     * 吞吐量基准测试（合成 14 位 RAW 数据）
+     *
+     * @param quality 质量档位
+     * @param width 测试图像宽度
+     * @param height 测试图像高度
+     * @param iterations 迭代次数（不含一次预热）
+     * @return 吞吐量（MP/s）
+     */
+    static double benchmark(DemosaicQuality quality, uint32_t width, uint32_t height, uint32_t iterations);
+
+    /**
+     * 超像素降采样（不做去马赛克，用于快速预览）
+     *
+     * 每个 2x2 Bayer 四元组直接生成一个 RGB 像素（R、两个 G 的平均、B），
+     * factor=4 时再对 2x2 个四元组（4x4 像素）求平均。
+     * 不足一个完整块的末行/末列被丢弃。
+     *
+     * @param raw RAW 数据视图
+     * @param factor 降采样倍数（2 = 半尺寸，4 = 四分之一尺寸）
+     * @param output 输出图像（raw.width / factor x raw.height / factor）
+     */
+    static void superpixel(const BayerRawView& raw, uint32_t factor, LinearImage& output);
+
+    /**
+     * 计算线程数（按 CPU 核心数，限制在 1-8）
+     */
+    static uint32_t threadCount();
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_BAYER_DEMOSAIC_H
@@ -0,0 +1,132 @@
+#ifndef FILMTRACKER_PROVENANCE_H
+#define FILMTRACKER_PROVENANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace filmtracker {
+
+/**
+ * xxHash64（仅头文件）
+ *
+ * 来源标识派生和缓存键共用；参考：https://github.com/Cyan4973/xxHash
+ */
+namespace xxh64 {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    acc *= kPrime1;
+    return acc;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    val = round(0, val);
+    acc ^= val;
+    acc = acc * kPrime1 + kPrime4;
+    return acc;
+}
+
+inline uint64_t hash(const void* data, size_t len, uint64_t seed = 0) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + len;
+    uint64_t h64;
+
+    if (len >= 32) {
+        const uint8_t* const limit = end - 32;
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed + 0;
+        uint64_t v4 = seed - kPrime1;
+
+        do {
+            v1 = round(v1, read64(p)); p += 8;
+            v2 = round(v2, read64(p)); p += 8;
+            v3 = round(v3, read64(p)); p += 8;
+            v4 = round(v4, read64(p)); p += 8;
+        } while (p <= limit);
+
+        h64 = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h64 = mergeRound(h64, v1);
+        h64 = mergeRound(h64, v2);
+        h64 = mergeRound(h64, v3);
+        h64 = mergeRound(h64, v4);
+    } else {
+        h64 = seed + kPrime5;
+    }
+
+    h64 += static_cast<uint64_t>(len);
+
+    while (p + 8 <= end) {
+        h64 ^= round(0, read64(p));
+        h64 = rotl(h64, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        h64 ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h64 = rotl(h64, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h64 ^= static_cast<uint64_t>(*p) * kPrime5;
+        h64 = rotl(h64, 11) * kPrime1;
+        p++;
+    }
+
+    h64 ^= h64 >> 33;
+    h64 *= kPrime2;
+    h64 ^= h64 >> 29;
+    h64 *= kPrime3;
+    h64 ^= h64 >> 32;
+
+    return h64;
+}
+
+} // namespace xxh64
+
+/**
+ * 派生来源标识（LinearImage::provenance）：上游标识 + 本阶段的描述（阶段标记和参数）
+ *
+ * 上游为匿名（0）时结果仍为 0，匿名不会因为经过某个阶段而变成可信的来源
+ *
+ * @param parent 上游图像的来源标识
+ * @param stage 阶段描述字节（阶段标记 + 参数）
+ * @param length 字节数
+ * @return 新的来源标识（非 0），或 0
+ */
+inline uint64_t deriveProvenance(uint64_t parent, const void* stage, size_t length) {
+    if (parent == 0) {
+        return 0;
+    }
+    const uint64_t derived = xxh64::hash(stage, length, parent);
+    return derived != 0 ? derived : 1;
+}
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_PROVENANCE_H
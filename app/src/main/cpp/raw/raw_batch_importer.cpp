@@ -0,0 +1,381 @@
+#include "raw_batch_importer.h"
+#include "raw_processor.h"
+#include "raw_header_parser.h"
+#include "image_converter.h"
+#include "image_resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <android/log.h>
+
+#define LOG_TAG "RawBatchImporter"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+// 初始单文件占用估计：24MP 传感器的解包缓冲（16 位）+ 半尺寸超像素预览（float RGB）
+const size_t kDefaultFileBytes = 6024ULL * 4024 * 2 + 3012ULL * 2012 * 3 * sizeof(float);
+
+size_t linearImageBytes(const LinearImage& image) {
+    return static_cast<size_t>(image.width) * image.height * 3 * sizeof(float);
+}
+
+/**
+ * 单文件峰值占用：解包缓冲（16 位）+ 超像素预览（float RGB）
+ */
+size_t decodeBytes(uint32_t rawWidth, uint32_t rawHeight, uint32_t downscale) {
+    return static_cast<size_t>(rawWidth) * rawHeight * sizeof(uint16_t) +
+           static_cast<size_t>(rawWidth / downscale) * (rawHeight / downscale) * 3 * sizeof(float);
+}
+
+/**
+ * 线性 RGB -> sRGB RGBA8 缩略图
+ */
+std::unique_ptr<OutputImage> makeThumbnail(const LinearImage& source, uint32_t maxEdge) {
+    uint32_t width, height;
+    ImageResampler::fitSize(source.width, source.height, maxEdge, width, height);
+    // 解码线程本身已经并行，这里单线程缩放
+    LinearImage small = (width == source.width && height == source.height)
+                            ? source
+                            : ImageResampler::resize(source, width, height, ResampleFilter::BOX, 1);
+
+    std::unique_ptr<OutputImage> thumbnail(new OutputImage(width, height));
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        uint8_t* pixel = &thumbnail->data[i * 4];
+        pixel[0] = static_cast<uint8_t>(ImageConverter::linearToSRGB(std::min(std::max(small.r[i], 0.0f), 1.0f)) * 255.0f + 0.5f);
+        pixel[1] = static_cast<uint8_t>(ImageConverter::linearToSRGB(std::min(std::max(small.g[i], 0.0f), 1.0f)) * 255.0f + 0.5f);
+        pixel[2] = static_cast<uint8_t>(ImageConverter::linearToSRGB(std::min(std::max(small.b[i], 0.0f), 1.0f)) * 255.0f + 0.5f);
+        pixel[3] = 255;
+    }
+    return thumbnail;
+}
+
+} // namespace
+
+RawBatchImporter::RawBatchImporter(const BatchImportOptions& options)
+    : m_options(options)
+    , m_memoryBudgetBytes(std::max<size_t>(options.memoryBudgetMB, 1) * 1024 * 1024)
+    , m_estimatedFileBytes(kDefaultFileBytes)
+    , m_observedLongEdge(0)
+    , m_deliveryThreadId(std::thread::id())
+    , m_nextIndex(0)
+    , m_running(false)
+    , m_cancelled(false) {
+}
+
+RawBatchImporter::~RawBatchImporter() {
+    cancel();
+    wait();
+}
+
+uint32_t RawBatchImporter::chooseWorkerCount(size_t memoryBudgetBytes, size_t bytesPerFile, uint32_t maxWorkers) {
+    uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t byMemory = bytesPerFile > 0 ? memoryBudgetBytes / bytesPerFile : cores;
+    uint32_t workers = static_cast<uint32_t>(std::min<size_t>(cores, byMemory));
+    if (maxWorkers > 0) {
+        workers = std::min(workers, maxWorkers);
+    }
+    return std::max(1u, workers);
+}
+
+bool RawBatchImporter::start(const std::vector<std::string>& filePaths, const Callbacks& callbacks) {
+    if (m_running.load()) {
+        LOGW("start: Import already running");
+        return false;
+    }
+    wait();  // 回收上一次导入的线程
+
+    // 线程数按第一个文件的文件头估计（无法解析时用已有估计）
+    uint32_t firstDownscale = 0;
+    const size_t firstFileBytes = filePaths.empty() ? m_estimatedFileBytes.load()
+                                                    : estimateFileBytes(filePaths.front(), firstDownscale);
+    const uint32_t workerCount = std::min<uint32_t>(
+        chooseWorkerCount(m_memoryBudgetBytes, firstFileBytes, m_options.maxWorkers),
+        std::max<uint32_t>(1, static_cast<uint32_t>(filePaths.size())));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filePaths = filePaths;
+        m_callbacks = callbacks;
+        m_nextIndex = 0;
+        m_cancelled = false;
+        m_reservedBytes = 0;
+        m_peakReservedBytes = 0;
+        m_queue.clear();
+        m_queueCapacity = workerCount * 2;
+        m_activeWorkers = workerCount;
+        m_stats = BatchImportStats();
+        m_stats.total = static_cast<uint32_t>(filePaths.size());
+        m_stats.workers = workerCount;
+        m_startTime = std::chrono::steady_clock::now();
+    }
+    m_running = true;
+
+    LOGI("start: %zu files, %u workers, budget %zu MB",
+         filePaths.size(), workerCount, m_memoryBudgetBytes / (1024 * 1024));
+
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&RawBatchImporter::workerLoop, this);
+    }
+    m_deliveryThread = std::thread(&RawBatchImporter::deliveryLoop, this);
+    return true;
+}
+
+void RawBatchImporter::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cancelled = true;
+    m_memoryCondition.notify_all();
+    m_queueNotEmpty.notify_all();
+    m_queueNotFull.notify_all();
+}
+
+void RawBatchImporter::wait() {
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    m_workers.clear();
+    if (m_deliveryThread.joinable()) {
+        if (isDeliveryThread()) {
+            m_deliveryThread.detach();
+        } else {
+            m_deliveryThread.join();
+        }
+    }
+    m_deliveryThreadId = std::thread::id();
+}
+
+BatchImportStats RawBatchImporter::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    BatchImportStats stats = m_stats;
+    if (m_running.load()) {
+        stats.elapsedSeconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_startTime).count();
+        stats.filesPerSecond = stats.elapsedSeconds > 0.0 ? stats.completed / stats.elapsedSeconds : 0.0;
+    }
+    stats.peakMemoryBytes = m_peakReservedBytes;
+    return stats;
+}
+
+bool RawBatchImporter::acquireMemory(size_t bytes) {
+    // 单个文件超过预算时独占全部预算
+    bytes = std::min(bytes, m_memoryBudgetBytes);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_memoryCondition.wait(lock, [this, bytes]() {
+        return m_cancelled.load() || m_reservedBytes + bytes <= m_memoryBudgetBytes;
+    });
+    if (m_cancelled.load()) {
+        return false;
+    }
+    m_reservedBytes += bytes;
+    m_peakReservedBytes = std::max(m_peakReservedBytes, m_reservedBytes);
+    return true;
+}
+
+void RawBatchImporter::releaseMemory(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reservedBytes -= std::min(m_reservedBytes, bytes);
+    m_memoryCondition.notify_all();
+}
+
+uint32_t RawBatchImporter::chooseDownscale(uint32_t longEdge) const {
+    // 四分之一尺寸仍能满足代理图时用 4
+    if (m_options.proxySize == 0 || (longEdge > 0 && longEdge / 4 >= m_options.proxySize)) {
+        return 4;
+    }
+    return 2;
+}
+
+size_t RawBatchImporter::estimateFileBytes(const std::string& filePath, uint32_t& downscale) const {
+    RawFileInfo info = {};
+    if (RawHeaderParser::parse(filePath.c_str(), info) && info.width > 0 && info.height > 0) {
+        downscale = chooseDownscale(std::max(info.width, info.height));
+        return decodeBytes(info.width, info.height, downscale);
+    }
+    // 文件头不含尺寸（或格式不支持）：按已解码文件中最大的占用预留
+    downscale = chooseDownscale(m_observedLongEdge.load());
+    return m_estimatedFileBytes.load();
+}
+
+void RawBatchImporter::importFile(BatchImportResult& result, uint32_t downscale, size_t& reservedBytes) {
+    RawProcessor processor;
+    LinearImage preview = processor.loadRawPreview(result.filePath.c_str(), result.metadata, downscale);
+
+    // 更新单文件峰值占用估计（解包缓冲 + 预览），供文件头无法解析的文件使用
+    const size_t peakBytes = static_cast<size_t>(result.metadata.width) * result.metadata.height * sizeof(uint16_t) +
+                             linearImageBytes(preview);
+    if (peakBytes > reservedBytes) {
+        LOGW("importFile: %s used %zu KB, reserved %zu KB", result.filePath.c_str(),
+             peakBytes / 1024, reservedBytes / 1024);
+    }
+    size_t estimate = m_estimatedFileBytes.load();
+    while (peakBytes > estimate && !m_estimatedFileBytes.compare_exchange_weak(estimate, peakBytes)) {
+    }
+    m_observedLongEdge = std::max(result.metadata.width, result.metadata.height);
+
+    if (m_options.proxySize > 0) {
+        uint32_t width, height;
+        ImageResampler::fitSize(preview.width, preview.height, m_options.proxySize, width, height);
+        if (width == preview.width && height == preview.height) {
+            result.proxy.reset(new LinearImage(std::move(preview)));
+        } else {
+            result.proxy.reset(new LinearImage(
+                ImageResampler::resize(preview, width, height, ResampleFilter::BOX, 1)));
+        }
+    }
+    if (m_options.thumbnailSize > 0) {
+        result.thumbnail = makeThumbnail(result.proxy ? *result.proxy : preview, m_options.thumbnailSize);
+    }
+
+    // 解码缓冲已释放，只保留结果占用的预留
+    size_t resultBytes = 0;
+    if (result.proxy) {
+        resultBytes += linearImageBytes(*result.proxy);
+    }
+    if (result.thumbnail) {
+        resultBytes += result.thumbnail->data.size();
+    }
+    if (reservedBytes > resultBytes) {
+        releaseMemory(reservedBytes - resultBytes);
+        reservedBytes = resultBytes;
+    }
+    result.success = true;
+}
+
+void RawBatchImporter::workerLoop() {
+    const uint32_t total = static_cast<uint32_t>(m_filePaths.size());
+
+    while (!m_cancelled.load()) {
+        const uint32_t index = m_nextIndex.fetch_add(1);
+        if (index >= total) {
+            break;
+        }
+
+        // 解码前按本文件的文件头估计占用并预留
+        uint32_t downscale = 2;
+        size_t reservedBytes = std::min(estimateFileBytes(m_filePaths[index], downscale), m_memoryBudgetBytes);
+        if (!acquireMemory(reservedBytes)) {
+            break;
+        }
+
+        std::unique_ptr<BatchImportResult> result(new BatchImportResult());
+        result->index = index;
+        result->filePath = m_filePaths[index];
+        try {
+            importFile(*result, downscale, reservedBytes);
+        } catch (const std::exception& e) {
+            LOGE("Failed to import %s: %s", result->filePath.c_str(), e.what());
+            result->success = false;
+            result->error = e.what();
+            result->proxy.reset();
+            result->thumbnail.reset();
+            releaseMemory(reservedBytes);
+            reservedBytes = 0;
+        }
+
+        // 交付队列已满时阻塞（背压）
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queueNotFull.wait(lock, [this]() {
+            return m_cancelled.load() || m_queue.size() < m_queueCapacity;
+        });
+        if (m_cancelled.load()) {
+            lock.unlock();
+            releaseMemory(reservedBytes);
+            break;
+        }
+        m_queue.emplace_back(std::move(result), reservedBytes);
+        m_queueNotEmpty.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_activeWorkers--;
+    m_queueNotEmpty.notify_all();
+}
+
+void RawBatchImporter::deliveryLoop() {
+    m_deliveryThreadId = std::this_thread::get_id();
+    if (m_callbacks.onThreadStart) {
+        m_callbacks.onThreadStart();
+    }
+
+    while (true) {
+        std::unique_ptr<BatchImportResult> result;
+        size_t reservedBytes = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueNotEmpty.wait(lock, [this]() {
+                return !m_queue.empty() || m_activeWorkers == 0;
+            });
+            if (m_queue.empty()) {
+                break;
+            }
+            result = std::move(m_queue.front().first);
+            reservedBytes = m_queue.front().second;
+            m_queue.pop_front();
+            m_queueNotFull.notify_one();
+        }
+
+        // 取消后丢弃未交付的结果
+        if (m_cancelled.load()) {
+            result.reset();
+            releaseMemory(reservedBytes);
+            continue;
+        }
+        if (m_callbacks.onResult) {
+            m_callbacks.onResult(*result);
+        }
+        const bool success = result->success;
+        result.reset();
+        releaseMemory(reservedBytes);
+
+        uint32_t completed, total;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.completed++;
+            if (!success) {
+                m_stats.failed++;
+            }
+            completed = m_stats.completed;
+            total = m_stats.total;
+        }
+        if (m_callbacks.onProgress) {
+            m_callbacks.onProgress(completed, total);
+        }
+    }
+
+    BatchImportStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.cancelled = m_cancelled.load();
+        m_stats.elapsedSeconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_startTime).count();
+        m_stats.filesPerSecond = m_stats.elapsedSeconds > 0.0 ? m_stats.completed / m_stats.elapsedSeconds : 0.0;
+        m_stats.peakMemoryBytes = m_peakReservedBytes;
+        stats = m_stats;
+    }
+
+    LOGI("Import finished: %u/%u files (%u failed), %.2f files/s, peak %zu MB%s",
+         stats.completed, stats.total, stats.failed, stats.filesPerSecond,
+         stats.peakMemoryBytes / (1024 * 1024), stats.cancelled ? ", cancelled" : "");
+
+    if (m_callbacks.onFinished) {
+        m_callbacks.onFinished(stats);
+    }
+    m_running = false;
+    // onThreadExit 可能析构导入器，先移出回调，调用后不再访问成员
+    std::function<void()> onThreadExit = std::move(m_callbacks.onThreadExit);
+    if (onThreadExit) {
+        onThreadExit();
+    }
+}
+
+} // namespace filmtracker
@@ -0,0 +1,194 @@
+#ifndef FILMTRACKER_RAW_BATCH_IMPORTER_H
+#define FILMTRACKER_RAW_BATCH_IMPORTER_H
+
+#include "raw_types.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 批量导入配置
+ */
+struct BatchImportOptions {
+    uint32_t maxWorkers = 0;            // 最大解码线程数，0 = 按 CPU 核心数
+    size_t memoryBudgetMB = 512;        // 解码中 + 等待交付的结果占用的内存上限
+    uint32_t thumbnailSize = 256;       // 缩略图长边（像素），0 = 不生成
+    uint32_t proxySize = 2048;          // 代理图长边（像素），0 = 不生成
+};
+
+/**
+ * 单个文件的导入结果
+ */
+struct BatchImportResult {
+    uint32_t index = 0;                 // 在输入列表中的序号
+    std::string filePath;
+    bool success = false;
+    std::string error;
+    RawMetadata metadata = {};
+    std::unique_ptr<OutputImage> thumbnail;     // sRGB RGBA8
+    std::unique_ptr<LinearImage> proxy;         // 线性 RGB
+};
+
+/**
+ * 批量导入统计
+ */
+struct BatchImportStats {
+    uint32_t total = 0;
+    uint32_t completed = 0;             // 已交付（含失败）
+    uint32_t failed = 0;
+    uint32_t workers = 0;
+    double elapsedSeconds = 0.0;
+    double filesPerSecond = 0.0;
+    size_t peakMemoryBytes = 0;         // 预留内存峰值
+    bool cancelled = false;
+};
+
+/**
+ * RAW 批量导入器
+ *
+ * 多个解码线程并行执行 LibRaw 解包 + 超像素预览解码，生成代理图和缩略图，
+ * 由单独的交付线程按完成顺序回调调用方。
+ *
+ * 内存控制：
+ * - 每个文件解码前按文件头（RawHeaderParser）中的传感器尺寸估计峰值占用（解包缓冲 + 预览）
+ *   并预留内存，文件头无法解析时使用已解码文件的最大占用；解码完成后只保留结果占用，
+ *   结果交付（回调返回）后释放；预留失败时解码线程阻塞
+ * - 待交付队列长度有上限，消费者处理慢时解码线程阻塞（背压）
+ * - 线程数 = min(CPU 核心数, 内存预算 / 单文件估计占用)
+ */
+class RawBatchImporter {
+public:
+    using ResultCallback = std::function<void(BatchImportResult& result)>;
+    using ProgressCallback = std::function<void(uint32_t completed, uint32_t total)>;
+    using FinishedCallback = std::function<void(const BatchImportStats& stats)>;
+
+    /**
+     * 回调（均在交付线程上调用，回调中不要调用 start / wait；
+     * onThreadExit 中可以析构导入器）
+     */
+    struct Callbacks {
+        std::function<void()> onThreadStart;        // 交付线程启动（例如 JNI AttachCurrentThread）
+        ResultCallback onResult;
+        ProgressCallback onProgress;
+        FinishedCallback onFinished;
+        std::function<void()> onThreadExit;         // 交付线程退出（例如 JNI DetachCurrentThread）
+    };
+
+    explicit RawBatchImporter(const BatchImportOptions& options);
+    ~RawBatchImporter();
+
+    RawBatchImporter(const RawBatchImporter&) = delete;
+    RawBatchImporter& operator=(const RawBatchImporter&) = delete;
+
+    /**
+     * 开始导入（异步）
+     *
+     * @param filePaths 文件列表
+     * @param callbacks 回调
+     * @return 已有导入在进行时返回 false
+     */
+    bool start(const std::vector<std::string>& filePaths, const Callbacks& callbacks);
+
+    /**
+     * 取消导入：未开始的文件不再解码，已解码未交付的结果被丢弃
+     */
+    void cancel();
+
+    /**
+     * 等待导入结束（所有线程退出）
+     *
+     * 在交付线程上调用时（例如回调中析构导入器）不等待交付线程自身，改为将其分离
+     */
+    void wait();
+
+    bool isRunning() const { return m_running.load(); }
+
+    /**
+     * 当前线程是否为交付线程（即处于回调中）
+     */
+    bool isDeliveryThread() const { return std::this_thread::get_id() == m_deliveryThreadId.load(); }
+
+    /**
+     * 获取统计
+     */
+    BatchImportStats getStats() const;
+
+    /**
+     * 按 CPU 核心数和内存预算计算解码线程数
+     *
+     * @param memoryBudgetBytes 内存预算
+     * @param bytesPerFile 单文件估计峰值占用
+     * @param maxWorkers 上限，0 = 不限制
+     */
+    static uint32_t chooseWorkerCount(size_t memoryBudgetBytes, size_t bytesPerFile, uint32_t maxWorkers);
+
+private:
+    /**
+     * 预留内存（不足时阻塞，取消时返回 false）
+     */
+    bool acquireMemory(size_t bytes);
+    void releaseMemory(size_t bytes);
+
+    void workerLoop();
+    void deliveryLoop();
+
+    /**
+     * 按原图长边选择预览降采样倍数（长边未知时为 0）
+     */
+    uint32_t chooseDownscale(uint32_t longEdge) const;
+
+    /**
+     * 解码前估计单个文件的峰值占用
+     *
+     * @param downscale 输出选用的预览降采样倍数
+     */
+    size_t estimateFileBytes(const std::string& filePath, uint32_t& downscale) const;
+
+    /**
+     * 解码单个文件，生成代理图和缩略图
+     */
+    void importFile(BatchImportResult& result, uint32_t downscale, size_t& reservedBytes);
+
+    BatchImportOptions m_options;
+    size_t m_memoryBudgetBytes;
+    std::atomic<size_t> m_estimatedFileBytes;   // 文件头无法解析时的单文件峰值占用估计（按已解码文件更新）
+    std::atomic<uint32_t> m_observedLongEdge;   // 已解码文件的原图长边（文件头无法解析时选择预览降采样倍数）
+
+    std::vector<std::string> m_filePaths;
+    Callbacks m_callbacks;
+    std::vector<std::thread> m_workers;
+    std::thread m_deliveryThread;
+    std::atomic<std::thread::id> m_deliveryThreadId;
+    std::atomic<uint32_t> m_nextIndex;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancelled;
+
+    // 内存预留
+    size_t m_reservedBytes = 0;
+    size_t m_peakReservedBytes = 0;
+    std::condition_variable m_memoryCondition;
+
+    // 待交付队列（结果 + 其预留的内存）
+    std::deque<std::pair<std::unique_ptr<BatchImportResult>, size_t>> m_queue;
+    size_t m_queueCapacity = 0;
+    uint32_t m_activeWorkers = 0;
+    std::condition_variable m_queueNotEmpty;
+    std::condition_variable m_queueNotFull;
+
+    BatchImportStats m_stats;
+    std::chrono::steady_clock::time_point m_startTime;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_RAW_BATCH_IMPORTER_H
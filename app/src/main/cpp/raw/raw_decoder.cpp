@@ -16,9 +16,10 @@
  */
 
 #include "raw_processor.h"
+#include "raw_header_parser.h"
+#include "raw_file_source.h"
 #include <libraw.h>
 #include <android/log.h>
-#include <fstream>
 #include <vector>
 #include <cstring>
 
@@ -68,43 +69,15 @@ bool validateRawFile(const char* filePath) {
         return false;
     }
     
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open()) {
-        LOGE("validateRawFile: Cannot open file '%s'", filePath);
+    // 解析文件头：识别 TIFF 系（DNG/CR2/NEF/ARW/ORF/RW2）、CR3 和 RAF 容器
+    RawFileInfo info;
+    if (!RawHeaderParser::parse(filePath, info)) {
+        LOGE("validateRawFile: Unknown file format");
         return false;
     }
     
-    // 读取文件头（前 8 字节）
-    uint8_t header[8];
-    file.read(reinterpret_cast<char*>(header), 8);
-    
-    if (file.gcount() < 8) {
-        LOGE("validateRawFile: File too small");
-        return false;
-    }
-    
-    // 检查 TIFF 头（大多数 RAW 格式基于 TIFF）
-    bool isTiff = (header[0] == 0x49 && header[1] == 0x49) ||  // Little-endian
-                  (header[0] == 0x4D && header[1] == 0x4D);     // Big-endian
-    
-    if (isTiff) {
-        LOGI("validateRawFile: Valid TIFF-based RAW file");
-        return true;
-    }
-    
-    // 检查其他 RAW 格式的魔数
-    // DNG: 通常是 TIFF 格式
-    // CR2 (Canon): TIFF 格式
-    // NEF (Nikon): TIFF 格式
-    // ARW (Sony): TIFF 格式
-    // RAF (Fuji): "FUJIFILMCCD-RAW"
-    if (header[0] == 'F' && header[1] == 'U' && header[2] == 'J' && header[3] == 'I') {
-        LOGI("validateRawFile: Valid Fuji RAF file");
-        return true;
-    }
-    
-    LOGE("validateRawFile: Unknown file format");
-    return false;
+    LOGI("validateRawFile: Valid %s file", info.format);
+    return true;
 }
 
 /**
@@ -121,7 +94,16 @@ bool getRawFileInfo(const char* filePath, uint32_t& width, uint32_t& height) {
         return false;
     }
     
-    // 使用 LibRaw 快速获取信息（不解码完整图像）
+    // 优先只解析文件头（读取几 KB，不经过 LibRaw）
+    RawFileInfo info;
+    if (RawHeaderParser::parse(filePath, info) && info.width > 0 && info.height > 0) {
+        width = info.width;
+        height = info.height;
+        LOGI("getRawFileInfo: Image size = %ux%u (%s header)", width, height, info.format);
+        return true;
+    }
+    
+    // 文件头中没有尺寸时退回 LibRaw（不解码完整图像）
     LibRaw rawProcessor;
     
     int ret = rawProcessor.open_file(filePath);
@@ -159,6 +141,21 @@ bool extractRawPreview(const char* filePath, std::vector<uint8_t>& jpegData) {
         return false;
     }
     
+    // 优先按文件头中记录的偏移直接从映射区域复制最大的嵌入式 JPEG（不经过 LibRaw）
+    MappedRawFile file;
+    RawFileInfo info;
+    if (file.open(filePath) && RawHeaderParser::parseBuffer(file.data(), file.size(), info) &&
+        info.previewLength >= 2 && info.previewOffset + info.previewLength <= file.size()) {
+        const uint8_t* preview = file.data() + info.previewOffset;
+        if (preview[0] == 0xFF && preview[1] == 0xD8) {
+            jpegData.assign(preview, preview + info.previewLength);
+            LOGI("extractRawPreview: Extracted %zu bytes of JPEG data (%ux%u, %s header)",
+                 jpegData.size(), info.previewWidth, info.previewHeight, info.format);
+            return true;
+        }
+    }
+    file.close();
+    
     LibRaw rawProcessor;
     
     int ret = rawProcessor.open_file(filePath);
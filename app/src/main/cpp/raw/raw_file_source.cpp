@@ -0,0 +1,114 @@
+#include "raw_file_source.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <android/log.h>
+
+#define LOG_TAG "MappedRawFile"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+MappedRawFile::MappedRawFile()
+    : m_mapBase(nullptr)
+    , m_mapLength(0)
+    , m_data(nullptr)
+    , m_size(0) {
+}
+
+MappedRawFile::~MappedRawFile() {
+    close();
+}
+
+bool MappedRawFile::open(const char* filePath) {
+    if (!filePath) {
+        LOGE("open: File path is null");
+        return false;
+    }
+    
+    int fd = ::open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("open: Failed to open %s: %s", filePath, std::strerror(errno));
+        return false;
+    }
+    
+    bool success = openFd(fd, 0, -1);
+    
+    // 映射建立后即可关闭文件描述符
+    ::close(fd);
+    return success;
+}
+
+bool MappedRawFile::openFd(int fd, int64_t offset, int64_t length) {
+    close();
+    
+    if (fd < 0 || offset < 0) {
+        LOGE("openFd: Invalid fd=%d or offset=%lld", fd, static_cast<long long>(offset));
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        LOGE("openFd: fstat failed: %s", std::strerror(errno));
+        return false;
+    }
+    
+    const int64_t fileSize = static_cast<int64_t>(st.st_size);
+    if (offset >= fileSize) {
+        LOGE("openFd: Offset %lld beyond file size %lld",
+             static_cast<long long>(offset), static_cast<long long>(fileSize));
+        return false;
+    }
+    if (length < 0 || offset + length > fileSize) {
+        length = fileSize - offset;
+    }
+    if (length == 0) {
+        LOGE("openFd: Empty range");
+        return false;
+    }
+    
+    // mmap 的偏移必须按页对齐
+    const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t mapOffset = offset & ~(pageSize - 1);
+    const size_t prefix = static_cast<size_t>(offset - mapOffset);
+    const size_t mapLength = static_cast<size_t>(length) + prefix;
+    
+    void* base = mmap(nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(mapOffset));
+    if (base == MAP_FAILED) {
+        LOGE("openFd: mmap failed: %s", std::strerror(errno));
+        return false;
+    }
+    
+    // LibRaw 解包基本是顺序读取：提示内核加大预读并提前换入
+    if (madvise(base, mapLength, MADV_SEQUENTIAL) != 0) {
+        LOGW("openFd: madvise(SEQUENTIAL) failed: %s", std::strerror(errno));
+    }
+    if (madvise(base, mapLength, MADV_WILLNEED) != 0) {
+        LOGW("openFd: madvise(WILLNEED) failed: %s", std::strerror(errno));
+    }
+    
+    m_mapBase = base;
+    m_mapLength = mapLength;
+    m_data = static_cast<const uint8_t*>(base) + prefix;
+    m_size = static_cast<size_t>(length);
+    
+    LOGI("openFd: Mapped %zu bytes (offset=%lld)", m_size, static_cast<long long>(offset));
+    return true;
+}
+
+void MappedRawFile::close() {
+    if (m_mapBase) {
+        munmap(m_mapBase, m_mapLength);
+    }
+    m_mapBase = nullptr;
+    m_mapLength = 0;
+    m_data = nullptr;
+    m_size = 0;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,59 @@
+#ifndef FILMTRACKER_RAW_FILE_SOURCE_H
+#define FILMTRACKER_RAW_FILE_SOURCE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace filmtracker {
+
+/**
+ * 内存映射的 RAW 文件（只读）
+ * 
+ * 以 PROT_READ 映射整个文件（或文件描述符中的一段），并通过 madvise 提示顺序读取，
+ * 映射区域直接交给 LibRaw::open_buffer，避免先把整个文件读入内存（或 Java 堆）再复制。
+ * 映射建立后不依赖原文件描述符，调用方可以立即关闭 fd。
+ */
+class MappedRawFile {
+public:
+    MappedRawFile();
+    ~MappedRawFile();
+    
+    MappedRawFile(const MappedRawFile&) = delete;
+    MappedRawFile& operator=(const MappedRawFile&) = delete;
+    
+    /**
+     * 按路径映射整个文件
+     * 
+     * @return 是否成功
+     */
+    bool open(const char* filePath);
+    
+    /**
+     * 映射文件描述符中的一段（用于 content:// URI 的 ParcelFileDescriptor / AssetFileDescriptor）
+     * 
+     * @param fd 文件描述符（不会被关闭）
+     * @param offset 起始偏移（无需页对齐）
+     * @param length 长度，< 0 表示到文件末尾
+     * @return 是否成功
+     */
+    bool openFd(int fd, int64_t offset, int64_t length);
+    
+    /**
+     * 解除映射
+     */
+    void close();
+    
+    bool isOpen() const { return m_data != nullptr; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    
+private:
+    void* m_mapBase;        // mmap 返回的页对齐地址
+    size_t m_mapLength;     // 映射长度（含页对齐前缀）
+    const uint8_t* m_data;  // 请求区域起始地址
+    size_t m_size;          // 请求区域长度
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_RAW_FILE_SOURCE_H
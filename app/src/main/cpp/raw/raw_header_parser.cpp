@@ -0,0 +1,881 @@
+#include "raw_header_parser.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <android/log.h>
+
+#define LOG_TAG "RawHeaderParser"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+// 首次读取的块大小：绝大多数相机的 IFD0 / Exif / SubIFD 都位于文件开头 16KB 内
+const size_t kHeadBlockSize = 16 * 1024;
+// 查找 JPEG SOF 时最多扫描的字节数（APP1 Exif / MPF 段可能较大）
+const uint64_t kMaxJpegScanBytes = 256 * 1024;
+const int kMaxIfdCount = 32;
+const uint32_t kMaxIfdEntries = 512;
+const int kMaxBoxDepth = 8;
+const int kMaxBoxesPerLevel = 256;
+
+// TIFF 标签
+const uint16_t TAG_NEW_SUBFILE_TYPE = 0x00FE;
+const uint16_t TAG_IMAGE_WIDTH = 0x0100;
+const uint16_t TAG_IMAGE_LENGTH = 0x0101;
+const uint16_t TAG_BITS_PER_SAMPLE = 0x0102;
+const uint16_t TAG_COMPRESSION = 0x0103;
+const uint16_t TAG_PHOTOMETRIC = 0x0106;
+const uint16_t TAG_MAKE = 0x010F;
+const uint16_t TAG_MODEL = 0x0110;
+const uint16_t TAG_STRIP_OFFSETS = 0x0111;
+const uint16_t TAG_ORIENTATION = 0x0112;
+const uint16_t TAG_STRIP_BYTE_COUNTS = 0x0117;
+const uint16_t TAG_SUB_IFDS = 0x014A;
+const uint16_t TAG_JPEG_OFFSET = 0x0201;
+const uint16_t TAG_JPEG_LENGTH = 0x0202;
+const uint16_t TAG_EXPOSURE_TIME = 0x829A;
+const uint16_t TAG_F_NUMBER = 0x829D;
+const uint16_t TAG_EXIF_IFD = 0x8769;
+const uint16_t TAG_ISO = 0x8827;
+const uint16_t TAG_FOCAL_LENGTH = 0x920A;
+const uint16_t TAG_DNG_VERSION = 0xC612;
+
+// Panasonic RW2 IFD0 私有标签
+const uint16_t TAG_RW2_SENSOR_WIDTH = 0x0002;
+const uint16_t TAG_RW2_SENSOR_HEIGHT = 0x0003;
+const uint16_t TAG_RW2_JPEG_FROM_RAW = 0x002E;
+
+const uint16_t PHOTOMETRIC_CFA = 32803;
+const uint16_t PHOTOMETRIC_LINEAR_RAW = 34892;
+
+// Canon CR3 元数据 uuid box
+const uint8_t kCanonUuid[16] = {
+    0x85, 0xC0, 0xB6, 0x87, 0x82, 0x0F, 0x11, 0xE0,
+    0x81, 0x11, 0xF4, 0xCE, 0x46, 0x2B, 0x6A, 0x48
+};
+
+/**
+ * 文件读取：缓存文件开头的一个块，块外的读取直接 pread
+ */
+class HeaderReader {
+public:
+    explicit HeaderReader(int fd) : m_fd(fd), m_data(nullptr), m_size(0) {}
+    HeaderReader(const uint8_t* data, size_t size) : m_fd(-1), m_data(data), m_size(size) {}
+
+    bool init() {
+        if (m_data) {
+            return m_size > 0;
+        }
+        struct stat st;
+        if (fstat(m_fd, &st) != 0 || st.st_size <= 0) {
+            return false;
+        }
+        m_size = static_cast<uint64_t>(st.st_size);
+        m_head.resize(static_cast<size_t>(std::min<uint64_t>(m_size, kHeadBlockSize)));
+        return preadAll(0, m_head.data(), m_head.size());
+    }
+
+    uint64_t size() const { return m_size; }
+
+    bool read(uint64_t offset, void* dst, size_t length) {
+        if (offset > m_size || length > m_size - offset) {
+            return false;
+        }
+        if (m_data) {
+            std::memcpy(dst, m_data + offset, length);
+            return true;
+        }
+        if (offset + length <= m_head.size()) {
+            std::memcpy(dst, m_head.data() + offset, length);
+            return true;
+        }
+        return preadAll(offset, dst, length);
+    }
+
+private:
+    bool preadAll(uint64_t offset, void* dst, size_t length) {
+        uint8_t* p = static_cast<uint8_t*>(dst);
+        while (length > 0) {
+            ssize_t got = pread(m_fd, p, length, static_cast<off_t>(offset));
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (got == 0) {
+                return false;
+            }
+            p += got;
+            length -= static_cast<size_t>(got);
+            offset += static_cast<uint64_t>(got);
+        }
+        return true;
+    }
+
+    int m_fd;
+    const uint8_t* m_data;
+    uint64_t m_size;
+    std::vector<uint8_t> m_head;
+};
+
+inline uint16_t readU16(const uint8_t* p, bool little) {
+    return little ? static_cast<uint16_t>(p[0] | (p[1] << 8))
+                  : static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline uint32_t readU32(const uint8_t* p, bool little) {
+    return little ? (static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                     (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24))
+                  : ((static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                     (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]));
+}
+
+inline uint64_t readU64BE(const uint8_t* p) {
+    return (static_cast<uint64_t>(readU32(p, false)) << 32) | readU32(p + 4, false);
+}
+
+void copyString(char* dst, size_t dstSize, const char* src, size_t srcLength) {
+    size_t length = std::min(srcLength, dstSize - 1);
+    std::memcpy(dst, src, length);
+    dst[length] = '\0';
+    // 去掉尾部空白和填充的 '\0'
+    while (length > 0 && (dst[length - 1] == ' ' || dst[length - 1] == '\0')) {
+        dst[--length] = '\0';
+    }
+    // 字段来自任意文件，非可打印 ASCII 字节替换为 '?'，保证交给 JNI NewStringUTF 的是合法的 modified UTF-8
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char c = static_cast<unsigned char>(dst[i]);
+        if (c < 0x20 || c > 0x7E) {
+            dst[i] = '?';
+        }
+    }
+}
+
+void setFormat(RawFileInfo& info, const char* format) {
+    copyString(info.format, sizeof(info.format), format, std::strlen(format));
+}
+
+/**
+ * 读取 JPEG 流的 SOF 尺寸（逐段跳过标记，只读取段头）
+ */
+bool readJpegDimensions(HeaderReader& reader, uint64_t offset,
+                        uint32_t& width, uint32_t& height, uint32_t& components) {
+    uint8_t marker[4];
+    if (!reader.read(offset, marker, 2) || marker[0] != 0xFF || marker[1] != 0xD8) {
+        return false;
+    }
+    uint64_t pos = offset + 2;
+    const uint64_t limit = offset + kMaxJpegScanBytes;
+    while (pos < limit) {
+        if (!reader.read(pos, marker, 4) || marker[0] != 0xFF) {
+            return false;
+        }
+        const uint8_t type = marker[1];
+        const uint16_t length = readU16(marker + 2, false);
+        const bool isSof = type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC;
+        if (isSof) {
+            uint8_t sof[6];
+            if (!reader.read(pos + 4, sof, sizeof(sof))) {
+                return false;
+            }
+            height = readU16(sof + 1, false);
+            width = readU16(sof + 3, false);
+            components = sof[5];
+            return true;
+        }
+        if (type == 0xD9 || type == 0xDA || length < 2) {
+            return false;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+/**
+ * 单个 IFD 中与图像相关的字段
+ */
+struct IfdInfo {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bitsPerSample = 0;
+    uint32_t compression = 0;
+    uint32_t photometric = 0;
+    uint32_t subfileType = 0;
+    uint64_t stripOffset = 0;
+    uint64_t stripBytes = 0;
+    uint32_t stripCount = 0;
+    uint64_t jpegOffset = 0;
+    uint64_t jpegLength = 0;
+};
+
+/**
+ * TIFF 结构解析状态
+ */
+struct TiffContext {
+    HeaderReader& reader;
+    uint64_t base;              // TIFF 头所在的文件偏移（CR3 的 CMT box、RAF 内嵌 JPEG 的 Exif 等）
+    bool little;
+    RawFileInfo& info;
+    std::vector<IfdInfo> ifds;  // 按访问顺序
+    std::vector<uint64_t> visited;
+    bool isDng = false;
+    bool isRw2 = false;
+    uint32_t rw2Width = 0;
+    uint32_t rw2Height = 0;
+    uint64_t rw2JpegOffset = 0;
+    uint64_t rw2JpegLength = 0;
+
+    TiffContext(HeaderReader& r, uint64_t b, bool l, RawFileInfo& i)
+        : reader(r), base(b), little(l), info(i) {}
+};
+
+uint32_t typeSize(uint16_t type) {
+    switch (type) {
+        case 1: case 2: case 6: case 7: return 1;     // BYTE, ASCII, SBYTE, UNDEFINED
+        case 3: case 8: return 2;                     // SHORT, SSHORT
+        case 4: case 9: case 11: case 13: return 4;   // LONG, SLONG, FLOAT, IFD
+        case 5: case 10: case 12: return 8;           // RATIONAL, SRATIONAL, DOUBLE
+        default: return 0;
+    }
+}
+
+/**
+ * IFD 条目的值
+ */
+struct IfdEntry {
+    uint16_t tag;
+    uint16_t type;
+    uint32_t count;
+    const uint8_t* inlineValue;     // 4 字节内联值
+    uint64_t valueOffset;           // 值的文件偏移（内联时指向条目内）
+
+    // 64 位乘法：count 来自文件，32 位相乘会回绕成很小的值而被当作内联值
+    uint64_t dataSize() const { return static_cast<uint64_t>(typeSize(type)) * count; }
+};
+
+uint32_t entryUInt(TiffContext& ctx, const IfdEntry& entry) {
+    if (entry.count == 0) return 0;
+    if (entry.type == 3 || entry.type == 8) return readU16(entry.inlineValue, ctx.little);
+    if (entry.type == 4 || entry.type == 9 || entry.type == 13) return readU32(entry.inlineValue, ctx.little);
+    if (entry.type == 1 || entry.type == 7) return entry.inlineValue[0];
+    return 0;
+}
+
+float entryRational(TiffContext& ctx, const IfdEntry& entry) {
+    if (entry.count == 0) return 0.0f;
+    if (entry.type == 5 || entry.type == 10) {
+        uint8_t value[8];
+        if (!ctx.reader.read(entry.valueOffset, value, sizeof(value))) {
+            return 0.0f;
+        }
+        uint32_t numerator = readU32(value, ctx.little);
+        uint32_t denominator = readU32(value + 4, ctx.little);
+        if (entry.type == 10) {
+            int32_t n = static_cast<int32_t>(numerator);
+            int32_t d = static_cast<int32_t>(denominator);
+            return d != 0 ? static_cast<float>(n) / static_cast<float>(d) : 0.0f;
+        }
+        return denominator != 0 ? static_cast<float>(numerator) / static_cast<float>(denominator) : 0.0f;
+    }
+    return static_cast<float>(entryUInt(ctx, entry));
+}
+
+void entryString(TiffContext& ctx, const IfdEntry& entry, char* dst, size_t dstSize) {
+    char buffer[64];
+    size_t length = std::min<size_t>(entry.count, sizeof(buffer));
+    if (length == 0 || !ctx.reader.read(entry.valueOffset, buffer, length)) {
+        return;
+    }
+    copyString(dst, dstSize, buffer, strnlen(buffer, length));
+}
+
+/**
+ * 读取 LONG/SHORT 数组（SubIFD 偏移等）
+ */
+std::vector<uint32_t> entryUIntArray(TiffContext& ctx, const IfdEntry& entry, uint32_t maxCount) {
+    std::vector<uint32_t> values;
+    const uint32_t size = typeSize(entry.type);
+    if (size != 2 && size != 4) {
+        return values;
+    }
+    const uint32_t count = std::min(entry.count, maxCount);
+    std::vector<uint8_t> raw(count * size);
+    if (count == 0 || !ctx.reader.read(entry.valueOffset, raw.data(), raw.size())) {
+        return values;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        values.push_back(size == 2 ? readU16(&raw[i * 2], ctx.little) : readU32(&raw[i * 4], ctx.little));
+    }
+    return values;
+}
+
+void parseIfd(TiffContext& ctx, uint64_t ifdOffset, int depth);
+
+/**
+ * 解析一个 IFD 以及它引用的 SubIFD / Exif IFD
+ *
+ * @return 下一个 IFD 的偏移（相对 base，0 表示结束）
+ */
+uint32_t parseIfdEntries(TiffContext& ctx, uint64_t ifdOffset, int depth) {
+    const uint64_t fileOffset = ctx.base + ifdOffset;
+    if (ctx.visited.size() >= static_cast<size_t>(kMaxIfdCount) ||
+        std::find(ctx.visited.begin(), ctx.visited.end(), fileOffset) != ctx.visited.end()) {
+        return 0;
+    }
+    ctx.visited.push_back(fileOffset);
+
+    uint8_t countBytes[2];
+    if (!ctx.reader.read(fileOffset, countBytes, 2)) {
+        return 0;
+    }
+    const uint32_t entryCount = readU16(countBytes, ctx.little);
+    if (entryCount == 0 || entryCount > kMaxIfdEntries) {
+        return 0;
+    }
+
+    // 一次读取整个 IFD（条目 + 下一个 IFD 偏移）
+    std::vector<uint8_t> table(entryCount * 12 + 4);
+    if (!ctx.reader.read(fileOffset + 2, table.data(), table.size())) {
+        if (!ctx.reader.read(fileOffset + 2, table.data(), entryCount * 12)) {
+            return 0;
+        }
+        std::memset(&table[entryCount * 12], 0, 4);
+    }
+
+    IfdInfo ifd;
+    std::vector<uint32_t> subIfds;
+    uint32_t exifIfd = 0;
+
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        const uint8_t* p = &table[i * 12];
+        IfdEntry entry;
+        entry.tag = readU16(p, ctx.little);
+        entry.type = readU16(p + 2, ctx.little);
+        entry.count = readU32(p + 4, ctx.little);
+        entry.inlineValue = p + 8;
+        entry.valueOffset = entry.dataSize() <= 4 ? fileOffset + 2 + i * 12 + 8
+                                                  : ctx.base + readU32(p + 8, ctx.little);
+        // 值超出文件范围的条目视为损坏，直接跳过
+        if (entry.dataSize() > 4 && (entry.valueOffset > ctx.reader.size() ||
+                                     entry.dataSize() > ctx.reader.size() - entry.valueOffset)) {
+            continue;
+        }
+
+        switch (entry.tag) {
+            case TAG_NEW_SUBFILE_TYPE: ifd.subfileType = entryUInt(ctx, entry); break;
+            case TAG_IMAGE_WIDTH: ifd.width = entryUInt(ctx, entry); break;
+            case TAG_IMAGE_LENGTH: ifd.height = entryUInt(ctx, entry); break;
+            case TAG_BITS_PER_SAMPLE: ifd.bitsPerSample = entryUInt(ctx, entry); break;
+            case TAG_COMPRESSION: ifd.compression = entryUInt(ctx, entry); break;
+            case TAG_PHOTOMETRIC: ifd.photometric = entryUInt(ctx, entry); break;
+            case TAG_STRIP_OFFSETS:
+                ifd.stripOffset = ctx.base + entryUInt(ctx, entry);
+                ifd.stripCount = entry.count;
+                if (entry.count > 1) {
+                    std::vector<uint32_t> offsets = entryUIntArray(ctx, entry, 1);
+                    ifd.stripOffset = offsets.empty() ? 0 : ctx.base + offsets[0];
+                }
+                break;
+            case TAG_STRIP_BYTE_COUNTS:
+                ifd.stripBytes = entry.count == 1 ? entryUInt(ctx, entry) : 0;
+                break;
+            case TAG_JPEG_OFFSET: ifd.jpegOffset = ctx.base + entryUInt(ctx, entry); break;
+            case TAG_JPEG_LENGTH: ifd.jpegLength = entryUInt(ctx, entry); break;
+            case TAG_MAKE:
+                if (ctx.info.make[0] == '\0') entryString(ctx, entry, ctx.info.make, sizeof(ctx.info.make));
+                break;
+            case TAG_MODEL:
+                if (ctx.info.model[0] == '\0') entryString(ctx, entry, ctx.info.model, sizeof(ctx.info.model));
+                break;
+            case TAG_ORIENTATION:
+                // 只采用主图像（第一个出现）的方向
+                if (ctx.visited.size() == 1 || ctx.info.orientation == 0) {
+                    uint32_t orientation = entryUInt(ctx, entry);
+                    if (orientation >= 1 && orientation <= 8) ctx.info.orientation = orientation;
+                }
+                break;
+            case TAG_SUB_IFDS: subIfds = entryUIntArray(ctx, entry, 8); break;
+            case TAG_EXIF_IFD: exifIfd = entryUInt(ctx, entry); break;
+            case TAG_EXPOSURE_TIME: ctx.info.exposureTime = entryRational(ctx, entry); break;
+            case TAG_F_NUMBER: ctx.info.aperture = entryRational(ctx, entry); break;
+            case TAG_ISO: if (ctx.info.iso == 0.0f) ctx.info.iso = static_cast<float>(entryUInt(ctx, entry)); break;
+            case TAG_FOCAL_LENGTH: ctx.info.focalLength = entryRational(ctx, entry); break;
+            case TAG_DNG_VERSION: ctx.isDng = true; break;
+            case TAG_RW2_SENSOR_WIDTH: if (ctx.isRw2) ctx.rw2Width = entryUInt(ctx, entry); break;
+            case TAG_RW2_SENSOR_HEIGHT: if (ctx.isRw2) ctx.rw2Height = entryUInt(ctx, entry); break;
+            case TAG_RW2_JPEG_FROM_RAW:
+                if (ctx.isRw2 && entry.dataSize() > 4) {
+                    ctx.rw2JpegOffset = entry.valueOffset;
+                    ctx.rw2JpegLength = entry.dataSize();
+                }
+                break;
+            default: break;
+        }
+    }
+
+    ctx.ifds.push_back(ifd);
+
+    if (depth < 3) {
+        for (uint32_t subIfd : subIfds) {
+            parseIfd(ctx, subIfd, depth + 1);
+        }
+        if (exifIfd != 0) {
+            parseIfd(ctx, exifIfd, depth + 1);
+        }
+    }
+
+    return readU32(&table[entryCount * 12], ctx.little);
+}
+
+/**
+ * 解析一个 IFD 链
+ */
+void parseIfd(TiffContext& ctx, uint64_t ifdOffset, int depth) {
+    while (ifdOffset != 0) {
+        ifdOffset = parseIfdEntries(ctx, ifdOffset, depth);
+        if (depth > 0) {
+            break;  // SubIFD / Exif IFD 不跟随链
+        }
+    }
+}
+
+/**
+ * 读取 TIFF 头
+ */
+bool readTiffHeader(HeaderReader& reader, uint64_t base, bool& little, uint16_t& magic, uint32_t& ifd0) {
+    uint8_t header[8];
+    if (!reader.read(base, header, sizeof(header))) {
+        return false;
+    }
+    if (header[0] == 'I' && header[1] == 'I') {
+        little = true;
+    } else if (header[0] == 'M' && header[1] == 'M') {
+        little = false;
+    } else {
+        return false;
+    }
+    magic = readU16(header + 2, little);
+    ifd0 = readU32(header + 4, little);
+    // 42 = TIFF，0x55 = Panasonic RW2，0x4F52 / 0x5352 = Olympus ORF
+    return magic == 42 || magic == 0x55 || magic == 0x4F52 || magic == 0x5352;
+}
+
+/**
+ * 只提取 TIFF 结构中的拍摄参数（CR3 CMT box、RAF 内嵌 JPEG 的 Exif）
+ */
+void parseTiffMetadata(HeaderReader& reader, uint64_t base, RawFileInfo& info) {
+    bool little;
+    uint16_t magic;
+    uint32_t ifd0;
+    if (!readTiffHeader(reader, base, little, magic, ifd0)) {
+        return;
+    }
+    TiffContext ctx(reader, base, little, info);
+    parseIfd(ctx, ifd0, 0);
+}
+
+/**
+ * TIFF 系 RAW（DNG / CR2 / NEF / ARW / ORF / RW2 ...）
+ */
+bool parseTiffRaw(HeaderReader& reader, RawFileInfo& info) {
+    bool little;
+    uint16_t magic;
+    uint32_t ifd0;
+    if (!readTiffHeader(reader, 0, little, magic, ifd0)) {
+        return false;
+    }
+
+    uint8_t cr2Marker[2] = {0, 0};
+    reader.read(8, cr2Marker, 2);
+    const bool isCr2 = cr2Marker[0] == 'C' && cr2Marker[1] == 'R';
+
+    TiffContext ctx(reader, 0, little, info);
+    ctx.isRw2 = magic == 0x55;
+    parseIfd(ctx, ifd0, 0);
+    if (ctx.ifds.empty()) {
+        return false;
+    }
+
+    // 格式
+    if (ctx.isDng) setFormat(info, "DNG");
+    else if (isCr2) setFormat(info, "CR2");
+    else if (ctx.isRw2) setFormat(info, "RW2");
+    else if (magic != 42) setFormat(info, "ORF");
+    else if (strncasecmp(info.make, "NIKON", 5) == 0) setFormat(info, "NEF");
+    else if (strncasecmp(info.make, "SONY", 4) == 0) setFormat(info, "ARW");
+    else if (strncasecmp(info.make, "PENTAX", 6) == 0 || strncasecmp(info.make, "RICOH", 5) == 0) setFormat(info, "PEF");
+    else setFormat(info, "TIFF");
+
+    // 原始图像 IFD：CFA / LinearRaw 中面积最大的；没有时取位深 > 8 的最大 IFD
+    const IfdInfo* rawIfd = nullptr;
+    for (const IfdInfo& ifd : ctx.ifds) {
+        if ((ifd.photometric == PHOTOMETRIC_CFA || ifd.photometric == PHOTOMETRIC_LINEAR_RAW) &&
+            (!rawIfd || static_cast<uint64_t>(ifd.width) * ifd.height >
+                        static_cast<uint64_t>(rawIfd->width) * rawIfd->height)) {
+            rawIfd = &ifd;
+        }
+    }
+
+    if (ctx.isRw2 && ctx.rw2Width > 0 && ctx.rw2Height > 0) {
+        info.width = ctx.rw2Width;
+        info.height = ctx.rw2Height;
+    } else if (isCr2) {
+        // CR2 的原始数据在 IFD3（无宽高标签），尺寸来自无损 JPEG 的 SOF3
+        if (ctx.ifds.size() > 3) {
+            uint32_t width = 0, height = 0, components = 0;
+            for (const IfdInfo& ifd : ctx.ifds) {
+                if (ifd.compression == 6 && ifd.width == 0 && ifd.stripOffset != 0 &&
+                    readJpegDimensions(reader, ifd.stripOffset, width, height, components)) {
+                    info.width = width * components;
+                    info.height = height;
+                    rawIfd = &ifd;
+                    break;
+                }
+            }
+        }
+    } else if (rawIfd) {
+        info.width = rawIfd->width;
+        info.height = rawIfd->height;
+    } else {
+        for (const IfdInfo& ifd : ctx.ifds) {
+            if (ifd.bitsPerSample > 8 &&
+                (!rawIfd || static_cast<uint64_t>(ifd.width) * ifd.height >
+                            static_cast<uint64_t>(rawIfd->width) * rawIfd->height)) {
+                rawIfd = &ifd;
+            }
+        }
+        if (rawIfd) {
+            info.width = rawIfd->width;
+            info.height = rawIfd->height;
+        }
+    }
+
+    // 嵌入式预览：所有 JPEG 候选中最大的
+    auto considerPreview = [&](uint64_t offset, uint64_t length, uint32_t width, uint32_t height) {
+        if (offset == 0 || length == 0 || offset > reader.size() || length > reader.size() - offset) {
+            return;
+        }
+        if (length > info.previewLength) {
+            info.previewOffset = offset;
+            info.previewLength = length;
+            info.previewWidth = width;
+            info.previewHeight = height;
+        }
+    };
+    for (const IfdInfo& ifd : ctx.ifds) {
+        if (&ifd == rawIfd) {
+            continue;
+        }
+        considerPreview(ifd.jpegOffset, ifd.jpegLength, 0, 0);
+        // JPEG 压缩的单条带 IFD（CR2 IFD0、DNG 预览 SubIFD）
+        const bool isJpegStrip = (ifd.compression == 6 || ifd.compression == 7) &&
+                                 ifd.photometric != PHOTOMETRIC_CFA &&
+                                 ifd.photometric != PHOTOMETRIC_LINEAR_RAW &&
+                                 ifd.stripCount == 1;
+        if (isJpegStrip) {
+            considerPreview(ifd.stripOffset, ifd.stripBytes, ifd.width, ifd.height);
+        }
+    }
+    considerPreview(ctx.rw2JpegOffset, ctx.rw2JpegLength, 0, 0);
+
+    return true;
+}
+
+/**
+ * ISO BMFF box 头
+ */
+struct Box {
+    uint64_t offset;        // box 起始
+    uint64_t payload;       // 数据起始（跳过头部和 uuid）
+    uint64_t end;
+    char type[5];
+    uint8_t uuid[16];
+};
+
+bool readBox(HeaderReader& reader, uint64_t offset, uint64_t limit, Box& box) {
+    uint8_t header[16];
+    if (offset + 8 > limit || !reader.read(offset, header, 8)) {
+        return false;
+    }
+    uint64_t size = readU32(header, false);
+    std::memcpy(box.type, header + 4, 4);
+    box.type[4] = '\0';
+    uint64_t headerSize = 8;
+    if (size == 1) {
+        if (!reader.read(offset + 8, header + 8, 8)) {
+            return false;
+        }
+        size = readU64BE(header + 8);
+        headerSize = 16;
+    } else if (size == 0) {
+        size = limit - offset;
+    }
+    if (size < headerSize || size > limit - offset) {
+        return false;
+    }
+    if (std::memcmp(box.type, "uuid", 4) == 0) {
+        if (!reader.read(offset + headerSize, box.uuid, 16)) {
+            return false;
+        }
+        headerSize += 16;
+    }
+    box.offset = offset;
+    box.payload = offset + headerSize;
+    box.end = offset + size;
+    return box.payload <= box.end;
+}
+
+/**
+ * CR3 轨道信息
+ */
+struct Cr3Track {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool isJpeg = false;
+    bool isRaw = false;
+    uint64_t chunkOffset = 0;
+    uint64_t sampleSize = 0;
+};
+
+void parseCr3SampleDescription(HeaderReader& reader, const Box& stsd, Cr3Track& track) {
+    // FullBox(4) + entry_count(4) + 第一个 sample entry
+    Box entry;
+    if (!readBox(reader, stsd.payload + 8, stsd.end, entry)) {
+        return;
+    }
+    // VisualSampleEntry：宽高位于 entry 起始 +32 / +34
+    uint8_t size[4];
+    if (reader.read(entry.offset + 32, size, sizeof(size))) {
+        track.width = readU16(size, false);
+        track.height = readU16(size + 2, false);
+    }
+    // CRAW entry 之后是子 box：JPEG 表示预览轨道，CMP1 表示 RAW 轨道
+    uint64_t pos = entry.offset + 90;
+    for (int i = 0; i < kMaxBoxesPerLevel && pos < entry.end; ++i) {
+        Box child;
+        if (!readBox(reader, pos, entry.end, child)) {
+            break;
+        }
+        if (std::memcmp(child.type, "JPEG", 4) == 0) track.isJpeg = true;
+        if (std::memcmp(child.type, "CMP1", 4) == 0) track.isRaw = true;
+        pos = child.end;
+    }
+}
+
+void parseCr3Boxes(HeaderReader& reader, uint64_t offset, uint64_t end, int depth,
+                   RawFileInfo& info, std::vector<Cr3Track>& tracks) {
+    if (depth > kMaxBoxDepth) {
+        return;
+    }
+    uint64_t pos = offset;
+    for (int i = 0; i < kMaxBoxesPerLevel && pos < end; ++i) {
+        Box box;
+        if (!readBox(reader, pos, end, box)) {
+            break;
+        }
+        const char* type = box.type;
+
+        if (std::memcmp(type, "moov", 4) == 0 || std::memcmp(type, "mdia", 4) == 0 ||
+            std::memcmp(type, "minf", 4) == 0 || std::memcmp(type, "stbl", 4) == 0) {
+            parseCr3Boxes(reader, box.payload, box.end, depth + 1, info, tracks);
+        } else if (std::memcmp(type, "trak", 4) == 0) {
+            tracks.emplace_back();
+            parseCr3Boxes(reader, box.payload, box.end, depth + 1, info, tracks);
+        } else if (std::memcmp(type, "uuid", 4) == 0 && std::memcmp(box.uuid, kCanonUuid, 16) == 0) {
+            parseCr3Boxes(reader, box.payload, box.end, depth + 1, info, tracks);
+        } else if (std::memcmp(type, "CMT1", 4) == 0 || std::memcmp(type, "CMT2", 4) == 0) {
+            // CMT1 = IFD0（相机型号、方向），CMT2 = Exif IFD（拍摄参数），都是完整的 TIFF 结构
+            parseTiffMetadata(reader, box.payload, info);
+        } else if (!tracks.empty() && std::memcmp(type, "stsd", 4) == 0) {
+            parseCr3SampleDescription(reader, box, tracks.back());
+        } else if (!tracks.empty() && std::memcmp(type, "stsz", 4) == 0) {
+            uint8_t value[12];
+            if (reader.read(box.payload, value, sizeof(value))) {
+                uint64_t sampleSize = readU32(value + 4, false);
+                uint8_t first[4];
+                if (sampleSize == 0 && readU32(value + 8, false) > 0 &&
+                    reader.read(box.payload + 12, first, sizeof(first))) {
+                    sampleSize = readU32(first, false);
+                }
+                tracks.back().sampleSize = sampleSize;
+            }
+        } else if (!tracks.empty() && std::memcmp(type, "stco", 4) == 0) {
+            uint8_t value[12];
+            if (reader.read(box.payload, value, sizeof(value)) && readU32(value + 4, false) > 0) {
+                tracks.back().chunkOffset = readU32(value + 8, false);
+            }
+        } else if (!tracks.empty() && std::memcmp(type, "co64", 4) == 0) {
+            uint8_t value[16];
+            if (reader.read(box.payload, value, sizeof(value)) && readU32(value + 4, false) > 0) {
+                tracks.back().chunkOffset = readU64BE(value + 8);
+            }
+        }
+        pos = box.end;
+    }
+}
+
+/**
+ * Canon CR3（ISO BMFF）
+ */
+bool parseCr3(HeaderReader& reader, RawFileInfo& info) {
+    uint8_t header[12];
+    if (!reader.read(0, header, sizeof(header)) ||
+        std::memcmp(header + 4, "ftyp", 4) != 0 || std::memcmp(header + 8, "crx ", 4) != 0) {
+        return false;
+    }
+    setFormat(info, "CR3");
+
+    std::vector<Cr3Track> tracks;
+    parseCr3Boxes(reader, 0, reader.size(), 0, info, tracks);
+
+    for (const Cr3Track& track : tracks) {
+        const uint64_t area = static_cast<uint64_t>(track.width) * track.height;
+        if (track.isRaw && area > static_cast<uint64_t>(info.width) * info.height) {
+            info.width = track.width;
+            info.height = track.height;
+        }
+        if (track.isJpeg && track.chunkOffset != 0 && track.sampleSize > info.previewLength &&
+            track.chunkOffset <= reader.size() && track.sampleSize <= reader.size() - track.chunkOffset) {
+            info.previewOffset = track.chunkOffset;
+            info.previewLength = track.sampleSize;
+            info.previewWidth = track.width;
+            info.previewHeight = track.height;
+        }
+    }
+    return true;
+}
+
+/**
+ * Fuji RAF
+ */
+bool parseRaf(HeaderReader& reader, RawFileInfo& info) {
+    uint8_t header[100];
+    if (!reader.read(0, header, sizeof(header)) || std::memcmp(header, "FUJIFILMCCD-RAW", 15) != 0) {
+        return false;
+    }
+    setFormat(info, "RAF");
+    copyString(info.make, sizeof(info.make), "FUJIFILM", 8);
+    copyString(info.model, sizeof(info.model), reinterpret_cast<const char*>(header + 28),
+               strnlen(reinterpret_cast<const char*>(header + 28), 32));
+
+    // 偏移表：内嵌 JPEG（84）、CFA 头（92）
+    const uint64_t jpegOffset = readU32(header + 84, false);
+    const uint64_t jpegLength = readU32(header + 88, false);
+    const uint64_t cfaHeaderOffset = readU32(header + 92, false);
+
+    if (jpegOffset != 0 && jpegLength != 0 && jpegOffset <= reader.size() &&
+        jpegLength <= reader.size() - jpegOffset) {
+        info.previewOffset = jpegOffset;
+        info.previewLength = jpegLength;
+        uint32_t components = 0;
+        readJpegDimensions(reader, jpegOffset, info.previewWidth, info.previewHeight, components);
+
+        // 拍摄参数在内嵌 JPEG 的 APP1 Exif 中
+        uint8_t app1[10];
+        if (reader.read(jpegOffset + 2, app1, sizeof(app1)) && app1[0] == 0xFF && app1[1] == 0xE1 &&
+            std::memcmp(app1 + 4, "Exif\0\0", 6) == 0) {
+            parseTiffMetadata(reader, jpegOffset + 12, info);
+        }
+    }
+
+    // CFA 头目录：条目 0x100 为原始尺寸（高、宽）
+    uint8_t countBytes[4];
+    if (cfaHeaderOffset != 0 && reader.read(cfaHeaderOffset, countBytes, sizeof(countBytes))) {
+        const uint32_t count = std::min<uint32_t>(readU32(countBytes, false), 256);
+        uint64_t pos = cfaHeaderOffset + 4;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint8_t entry[8];
+            if (!reader.read(pos, entry, 4)) {
+                break;
+            }
+            const uint16_t tag = readU16(entry, false);
+            const uint16_t size = readU16(entry + 2, false);
+            if (tag == 0x100 && size >= 4 && reader.read(pos + 4, entry + 4, 4)) {
+                info.height = readU16(entry + 4, false);
+                info.width = readU16(entry + 6, false);
+                break;
+            }
+            pos += 4 + size;
+        }
+    }
+    return true;
+}
+
+bool parseWithReader(HeaderReader& reader, RawFileInfo& info) {
+    std::memset(&info, 0, sizeof(info));
+    if (!reader.init()) {
+        return false;
+    }
+
+    bool recognized = parseTiffRaw(reader, info) || parseCr3(reader, info) || parseRaf(reader, info);
+    if (recognized && info.orientation == 0) {
+        info.orientation = 1;
+    }
+    return recognized;
+}
+
+} // namespace
+
+bool RawHeaderParser::parseFd(int fd, RawFileInfo& info) {
+    HeaderReader reader(fd);
+    return parseWithReader(reader, info);
+}
+
+bool RawHeaderParser::parseBuffer(const uint8_t* data, size_t size, RawFileInfo& info) {
+    if (!data || size == 0) {
+        return false;
+    }
+    HeaderReader reader(data, size);
+    return parseWithReader(reader, info);
+}
+
+bool RawHeaderParser::parse(const char* filePath, RawFileInfo& info) {
+    if (!filePath) {
+        return false;
+    }
+    int fd = ::open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("parse: Cannot open '%s': %s", filePath, std::strerror(errno));
+        return false;
+    }
+    bool success = parseFd(fd, info);
+    ::close(fd);
+    return success;
+}
+
+std::vector<bool> RawHeaderParser::parseFiles(const std::vector<std::string>& filePaths,
+                                              std::vector<RawFileInfo>& infos) {
+    const size_t count = filePaths.size();
+    infos.assign(count, RawFileInfo());
+    std::vector<uint8_t> results(count, 0);
+
+    // 以 I/O 为主，线程数可以略多于核心数
+    const uint32_t numThreads = static_cast<uint32_t>(std::min<size_t>(
+        count, std::max(2u, std::thread::hardware_concurrency())));
+    std::atomic<size_t> next(0);
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                results[i] = parse(filePaths[i].c_str(), infos[i]) ? 1 : 0;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return std::vector<bool>(results.begin(), results.end());
+}
+
+} // namespace filmtracker
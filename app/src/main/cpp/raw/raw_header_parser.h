@@ -0,0 +1,76 @@
+#ifndef FILMTRACKER_RAW_HEADER_PARSER_H
+#define FILMTRACKER_RAW_HEADER_PARSER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * RAW 文件头信息（不解包图像数据）
+ */
+struct RawFileInfo {
+    char format[8];             // "DNG", "CR2", "CR3", "NEF", "ARW", "ORF", "RW2", "RAF", "TIFF"
+    uint32_t width;             // 传感器原始尺寸（与 LibRaw raw_width / raw_height 一致）
+    uint32_t height;
+    uint32_t orientation;       // EXIF 方向（1-8），未知为 1
+    float iso;
+    float exposureTime;         // 秒
+    float aperture;
+    float focalLength;
+    char make[32];
+    char model[64];
+
+    // 最大的嵌入式 JPEG 预览（文件内偏移，长度为 0 表示没有）
+    uint64_t previewOffset;
+    uint64_t previewLength;
+    uint32_t previewWidth;
+    uint32_t previewHeight;
+};
+
+/**
+ * 轻量 RAW 文件头解析器
+ *
+ * 只通过 pread 读取文件开头的一个块和少量 IFD / box，不经过 LibRaw，
+ * 用于图库浏览时批量扫描尺寸、方向、拍摄参数和嵌入式预览位置。
+ *
+ * 支持：
+ * - TIFF/IFD 结构：DNG、CR2、NEF、ARW、ORF、RW2、PEF 等
+ * - ISO BMFF box 结构：CR3
+ * - Fuji RAF
+ */
+class RawHeaderParser {
+public:
+    /**
+     * 按路径解析
+     *
+     * @return 是否识别出 RAW 容器格式（尺寸等字段可能仍为 0）
+     */
+    static bool parse(const char* filePath, RawFileInfo& info);
+
+    /**
+     * 从文件描述符解析（fd 不会被关闭）
+     */
+    static bool parseFd(int fd, RawFileInfo& info);
+
+    /**
+     * 从内存缓冲区解析（例如 MappedRawFile 的映射区域）
+     */
+    static bool parseBuffer(const uint8_t* data, size_t size, RawFileInfo& info);
+
+    /**
+     * 多线程批量解析
+     *
+     * @param filePaths 文件列表
+     * @param infos 输出信息（与输入一一对应）
+     * @return 每个文件是否解析成功
+     */
+    static std::vector<bool> parseFiles(const std::vector<std::string>& filePaths,
+                                        std::vector<RawFileInfo>& infos);
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_RAW_HEADER_PARSER_H
@@ -1,4 +1,7 @@
 #include "raw_processor.h"
+#include "raw_file_source.h"
+#include "decoded_image_cache.h"
+#include "image_hash_cache.h"
 #include <libraw.h>
 #include <fstream>
 #include <cmath>
@@ -12,9 +15,106 @@
 #define LOG_TAG "RawProcessor"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 
 namespace filmtracker {
 
+namespace {
+
+// 解码输出格式版本：解码流程改变时递增，使旧的磁盘缓存失效
+// 2：应用相机白平衡和色彩矩阵
+const uint32_t kDecodeFormatVersion = 2;
+
+// 去马赛克自身需要的上下 halo 行数（PPG 读取 ±2 行，并依赖相邻行插值出的绿色）
+const uint32_t kDemosaicHaloRows = 4;
+
+// 线性 Rec.709 -> 线性 ProPhoto（D65 -> D50 Bradford 适配）
+const float kRec709ToProPhoto[9] = {
+    0.5293458f, 0.3300728f, 0.1405812f,
+    0.0983744f, 0.8734611f, 0.0281647f,
+    0.0168832f, 0.1176725f, 0.8654443f
+};
+
+uint32_t decodeSettingsKey(const RawProcessor::Config& config) {
+    return static_cast<uint32_t>(config.demosaicQuality) |
+           (static_cast<uint32_t>(config.colorSpace) << 4) |
+           (config.applyCameraColor ? 1u << 7 : 0u) |
+           (kDecodeFormatVersion << 8);
+}
+
+/**
+ * 源文件解码结果的来源标识（路径、大小、修改时间、解码设置和输出变体）
+ * 
+ * 同一文件以相同设置解码总得到相同像素，下游缓存可以直接以此为键
+ * 
+ * @param variant 0 为完整解码，预览为缩小倍数
+ */
+uint64_t sourceProvenance(const DecodedImageCache::Key& key, uint32_t variant) {
+    const int64_t fields[4] = {key.fileSize, key.modifiedTimeNs,
+                               static_cast<int64_t>(key.decodeSettings), static_cast<int64_t>(variant)};
+    const uint64_t seed = ImageHashCache::hashBytes(key.filePath.data(), key.filePath.size());
+    const uint64_t provenance = ImageHashCache::hashBytes(fields, sizeof(fields), seed);
+    return provenance != 0 ? provenance : 1;
+}
+
+/**
+ * 相机白平衡系数（R, G, B），按最小值归一化为 1
+ * 
+ * 优先使用拍摄时的 cam_mul，无效时退回 pre_mul（日光），都无效时返回 false
+ */
+bool cameraWhiteBalance(const libraw_colordata_t& color, float wb[3]) {
+    const float* sources[2] = {color.cam_mul, color.pre_mul};
+    for (const float* mul : sources) {
+        if (mul[0] > 0.0f && mul[1] > 0.0f && mul[2] > 0.0f) {
+            const float minMul = std::min(mul[0], std::min(mul[1], mul[2]));
+            for (int c = 0; c < 3; ++c) {
+                wb[c] = mul[c] / minMul;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 相机 RGB（已白平衡）-> 工作空间矩阵
+ * 
+ * LibRaw 的 rgb_cam 把白平衡后的相机 RGB 转到线性 sRGB（每行和为 1），
+ * ProPhoto 在此基础上再乘一个固定矩阵。rgb_cam 缺失或不可用（非三色相机）时返回 false。
+ */
+bool cameraToWorkingMatrix(const libraw_colordata_t& color, int colors,
+                           WorkingColorSpace space, float matrix[9]) {
+    if (colors != 3) {
+        return false;
+    }
+    float camToRec709[9];
+    for (int i = 0; i < 3; ++i) {
+        float rowSum = 0.0f;
+        for (int j = 0; j < 3; ++j) {
+            camToRec709[i * 3 + j] = color.rgb_cam[i][j];
+            rowSum += color.rgb_cam[i][j];
+        }
+        if (std::fabs(rowSum - 1.0f) > 0.05f) {
+            return false;
+        }
+    }
+    
+    if (space == WorkingColorSpace::PROPHOTO) {
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                matrix[i * 3 + j] = kRec709ToProPhoto[i * 3 + 0] * camToRec709[0 * 3 + j] +
+                                    kRec709ToProPhoto[i * 3 + 1] * camToRec709[1 * 3 + j] +
+                                    kRec709ToProPhoto[i * 3 + 2] * camToRec709[2 * 3 + j];
+            }
+        }
+    } else {
+        std::memcpy(matrix, camToRec709, sizeof(camToRec709));
+    }
+    return true;
+}
+
+} // namespace
+
 RawProcessor::RawProcessor() {
 }
 
@@ -26,6 +126,12 @@ RawProcessor::~RawProcessor() {
  * 支持所有 LibRaw 支持的 RAW 格式（ARW, CR2, NEF, RAF, ORF, RW2 等）
  */
 LinearImage RawProcessor::loadRaw(const char* filePath, RawMetadata& metadata) {
+    SharedImage image = loadRawShared(filePath, metadata);
+    // 后台写入线程仍持有缓冲区时 mutableImage() 先复制
+    return std::move(image.mutableImage());
+}
+
+SharedImage RawProcessor::loadRawShared(const char* filePath, RawMetadata& metadata) {
     LOGI("loadRaw: Starting with LibRaw, filePath=%s", filePath);
     
     if (!filePath) {
@@ -33,11 +139,33 @@ LinearImage RawProcessor::loadRaw(const char* filePath, RawMetadata& metadata) {
         throw std::runtime_error("File path is null");
     }
     
+    // 查找解码图像磁盘缓存
+    DecodedImageCache& diskCache = DecodedImageCache::getInstance();
+    // 同一个键也是结果图像的来源标识（文件不存在时 makeKey 失败，后面打开文件会报错）
+    DecodedImageCache::Key cacheKey;
+    const bool haveKey = DecodedImageCache::makeKey(filePath, decodeSettingsKey(m_config), cacheKey);
+    bool useDiskCache = haveKey && m_config.enableDiskCache && diskCache.isEnabled();
+    if (useDiskCache) {
+        LinearImage cached(0, 0);
+        if (diskCache.find(cacheKey, cached, metadata)) {
+            LOGI("loadRaw: Disk cache hit (%ux%u)", cached.width, cached.height);
+            cached.provenance = sourceProvenance(cacheKey, 0);
+            return SharedImage::create(std::move(cached), MemoryCategory::IMAGES);
+        }
+    }
+    
     // 创建 LibRaw 处理器
     LibRaw rawProcessor;
     
-    // 打开 RAW 文件
-    int ret = rawProcessor.open_file(filePath);
+    // 打开 RAW 文件：优先使用只读内存映射交给 LibRaw，映射失败时退回 open_file
+    MappedRawFile mappedFile;
+    int ret;
+    if (mappedFile.open(filePath)) {
+        ret = rawProcessor.open_buffer(const_cast<uint8_t*>(mappedFile.data()), mappedFile.size());
+    } else {
+        LOGW("loadRaw: mmap failed, falling back to open_file");
+        ret = rawProcessor.open_file(filePath);
+    }
     if (ret != LIBRAW_SUCCESS) {
         LOGE("loadRaw: Failed to open RAW file: %s, error: %s", 
              filePath, libraw_strerror(ret));
@@ -56,131 +184,23 @@ LinearImage RawProcessor::loadRaw(const char* filePath, RawMetadata& metadata) {
     
     LOGI("loadRaw: RAW data unpacked successfully");
     
-    // 获取图像数据（imgdata 是结构体，不是指针）
-    libraw_data_t& imgdata = rawProcessor.imgdata;
-    
-    // 提取元数据
-    metadata.width = imgdata.sizes.width;
-    metadata.height = imgdata.sizes.height;
-    metadata.iso = imgdata.other.iso_speed;
-    metadata.exposureTime = imgdata.other.shutter;
-    metadata.aperture = imgdata.other.aperture;
-    metadata.focalLength = imgdata.other.focal_len;
+    LinearImage result = decodeUnpacked(rawProcessor, metadata);
     
-    // 相机信息
-    std::strncpy(metadata.cameraModel, imgdata.idata.make, sizeof(metadata.cameraModel) - 1);
-    std::strncat(metadata.cameraModel, " ", sizeof(metadata.cameraModel) - std::strlen(metadata.cameraModel) - 1);
-    std::strncat(metadata.cameraModel, imgdata.idata.model, sizeof(metadata.cameraModel) - std::strlen(metadata.cameraModel) - 1);
-    
-    // 白平衡（只使用前两个值）
-    metadata.whiteBalance[0] = imgdata.color.cam_mul[0];
-    metadata.whiteBalance[1] = imgdata.color.cam_mul[1];
-    
-    // 黑电平和白电平
-    metadata.blackLevel = static_cast<float>(imgdata.color.black);
-    metadata.whiteLevel = static_cast<float>(imgdata.color.maximum);
-    
-    // Bits per sample
-    metadata.bitsPerSample = imgdata.sizes.raw_pitch ? 16 : 14;
-    
-    // 颜色空间
-    std::strncpy(metadata.colorSpace, "sRGB", sizeof(metadata.colorSpace) - 1);
-    
-    LOGI("loadRaw: Image dimensions: %dx%d, ISO=%.0f, Exposure=%.3fs, Aperture=f/%.1f, Focal=%.1fmm",
-         metadata.width, metadata.height, metadata.iso, metadata.exposureTime,
-         metadata.aperture, metadata.focalLength);
-    LOGI("loadRaw: Camera: %s", metadata.cameraModel);
-    LOGI("loadRaw: Black level=%.0f, White level=%.0f, Bits per sample=%d",
-         metadata.blackLevel, metadata.whiteLevel, metadata.bitsPerSample);
-    
-    // 获取 RAW Bayer 数据
-    uint16_t* rawData = imgdata.rawdata.raw_image;
-    if (!rawData) {
-        LOGE("loadRaw: RAW image data is null");
-        rawProcessor.recycle();
-        throw std::runtime_error("RAW image data is null");
-    }
-    
-    uint32_t rawWidth = imgdata.sizes.raw_width;
-    uint32_t rawHeight = imgdata.sizes.raw_height;
-    uint32_t rawPixels = rawWidth * rawHeight;
-    
-    LOGI("loadRaw: RAW dimensions: %dx%d (%u pixels)", rawWidth, rawHeight, rawPixels);
-    
-    // 获取 CFA 模式
-    uint32_t cfaPattern = 0;  // 默认 RGGB
-    if (imgdata.idata.filters > 0) {
-        uint32_t filter = imgdata.idata.filters;
-        if ((filter & 0x0000FF00) == 0x00009400) {
-            cfaPattern = 0;  // RGGB
-        } else if ((filter & 0x0000FF00) == 0x00004900) {
-            cfaPattern = 1;  // GRBG
-        } else if ((filter & 0x0000FF00) == 0x00006100) {
-            cfaPattern = 2;  // GBRG
-        } else if ((filter & 0x0000FF00) == 0x00001600) {
-            cfaPattern = 3;  // BGGR
-        }
-        LOGI("loadRaw: CFA pattern: %u (filter=0x%08x)", cfaPattern, filter);
-    }
-    
-    // 将 RAW 数据复制到 vector（用于黑电平校正）
-    std::vector<uint16_t> rawBayerData(rawPixels);
-    std::memcpy(rawBayerData.data(), rawData, rawPixels * sizeof(uint16_t));
-    
-    // 应用黑电平校正
-    applyBlackLevel(rawBayerData, metadata.blackLevel, rawWidth, rawHeight);
+    // 清理 LibRaw 资源
+    rawProcessor.recycle();
     
-    // 归一化到 0-1 范围
-    std::vector<float> normalizedRawData(rawPixels);
-    float whiteLevel = metadata.whiteLevel;
-    for (size_t i = 0; i < rawPixels; ++i) {
-        normalizedRawData[i] = std::max(0.0f, std::min(1.0f, 
-            static_cast<float>(rawBayerData[i]) / whiteLevel));
+    if (haveKey) {
+        result.provenance = sourceProvenance(cacheKey, 0);
     }
     
-    LOGI("loadRaw: Applied black level correction and normalization");
-    
-    // 去马赛克（Bayer 转 RGB）
-    LinearImage demosaiced = demosaicBayerNormalized(normalizedRawData, rawWidth, rawHeight, cfaPattern);
-    
-    LOGI("loadRaw: Demosaicing completed, output size: %dx%d", demosaiced.width, demosaiced.height);
-    
-    // 如果 RAW 尺寸与输出尺寸不匹配，需要缩放
-    if (demosaiced.width != metadata.width || demosaiced.height != metadata.height) {
-        LOGI("loadRaw: Resizing from %dx%d to %dx%d", 
-             demosaiced.width, demosaiced.height, metadata.width, metadata.height);
-        
-        LinearImage resized(metadata.width, metadata.height);
-        
-        float scaleX = static_cast<float>(demosaiced.width) / static_cast<float>(metadata.width);
-        float scaleY = static_cast<float>(demosaiced.height) / static_cast<float>(metadata.height);
-        
-        for (uint32_t y = 0; y < metadata.height; ++y) {
-            for (uint32_t x = 0; x < metadata.width; ++x) {
-                uint32_t srcX = static_cast<uint32_t>(x * scaleX);
-                uint32_t srcY = static_cast<uint32_t>(y * scaleY);
-                srcX = std::min(srcX, demosaiced.width - 1);
-                srcY = std::min(srcY, demosaiced.height - 1);
-                
-                uint32_t dstIdx = y * metadata.width + x;
-                uint32_t srcIdx = srcY * demosaiced.width + srcX;
-                
-                resized.r[dstIdx] = demosaiced.r[srcIdx];
-                resized.g[dstIdx] = demosaiced.g[srcIdx];
-                resized.b[dstIdx] = demosaiced.b[srcIdx];
-            }
-        }
-        
-        rawProcessor.recycle();
-        LOGI("loadRaw: Completed successfully with LibRaw");
-        return resized;
+    SharedImage shared = SharedImage::create(std::move(result), MemoryCategory::IMAGES);
+    if (useDiskCache) {
+        // fp16 转换和 fsync 在后台写入线程进行，解码线程直接返回
+        diskCache.storeAsync(cacheKey, shared.share(), metadata);
     }
     
-    // 清理 LibRaw 资源
-    rawProcessor.recycle();
-    
     LOGI("loadRaw: Completed successfully with LibRaw");
-    return demosaiced;
+    return shared;
 }
 
 LinearImage RawProcessor::loadRawFromBuffer(const uint8_t* buffer, 
@@ -215,10 +235,174 @@ LinearImage RawProcessor::loadRawFromBuffer(const uint8_t* buffer,
     
     LOGI("loadRawFromBuffer: RAW data unpacked successfully");
     
+    LinearImage result = decodeUnpacked(rawProcessor, metadata);
+    
+    rawProcessor.recycle();
+    
+    LOGI("loadRawFromBuffer: Completed successfully with LibRaw");
+    return result;
+}
+
+LinearImage RawProcessor::loadRawFromFd(int fd, int64_t offset, int64_t length, RawMetadata& metadata) {
+    LOGI("loadRawFromFd: fd=%d, offset=%lld, length=%lld",
+         fd, static_cast<long long>(offset), static_cast<long long>(length));
+    
+    // 映射在整个解码期间保持有效，LibRaw 直接读取映射区域
+    MappedRawFile mappedFile;
+    if (!mappedFile.openFd(fd, offset, length)) {
+        LOGE("loadRawFromFd: Failed to map file descriptor %d", fd);
+        throw std::runtime_error("Failed to map RAW file descriptor");
+    }
+    
+    return loadRawFromBuffer(mappedFile.data(), mappedFile.size(), metadata);
+}
+
+LinearImage RawProcessor::loadRawPreview(const char* filePath, RawMetadata& metadata, uint32_t downscale) {
+    LOGI("loadRawPreview: Starting, filePath=%s, downscale=%u", filePath, downscale);
+    
+    if (!filePath) {
+        LOGE("loadRawPreview: File path is null");
+        throw std::runtime_error("File path is null");
+    }
+    if (downscale != 2 && downscale != 4) {
+        LOGE("loadRawPreview: Unsupported downscale %u", downscale);
+        throw std::runtime_error("Unsupported preview downscale");
+    }
+    
+    LibRaw rawProcessor;
+    
+    MappedRawFile mappedFile;
+    int ret;
+    if (mappedFile.open(filePath)) {
+        ret = rawProcessor.open_buffer(const_cast<uint8_t*>(mappedFile.data()), mappedFile.size());
+    } else {
+        LOGW("loadRawPreview: mmap failed, falling back to open_file");
+        ret = rawProcessor.open_file(filePath);
+    }
+    if (ret != LIBRAW_SUCCESS) {
+        LOGE("loadRawPreview: Failed to open RAW file: %s, error: %s", 
+             filePath, libraw_strerror(ret));
+        throw std::runtime_error("Failed to open RAW file");
+    }
+    
+    ret = rawProcessor.unpack();
+    if (ret != LIBRAW_SUCCESS) {
+        LOGE("loadRawPreview: Failed to unpack RAW data: %s", libraw_strerror(ret));
+        rawProcessor.recycle();
+        throw std::runtime_error("Failed to unpack RAW data");
+    }
+    
+    BayerRawView view = prepareRawView(rawProcessor, metadata);
+    
+    // 直接从解包后的缓冲区生成超像素，不做去马赛克
+    LinearImage preview(view.width / downscale, view.height / downscale);
+    BayerDemosaic::superpixel(view, downscale, preview);
+    
+    rawProcessor.recycle();
+    
+    DecodedImageCache::Key sourceKey;
+    if (DecodedImageCache::makeKey(filePath, decodeSettingsKey(m_config), sourceKey)) {
+        preview.provenance = sourceProvenance(sourceKey, downscale);
+    }
+    
+    LOGI("loadRawPreview: Completed, preview size: %ux%u", preview.width, preview.height);
+    return preview;
+}
+
+bool RawProcessor::loadRawStrips(const char* filePath,
+                                 RawMetadata& metadata,
+                                 uint32_t stripHeight,
+                                 uint32_t haloRows,
+                                 const StripConsumer& consumer) {
+    LOGI("loadRawStrips: Starting, filePath=%s, stripHeight=%u, haloRows=%u",
+         filePath, stripHeight, haloRows);
+    
+    if (!filePath) {
+        LOGE("loadRawStrips: File path is null");
+        throw std::runtime_error("File path is null");
+    }
+    
+    LibRaw rawProcessor;
+    
+    MappedRawFile mappedFile;
+    int ret;
+    if (mappedFile.open(filePath)) {
+        ret = rawProcessor.open_buffer(const_cast<uint8_t*>(mappedFile.data()), mappedFile.size());
+    } else {
+        LOGW("loadRawStrips: mmap failed, falling back to open_file");
+        ret = rawProcessor.open_file(filePath);
+    }
+    if (ret != LIBRAW_SUCCESS) {
+        LOGE("loadRawStrips: Failed to open RAW file: %s, error: %s", 
+             filePath, libraw_strerror(ret));
+        throw std::runtime_error("Failed to open RAW file");
+    }
+    
+    ret = rawProcessor.unpack();
+    if (ret != LIBRAW_SUCCESS) {
+        LOGE("loadRawStrips: Failed to unpack RAW data: %s", libraw_strerror(ret));
+        rawProcessor.recycle();
+        throw std::runtime_error("Failed to unpack RAW data");
+    }
+    
+    const BayerRawView view = prepareRawView(rawProcessor, metadata);
+    
+    // 条带起点和 halo 都保持偶数，子视图的 CFA 相位与整幅一致
+    const uint32_t rows = std::max(2u, (stripHeight + 1) & ~1u);
+    const uint32_t halo = (haloRows + kDemosaicHaloRows + 1) & ~1u;
+    
+    // 条带缓冲区按最大条带分配一次，之后只调整逻辑尺寸（不缩小容量）
+    const uint32_t maxRows = std::min(view.height, rows + 2 * halo);
+    LinearImage strip(view.width, maxRows);
+    
+    bool completed = true;
+    for (uint32_t y0 = 0; y0 < view.height; y0 += rows) {
+        const uint32_t y1 = std::min(view.height, y0 + rows);
+        const uint32_t top = y0 > halo ? y0 - halo : 0;
+        const uint32_t bottom = std::min(view.height, y1 + halo);
+        
+        BayerRawView stripView = view;
+        stripView.data = view.data + static_cast<size_t>(top) * view.stride;
+        stripView.height = bottom - top;
+        
+        const size_t pixelCount = static_cast<size_t>(view.width) * stripView.height;
+        strip.height = stripView.height;
+        strip.r.resize(pixelCount);
+        strip.g.resize(pixelCount);
+        strip.b.resize(pixelCount);
+        
+        BayerDemosaic::demosaic(stripView, m_config.demosaicQuality, strip);
+        
+        if (!consumer(strip, y0, y0 - top, y1 - y0)) {
+            LOGW("loadRawStrips: Stopped by consumer at row %u", y0);
+            completed = false;
+            break;
+        }
+    }
+    
+    rawProcessor.recycle();
+    
+    LOGI("loadRawStrips: %s, %ux%u, strip buffer %ux%u",
+         completed ? "Completed" : "Stopped", view.width, view.height, view.width, maxRows);
+    return completed;
+}
+
+LinearImage RawProcessor::decodeUnpacked(LibRaw& rawProcessor, RawMetadata& metadata) {
+    BayerRawView view = prepareRawView(rawProcessor, metadata);
+    
+    // 黑电平校正、归一化和去马赛克在同一遍中完成
+    LinearImage demosaiced(view.width, view.height);
+    BayerDemosaic::demosaic(view, m_config.demosaicQuality, demosaiced);
+    
+    LOGI("decodeUnpacked: Demosaicing completed, output size: %dx%d", demosaiced.width, demosaiced.height);
+    return demosaiced;
+}
+
+BayerRawView RawProcessor::prepareRawView(LibRaw& rawProcessor, RawMetadata& metadata) {
     // 获取图像数据（imgdata 是结构体，不是指针）
     libraw_data_t& imgdata = rawProcessor.imgdata;
     
-    // 提取元数据（与loadRaw相同的逻辑）
+    // 提取元数据
     metadata.width = imgdata.sizes.width;
     metadata.height = imgdata.sizes.height;
     metadata.iso = imgdata.other.iso_speed;
@@ -226,91 +410,133 @@ LinearImage RawProcessor::loadRawFromBuffer(const uint8_t* buffer,
     metadata.aperture = imgdata.other.aperture;
     metadata.focalLength = imgdata.other.focal_len;
     
+    // 相机信息
     std::strncpy(metadata.cameraModel, imgdata.idata.make, sizeof(metadata.cameraModel) - 1);
     std::strncat(metadata.cameraModel, " ", sizeof(metadata.cameraModel) - std::strlen(metadata.cameraModel) - 1);
     std::strncat(metadata.cameraModel, imgdata.idata.model, sizeof(metadata.cameraModel) - std::strlen(metadata.cameraModel) - 1);
     
+    // 白平衡（只使用前两个值）
     metadata.whiteBalance[0] = imgdata.color.cam_mul[0];
     metadata.whiteBalance[1] = imgdata.color.cam_mul[1];
     
-    metadata.blackLevel = static_cast<float>(imgdata.color.black);
-    metadata.whiteLevel = static_cast<float>(imgdata.color.maximum);
+    // Bits per sample
     metadata.bitsPerSample = imgdata.sizes.raw_pitch ? 16 : 14;
-    std::strncpy(metadata.colorSpace, "sRGB", sizeof(metadata.colorSpace) - 1);
     
     // 获取 RAW Bayer 数据
     uint16_t* rawData = imgdata.rawdata.raw_image;
     if (!rawData) {
-        LOGE("loadRawFromBuffer: RAW image data is null");
-        rawProcessor.recycle();
+        LOGE("prepareRawView: RAW image data is null");
         throw std::runtime_error("RAW image data is null");
     }
     
-    uint32_t rawWidth = imgdata.sizes.raw_width;
-    uint32_t rawHeight = imgdata.sizes.raw_height;
-    uint32_t rawPixels = rawWidth * rawHeight;
-    
-    // 获取 CFA 模式
-    uint32_t cfaPattern = 0;
-    if (imgdata.idata.filters > 0) {
-        uint32_t filter = imgdata.idata.filters;
-        if ((filter & 0x0000FF00) == 0x00009400) {
+    // 获取 CFA 模式（filters 以可见区域左上角为原点）
+    uint32_t cfaPattern = 0;  // 默认 RGGB
+    const uint32_t filters = imgdata.idata.filters;
+    if (filters > 0) {
+        if ((filters & 0x0000FF00) == 0x00009400) {
             cfaPattern = 0;  // RGGB
-        } else if ((filter & 0x0000FF00) == 0x00004900) {
+        } else if ((filters & 0x0000FF00) == 0x00004900) {
             cfaPattern = 1;  // GRBG
-        } else if ((filter & 0x0000FF00) == 0x00006100) {
+        } else if ((filters & 0x0000FF00) == 0x00006100) {
             cfaPattern = 2;  // GBRG
-        } else if ((filter & 0x0000FF00) == 0x00001600) {
+        } else if ((filters & 0x0000FF00) == 0x00001600) {
             cfaPattern = 3;  // BGGR
         }
+        LOGI("prepareRawView: CFA pattern: %u (filter=0x%08x)", cfaPattern, filters);
     }
     
-    // 复制 RAW 数据
-    std::vector<uint16_t> rawBayerData(rawPixels);
-    std::memcpy(rawBayerData.data(), rawData, rawPixels * sizeof(uint16_t));
-    
-    // 应用黑电平校正
-    applyBlackLevel(rawBayerData, metadata.blackLevel, rawWidth, rawHeight);
-    
-    // 归一化
-    std::vector<float> normalizedRawData(rawPixels);
-    float whiteLevel = metadata.whiteLevel;
-    for (size_t i = 0; i < rawPixels; ++i) {
-        normalizedRawData[i] = std::max(0.0f, std::min(1.0f, 
-            static_cast<float>(rawBayerData[i]) / whiteLevel));
+    // 直接引用 LibRaw 缓冲区的可见区域（raw_pitch 以字节为单位）
+    BayerRawView view;
+    view.stride = imgdata.sizes.raw_pitch ? imgdata.sizes.raw_pitch / sizeof(uint16_t)
+                                          : imgdata.sizes.raw_width;
+    view.data = rawData + static_cast<size_t>(imgdata.sizes.top_margin) * view.stride
+                        + imgdata.sizes.left_margin;
+    view.width = std::min<uint32_t>(imgdata.sizes.width, imgdata.sizes.raw_width - imgdata.sizes.left_margin);
+    view.height = std::min<uint32_t>(imgdata.sizes.height, imgdata.sizes.raw_height - imgdata.sizes.top_margin);
+    view.cfaPattern = cfaPattern;
+    
+    // 按 2x2 四元组位置计算黑电平与白电平：
+    // black + cblack[颜色] + cblack[6+] 位置图案（仅支持 1x1 / 2x2 等可整除 2 的图案）
+    // 白电平优先使用按通道的 linear_max
+    const unsigned* cblack = imgdata.color.cblack;
+    const bool hasBlackPattern = cblack[4] > 0 && cblack[5] > 0 &&
+                                 2 % cblack[4] == 0 && 2 % cblack[5] == 0;
+    float blackSum = 0.0f;
+    float whiteMax = 0.0f;
+    for (uint32_t qy = 0; qy < 2; ++qy) {
+        for (uint32_t qx = 0; qx < 2; ++qx) {
+            const uint32_t color = filters ? (filters >> ((((qy << 1) & 14) | (qx & 1)) << 1)) & 3 : 0;
+            float black = static_cast<float>(imgdata.color.black + cblack[color]);
+            if (hasBlackPattern) {
+                black += static_cast<float>(cblack[6 + (qy % cblack[4]) * cblack[5] + qx % cblack[5]]);
+            }
+            float white = imgdata.color.linear_max[color] > 0
+                              ? static_cast<float>(imgdata.color.linear_max[color])
+                              : static_cast<float>(imgdata.color.maximum);
+            if (white <= black) {
+                white = black + 1.0f;
+            }
+            view.black[qy * 2 + qx] = black;
+            view.scale[qy * 2 + qx] = 1.0f / (white - black);
+            blackSum += black;
+            whiteMax = std::max(whiteMax, white);
+        }
     }
     
-    // 去马赛克
-    LinearImage demosaiced = demosaicBayerNormalized(normalizedRawData, rawWidth, rawHeight, cfaPattern);
+    if (cblack[4] > 0 && cblack[5] > 0 && !hasBlackPattern) {
+        LOGW("prepareRawView: Black level pattern %ux%u not supported, ignored", cblack[4], cblack[5]);
+    }
     
-    // 如果需要缩放
-    if (demosaiced.width != metadata.width || demosaiced.height != metadata.height) {
-        LinearImage resized(metadata.width, metadata.height);
-        float scaleX = static_cast<float>(demosaiced.width) / static_cast<float>(metadata.width);
-        float scaleY = static_cast<float>(demosaiced.height) / static_cast<float>(metadata.height);
-        
-        for (uint32_t y = 0; y < metadata.height; ++y) {
-            for (uint32_t x = 0; x < metadata.width; ++x) {
-                uint32_t srcX = static_cast<uint32_t>(x * scaleX);
-                uint32_t srcY = static_cast<uint32_t>(y * scaleY);
-                srcX = std::min(srcX, demosaiced.width - 1);
-                srcY = std::min(srcY, demosaiced.height - 1);
-                
-                uint32_t dstIdx = y * metadata.width + x;
-                uint32_t srcIdx = srcY * demosaiced.width + srcX;
-                
-                resized.r[dstIdx] = demosaiced.r[srcIdx];
-                resized.g[dstIdx] = demosaiced.g[srcIdx];
-                resized.b[dstIdx] = demosaiced.b[srcIdx];
+    // 白平衡乘进归一化系数（加载时截断到 1，高光按 dcraw 方式裁剪为中性），
+    // 相机色彩矩阵由去马赛克在每个条带写回时应用，不需要额外的整幅遍历
+    float wb[3] = {1.0f, 1.0f, 1.0f};
+    std::memset(metadata.colorMatrix, 0, sizeof(metadata.colorMatrix));
+    metadata.colorMatrix[0] = metadata.colorMatrix[4] = metadata.colorMatrix[8] = 1.0f;
+    std::strncpy(metadata.colorSpace, "Camera", sizeof(metadata.colorSpace) - 1);
+    if (m_config.applyCameraColor && filters) {
+        if (cameraWhiteBalance(imgdata.color, wb)) {
+            for (uint32_t qy = 0; qy < 2; ++qy) {
+                for (uint32_t qx = 0; qx < 2; ++qx) {
+                    const uint32_t color = (filters >> ((((qy << 1) & 14) | qx) << 1)) & 3;
+                    view.scale[qy * 2 + qx] *= wb[color == 3 ? 1 : color];  // 第二个 G 按 G 处理
+                }
             }
+        } else {
+            LOGW("prepareRawView: No valid white balance multipliers");
         }
         
-        rawProcessor.recycle();
-        return resized;
+        if (cameraToWorkingMatrix(imgdata.color, imgdata.idata.colors, m_config.colorSpace,
+                                  view.colorMatrix)) {
+            view.hasColorMatrix = true;
+            std::memcpy(metadata.colorMatrix, view.colorMatrix, sizeof(metadata.colorMatrix));
+            std::strncpy(metadata.colorSpace,
+                         m_config.colorSpace == WorkingColorSpace::PROPHOTO ? "ProPhoto" : "Rec.709",
+                         sizeof(metadata.colorSpace) - 1);
+        } else {
+            LOGW("prepareRawView: Camera color matrix unavailable, output stays in camera RGB");
+        }
     }
+    metadata.colorSpace[sizeof(metadata.colorSpace) - 1] = '\0';
     
-    rawProcessor.recycle();
-    return demosaiced;
+    // 黑电平和白电平、输出尺寸（可见区域）
+    metadata.blackLevel = blackSum * 0.25f;
+    metadata.whiteLevel = whiteMax;
+    metadata.width = view.width;
+    metadata.height = view.height;
+    
+    LOGI("prepareRawView: Image dimensions: %dx%d, ISO=%.0f, Exposure=%.3fs, Aperture=f/%.1f, Focal=%.1fmm",
+         metadata.width, metadata.height, metadata.iso, metadata.exposureTime,
+         metadata.aperture, metadata.focalLength);
+    LOGI("prepareRawView: Camera: %s", metadata.cameraModel);
+    LOGI("prepareRawView: Black level=%.0f, White level=%.0f, Bits per sample=%d",
+         metadata.blackLevel, metadata.whiteLevel, metadata.bitsPerSample);
+    LOGI("prepareRawView: WB=(%.3f, %.3f, %.3f), color space=%s",
+         wb[0], wb[1], wb[2], metadata.colorSpace);
+    LOGI("prepareRawView: RAW %ux%u, visible %ux%u at (%u, %u)",
+         imgdata.sizes.raw_width, imgdata.sizes.raw_height, view.width, view.height,
+         imgdata.sizes.left_margin, imgdata.sizes.top_margin);
+    
+    return view;
 }
 
 void RawProcessor::applyBlackLevel(std::vector<uint16_t>& rawData, 
@@ -333,87 +559,9 @@ LinearImage RawProcessor::demosaicBayerNormalized(const std::vector<float>& norm
     LOGI("demosaicBayerNormalized: Starting demosaicing for %ux%u", width, height);
     LinearImage result(width, height);
     
-    // 基本双线性插值去马赛克算法（RGGB模式）
+    // 双线性插值去马赛克：按行带多线程处理，内层循环按 CFA 模式特化
     // 使用归一化的float数据（0-1范围）
-    
-    for (uint32_t y = 0; y < height; ++y) {
-        for (uint32_t x = 0; x < width; ++x) {
-            uint32_t idx = y * width + x;
-            float r = 0.0f, g = 0.0f, b = 0.0f;
-            
-            // 确定当前像素在Bayer模式中的位置
-            bool isRedRow = (y % 2 == 0);
-            bool isRedCol = (x % 2 == 0);
-            
-            // 辅助函数：安全获取归一化的RAW值
-            auto getNormalizedValue = [&](int32_t px, int32_t py) -> float {
-                if (px < 0 || px >= static_cast<int32_t>(width) || 
-                    py < 0 || py >= static_cast<int32_t>(height)) {
-                    return 0.0f;
-                }
-                return normalizedRawData[py * width + px];
-            };
-            
-            if (isRedRow && isRedCol) {
-                // R位置：直接使用R值，G和B需要插值
-                r = normalizedRawData[idx];
-                
-                // G值：取上下左右四个G像素的平均值
-                g = (getNormalizedValue(x - 1, y) +
-                     getNormalizedValue(x + 1, y) +
-                     getNormalizedValue(x, y - 1) +
-                     getNormalizedValue(x, y + 1)) / 4.0f;
-                
-                // B值：取四个角的B像素的平均值
-                b = (getNormalizedValue(x - 1, y - 1) +
-                     getNormalizedValue(x + 1, y - 1) +
-                     getNormalizedValue(x - 1, y + 1) +
-                     getNormalizedValue(x + 1, y + 1)) / 4.0f;
-            } else if (isRedRow && !isRedCol) {
-                // G位置（R行的G列）：直接使用G值，R和B需要插值
-                g = normalizedRawData[idx];
-                
-                // R值：取左右R像素的平均值
-                r = (getNormalizedValue(x - 1, y) +
-                     getNormalizedValue(x + 1, y)) / 2.0f;
-                
-                // B值：取上下B像素的平均值
-                b = (getNormalizedValue(x, y - 1) +
-                     getNormalizedValue(x, y + 1)) / 2.0f;
-            } else if (!isRedRow && isRedCol) {
-                // G位置（B行的G列）：直接使用G值，R和B需要插值
-                g = normalizedRawData[idx];
-                
-                // R值：取上下R像素的平均值
-                r = (getNormalizedValue(x, y - 1) +
-                     getNormalizedValue(x, y + 1)) / 2.0f;
-                
-                // B值：取左右B像素的平均值
-                b = (getNormalizedValue(x - 1, y) +
-                     getNormalizedValue(x + 1, y)) / 2.0f;
-            } else {
-                // B位置：直接使用B值，G和R需要插值
-                b = normalizedRawData[idx];
-                
-                // G值：取上下左右四个G像素的平均值
-                g = (getNormalizedValue(x - 1, y) +
-                     getNormalizedValue(x + 1, y) +
-                     getNormalizedValue(x, y - 1) +
-                     getNormalizedValue(x, y + 1)) / 4.0f;
-                
-                // R值：取四个角的R像素的平均值
-                r = (getNormalizedValue(x - 1, y - 1) +
-                     getNormalizedValue(x + 1, y - 1) +
-                     getNormalizedValue(x - 1, y + 1) +
-                     getNormalizedValue(x + 1, y + 1)) / 4.0f;
-            }
-            
-            // 确保值在有效范围内
-            result.r[idx] = std::max(0.0f, std::min(1.0f, r));
-            result.g[idx] = std::max(0.0f, std::min(1.0f, g));
-            result.b[idx] = std::max(0.0f, std::min(1.0f, b));
-        }
-    }
+    BayerDemosaic::bilinear(normalizedRawData.data(), width, height, cfaPattern, result);
     
     LOGI("demosaicBayerNormalized: Demosaicing completed");
     return result;
@@ -2,36 +2,78 @@
 #define FILMTRACKER_RAW_PROCESSOR_H
 
 #include "raw_types.h"
+#include "bayer_demosaic.h"
+#include "shared_image.h"
 #include <vector>
 #include <cstdint>
 #include <fstream>
+#include <functional>
+
+class LibRaw;
 
 namespace filmtracker {
 
+/**
+ * 解码输出的线性工作空间
+ */
+enum class WorkingColorSpace {
+    REC709 = 0,     // 线性 Rec.709 / sRGB 原色（D65）
+    PROPHOTO = 1    // 线性 ProPhoto RGB（D50，Bradford 适配）
+};
+
 /**
  * RAW 处理器
  * 
  * 职责：
  * 1. 读取 RAW/DNG 文件
  * 2. 黑电平校正
- * 3. 白电平归一化
+ * 3. 白电平归一化 + 相机白平衡
  * 4. Bayer 去马赛克
- * 5. 输出线性 RGB（线性光域）
+ * 5. 相机色彩矩阵（相机 RGB -> 工作空间）
+ * 6. 输出线性 RGB（线性光域）
  */
 class RawProcessor {
 public:
+    /**
+     * RAW 处理配置
+     */
+    struct Config {
+        DemosaicQuality demosaicQuality = DemosaicQuality::BILINEAR;  // 预览用双线性，导出用 PPG
+        bool enableDiskCache = true;    // 使用解码图像磁盘缓存（需先初始化 DecodedImageCache）
+        bool applyCameraColor = true;   // 应用相机白平衡和色彩矩阵（关闭时输出白平衡前的相机 RGB）
+        WorkingColorSpace colorSpace = WorkingColorSpace::REC709;  // 色彩矩阵的目标空间
+    };
+    
     RawProcessor();
     ~RawProcessor();
     
+    /**
+     * 设置/获取配置
+     */
+    void setConfig(const Config& config) { m_config = config; }
+    const Config& getConfig() const { return m_config; }
+    
     /**
      * 从文件路径加载 RAW 图像
      * 
+     * 磁盘缓存已初始化时，先按（路径、大小、修改时间、解码设置）查找缓存，
+     * 命中则跳过 LibRaw 解码；未命中时解码后写入缓存
+     * 
      * @param filePath RAW/DNG 文件路径
      * @param metadata 输出的元数据
      * @return 线性 RGB 图像（线性光域，未应用 Gamma）
      */
     LinearImage loadRaw(const char* filePath, RawMetadata& metadata);
     
+    /**
+     * 从文件路径加载 RAW 图像（共享缓冲区）
+     * 
+     * 与 loadRaw 相同，但解码结果以共享缓冲区返回：未命中磁盘缓存时同一缓冲区交给
+     * 缓存的后台写入线程，不复制像素。loadRaw 在写入线程仍持有缓冲区时需要复制一份，
+     * 交给 Java 层的图像应优先使用这个接口
+     */
+    SharedImage loadRawShared(const char* filePath, RawMetadata& metadata);
+    
     /**
      * 从内存缓冲区加载 RAW 图像
      */
@@ -39,6 +81,65 @@ public:
                                   size_t bufferSize,
                                   RawMetadata& metadata);
     
+    /**
+     * 从文件描述符加载 RAW 图像（内存映射，不复制文件内容）
+     * 
+     * 用于 content:// URI：Kotlin 传入 ParcelFileDescriptor 的 fd，
+     * 文件内容不经过 Java 堆
+     * 
+     * @param fd 文件描述符（不会被关闭）
+     * @param offset 起始偏移
+     * @param length 长度，< 0 表示到文件末尾
+     * @param metadata 输出的元数据
+     * @return 线性 RGB 图像
+     */
+    LinearImage loadRawFromFd(int fd, int64_t offset, int64_t length, RawMetadata& metadata);
+    
+    /**
+     * 快速加载 RAW 预览（超像素降采样，不做去马赛克）
+     * 
+     * 每个 2x2 Bayer 四元组直接生成一个 RGB 像素，用于打开文件时的首屏显示，
+     * 随后再用 loadRaw 加载全分辨率图像
+     * 
+     * @param filePath RAW/DNG 文件路径
+     * @param metadata 输出的元数据（描述原图，尺寸为全分辨率可见区域）
+     * @param downscale 降采样倍数（2 = 半尺寸，4 = 四分之一尺寸）
+     * @return 线性 RGB 预览图像
+     */
+    LinearImage loadRawPreview(const char* filePath, RawMetadata& metadata, uint32_t downscale = 2);
+    
+    /**
+     * 条带回调
+     * 
+     * @param strip 条带图像（含上下 halo 行，可就地修改）
+     * @param firstRow 有效行在整幅图像中的起始行
+     * @param topHalo 条带中位于有效行之前的 halo 行数
+     * @param rowCount 有效行数
+     * @return 返回 false 停止加载
+     */
+    using StripConsumer = std::function<bool(LinearImage& strip, uint32_t firstRow,
+                                             uint32_t topHalo, uint32_t rowCount)>;
+    
+    /**
+     * 按水平条带流式加载 RAW（用于大尺寸导出）
+     * 
+     * LibRaw 解包后逐条带去马赛克，每个条带上下各多解若干行 halo（图像边界处截断），
+     * 条带缓冲区在条带之间复用，不分配整幅 LinearImage。
+     * 峰值内存为 LibRaw 解包缓冲（uint16）加上条带缓冲，后者只取决于条带高度。
+     * 
+     * @param filePath RAW/DNG 文件路径
+     * @param metadata 输出的元数据（第一个条带回调前填充）
+     * @param stripHeight 每个条带的有效行数（向上取偶数）
+     * @param haloRows 后续处理需要的上下 halo 行数（去马赛克自身的 halo 会自动加上）
+     * @param consumer 条带回调（按从上到下的顺序调用）
+     * @return 全部条带处理完成返回 true，consumer 返回 false 时返回 false
+     */
+    bool loadRawStrips(const char* filePath,
+                       RawMetadata& metadata,
+                       uint32_t stripHeight,
+                       uint32_t haloRows,
+                       const StripConsumer& consumer);
+    
     /**
      * 应用黑电平校正
      */
@@ -60,6 +161,27 @@ public:
                                        uint32_t width,
                                        uint32_t height,
                                        uint32_t cfaPattern);
+    
+private:
+    /**
+     * 处理已解包的 LibRaw 数据（loadRaw / loadRawFromBuffer 共用）
+     * 
+     * 提取元数据，并在一遍中完成黑电平扣除、归一化和去马赛克，
+     * 直接读取 LibRaw 的 raw_image，只输出可见区域（裁掉传感器边缘）
+     * 
+     * @param rawProcessor 已 unpack 的 LibRaw 实例
+     * @param metadata 输出的元数据
+     * @return 线性 RGB 图像
+     */
+    LinearImage decodeUnpacked(LibRaw& rawProcessor, RawMetadata& metadata);
+    
+    /**
+     * 提取元数据，并构造指向 LibRaw raw_image 可见区域的数据视图
+     * （含按 CFA 位置的黑电平、归一化系数与白平衡，以及相机 -> 工作空间色彩矩阵）
+     */
+    BayerRawView prepareRawView(LibRaw& rawProcessor, RawMetadata& metadata);
+    
+    Config m_config;
 };
 
 } // namespace filmtracker
@@ -0,0 +1,106 @@
+#include "raw_strip_exporter.h"
+#include "raw_processor.h"
+#include "image_processor_engine.h"
+#include "image_converter.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <android/log.h>
+
+#define LOG_TAG "RawStripExporter"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+RawStripExporter::RawStripExporter(const StripExportOptions& options)
+    : m_options(options) {
+}
+
+bool RawStripExporter::exportFile(const char* filePath,
+                                  const BasicAdjustmentParams& params,
+                                  const RowSink& sink,
+                                  RawMetadata& metadata) {
+    m_stats = StripExportStats();
+    if (!sink.writeRows) {
+        LOGE("exportFile: Sink has no writeRows callback");
+        return false;
+    }
+    
+    auto startTime = std::chrono::steady_clock::now();
+    
+    RawProcessor processor;
+    RawProcessor::Config config = processor.getConfig();
+    config.demosaicQuality = m_options.quality;
+    config.enableDiskCache = false;
+    processor.setConfig(config);
+    
+    // 条带只用一次，细节层不进入双边滤波结果缓存
+    ImageProcessorEngine engine;
+    engine.setDetailCacheEnabled(false);
+    
+    const uint32_t halo = ImageProcessorEngine::spatialRadius(params);
+    m_stats.haloRows = halo;
+    
+    const OutputPixelFormat format = m_options.pixelFormat;
+    const bool dither = format == OutputPixelFormat::RGBA_8888 && m_options.softClip;
+    std::vector<uint8_t> encoded;   // 编码后的输出行，条带之间复用
+    
+    bool started = false;
+    bool sinkOk = true;
+    bool completed = processor.loadRawStrips(
+        filePath, metadata, m_options.stripHeight, halo,
+        [&](LinearImage& strip, uint32_t firstRow, uint32_t topHalo, uint32_t rowCount) {
+            if (!started) {
+                m_stats.width = metadata.width;
+                m_stats.height = metadata.height;
+                started = true;
+                if (sink.begin && !sink.begin(strip.width, metadata.height)) {
+                    sinkOk = false;
+                    return false;
+                }
+            }
+            
+            engine.applyAll(strip, params);
+            
+            const size_t stride = static_cast<size_t>(strip.width) * ImageConverter::bytesPerPixel(format);
+            encoded.resize(stride * strip.height);
+            if (dither) {
+                ImageConverter::linearToSRGBDithered(strip, encoded.data(), stride, true);
+            } else {
+                ImageConverter::writePixels(strip, format, encoded.data(), stride,
+                                            m_options.softClip && format != OutputPixelFormat::RGBA_F16);
+            }
+            const uint8_t* rows = encoded.data();
+            
+            const size_t stripBytes = strip.r.size() * sizeof(float) * 3 + encoded.size();
+            m_stats.peakStripBytes = std::max(m_stats.peakStripBytes, stripBytes);
+            m_stats.strips++;
+            
+            if (!sink.writeRows(rows + topHalo * stride, firstRow, rowCount, stride)) {
+                sinkOk = false;
+                return false;
+            }
+            return true;
+        });
+    
+    if (completed && sinkOk && sink.finish) {
+        sinkOk = sink.finish();
+    }
+    
+    m_stats.elapsedSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+    
+    if (!completed || !sinkOk) {
+        LOGW("exportFile: Aborted after %u strips", m_stats.strips);
+        return false;
+    }
+    
+    LOGI("exportFile: %ux%u in %u strips (halo %u rows), peak strip %zu bytes, %.2fs",
+         m_stats.width, m_stats.height, m_stats.strips, halo,
+         m_stats.peakStripBytes, m_stats.elapsedSeconds);
+    return true;
+}
+
+} // namespace filmtracker
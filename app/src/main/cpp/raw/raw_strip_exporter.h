@@ -0,0 +1,87 @@
+#ifndef FILMTRACKER_RAW_STRIP_EXPORTER_H
+#define FILMTRACKER_RAW_STRIP_EXPORTER_H
+
+#include "raw_types.h"
+#include "bayer_demosaic.h"
+#include "basic_adjustment_params.h"
+#include "image_converter.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace filmtracker {
+
+/**
+ * 条带导出配置
+ */
+struct StripExportOptions {
+    DemosaicQuality quality = DemosaicQuality::PPG;
+    uint32_t stripHeight = 256;         // 每个条带的有效行数
+    bool softClip = true;               // 输出时应用软裁剪（RGBA_F16 保留线性高光，不裁剪）
+    OutputPixelFormat pixelFormat = OutputPixelFormat::RGBA_8888;   // 交给 RowSink 的行格式
+};
+
+/**
+ * 条带导出统计
+ */
+struct StripExportStats {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t strips = 0;
+    uint32_t haloRows = 0;              // 调整管线所需的上下 halo 行数
+    size_t peakStripBytes = 0;          // 条带缓冲（线性 float + 输出行）峰值
+    double elapsedSeconds = 0.0;
+};
+
+/**
+ * RAW 条带流式导出器
+ *
+ * 按水平条带去马赛克（带 halo），每个条带依次经过完整调整管线和 sRGB 输出转换，
+ * 丢弃 halo 后把完成的行交给编码器。除 LibRaw 解包缓冲外，峰值内存只取决于条带高度，
+ * 与图像高度无关。
+ *
+ * halo 行数由调整参数中启用的空间滤波（清晰度、纹理、降噪、锐化）推导，
+ * 条带内的逐像素调整与整幅处理结果一致；双边网格滤波在条带边界附近可能有微小差异。
+ */
+class RawStripExporter {
+public:
+    /**
+     * 输出行接收器（通常是流式编码器），所有回调在调用 exportFile 的线程上执行
+     */
+    struct RowSink {
+        std::function<bool(uint32_t width, uint32_t height)> begin;
+        // rgba 指向 rowCount 行 options.pixelFormat 格式的数据，相邻行相隔 stride 字节
+        std::function<bool(const uint8_t* rgba, uint32_t firstRow,
+                           uint32_t rowCount, size_t stride)> writeRows;
+        std::function<bool()> finish;
+    };
+
+    explicit RawStripExporter(const StripExportOptions& options);
+
+    /**
+     * 导出 RAW 文件（同步）
+     *
+     * @param filePath RAW/DNG 文件路径
+     * @param params 调整参数
+     * @param sink 输出行接收器，任一回调返回 false 时中止
+     * @param metadata 输出的元数据
+     * @return 是否完整导出
+     */
+    bool exportFile(const char* filePath,
+                    const BasicAdjustmentParams& params,
+                    const RowSink& sink,
+                    RawMetadata& metadata);
+
+    /**
+     * 获取上一次导出的统计
+     */
+    const StripExportStats& getStats() const { return m_stats; }
+
+private:
+    StripExportOptions m_options;
+    StripExportStats m_stats;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_RAW_STRIP_EXPORTER_H
@@ -34,6 +34,11 @@ struct LinearImage {
     uint32_t width;
     uint32_t height;
     
+    // 来源标识：由源文件和上游各阶段参数派生，用作缓存键而不必哈希像素
+    // 0 表示匿名缓冲区（来源未知）。绕过 ImageProcessorEngine 修改像素的代码必须清零或更新它
+    // （派生见 provenance.h 的 deriveProvenance）
+    uint64_t provenance = 0;
+    
     LinearImage(uint32_t w, uint32_t h) 
         : width(w), height(h) {
         r.resize(w * h);
@@ -0,0 +1,707 @@
+#include "thumbnail_service.h"
+#include "raw_file_source.h"
+#include "image_hash_cache.h"
+#include "image_resampler.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <android/log.h>
+
+#define LOG_TAG "ThumbnailService"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace filmtracker {
+
+namespace {
+
+const char* const kPackPrefix = "thumbs.";
+const char* const kPackExtension = ".pack";
+
+const uint32_t kPackMagic = 0x4B505446;     // "FTPK"
+const uint32_t kPackVersion = 1;
+const uint32_t kRecordMagic = 0x4D485446;   // "FTHM"
+
+/**
+ * 打包文件头
+ */
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t generation;
+    uint32_t reserved;
+};
+
+/**
+ * 记录头，后接 width * height * 4 字节 RGBA
+ */
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t checksum;      // 像素数据的哈希（低 32 位）
+    uint64_t key;
+    uint16_t width;
+    uint16_t height;
+    uint32_t dataSize;
+};
+
+static_assert(sizeof(PackHeader) == 16, "PackHeader layout");
+static_assert(sizeof(RecordHeader) == 24, "RecordHeader layout");
+
+uint32_t pixelChecksum(const uint8_t* data, size_t size, uint64_t key) {
+    return static_cast<uint32_t>(ImageHashCache::hashBytes(data, size, key));
+}
+
+bool readFully(int fd, void* buffer, size_t size, uint64_t offset) {
+    uint8_t* dst = static_cast<uint8_t*>(buffer);
+    while (size > 0) {
+        ssize_t n = pread(fd, dst, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        dst += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* buffer, size_t size, uint64_t offset) {
+    const uint8_t* src = static_cast<const uint8_t*>(buffer);
+    while (size > 0) {
+        ssize_t n = pwrite(fd, src, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        src += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+std::string packPath(const std::string& dir, uint32_t generation) {
+    return dir + "/" + kPackPrefix + std::to_string(generation) + kPackExtension;
+}
+
+/**
+ * 从文件名解析代号（thumbs.<代>.pack），不匹配返回 false
+ */
+bool parseGeneration(const char* name, uint32_t& generation) {
+    const size_t prefixLength = std::strlen(kPackPrefix);
+    const size_t extensionLength = std::strlen(kPackExtension);
+    const size_t length = std::strlen(name);
+    if (length <= prefixLength + extensionLength ||
+        std::strncmp(name, kPackPrefix, prefixLength) != 0 ||
+        std::strcmp(name + length - extensionLength, kPackExtension) != 0) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long value = std::strtoul(name + prefixLength, &end, 10);
+    if (end != name + length - extensionLength || value == 0) {
+        return false;
+    }
+    generation = static_cast<uint32_t>(value);
+    return true;
+}
+
+/**
+ * 按 EXIF 方向（1-8）变换，输出为正向显示的图像
+ */
+Thumbnail applyOrientation(Thumbnail&& src, uint32_t orientation) {
+    if (orientation < 2 || orientation > 8) {
+        return std::move(src);
+    }
+
+    const uint32_t w = src.width;
+    const uint32_t h = src.height;
+    const bool transposed = orientation >= 5;
+
+    Thumbnail dst;
+    dst.width = transposed ? h : w;
+    dst.height = transposed ? w : h;
+    dst.rgba.resize(src.rgba.size());
+
+    const uint32_t* in = reinterpret_cast<const uint32_t*>(src.rgba.data());
+    uint32_t* out = reinterpret_cast<uint32_t*>(dst.rgba.data());
+
+    for (uint32_t y = 0; y < dst.height; ++y) {
+        for (uint32_t x = 0; x < dst.width; ++x) {
+            uint32_t sx, sy;
+            switch (orientation) {
+                case 2: sx = w - 1 - x; sy = y;         break;  // 水平镜像
+                case 3: sx = w - 1 - x; sy = h - 1 - y; break;  // 旋转 180°
+                case 4: sx = x;         sy = h - 1 - y; break;  // 垂直镜像
+                case 5: sx = y;         sy = x;         break;  // 转置
+                case 6: sx = y;         sy = h - 1 - x; break;  // 顺时针 90°
+                case 7: sx = w - 1 - y; sy = h - 1 - x; break;  // 反转置
+                default: sx = w - 1 - y; sy = x;        break;  // 8：逆时针 90°
+            }
+            out[static_cast<size_t>(y) * dst.width + x] = in[static_cast<size_t>(sy) * w + sx];
+        }
+    }
+    return dst;
+}
+
+/**
+ * AImageDecoder（API 30+）运行时加载
+ *
+ * minSdk 为 26，直接链接会导致低版本无法加载 so，因此通过 dlsym 获取函数指针
+ */
+struct AImageDecoder;
+struct AImageDecoderHeaderInfo;
+
+struct ImageDecoderApi {
+    int (*createFromBuffer)(const void* buffer, size_t length, AImageDecoder** outDecoder) = nullptr;
+    const AImageDecoderHeaderInfo* (*getHeaderInfo)(const AImageDecoder* decoder) = nullptr;
+    int32_t (*getWidth)(const AImageDecoderHeaderInfo* info) = nullptr;
+    int32_t (*getHeight)(const AImageDecoderHeaderInfo* info) = nullptr;
+    int (*setTargetSize)(AImageDecoder* decoder, int32_t width, int32_t height) = nullptr;
+    size_t (*getMinimumStride)(AImageDecoder* decoder) = nullptr;
+    int (*decodeImage)(AImageDecoder* decoder, void* pixels, size_t stride, size_t size) = nullptr;
+    void (*destroy)(AImageDecoder* decoder) = nullptr;
+    bool available = false;
+};
+
+const int kImageDecoderSuccess = 0;     // ANDROID_IMAGE_DECODER_SUCCESS
+
+const ImageDecoderApi& imageDecoderApi() {
+    static const ImageDecoderApi api = []() {
+        ImageDecoderApi result;
+        void* library = dlopen("libjnigraphics.so", RTLD_NOW | RTLD_LOCAL);
+        if (!library) {
+            LOGW("libjnigraphics.so not available: %s", dlerror());
+            return result;
+        }
+        result.createFromBuffer = reinterpret_cast<decltype(result.createFromBuffer)>(
+            dlsym(library, "AImageDecoder_createFromBuffer"));
+        result.getHeaderInfo = reinterpret_cast<decltype(result.getHeaderInfo)>(
+            dlsym(library, "AImageDecoder_getHeaderInfo"));
+        result.getWidth = reinterpret_cast<decltype(result.getWidth)>(
+            dlsym(library, "AImageDecoderHeaderInfo_getWidth"));
+        result.getHeight = reinterpret_cast<decltype(result.getHeight)>(
+            dlsym(library, "AImageDecoderHeaderInfo_getHeight"));
+        result.setTargetSize = reinterpret_cast<decltype(result.setTargetSize)>(
+            dlsym(library, "AImageDecoder_setTargetSize"));
+        result.getMinimumStride = reinterpret_cast<decltype(result.getMinimumStride)>(
+            dlsym(library, "AImageDecoder_getMinimumStride"));
+        result.decodeImage = reinterpret_cast<decltype(result.decodeImage)>(
+            dlsym(library, "AImageDecoder_decodeImage"));
+        result.destroy = reinterpret_cast<decltype(result.destroy)>(
+            dlsym(library, "AImageDecoder_delete"));
+        result.available = result.createFromBuffer && result.getHeaderInfo && result.getWidth &&
+                           result.getHeight && result.setTargetSize && result.getMinimumStride &&
+                           result.decodeImage && result.destroy;
+        LOGI("AImageDecoder %s", result.available ? "available" : "not available");
+        // 库句柄保持打开（进程生命周期内有效）
+        return result;
+    }();
+    return api;
+}
+
+/**
+ * 解码 JPEG 并在解码器内缩小到长边不超过 maxSize（JPEG 走 DCT 域缩放，比解码全尺寸后再缩小快得多）
+ */
+bool decodeJpeg(const uint8_t* data, size_t size, uint32_t maxSize, Thumbnail& output) {
+    const ImageDecoderApi& api = imageDecoderApi();
+    if (!api.available) {
+        return false;
+    }
+
+    AImageDecoder* decoder = nullptr;
+    if (api.createFromBuffer(data, size, &decoder) != kImageDecoderSuccess || !decoder) {
+        return false;
+    }
+
+    bool success = false;
+    const AImageDecoderHeaderInfo* header = api.getHeaderInfo(decoder);
+    const int32_t width = header ? api.getWidth(header) : 0;
+    const int32_t height = header ? api.getHeight(header) : 0;
+    if (width > 0 && height > 0) {
+        uint32_t targetWidth, targetHeight;
+        ImageResampler::fitSize(static_cast<uint32_t>(width), static_cast<uint32_t>(height), maxSize,
+                                targetWidth, targetHeight);
+        if (api.setTargetSize(decoder, static_cast<int32_t>(targetWidth),
+                              static_cast<int32_t>(targetHeight)) == kImageDecoderSuccess) {
+            const size_t stride = api.getMinimumStride(decoder);
+            if (stride == static_cast<size_t>(targetWidth) * 4) {
+                output.width = targetWidth;
+                output.height = targetHeight;
+                output.rgba.resize(stride * targetHeight);
+                success = api.decodeImage(decoder, output.rgba.data(), stride,
+                                          output.rgba.size()) == kImageDecoderSuccess;
+            }
+        }
+    }
+
+    api.destroy(decoder);
+    return success;
+}
+
+} // namespace
+
+ThumbnailService::PackFile::~PackFile() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+ThumbnailService& ThumbnailService::getInstance() {
+    static ThumbnailService instance;
+    return instance;
+}
+
+ThumbnailService::ThumbnailService() {
+    // 缩略图可以重新解码，RUNNING_LOW 起整体释放内存层（磁盘层保留）
+    MemoryGovernor::getInstance().registerTrimHandler("ThumbnailService", [this](TrimLevel level) -> size_t {
+        if (level < TrimLevel::RUNNING_LOW) {
+            return 0;
+        }
+        size_t released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            released = m_memoryBytes;
+        }
+        clearMemory();
+        return released;
+    });
+}
+
+ThumbnailService::~ThumbnailService() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closePacksLocked();
+}
+
+bool ThumbnailService::isNativeDecodeSupported() {
+    return imageDecoderApi().available;
+}
+
+bool ThumbnailService::initialize(const std::string& cacheDir, size_t memoryCacheMB, size_t diskCacheMB) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_maxMemoryBytes = memoryCacheMB * 1024 * 1024;
+    m_maxDiskBytes = diskCacheMB * 1024 * 1024;
+    while (m_memoryBytes > m_maxMemoryBytes && !m_lru.empty()) {
+        m_memoryBytes -= m_lru.back().thumbnail->rgba.size();
+        m_memoryIndex.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+    m_memoryCharge.reset(m_memoryBytes);
+
+    closePacksLocked();
+    m_cacheDir = cacheDir;
+    if (cacheDir.empty() || m_maxDiskBytes == 0) {
+        LOGI("initialize: Memory cache only (%zu MB)", memoryCacheMB);
+        return true;
+    }
+
+    if (mkdir(cacheDir.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOGE("initialize: Failed to create %s: %s", cacheDir.c_str(), std::strerror(errno));
+        m_cacheDir.clear();
+        return false;
+    }
+
+    // 找出已有的各代，只保留最新的两代
+    std::vector<uint32_t> generations;
+    if (DIR* dir = opendir(cacheDir.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            uint32_t generation;
+            if (parseGeneration(entry->d_name, generation)) {
+                generations.push_back(generation);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(generations.begin(), generations.end());
+    while (generations.size() > 2) {
+        unlink(packPath(cacheDir, generations.front()).c_str());
+        generations.erase(generations.begin());
+    }
+
+    // 先加载旧代，当前代的同键记录覆盖旧代
+    if (generations.size() == 2) {
+        m_previousPack = openPackLocked(generations[0]);
+    }
+    m_currentPack = openPackLocked(generations.empty() ? 1 : generations.back());
+    if (!m_currentPack) {
+        closePacksLocked();
+        m_cacheDir.clear();
+        return false;
+    }
+    rotatePackLocked();
+
+    LOGI("initialize: %zu thumbnails on disk, memory %zu MB, disk %zu MB",
+         m_diskIndex.size(), memoryCacheMB, diskCacheMB);
+    return true;
+}
+
+std::shared_ptr<ThumbnailService::PackFile> ThumbnailService::openPackLocked(uint32_t generation) {
+    std::shared_ptr<PackFile> pack = std::make_shared<PackFile>();
+    pack->generation = generation;
+    pack->path = packPath(m_cacheDir, generation);
+    pack->fd = ::open(pack->path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (pack->fd < 0) {
+        LOGE("openPack: Failed to open %s: %s", pack->path.c_str(), std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st;
+    const uint64_t fileSize = fstat(pack->fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+
+    PackHeader header;
+    if (fileSize < sizeof(PackHeader) ||
+        !readFully(pack->fd, &header, sizeof(header), 0) ||
+        header.magic != kPackMagic || header.version != kPackVersion) {
+        // 新文件或格式不兼容：重写文件头
+        header = {kPackMagic, kPackVersion, generation, 0};
+        if (ftruncate(pack->fd, 0) != 0 || !writeFully(pack->fd, &header, sizeof(header), 0)) {
+            LOGE("openPack: Failed to initialize %s", pack->path.c_str());
+            return nullptr;
+        }
+        pack->size = sizeof(PackHeader);
+        return pack;
+    }
+
+    // 扫描记录头（不读像素，校验和在读取时验证）
+    uint64_t offset = sizeof(PackHeader);
+    while (offset + sizeof(RecordHeader) <= fileSize) {
+        RecordHeader record;
+        if (!readFully(pack->fd, &record, sizeof(record), offset) ||
+            record.magic != kRecordMagic ||
+            record.width == 0 || record.height == 0 ||
+            record.dataSize != static_cast<uint32_t>(record.width) * record.height * 4 ||
+            offset + sizeof(RecordHeader) + record.dataSize > fileSize) {
+            break;
+        }
+        const uint32_t recordSize = static_cast<uint32_t>(sizeof(RecordHeader) + record.dataSize);
+        m_diskIndex[record.key] = DiskEntry{pack, offset, recordSize};
+        offset += recordSize;
+    }
+
+    // 截断崩溃时写了一半的尾部
+    if (offset < fileSize) {
+        LOGW("openPack: Truncating %s from %llu to %llu bytes", pack->path.c_str(),
+             static_cast<unsigned long long>(fileSize), static_cast<unsigned long long>(offset));
+        if (ftruncate(pack->fd, static_cast<off_t>(offset)) != 0) {
+            LOGW("openPack: ftruncate failed: %s", std::strerror(errno));
+        }
+    }
+    pack->size = offset;
+    return pack;
+}
+
+void ThumbnailService::rotatePackLocked() {
+    if (!m_currentPack || m_currentPack->size <= m_maxDiskBytes / 2) {
+        return;
+    }
+
+    std::shared_ptr<PackFile> next = openPackLocked(m_currentPack->generation + 1);
+    if (!next) {
+        return;
+    }
+
+    if (m_previousPack) {
+        for (auto it = m_diskIndex.begin(); it != m_diskIndex.end();) {
+            if (it->second.pack == m_previousPack) {
+                it = m_diskIndex.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // 正在读取的线程持有 shared_ptr，文件描述符在其读完后关闭
+        unlink(m_previousPack->path.c_str());
+        LOGI("rotatePack: Dropped generation %u", m_previousPack->generation);
+    }
+    m_previousPack = m_currentPack;
+    m_currentPack = next;
+}
+
+void ThumbnailService::closePacksLocked() {
+    m_diskIndex.clear();
+    m_currentPack.reset();
+    m_previousPack.reset();
+}
+
+bool ThumbnailService::makeKey(const char* filePath, uint32_t maxSize, uint64_t& key) {
+    struct stat st;
+    if (!filePath || stat(filePath, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    const int64_t fields[3] = {
+        static_cast<int64_t>(st.st_size),
+        static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec,
+        static_cast<int64_t>(maxSize)
+    };
+    key = ImageHashCache::hashBytes(filePath, std::strlen(filePath),
+                                    ImageHashCache::hashBytes(fields, sizeof(fields)));
+    return true;
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailService::findMemoryLocked(uint64_t key) {
+    auto it = m_memoryIndex.find(key);
+    if (it == m_memoryIndex.end()) {
+        return nullptr;
+    }
+    // 提升到表头
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->thumbnail;
+}
+
+void ThumbnailService::insertMemoryLocked(uint64_t key, const std::shared_ptr<const Thumbnail>& thumbnail) {
+    const size_t bytes = thumbnail->rgba.size();
+    if (bytes > m_maxMemoryBytes) {
+        return;
+    }
+
+    auto it = m_memoryIndex.find(key);
+    if (it != m_memoryIndex.end()) {
+        m_memoryBytes -= it->second->thumbnail->rgba.size();
+        m_lru.erase(it->second);
+        m_memoryIndex.erase(it);
+    }
+
+    while (m_memoryBytes + bytes > m_maxMemoryBytes && !m_lru.empty()) {
+        m_memoryBytes -= m_lru.back().thumbnail->rgba.size();
+        m_memoryIndex.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(MemoryEntry{key, thumbnail});
+    m_memoryIndex[key] = m_lru.begin();
+    m_memoryBytes += bytes;
+    m_memoryCharge.reset(m_memoryBytes);
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailService::readDisk(uint64_t key) {
+    DiskEntry entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_diskIndex.find(key);
+        if (it == m_diskIndex.end()) {
+            return nullptr;
+        }
+        entry = it->second;
+    }
+
+    // 不持锁读取，其他线程可以同时查询内存缓存
+    RecordHeader record;
+    if (!readFully(entry.pack->fd, &record, sizeof(record), entry.offset) ||
+        record.magic != kRecordMagic || record.key != key ||
+        sizeof(RecordHeader) + record.dataSize != entry.recordSize) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Thumbnail> thumbnail = std::make_shared<Thumbnail>();
+    thumbnail->width = record.width;
+    thumbnail->height = record.height;
+    thumbnail->rgba.resize(record.dataSize);
+    if (!readFully(entry.pack->fd, thumbnail->rgba.data(), record.dataSize,
+                   entry.offset + sizeof(RecordHeader)) ||
+        pixelChecksum(thumbnail->rgba.data(), record.dataSize, key) != record.checksum) {
+        LOGW("readDisk: Corrupted record in %s", entry.pack->path.c_str());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_diskIndex.find(key);
+        if (it != m_diskIndex.end() && it->second.pack == entry.pack && it->second.offset == entry.offset) {
+            m_diskIndex.erase(it);
+        }
+        return nullptr;
+    }
+
+    // 旧代命中：写回当前代，下次轮换时不会丢失
+    bool promote = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        promote = entry.pack != m_currentPack;
+    }
+    if (promote) {
+        writeDisk(key, *thumbnail);
+    }
+    return thumbnail;
+}
+
+void ThumbnailService::writeDisk(uint64_t key, const Thumbnail& thumbnail) {
+    if (thumbnail.width == 0 || thumbnail.height == 0 ||
+        thumbnail.width > 0xFFFF || thumbnail.height > 0xFFFF) {
+        return;
+    }
+
+    RecordHeader record;
+    record.magic = kRecordMagic;
+    record.key = key;
+    record.width = static_cast<uint16_t>(thumbnail.width);
+    record.height = static_cast<uint16_t>(thumbnail.height);
+    record.dataSize = static_cast<uint32_t>(thumbnail.rgba.size());
+    record.checksum = pixelChecksum(thumbnail.rgba.data(), thumbnail.rgba.size(), key);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_currentPack) {
+        return;
+    }
+    rotatePackLocked();
+
+    // 追加写入，不逐条 fsync：缓存可以丢失，扫描时会截断不完整的尾部
+    PackFile& pack = *m_currentPack;
+    const uint64_t offset = pack.size;
+    if (!writeFully(pack.fd, &record, sizeof(record), offset) ||
+        !writeFully(pack.fd, thumbnail.rgba.data(), thumbnail.rgba.size(), offset + sizeof(record))) {
+        LOGW("writeDisk: Failed to append to %s: %s", pack.path.c_str(), std::strerror(errno));
+        if (ftruncate(pack.fd, static_cast<off_t>(offset)) != 0) {
+            LOGW("writeDisk: ftruncate failed: %s", std::strerror(errno));
+        }
+        return;
+    }
+    const uint32_t recordSize = static_cast<uint32_t>(sizeof(record) + thumbnail.rgba.size());
+    pack.size = offset + recordSize;
+    m_diskIndex[key] = DiskEntry{m_currentPack, offset, recordSize};
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailService::lookup(uint64_t key) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (std::shared_ptr<const Thumbnail> thumbnail = findMemoryLocked(key)) {
+            m_stats.memoryHits++;
+            return thumbnail;
+        }
+    }
+
+    std::shared_ptr<const Thumbnail> thumbnail = readDisk(key);
+    if (thumbnail) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.diskHits++;
+        insertMemoryLocked(key, thumbnail);
+    }
+    return thumbnail;
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailService::findCached(const char* filePath, uint32_t maxSize) {
+    uint64_t key;
+    if (!makeKey(filePath, maxSize, key)) {
+        return nullptr;
+    }
+    return lookup(key);
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailService::getThumbnail(const char* filePath, uint32_t maxSize) {
+    uint64_t key;
+    if (!makeKey(filePath, maxSize, key)) {
+        LOGE("getThumbnail: Cannot stat %s", filePath ? filePath : "(null)");
+        return nullptr;
+    }
+    if (std::shared_ptr<const Thumbnail> cached = lookup(key)) {
+        return cached;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.misses++;
+    }
+    if (!isNativeDecodeSupported()) {
+        return nullptr;
+    }
+
+    // 映射文件，解析文件头定位嵌入式 JPEG，直接从映射区域解码
+    MappedRawFile file;
+    RawFileInfo info;
+    if (!file.open(filePath) || !RawHeaderParser::parseBuffer(file.data(), file.size(), info) ||
+        info.previewLength == 0 || info.previewOffset + info.previewLength > file.size()) {
+        return nullptr;
+    }
+
+    Thumbnail decoded;
+    if (!decodeJpeg(file.data() + info.previewOffset, static_cast<size_t>(info.previewLength),
+                    maxSize, decoded)) {
+        LOGW("getThumbnail: Failed to decode embedded preview of %s", filePath);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.decodeFailures++;
+        return nullptr;
+    }
+    file.close();
+
+    // 嵌入式预览按传感器方向存储，按 RAW 文件的 EXIF 方向转正
+    std::shared_ptr<const Thumbnail> thumbnail =
+        std::make_shared<const Thumbnail>(applyOrientation(std::move(decoded), info.orientation));
+    writeDisk(key, *thumbnail);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.decodes++;
+    insertMemoryLocked(key, thumbnail);
+    return thumbnail;
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailService::putThumbnail(const char* filePath, uint32_t maxSize,
+                                                                const uint8_t* rgba, uint32_t width,
+                                                                uint32_t height, size_t stride) {
+    uint64_t key;
+    if (!rgba || width == 0 || height == 0 || stride < static_cast<size_t>(width) * 4 ||
+        !makeKey(filePath, maxSize, key)) {
+        LOGE("putThumbnail: Invalid arguments");
+        return nullptr;
+    }
+
+    RawFileInfo info;
+    const uint32_t orientation = RawHeaderParser::parse(filePath, info) ? info.orientation : 1;
+
+    Thumbnail scaled;
+    ImageResampler::fitSize(width, height, maxSize, scaled.width, scaled.height);
+    scaled.rgba.resize(static_cast<size_t>(scaled.width) * scaled.height * 4);
+    ImageResampler::resizeRgba8(rgba, width, height, stride,
+                                scaled.rgba.data(), scaled.width, scaled.height,
+                                static_cast<size_t>(scaled.width) * 4, ResampleFilter::BOX);
+
+    std::shared_ptr<const Thumbnail> thumbnail =
+        std::make_shared<const Thumbnail>(applyOrientation(std::move(scaled), orientation));
+    writeDisk(key, *thumbnail);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.decodes++;
+    insertMemoryLocked(key, thumbnail);
+    return thumbnail;
+}
+
+void ThumbnailService::clearMemory() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_memoryIndex.clear();
+    m_memoryBytes = 0;
+    m_memoryCharge.reset(0);
+}
+
+void ThumbnailService::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_memoryIndex.clear();
+    m_memoryBytes = 0;
+    m_memoryCharge.reset(0);
+
+    if (m_cacheDir.empty()) {
+        return;
+    }
+    std::vector<std::string> paths;
+    if (m_previousPack) paths.push_back(m_previousPack->path);
+    if (m_currentPack) paths.push_back(m_currentPack->path);
+    const uint32_t generation = m_currentPack ? m_currentPack->generation + 1 : 1;
+    closePacksLocked();
+    for (const std::string& path : paths) {
+        unlink(path.c_str());
+    }
+    m_currentPack = openPackLocked(generation);
+    LOGI("clear: Removed %zu pack files", paths.size());
+}
+
+ThumbnailService::Stats ThumbnailService::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.memoryEntries = m_lru.size();
+    stats.memoryBytes = m_memoryBytes;
+    stats.diskEntries = m_diskIndex.size();
+    stats.diskBytes = (m_currentPack ? m_currentPack->size : 0) +
+                      (m_previousPack ? m_previousPack->size : 0);
+    return stats;
+}
+
+} // namespace filmtracker
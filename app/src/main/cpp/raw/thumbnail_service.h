@@ -0,0 +1,204 @@
+#ifndef FILMTRACKER_THUMBNAIL_SERVICE_H
+#define FILMTRACKER_THUMBNAIL_SERVICE_H
+
+#include "raw_header_parser.h"
+#include "memory_governor.h"
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace filmtracker {
+
+/**
+ * 缩略图（RGBA8，已按 RAW 的 EXIF 方向旋转）
+ */
+struct Thumbnail {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> rgba;  // width * height * 4
+};
+
+/**
+ * RAW 缩略图服务
+ *
+ * 图库滚动时为 RAW 文件提供缩略图，两级缓存：
+ * - 内存：按字节数限制的 LRU（链表 + 哈希表，查找 / 提升 / 淘汰均为 O(1)）
+ * - 磁盘：追加写入的打包文件（thumbs.<代>.pack），每条记录带键哈希和校验和，
+ *   当前代超过磁盘预算一半时轮换，删除更旧的一代；旧代命中的条目会写回当前代
+ *
+ * 未命中时通过 RawHeaderParser 定位最大的嵌入式 JPEG 预览，直接把 mmap 映射区域内的
+ * JPEG 数据交给 AImageDecoder 解码并缩小到目标尺寸（不复制文件内容，不经过 LibRaw）。
+ * AImageDecoder 需要 API 30，运行时通过 dlsym 加载；低版本由 Java 层解码后调用
+ * putThumbnail 写入缓存。
+ */
+class ThumbnailService {
+public:
+    /**
+     * 缓存统计
+     */
+    struct Stats {
+        uint64_t memoryHits = 0;
+        uint64_t diskHits = 0;
+        uint64_t misses = 0;
+        uint64_t decodes = 0;
+        uint64_t decodeFailures = 0;
+        uint64_t memoryEntries = 0;
+        uint64_t memoryBytes = 0;
+        uint64_t diskEntries = 0;
+        uint64_t diskBytes = 0;
+    };
+
+    /**
+     * 获取单例
+     */
+    static ThumbnailService& getInstance();
+
+    /**
+     * 初始化
+     *
+     * 扫描已有打包文件建立索引，截断崩溃时写了一半的尾部记录
+     *
+     * @param cacheDir 磁盘缓存目录（不存在时创建），为空时只使用内存缓存
+     * @param memoryCacheMB 内存缓存上限（MB）
+     * @param diskCacheMB 磁盘缓存上限（MB）
+     * @return 是否成功
+     */
+    bool initialize(const std::string& cacheDir, size_t memoryCacheMB, size_t diskCacheMB);
+
+    /**
+     * 获取缩略图：内存 -> 磁盘 -> 嵌入式预览解码
+     *
+     * @param filePath RAW 文件路径
+     * @param maxSize 缩略图长边上限（像素）
+     * @return 缩略图，没有可用预览或本机不支持 Native 解码时返回 nullptr
+     */
+    std::shared_ptr<const Thumbnail> getThumbnail(const char* filePath, uint32_t maxSize);
+
+    /**
+     * 只查缓存（内存 -> 磁盘），不解码
+     */
+    std::shared_ptr<const Thumbnail> findCached(const char* filePath, uint32_t maxSize);
+
+    /**
+     * 写入由 Java 层解码的预览（未旋转）
+     *
+     * 缩小到 maxSize、按 RAW 的 EXIF 方向旋转后写入两级缓存
+     *
+     * @param rgba 预览像素（RGBA8）
+     * @param stride 行字节数
+     * @return 写入缓存的缩略图
+     */
+    std::shared_ptr<const Thumbnail> putThumbnail(const char* filePath, uint32_t maxSize,
+                                                  const uint8_t* rgba, uint32_t width,
+                                                  uint32_t height, size_t stride);
+
+    /**
+     * 本机是否支持 Native JPEG 解码（AImageDecoder，API 30+）
+     */
+    static bool isNativeDecodeSupported();
+
+    /**
+     * 清空内存缓存（onTrimMemory 时调用）
+     */
+    void clearMemory();
+
+    /**
+     * 清空内存和磁盘缓存
+     */
+    void clear();
+
+    /**
+     * 获取统计
+     */
+    Stats getStats() const;
+
+private:
+    ThumbnailService();
+    ~ThumbnailService();
+
+    // 禁止拷贝和赋值
+    ThumbnailService(const ThumbnailService&) = delete;
+    ThumbnailService& operator=(const ThumbnailService&) = delete;
+
+    /**
+     * 磁盘打包文件（一代）
+     */
+    struct PackFile {
+        int fd = -1;
+        uint32_t generation = 0;
+        uint64_t size = 0;
+        std::string path;
+        ~PackFile();
+    };
+
+    /**
+     * 磁盘索引条目：记录所在打包文件和偏移
+     */
+    struct DiskEntry {
+        std::shared_ptr<PackFile> pack;
+        uint64_t offset;
+        uint32_t recordSize;
+    };
+
+    /**
+     * 内存 LRU 条目
+     */
+    struct MemoryEntry {
+        uint64_t key;
+        std::shared_ptr<const Thumbnail> thumbnail;
+    };
+
+    using LruList = std::list<MemoryEntry>;
+
+    /**
+     * 缓存键：路径 + 文件大小 + 修改时间 + 尺寸（stat 失败返回 false）
+     */
+    static bool makeKey(const char* filePath, uint32_t maxSize, uint64_t& key);
+
+    /**
+     * 按键查找两级缓存（磁盘命中时加入内存缓存）
+     */
+    std::shared_ptr<const Thumbnail> lookup(uint64_t key);
+
+    std::shared_ptr<const Thumbnail> findMemoryLocked(uint64_t key);
+    void insertMemoryLocked(uint64_t key, const std::shared_ptr<const Thumbnail>& thumbnail);
+
+    std::shared_ptr<const Thumbnail> readDisk(uint64_t key);
+    void writeDisk(uint64_t key, const Thumbnail& thumbnail);
+
+    /**
+     * 打开（或创建）一代打包文件并扫描记录加入索引（调用方持有锁）
+     */
+    std::shared_ptr<PackFile> openPackLocked(uint32_t generation);
+
+    /**
+     * 当前代超过预算一半时开启新一代，删除更旧的一代（调用方持有锁）
+     */
+    void rotatePackLocked();
+
+    void closePacksLocked();
+
+    std::string m_cacheDir;
+    size_t m_maxMemoryBytes = 32ULL * 1024 * 1024;     // 32MB
+    size_t m_maxDiskBytes = 128ULL * 1024 * 1024;      // 128MB
+    size_t m_memoryBytes = 0;
+    MemoryCharge m_memoryCharge{MemoryCategory::CACHES, 0};   // 与 m_memoryBytes 同步
+
+    LruList m_lru;                                      // 表头为最近使用
+    std::unordered_map<uint64_t, LruList::iterator> m_memoryIndex;
+    std::unordered_map<uint64_t, DiskEntry> m_diskIndex;
+    std::shared_ptr<PackFile> m_currentPack;
+    std::shared_ptr<PackFile> m_previousPack;
+
+    Stats m_stats;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace filmtracker
+
+#endif // FILMTRACKER_THUMBNAIL_SERVICE_H
@@ -27,6 +27,8 @@ import com.filmtracker.app.util.ImageExporter
 import com.filmtracker.app.util.ImageProcessor
 import com.filmtracker.app.native.RawProcessorNative
 import com.filmtracker.app.native.BilateralFilterNative
+import com.filmtracker.app.native.MemoryGovernorNative
+import com.filmtracker.app.native.ThumbnailServiceNative
 import android.widget.Toast
 import kotlinx.coroutines.launch
 import androidx.lifecycle.lifecycleScope
@@ -52,6 +54,9 @@ class MainActivity : ComponentActivity() {
         // 初始化双边滤波器配置
         initializeBilateralFilterConfig()
         
+        // 初始化磁盘缓存（涉及目录扫描，放到 IO 线程）
+        initializeDiskCaches()
+        
         setContent {
             var currentScreen by remember { mutableStateOf<Screen>(Screen.Home) }
             var aiSuggestedImageUri by remember { mutableStateOf<String?>(null) }
@@ -319,9 +324,17 @@ class MainActivity : ComponentActivity() {
                     width = rawSize.first
                     height = rawSize.second
                 }
-                
-                // 直接使用 RAW 内嵌的预览图，不做额外处理
-                previewBitmap = rawProcessor.extractPreview(filePath)
+
+                // 缩略图已按 EXIF 方向转正，方向 5-8（转置/旋转 90°）时宽高随之交换
+                val orientation = rawProcessor.scanRawFiles(listOf(filePath)).firstOrNull()?.orientation ?: 1
+                if (orientation in 5..8) {
+                    val sensorWidth = width
+                    width = height
+                    height = sensorWidth
+                }
+
+                // 内嵌预览经缩略图服务缩小到与普通图片相同的 400px，命中缓存时不再读取 RAW
+                previewBitmap = ThumbnailServiceNative.getThumbnail(filePath, 400)
             } else {
                 // 普通图片：解码获取真实尺寸
                 val options = BitmapFactory.Options().apply {
@@ -539,6 +552,13 @@ class MainActivity : ComponentActivity() {
         }
     }
     
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        // 让 Native 缓存和工作缓冲区按级别释放内存
+        val released = MemoryGovernorNative.trim(level)
+        android.util.Log.i("MainActivity", "onTrimMemory($level): native released ${released / 1024} KB")
+    }
+    
     /**
      * 初始化双边滤波器配置
      * 在应用启动时调用，启用所有性能优化功能
@@ -555,7 +575,7 @@ class MainActivity : ComponentActivity() {
             android.util.Log.i("MainActivity", "  - Cache enabled: true")
             android.util.Log.i("MainActivity", "  - Fast approximation enabled: true")
             android.util.Log.i("MainActivity", "  - GPU enabled: true")
-            android.util.Log.i("MainActivity", "  - Fast approx threshold: 4.5")
+            android.util.Log.i("MainActivity", "  - Fast approx threshold: 3.0")
             android.util.Log.i("MainActivity", "  - GPU threshold pixels: 1500000")
             android.util.Log.i("MainActivity", "  - Max cache size: 100")
             android.util.Log.i("MainActivity", "  - Max cache memory: 512 MB")
@@ -567,4 +587,29 @@ class MainActivity : ComponentActivity() {
         }
     }
     
+    /**
+     * 初始化磁盘缓存
+     * RAW 解码结果缓存、缩略图缓存和双边滤波结果的溢出层都放在 cacheDir 的子目录下，系统空间不足时可被整体清理
+     */
+    private fun initializeDiskCaches() {
+        val decodedDir = java.io.File(cacheDir, "decoded_raw").absolutePath
+        val thumbnailDir = java.io.File(cacheDir, "thumbnails").absolutePath
+        val spillDir = java.io.File(cacheDir, "bilateral_spill").absolutePath
+        lifecycleScope.launch(Dispatchers.IO) {
+            try {
+                if (!ThumbnailServiceNative.init(thumbnailDir)) {
+                    android.util.Log.w("MainActivity", "Thumbnail cache unavailable: $thumbnailDir")
+                }
+                if (!RawProcessorNative.initDiskCache(decodedDir)) {
+                    android.util.Log.w("MainActivity", "Decoded image cache unavailable: $decodedDir")
+                }
+                if (!BilateralFilterNative.initSpillCache(spillDir)) {
+                    android.util.Log.w("MainActivity", "Bilateral spill cache unavailable: $spillDir")
+                }
+            } catch (e: Exception) {
+                android.util.Log.e("MainActivity", "Failed to initialize disk caches", e)
+            }
+        }
+    }
+    
 }
@@ -6,6 +6,13 @@ package com.filmtracker.app.native
  */
 object BilateralFilterNative {
     
+    /** 缓存条目原样保存 fp32 */
+    const val CACHE_COMPRESSION_NONE = 0
+    /** fp16 + 预测差分压缩（近无损，同样内存约多存 3 - 5 倍条目） */
+    const val CACHE_COMPRESSION_HALF = 1
+    /** fp32 无损预测差分压缩 */
+    const val CACHE_COMPRESSION_LOSSLESS = 2
+    
     /**
      * 双边滤波器配置
      * @param enableCache 启用结果缓存
@@ -15,6 +22,8 @@ object BilateralFilterNative {
      * @param maxCacheMemoryMB 最大缓存内存(MB)
      * @param fastApproxThreshold 快速近似触发阈值
      * @param gpuThresholdPixels GPU加速触发阈值(像素)
+     * @param sampledImageHash 无来源标识的图像改用稀疏采样哈希作缓存键(默认完整哈希；采样更快但内容局部变化时可能误命中，需调用方显式开启)
+     * @param cacheCompression 缓存条目压缩方式（[CACHE_COMPRESSION_NONE] / [CACHE_COMPRESSION_HALF] / [CACHE_COMPRESSION_LOSSLESS]）
      */
     data class Config @JvmOverloads constructor(
         val enableCache: Boolean = true,
@@ -22,8 +31,10 @@ object BilateralFilterNative {
         val enableGPU: Boolean = true,
         val maxCacheSize: Int = 100,
         val maxCacheMemoryMB: Int = 512,
-        val fastApproxThreshold: Float = 4.5f,
-        val gpuThresholdPixels: Int = 1_500_000
+        val fastApproxThreshold: Float = 3.0f,
+        val gpuThresholdPixels: Int = 1_500_000,
+        val sampledImageHash: Boolean = false,
+        val cacheCompression: Int = CACHE_COMPRESSION_NONE
     )
     
     /**
@@ -46,6 +57,143 @@ object BilateralFilterNative {
         val avgProcessingTimeMs: Double
     )
     
+    /**
+     * 结果缓存（ImageHashCache）统计
+     * @param hits 命中次数
+     * @param misses 未命中次数
+     * @param inserts 插入次数
+     * @param evictions LRU 驱逐次数
+     * @param bytesServed 命中时返回的字节数
+     * @param bytesInserted 插入的字节数
+     * @param entries 当前条目数
+     * @param memoryBytes 当前内存占用(字节)
+     * @param spillHits 内存未命中、从磁盘溢出层取回的次数
+     * @param logicalBytes 当前条目解压后的字节数(未压缩时等于 memoryBytes)
+     * @param decompressions 命中压缩条目时的解压次数
+     * @param decompressNs 解压累计耗时(纳秒)
+     */
+    data class CacheStats(
+        val hits: Long,
+        val misses: Long,
+        val inserts: Long,
+        val evictions: Long,
+        val bytesServed: Long,
+        val bytesInserted: Long,
+        val entries: Long,
+        val memoryBytes: Long,
+        val spillHits: Long = 0,
+        val logicalBytes: Long = memoryBytes,
+        val decompressions: Long = 0,
+        val decompressNs: Long = 0
+    ) {
+        val compressionRatio: Double
+            get() = if (memoryBytes > 0) logicalBytes.toDouble() / memoryBytes else 1.0
+        
+        val hitRate: Double
+            get() {
+                val lookups = hits + spillHits + misses
+                return if (lookups > 0) (hits + spillHits).toDouble() / lookups else 0.0
+            }
+    }
+    
+    /**
+     * 磁盘溢出层统计
+     * @param hits 从磁盘读回的次数
+     * @param pendingHits 命中写入队列中条目的次数
+     * @param misses 未命中次数
+     * @param writes 写入次数
+     * @param writeFailures 写入失败次数
+     * @param dropped 写入队列已满而放弃的次数
+     * @param evictions 磁盘淘汰次数
+     * @param bytesRead 读取字节数
+     * @param bytesWritten 写入字节数
+     * @param entryCount 当前文件数
+     * @param totalBytes 当前磁盘占用(字节)
+     * @param pendingBytes 写入队列中的字节数
+     */
+    data class SpillCacheStats(
+        val hits: Long,
+        val pendingHits: Long,
+        val misses: Long,
+        val writes: Long,
+        val writeFailures: Long,
+        val dropped: Long,
+        val evictions: Long,
+        val bytesRead: Long,
+        val bytesWritten: Long,
+        val entryCount: Long,
+        val totalBytes: Long,
+        val pendingBytes: Long
+    ) {
+        val hitRate: Double
+            get() {
+                val lookups = hits + pendingHits + misses
+                return if (lookups > 0) (hits + pendingHits).toDouble() / lookups else 0.0
+            }
+    }
+    
+    /**
+     * 获取结果缓存统计（便捷方法）
+     */
+    fun getCacheStats(): CacheStats? {
+        val values = nativeGetCacheStats() ?: return null
+        if (values.size < 8) return null
+        return CacheStats(
+            hits = values[0],
+            misses = values[1],
+            inserts = values[2],
+            evictions = values[3],
+            bytesServed = values[4],
+            bytesInserted = values[5],
+            entries = values[6],
+            memoryBytes = values[7],
+            spillHits = if (values.size > 8) values[8] else 0,
+            logicalBytes = if (values.size > 9) values[9] else values[7],
+            decompressions = if (values.size > 10) values[10] else 0,
+            decompressNs = if (values.size > 11) values[11] else 0
+        )
+    }
+    
+    /**
+     * 初始化结果缓存的磁盘溢出层
+     * 初始化后被驱逐的双边滤波结果以 fp16 异步写入该目录，再次需要时从磁盘读回而不是重新计算
+     * 
+     * @param cacheDir 缓存目录（建议使用 context.cacheDir 下的子目录）
+     * @param maxSizeMB 最大磁盘占用（MB）
+     */
+    fun initSpillCache(cacheDir: String, maxSizeMB: Int = 512): Boolean {
+        return nativeInitSpillCache(cacheDir, maxSizeMB)
+    }
+    
+    /**
+     * 获取磁盘溢出层统计（便捷方法）
+     */
+    fun getSpillCacheStats(): SpillCacheStats? {
+        val values = nativeGetSpillCacheStats() ?: return null
+        if (values.size < 12) return null
+        return SpillCacheStats(
+            hits = values[0],
+            pendingHits = values[1],
+            misses = values[2],
+            writes = values[3],
+            writeFailures = values[4],
+            dropped = values[5],
+            evictions = values[6],
+            bytesRead = values[7],
+            bytesWritten = values[8],
+            entryCount = values[9],
+            totalBytes = values[10],
+            pendingBytes = values[11]
+        )
+    }
+    
+    /**
+     * 清空磁盘溢出层（便捷方法）
+     */
+    fun clearSpillCache() {
+        nativeClearSpillCache()
+    }
+    
     /**
      * 设置配置（便捷方法）
      * @param config 配置对象
@@ -58,7 +206,9 @@ object BilateralFilterNative {
             config.maxCacheSize,
             config.maxCacheMemoryMB,
             config.fastApproxThreshold,
-            config.gpuThresholdPixels
+            config.gpuThresholdPixels,
+            config.sampledImageHash,
+            config.cacheCompression
         )
     }
     
@@ -82,7 +232,9 @@ object BilateralFilterNative {
         maxCacheSize: Int,
         maxCacheMemoryMB: Int,
         fastApproxThreshold: Float,
-        gpuThresholdPixels: Int
+        gpuThresholdPixels: Int,
+        sampledImageHash: Boolean,
+        cacheCompression: Int
     )
     
     /**
@@ -100,6 +252,30 @@ object BilateralFilterNative {
      */
     external fun nativeResetStats()
     
+    /**
+     * 获取结果缓存统计
+     * 返回 [hits, misses, inserts, evictions, bytesServed, bytesInserted, entries, memoryBytes, spillHits,
+     *       logicalBytes, decompressions, decompressNs]
+     */
+    external fun nativeGetCacheStats(): LongArray?
+    
+    /**
+     * 初始化磁盘溢出层
+     */
+    external fun nativeInitSpillCache(cacheDir: String, maxSizeMB: Int): Boolean
+    
+    /**
+     * 获取磁盘溢出层统计
+     * 返回 [hits, pendingHits, misses, writes, writeFailures, dropped, evictions,
+     *       bytesRead, bytesWritten, entryCount, totalBytes, pendingBytes]
+     */
+    external fun nativeGetSpillCacheStats(): LongArray?
+    
+    /**
+     * 清空磁盘溢出层
+     */
+    external fun nativeClearSpillCache()
+    
     /**
      * 清除缓存
      */
@@ -12,9 +12,12 @@ class ImageConverterNative {
     private external fun nativeGetImageSize(imagePtr: Long): IntArray?
     private external fun nativeLinearToSRGB(imagePtr: Long): ByteArray?
     private external fun nativeLinearToSRGBWithDithering(imagePtr: Long): ByteArray?
+    private external fun nativeLinearToBitmap(imagePtr: Long, bitmap: Bitmap): Boolean
+    private external fun nativeLinearToBuffer(imagePtr: Long, buffer: java.nio.ByteBuffer, format: Int, rowStride: Int): Boolean
     private external fun nativeBitmapToLinear(bitmap: Bitmap): Long
     private external fun nativeCloneLinearImage(imagePtr: Long): Long
     private external fun nativeReleaseImage(imagePtr: Long)
+    private external fun nativeBenchmarkDitheredOutput(width: Int, height: Int, iterations: Int): DoubleArray?
     
     /**
      * 获取图像尺寸
@@ -24,15 +27,30 @@ class ImageConverterNative {
         return Pair(size[0], size[1])
     }
     
+    /**
+     * 直接写入缓冲区时的像素格式（对应 Native 层 OutputPixelFormat）
+     */
+    enum class OutputFormat(val value: Int, val bytesPerPixel: Int) {
+        RGBA_8888(0, 4),    // sRGB 8 位
+        RGBA_16(1, 8),      // sRGB 16 位无符号（本机字节序）
+        RGBA_F16(2, 8),     // 线性光 fp16
+        RGBA_1010102(3, 4)  // sRGB 10 位打包（R 在低位，alpha 2 位）
+    }
+    
     /**
      * 将线性图像转换为 sRGB Bitmap（用于显示）
+     * 
+     * Native 层直接写入 Bitmap 像素；失败时退回 jbyteArray 复制路径
      */
     fun linearToBitmap(image: LinearImageNative): Bitmap? {
         return try {
             val (width, height) = getImageSize(image) ?: return null
-            val rgbaData = nativeLinearToSRGB(image.nativePtr) ?: return null
-            
             val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+            if (nativeLinearToBitmap(image.nativePtr, bitmap)) {
+                return bitmap
+            }
+            
+            val rgbaData = nativeLinearToSRGB(image.nativePtr) ?: return null
             val buffer = java.nio.ByteBuffer.wrap(rgbaData)
             bitmap.copyPixelsFromBuffer(buffer)
             
@@ -43,6 +61,44 @@ class ImageConverterNative {
         }
     }
     
+    /**
+     * 写入已有的 Bitmap（尺寸必须与图像一致）
+     * 
+     * ARGB_8888 写入 sRGB 8 位；RGBA_F16 写入线性 fp16，保留大于 1 的高光；
+     * RGBA_1010102（API 33+）写入 sRGB 10 位，不经过 8 位中间结果
+     */
+    fun writeToBitmap(image: LinearImageNative, bitmap: Bitmap): Boolean {
+        return try {
+            nativeLinearToBitmap(image.nativePtr, bitmap)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error writing to bitmap", e)
+            false
+        }
+    }
+    
+    /**
+     * 写入直接 ByteBuffer（例如编码器的输入缓冲区），无中间复制
+     * 
+     * @param rowStride 行字节数，0 表示紧密排列（width * bytesPerPixel）
+     */
+    fun writeToBuffer(
+        image: LinearImageNative,
+        buffer: java.nio.ByteBuffer,
+        format: OutputFormat = OutputFormat.RGBA_8888,
+        rowStride: Int = 0
+    ): Boolean {
+        if (!buffer.isDirect) {
+            Log.e(TAG, "writeToBuffer requires a direct buffer")
+            return false
+        }
+        return try {
+            nativeLinearToBuffer(image.nativePtr, buffer, format.value, rowStride)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error writing to buffer", e)
+            false
+        }
+    }
+    
     /**
      * 将线性图像转换为 sRGB Bitmap，使用误差扩散抖动
      * 
@@ -65,6 +121,43 @@ class ImageConverterNative {
         }
     }
     
+    /**
+     * 抖动输出基准测试结果（每帧）
+     */
+    data class DitherBenchmark(
+        val fusedMs: Double,
+        val multiPassMs: Double,
+        val fusedTrafficEstimateMB: Double,  // 主存流量估算（按每像素固定字节数计算，非实测）
+        val multiPassTrafficEstimateMB: Double,
+        val fusedScratchMB: Double,          // 额外分配
+        val multiPassScratchMB: Double
+    )
+    
+    /**
+     * 抖动输出基准测试：融合输出阶段 vs 旧的多遍流程（合成数据，默认 24MP）
+     */
+    fun benchmarkDitheredOutput(
+        width: Int = 6000,
+        height: Int = 4000,
+        iterations: Int = 3
+    ): DitherBenchmark? {
+        return try {
+            val values = nativeBenchmarkDitheredOutput(width, height, iterations) ?: return null
+            if (values.size < 6) return null
+            DitherBenchmark(
+                fusedMs = values[0],
+                multiPassMs = values[1],
+                fusedTrafficEstimateMB = values[2],
+                multiPassTrafficEstimateMB = values[3],
+                fusedScratchMB = values[4],
+                multiPassScratchMB = values[5]
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Error running dithered output benchmark", e)
+            null
+        }
+    }
+    
     /**
      * 将Bitmap转换为LinearImage（sRGB到线性域）
      */
@@ -84,6 +177,9 @@ class ImageConverterNative {
     
     /**
      * 克隆线性图像
+     *
+     * O(1)：新句柄与原句柄共用像素缓冲区，任一方首次被写入时才复制，
+     * 保存撤销历史或阶段缓存不会成倍占用内存
      */
     fun cloneLinearImage(image: LinearImageNative): LinearImageNative {
         val clonedPtr = nativeCloneLinearImage(image.nativePtr)
@@ -106,6 +202,6 @@ class ImageConverterNative {
 }
 
 /**
- * 线性图像 Native 包装
+ * 线性图像 Native 包装（写时复制句柄，用完需要 release）
  */
 class LinearImageNative(val nativePtr: Long)
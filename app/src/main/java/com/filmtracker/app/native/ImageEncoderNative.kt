@@ -0,0 +1,118 @@
+package com.filmtracker.app.native
+
+import android.graphics.Bitmap
+import android.graphics.ColorSpace
+import android.os.ParcelFileDescriptor
+import android.util.Log
+import java.io.File
+
+/**
+ * 流式图像编码器 Native 接口
+ *
+ * Native 层按行块并行压缩（JPEG 每块一个 restart interval，PNG 每块一段独立 deflate 流，
+ * TIFF 为未压缩条带），按顺序直接写入文件描述符，不经过 Java 层的字节数组。
+ * 输出文件嵌入 Bitmap 色彩空间对应的 ICC 配置文件。
+ * RAW 大图导出请使用 [RawStripExporterNative.exportToFile]，条带计算与编码重叠进行。
+ */
+object ImageEncoderNative {
+
+    private const val TAG = "ImageEncoderNative"
+
+    /**
+     * 编码格式（与 Native 层 EncodeFormat 一致）
+     */
+    enum class Format(val value: Int, val mimeType: String, val extension: String) {
+        JPEG(0, "image/jpeg", ".jpg"),
+        PNG(1, "image/png", ".png"),
+        TIFF(2, "image/tiff", ".tif")
+    }
+
+    /**
+     * 嵌入的 ICC 配置文件（与 Native 层 EncodeColorSpace 一致）
+     */
+    private enum class ColorSpaceTag(val value: Int) {
+        NONE(0),
+        SRGB(1),
+        DISPLAY_P3(2),
+        ADOBE_RGB(3),
+        LINEAR_SRGB(4)
+    }
+
+    /**
+     * 编码统计
+     */
+    data class Stats(
+        val bytesWritten: Long,
+        val blocks: Int,
+        val encodeMs: Double       // 工作线程累计压缩时间
+    )
+
+    private external fun nativeEncodeBitmap(bitmap: Bitmap, fd: Int, format: Int, quality: Int, colorSpace: Int): LongArray?
+
+    init {
+        System.loadLibrary("filmtracker")
+    }
+
+    /**
+     * 编码 Bitmap 并写入文件描述符（同步，请在后台线程调用）
+     *
+     * ARGB_8888 可编码为任意格式；RGBA_F16 只支持 TIFF（16 位浮点，线性）。
+     *
+     * @param fd 可写文件描述符，由调用方关闭
+     * @param quality JPEG 质量 1-100
+     * @return 编码统计，失败返回 null
+     */
+    fun encodeBitmap(bitmap: Bitmap, fd: Int, format: Format, quality: Int = 95): Stats? {
+        return try {
+            val values = nativeEncodeBitmap(bitmap, fd, format.value, quality, colorSpaceTag(bitmap).value)
+                ?: return null
+            if (values.size < 3) return null
+            Stats(
+                bytesWritten = values[0],
+                blocks = values[1].toInt(),
+                encodeMs = values[2] / 1000.0
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Error encoding bitmap", e)
+            null
+        }
+    }
+
+    /**
+     * Bitmap 色彩空间对应的 ICC 配置文件；没有对应配置文件时不嵌入（查看器按 sRGB 处理）
+     */
+    private fun colorSpaceTag(bitmap: Bitmap): ColorSpaceTag {
+        val colorSpace = bitmap.colorSpace ?: return ColorSpaceTag.SRGB
+        return when (colorSpace) {
+            ColorSpace.get(ColorSpace.Named.SRGB),
+            ColorSpace.get(ColorSpace.Named.EXTENDED_SRGB) -> ColorSpaceTag.SRGB
+            ColorSpace.get(ColorSpace.Named.DISPLAY_P3) -> ColorSpaceTag.DISPLAY_P3
+            ColorSpace.get(ColorSpace.Named.ADOBE_RGB) -> ColorSpaceTag.ADOBE_RGB
+            ColorSpace.get(ColorSpace.Named.LINEAR_SRGB),
+            ColorSpace.get(ColorSpace.Named.LINEAR_EXTENDED_SRGB) -> ColorSpaceTag.LINEAR_SRGB
+            else -> {
+                Log.w(TAG, "No ICC profile for color space ${colorSpace.name}, writing untagged")
+                ColorSpaceTag.NONE
+            }
+        }
+    }
+
+    /**
+     * 编码 Bitmap 并写入文件（覆盖已有文件）
+     */
+    fun encodeBitmap(bitmap: Bitmap, file: File, format: Format, quality: Int = 95): Stats? {
+        return try {
+            ParcelFileDescriptor.open(
+                file,
+                ParcelFileDescriptor.MODE_WRITE_ONLY or
+                    ParcelFileDescriptor.MODE_CREATE or
+                    ParcelFileDescriptor.MODE_TRUNCATE
+            ).use { pfd ->
+                encodeBitmap(bitmap, pfd.fd, format, quality)
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error opening ${file.absolutePath}", e)
+            null
+        }
+    }
+}
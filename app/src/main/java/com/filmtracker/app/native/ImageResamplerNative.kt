@@ -0,0 +1,70 @@
+package com.filmtracker.app.native
+
+import android.graphics.Bitmap
+import android.util.Log
+
+/**
+ * 图像重采样 Native 接口
+ *
+ * 预览、导出、缩略图共用的可分离重采样（面积平均 / 双三次 / Lanczos3），
+ * Native 层多线程执行，缩小时自动抗锯齿。
+ */
+object ImageResamplerNative {
+
+    private const val TAG = "ImageResamplerNative"
+
+    /**
+     * 重采样滤波器
+     */
+    enum class Filter(val value: Int) {
+        BOX(0),         // 面积平均：缩略图
+        BICUBIC(1),
+        LANCZOS3(2)     // 最锐利：预览、导出
+    }
+
+    private external fun nativeResizeBitmap(source: Bitmap, target: Bitmap, filter: Int): Boolean
+    private external fun nativeResizeLinear(imagePtr: Long, width: Int, height: Int, filter: Int): Long
+
+    init {
+        System.loadLibrary("filmtracker")
+    }
+
+    /**
+     * 缩放 Bitmap 到指定尺寸，失败时退回 Bitmap.createScaledBitmap
+     */
+    fun resize(bitmap: Bitmap, width: Int, height: Int, filter: Filter = Filter.LANCZOS3): Bitmap {
+        if (bitmap.width == width && bitmap.height == height) return bitmap
+        if (bitmap.config == Bitmap.Config.ARGB_8888) {
+            try {
+                val target = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+                if (nativeResizeBitmap(bitmap, target, filter.value)) {
+                    return target
+                }
+                target.recycle()
+            } catch (e: Exception) {
+                Log.e(TAG, "Native resize failed, falling back", e)
+            }
+        }
+        return Bitmap.createScaledBitmap(bitmap, width, height, true)
+    }
+
+    /**
+     * 等比缩小到长边不超过 maxEdge（不放大）
+     */
+    fun fitWithin(bitmap: Bitmap, maxEdge: Int, filter: Filter = Filter.LANCZOS3): Bitmap {
+        val longEdge = maxOf(bitmap.width, bitmap.height)
+        if (longEdge <= maxEdge) return bitmap
+        val scale = maxEdge.toDouble() / longEdge
+        val width = maxOf(1, Math.round(bitmap.width * scale).toInt())
+        val height = maxOf(1, Math.round(bitmap.height * scale).toInt())
+        return resize(bitmap, width, height, filter)
+    }
+
+    /**
+     * 缩放线性图像，返回新图像（调用方负责通过 ImageConverterNative.release 释放）
+     */
+    fun resize(image: LinearImageNative, width: Int, height: Int, filter: Filter = Filter.LANCZOS3): LinearImageNative? {
+        val ptr = nativeResizeLinear(image.nativePtr, width, height, filter.value)
+        return if (ptr != 0L) LinearImageNative(ptr) else null
+    }
+}
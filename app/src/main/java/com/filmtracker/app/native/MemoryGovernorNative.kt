@@ -0,0 +1,120 @@
+package com.filmtracker.app.native
+
+import android.util.Log
+
+/**
+ * Native 内存预算 Native 接口
+ *
+ * Native 层按分类（图像句柄、缓存、临时缓冲区、GPU 暂存）统计大块内存，总量超出预算时
+ * 按回收级别依次让缓存和工作缓冲区释放内存。Application / Activity 的 onTrimMemory
+ * 直接把 level 转发给 [trim]。
+ */
+object MemoryGovernorNative {
+
+    private const val TAG = "MemoryGovernorNative"
+
+    /** 回收级别，数值与 ComponentCallbacks2.TRIM_MEMORY_* 一致 */
+    const val TRIM_RUNNING_MODERATE = 5
+    const val TRIM_RUNNING_LOW = 10
+    const val TRIM_RUNNING_CRITICAL = 15
+    const val TRIM_UI_HIDDEN = 20
+    const val TRIM_BACKGROUND = 40
+    const val TRIM_MODERATE = 60
+    const val TRIM_COMPLETE = 80
+
+    /**
+     * 单个分类的用量
+     */
+    data class CategoryUsage(
+        val currentBytes: Long,
+        val peakBytes: Long,
+        val charges: Long
+    )
+
+    /**
+     * 内存统计
+     */
+    data class Stats(
+        val images: CategoryUsage,
+        val caches: CategoryUsage,
+        val scratch: CategoryUsage,
+        val gpuStaging: CategoryUsage,
+        val totalBytes: Long,
+        val budgetBytes: Long,
+        val trims: Long,
+        val budgetTrims: Long,
+        val bytesTrimmed: Long,
+        val lastTrimLevel: Int
+    ) {
+        val budgetUsage: Double
+            get() = if (budgetBytes > 0) totalBytes.toDouble() / budgetBytes else 0.0
+    }
+
+    private const val CATEGORY_COUNT = 4
+    private const val STATS_LENGTH = CATEGORY_COUNT * 3 + 6
+
+    private external fun nativeSetBudgetMB(budgetMB: Int)
+    private external fun nativeTrim(level: Int): Long
+    private external fun nativeGetStats(): LongArray?
+    private external fun nativeResetPeaks()
+
+    init {
+        System.loadLibrary("filmtracker")
+    }
+
+    /**
+     * 设置 Native 内存预算
+     *
+     * @param budgetMB 预算（MB），0 表示不限制；建议取 ActivityManager.getMemoryClass() 的一部分
+     */
+    fun setBudgetMB(budgetMB: Int) {
+        nativeSetBudgetMB(budgetMB)
+    }
+
+    /**
+     * 转发 onTrimMemory
+     *
+     * @return 释放的字节数
+     */
+    fun trim(level: Int): Long {
+        return try {
+            nativeTrim(level)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error trimming native memory", e)
+            0L
+        }
+    }
+
+    /**
+     * 获取各分类用量
+     */
+    fun getStats(): Stats? {
+        val values = nativeGetStats() ?: return null
+        if (values.size < STATS_LENGTH) return null
+        fun category(index: Int) = CategoryUsage(
+            currentBytes = values[index * 3],
+            peakBytes = values[index * 3 + 1],
+            charges = values[index * 3 + 2]
+        )
+        val base = CATEGORY_COUNT * 3
+        return Stats(
+            images = category(0),
+            caches = category(1),
+            scratch = category(2),
+            gpuStaging = category(3),
+            totalBytes = values[base],
+            budgetBytes = values[base + 1],
+            trims = values[base + 2],
+            budgetTrims = values[base + 3],
+            bytesTrimmed = values[base + 4],
+            lastTrimLevel = values[base + 5].toInt()
+        )
+    }
+
+    /**
+     * 把峰值重置为当前用量
+     */
+    fun resetPeaks() {
+        nativeResetPeaks()
+    }
+}
@@ -0,0 +1,174 @@
+package com.filmtracker.app.native
+
+import android.graphics.Bitmap
+import android.util.Log
+import java.nio.ByteBuffer
+
+/**
+ * RAW 批量导入 Native 封装
+ *
+ * Native 层按 CPU 核心数和内存预算启动多个解码线程，
+ * 为每个文件生成缩略图和代理图，并通过 [Listener] 流式回调结果。
+ * 回调在 Native 交付线程上执行，需要更新 UI 时请自行切换到主线程；
+ * 回调处理越慢，Native 解码线程越早因背压而暂停，内存占用不会超过预算。
+ *
+ * @param maxWorkers 最大解码线程数，0 = 按 CPU 核心数
+ * @param memoryBudgetMB 解码中和等待回调的结果占用的内存上限（MB）
+ * @param thumbnailSize 缩略图长边（像素），0 = 不生成
+ * @param proxySize 代理图长边（像素），0 = 不生成
+ */
+class RawBatchImporterNative(
+    maxWorkers: Int = 0,
+    memoryBudgetMB: Int = 512,
+    thumbnailSize: Int = 256,
+    proxySize: Int = 2048
+) {
+
+    private external fun nativeCreate(maxWorkers: Int, memoryBudgetMB: Int, thumbnailSize: Int, proxySize: Int): Long
+    private external fun nativeStart(nativePtr: Long, filePaths: Array<String>, listener: NativeListener): Boolean
+    private external fun nativeCancel(nativePtr: Long)
+    private external fun nativeGetStats(nativePtr: Long): DoubleArray?
+    private external fun nativeRelease(nativePtr: Long)
+
+    private var nativePtr: Long = 0
+
+    init {
+        System.loadLibrary("filmtracker")
+        nativePtr = nativeCreate(maxWorkers, memoryBudgetMB, thumbnailSize, proxySize)
+    }
+
+    /**
+     * 导入回调
+     */
+    interface Listener {
+        /**
+         * 单个文件导入完成（按完成顺序，不一定按输入顺序）
+         *
+         * @param proxy 代理图（线性 RGB），调用方负责通过 ImageConverterNative.release 释放
+         */
+        fun onFileImported(
+            index: Int,
+            filePath: String,
+            thumbnail: Bitmap?,
+            proxy: LinearImageNative?,
+            metadata: RawMetadataNative
+        )
+
+        fun onFileFailed(index: Int, filePath: String, error: String) {}
+
+        fun onProgress(completed: Int, total: Int) {}
+
+        fun onFinished(imported: Int, failed: Int, filesPerSecond: Double, cancelled: Boolean) {}
+    }
+
+    /**
+     * 开始导入（异步）
+     *
+     * @return 已有导入在进行时返回 false
+     */
+    fun start(filePaths: List<String>, listener: Listener): Boolean {
+        if (nativePtr == 0L) return false
+        return try {
+            nativeStart(nativePtr, filePaths.toTypedArray(), NativeListener(listener))
+        } catch (e: Exception) {
+            Log.e(TAG, "Error starting batch import", e)
+            false
+        }
+    }
+
+    /**
+     * 取消导入：未开始的文件不再解码
+     */
+    fun cancel() {
+        if (nativePtr != 0L) {
+            nativeCancel(nativePtr)
+        }
+    }
+
+    /**
+     * 获取导入统计
+     */
+    fun getStats(): Stats? {
+        if (nativePtr == 0L) return null
+        val values = nativeGetStats(nativePtr) ?: return null
+        if (values.size < 7) return null
+        return Stats(
+            total = values[0].toInt(),
+            completed = values[1].toInt(),
+            failed = values[2].toInt(),
+            workers = values[3].toInt(),
+            elapsedSeconds = values[4],
+            filesPerSecond = values[5],
+            peakMemoryMB = values[6]
+        )
+    }
+
+    /**
+     * 释放 Native 资源（会取消未完成的导入并等待线程退出）
+     */
+    fun release() {
+        if (nativePtr != 0L) {
+            nativeRelease(nativePtr)
+            nativePtr = 0
+        }
+    }
+
+    /**
+     * 导入统计
+     */
+    data class Stats(
+        val total: Int,
+        val completed: Int,
+        val failed: Int,
+        val workers: Int,
+        val elapsedSeconds: Double,
+        val filesPerSecond: Double,
+        val peakMemoryMB: Double
+    )
+
+    /**
+     * Native 回调适配：把原始数据转换为 Bitmap / Native 包装对象
+     */
+    private class NativeListener(private val listener: Listener) {
+
+        @Suppress("unused")
+        fun onFileImported(
+            index: Int,
+            filePath: String,
+            thumbnail: ByteArray?,
+            thumbnailWidth: Int,
+            thumbnailHeight: Int,
+            proxyPtr: Long,
+            metadataPtr: Long
+        ) {
+            val bitmap = if (thumbnail != null && thumbnailWidth > 0 && thumbnailHeight > 0) {
+                Bitmap.createBitmap(thumbnailWidth, thumbnailHeight, Bitmap.Config.ARGB_8888).apply {
+                    copyPixelsFromBuffer(ByteBuffer.wrap(thumbnail))
+                }
+            } else {
+                null
+            }
+            val proxy = if (proxyPtr != 0L) LinearImageNative(proxyPtr) else null
+            listener.onFileImported(index, filePath, bitmap, proxy, RawMetadataNative(metadataPtr))
+        }
+
+        @Suppress("unused")
+        fun onFileFailed(index: Int, filePath: String, error: String) {
+            listener.onFileFailed(index, filePath, error)
+        }
+
+        @Suppress("unused")
+        fun onProgress(completed: Int, total: Int) {
+            listener.onProgress(completed, total)
+        }
+
+        @Suppress("unused")
+        fun onFinished(imported: Int, failed: Int, filesPerSecond: Double, cancelled: Boolean) {
+            listener.onFinished(imported, failed, filesPerSecond, cancelled)
+        }
+    }
+
+    companion object {
+        private const val TAG = "RawBatchImporterNative"
+    }
+}
@@ -19,6 +19,13 @@ class RawMetadataNative(val nativePtr: Long) {
     external fun getBlackLevel(): Float
     external fun getWhiteLevel(): Float
     
+    private external fun nativeGetColorMatrix(nativePtr: Long): FloatArray?
+    
+    /**
+     * 相机 RGB -> 工作空间色彩矩阵（3x3，行优先），解码时已应用；未应用时为单位矩阵
+     */
+    fun getColorMatrix(): FloatArray? = nativeGetColorMatrix(nativePtr)
+    
     companion object {
         init {
             System.loadLibrary("filmtracker")
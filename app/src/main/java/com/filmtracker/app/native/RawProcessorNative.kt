@@ -2,6 +2,7 @@ package com.filmtracker.app.native
 
 import android.graphics.Bitmap
 import android.graphics.BitmapFactory
+import android.os.ParcelFileDescriptor
 import android.util.Log
 
 /**
@@ -14,6 +15,9 @@ class RawProcessorNative {
     private external fun nativeLoadRaw(nativePtr: Long, filePath: String): Long
     private external fun nativeExtractPreview(nativePtr: Long, filePath: String): ByteArray?
     private external fun nativeGetRawImageSize(nativePtr: Long, filePath: String): IntArray?
+    private external fun nativeScanRawFiles(filePaths: Array<String>): Array<RawFileInfo?>?
+    private external fun nativeSetDemosaicQuality(nativePtr: Long, quality: Int)
+    private external fun nativeBenchmarkDemosaic(quality: Int, width: Int, height: Int, iterations: Int): Double
     
     private var nativePtr: Long = 0
     
@@ -62,6 +66,21 @@ class RawProcessorNative {
         }
     }
     
+    /**
+     * 批量扫描 RAW 文件头（用于图库索引）
+     * 只读取文件开头几 KB，不解码图像；多线程并行扫描
+     * 
+     * @return 与输入一一对应的文件信息，无法识别的文件为 null
+     */
+    fun scanRawFiles(filePaths: List<String>): List<RawFileInfo?> {
+        return try {
+            nativeScanRawFiles(filePaths.toTypedArray())?.toList() ?: List(filePaths.size) { null }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error scanning RAW files", e)
+            List(filePaths.size) { null }
+        }
+    }
+    
     /**
      * 加载 RAW 图像文件
      * @return Pair<LinearImageNative, RawMetadataNative> 或 null
@@ -81,9 +100,217 @@ class RawProcessorNative {
         }
     }
     
+    /**
+     * 从文件描述符加载 RAW 图像（用于 content:// URI）
+     * Native 层直接 mmap 该 fd，文件内容不会读入 Java 堆；
+     * 调用方负责关闭 ParcelFileDescriptor
+     * 
+     * @param offset 起始偏移（AssetFileDescriptor 的 startOffset）
+     * @param length 长度，-1 表示到文件末尾
+     * @return Pair<LinearImageNative, RawMetadataNative> 或 null
+     */
+    fun loadRaw(
+        fileDescriptor: ParcelFileDescriptor,
+        offset: Long = 0L,
+        length: Long = -1L
+    ): Pair<LinearImageNative, RawMetadataNative>? {
+        return try {
+            val result = nativeLoadRawFromFd(nativePtr, fileDescriptor.fd, offset, length)
+            if (result != null && result.size >= 2 && result[0] != 0L && result[1] != 0L) {
+                Pair(LinearImageNative(result[0]), RawMetadataNative(result[1]))
+            } else {
+                Log.e(TAG, "Failed to load RAW image from file descriptor")
+                null
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error loading RAW from file descriptor", e)
+            null
+        }
+    }
+    
+    /**
+     * 快速加载 RAW 预览（超像素降采样，不做去马赛克）
+     * 每个 2x2 Bayer 块直接生成一个像素，适合打开文件时立即显示，
+     * 之后再用 loadRaw 加载全分辨率图像
+     * 
+     * @param quarterSize true 为四分之一尺寸，false 为半尺寸
+     * @return Pair<LinearImageNative, RawMetadataNative> 或 null
+     */
+    fun loadRawPreview(filePath: String, quarterSize: Boolean = false): Pair<LinearImageNative, RawMetadataNative>? {
+        return try {
+            val downscale = if (quarterSize) 4 else 2
+            val result = nativeLoadRawPreview(nativePtr, filePath, downscale)
+            if (result != null && result.size >= 2 && result[0] != 0L && result[1] != 0L) {
+                Pair(LinearImageNative(result[0]), RawMetadataNative(result[1]))
+            } else {
+                Log.e(TAG, "Failed to load RAW preview")
+                null
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error loading RAW preview", e)
+            null
+        }
+    }
+    
+    /**
+     * 设置去马赛克质量
+     * 预览使用 BILINEAR，导出使用 PPG
+     */
+    fun setDemosaicQuality(quality: DemosaicQuality) {
+        nativeSetDemosaicQuality(nativePtr, quality.value)
+    }
+    
+    /**
+     * 设置相机色彩处理
+     * 
+     * @param applyCameraColor 应用相机白平衡和色彩矩阵（关闭时输出白平衡前的相机 RGB）
+     * @param colorSpace 解码输出的线性工作空间
+     */
+    fun setColorProcessing(applyCameraColor: Boolean, colorSpace: WorkingColorSpace = WorkingColorSpace.REC709) {
+        nativeSetColorProcessing(nativePtr, applyCameraColor, colorSpace.value)
+    }
+    
+    /**
+     * 去马赛克吞吐量基准测试（合成 RAW 数据）
+     * 
+     * @return 吞吐量（MP/s）
+     */
+    fun benchmarkDemosaic(
+        quality: DemosaicQuality,
+        width: Int = 6000,
+        height: Int = 4000,
+        iterations: Int = 3
+    ): Double {
+        return try {
+            nativeBenchmarkDemosaic(quality.value, width, height, iterations)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error running demosaic benchmark", e)
+            0.0
+        }
+    }
+    
+    /**
+     * 磁盘缓存统计
+     */
+    data class DiskCacheStats(
+        val hits: Long,
+        val misses: Long,
+        val writes: Long,
+        val writeFailures: Long,
+        val evictions: Long,
+        val bytesRead: Long,
+        val bytesWritten: Long,
+        val entryCount: Long,
+        val totalBytes: Long,
+        val droppedWrites: Long
+    ) {
+        val hitRate: Float
+            get() = if (hits + misses > 0) hits.toFloat() / (hits + misses) else 0f
+    }
+    
+    /**
+     * RAW 文件头信息
+     * 
+     * @param width 传感器原始宽度
+     * @param height 传感器原始高度
+     * @param orientation EXIF 方向（1-8）
+     * @param previewOffset 最大嵌入式 JPEG 预览在文件中的偏移
+     * @param previewLength 预览长度，0 表示没有
+     */
+    data class RawFileInfo(
+        val format: String,
+        val width: Int,
+        val height: Int,
+        val orientation: Int,
+        val iso: Float,
+        val exposureTime: Float,
+        val aperture: Float,
+        val focalLength: Float,
+        val make: String,
+        val model: String,
+        val previewOffset: Long,
+        val previewLength: Long,
+        val previewWidth: Int,
+        val previewHeight: Int
+    )
+    
+    /**
+     * 去马赛克质量档位
+     */
+    enum class DemosaicQuality(val value: Int) {
+        BILINEAR(0),
+        PPG(1)
+    }
+    
+    /**
+     * 解码输出的线性工作空间
+     */
+    enum class WorkingColorSpace(val value: Int) {
+        REC709(0),
+        PROPHOTO(1)
+    }
+    
+    private external fun nativeSetColorProcessing(nativePtr: Long, applyCameraColor: Boolean, colorSpace: Int)
     private external fun nativeLoadRawWithMetadata(nativePtr: Long, filePath: String): LongArray?
+    private external fun nativeLoadRawFromFd(nativePtr: Long, fd: Int, offset: Long, length: Long): LongArray?
+    private external fun nativeLoadRawPreview(nativePtr: Long, filePath: String, downscale: Int): LongArray?
     
     companion object {
         private const val TAG = "RawProcessorNative"
+        
+        init {
+            System.loadLibrary("filmtracker")
+        }
+        
+        /**
+         * 初始化解码图像磁盘缓存
+         * 缓存是进程级单例，不需要创建 RawProcessorNative 实例；
+         * 初始化后 loadRaw(filePath) 会优先读取缓存，跳过 RAW 解码
+         * 
+         * @param cacheDir 缓存目录（建议使用 context.cacheDir 下的子目录）
+         * @param maxSizeMB 最大磁盘占用（MB）
+         */
+        fun initDiskCache(cacheDir: String, maxSizeMB: Int = 1024): Boolean {
+            return try {
+                nativeInitDiskCache(cacheDir, maxSizeMB)
+            } catch (e: Exception) {
+                Log.e(TAG, "Error initializing disk cache", e)
+                false
+            }
+        }
+        
+        /**
+         * 获取磁盘缓存统计
+         */
+        fun getDiskCacheStats(): DiskCacheStats? {
+            val values = nativeGetDiskCacheStats() ?: return null
+            if (values.size < 10) return null
+            return DiskCacheStats(
+                hits = values[0],
+                misses = values[1],
+                writes = values[2],
+                writeFailures = values[3],
+                evictions = values[4],
+                bytesRead = values[5],
+                bytesWritten = values[6],
+                entryCount = values[7],
+                totalBytes = values[8],
+                droppedWrites = values[9]
+            )
+        }
+        
+        /**
+         * 清空磁盘缓存
+         */
+        fun clearDiskCache() {
+            nativeClearDiskCache()
+        }
+        
+        @JvmStatic
+        private external fun nativeInitDiskCache(cacheDir: String, maxSizeMB: Int): Boolean
+        @JvmStatic
+        private external fun nativeGetDiskCacheStats(): LongArray?
+        @JvmStatic
+        private external fun nativeClearDiskCache()
     }
 }
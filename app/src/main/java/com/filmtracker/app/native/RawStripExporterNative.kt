@@ -0,0 +1,154 @@
+package com.filmtracker.app.native
+
+import android.util.Log
+import java.nio.ByteBuffer
+
+/**
+ * RAW 条带流式导出 Native 接口
+ *
+ * Native 层按水平条带去马赛克（带 halo），每个条带经过完整调整管线和 sRGB 输出转换后，
+ * 把完成的行交给 [RowSink]（通常是流式编码器）。除 LibRaw 解包缓冲外，峰值内存只取决于
+ * 条带高度，适合在内存受限的设备上导出大尺寸 RAW。
+ *
+ * [exportToFile] 把行直接交给 Native 流式编码器写入文件，编码与下一个条带的计算重叠进行。
+ */
+object RawStripExporterNative {
+
+    private const val TAG = "RawStripExporterNative"
+
+    /**
+     * 输出行接收器（在调用 export 的线程上回调），任一方法返回 false 时中止导出
+     */
+    interface RowSink {
+        fun begin(width: Int, height: Int): Boolean = true
+
+        /**
+         * 写入若干完整的行
+         *
+         * @param rows RGBA8 像素（直接缓冲区，只在回调期间有效，需要保留时请复制）
+         * @param firstRow 第一行在整幅图像中的行号
+         * @param rowCount 行数
+         * @param rowStride 相邻行的字节间隔
+         */
+        fun writeRows(rows: ByteBuffer, firstRow: Int, rowCount: Int, rowStride: Int): Boolean
+
+        fun finish(): Boolean = true
+    }
+
+    /**
+     * 导出统计
+     */
+    data class Stats(
+        val width: Int,
+        val height: Int,
+        val strips: Int,
+        val haloRows: Int,
+        val peakStripMB: Double,
+        val elapsedSeconds: Double,
+        val bytesWritten: Long = 0,         // 仅 exportToFile
+        val encodeSeconds: Double = 0.0     // 仅 exportToFile：编码工作线程累计时间
+    )
+
+    private external fun nativeExport(
+        filePath: String,
+        paramsHandle: Long,
+        quality: Int,
+        stripHeight: Int,
+        softClip: Boolean,
+        sink: RowSink
+    ): DoubleArray?
+
+    private external fun nativeExportToFile(
+        filePath: String,
+        paramsHandle: Long,
+        quality: Int,
+        stripHeight: Int,
+        softClip: Boolean,
+        fd: Int,
+        encodeFormat: Int,
+        pixelFormat: Int,
+        encodeQuality: Int
+    ): DoubleArray?
+
+    init {
+        System.loadLibrary("filmtracker")
+    }
+
+    /**
+     * 导出 RAW 文件（同步，请在后台线程调用）
+     *
+     * @param params 调整参数
+     * @param stripHeight 每个条带的行数，越小峰值内存越低，但 halo 重复计算越多
+     * @return 导出统计，失败或被 sink 中止时返回 null
+     */
+    fun export(
+        filePath: String,
+        params: BasicAdjustmentParamsNative,
+        sink: RowSink,
+        quality: RawProcessorNative.DemosaicQuality = RawProcessorNative.DemosaicQuality.PPG,
+        stripHeight: Int = 256,
+        softClip: Boolean = true
+    ): Stats? {
+        return try {
+            val values = nativeExport(filePath, params.handle, quality.value, stripHeight, softClip, sink)
+                ?: return null
+            if (values.size < 6) return null
+            Stats(
+                width = values[0].toInt(),
+                height = values[1].toInt(),
+                strips = values[2].toInt(),
+                haloRows = values[3].toInt(),
+                peakStripMB = values[4],
+                elapsedSeconds = values[5]
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Error exporting $filePath", e)
+            null
+        }
+    }
+
+    /**
+     * 导出 RAW 文件并直接编码写入文件描述符（同步，请在后台线程调用）
+     *
+     * 支持的组合：JPEG + RGBA_8888；PNG + RGBA_8888 / RGBA_16；TIFF + 任意格式
+     * （RGBA_F16 为线性 16 位浮点 TIFF，不做软裁剪）。
+     *
+     * @param fd 可写文件描述符，由调用方关闭
+     * @param format 编码格式
+     * @param pixelFormat 输出位深度
+     * @param encodeQuality JPEG 质量 1-100
+     * @return 导出统计，失败时返回 null（文件内容不完整，调用方应删除）
+     */
+    fun exportToFile(
+        filePath: String,
+        params: BasicAdjustmentParamsNative,
+        fd: Int,
+        format: ImageEncoderNative.Format,
+        pixelFormat: ImageConverterNative.OutputFormat = ImageConverterNative.OutputFormat.RGBA_8888,
+        encodeQuality: Int = 95,
+        quality: RawProcessorNative.DemosaicQuality = RawProcessorNative.DemosaicQuality.PPG,
+        stripHeight: Int = 256,
+        softClip: Boolean = true
+    ): Stats? {
+        return try {
+            val values = nativeExportToFile(
+                filePath, params.handle, quality.value, stripHeight, softClip,
+                fd, format.value, pixelFormat.value, encodeQuality
+            ) ?: return null
+            if (values.size < 8) return null
+            Stats(
+                width = values[0].toInt(),
+                height = values[1].toInt(),
+                strips = values[2].toInt(),
+                haloRows = values[3].toInt(),
+                peakStripMB = values[4],
+                elapsedSeconds = values[5],
+                bytesWritten = values[6].toLong(),
+                encodeSeconds = values[7]
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Error exporting $filePath to file", e)
+            null
+        }
+    }
+}
@@ -0,0 +1,92 @@
+package com.filmtracker.app.native
+
+import android.graphics.Bitmap
+import android.util.Log
+import java.nio.ByteBuffer
+
+/**
+ * 单次调用渲染管线 Native 接口
+ *
+ * 一次 JNI 调用完成 参数解析 -> 全部调整 -> sRGB 输出，结果直接写入 Bitmap 像素。
+ * 参数以打包的直接 ByteBuffer 传入（布局见 Native 层 RenderParamsLayout，
+ * 由 [com.filmtracker.app.util.RenderParamsPacker] 生成）。
+ */
+object RenderPipelineNative {
+
+    private const val TAG = "RenderPipelineNative"
+
+    /** 打包参数魔数 "FTRP"（小端） */
+    const val PARAMS_MAGIC = 0x50525446
+    /** 打包参数布局版本 */
+    const val PARAMS_VERSION = 1
+    /** 头部字节数：magic | version | totalSize | flags */
+    const val PARAMS_HEADER_BYTES = 16
+    /** 标量参数个数 */
+    const val PARAMS_SCALAR_COUNT = 25
+
+    /** 软裁剪 + 误差扩散抖动输出（导出用，较慢） */
+    const val FLAG_DITHER = 1
+
+    /**
+     * 最近一次渲染的耗时统计
+     */
+    data class Stats(
+        val renders: Long,
+        val prepareMs: Double,
+        val adjustMs: Double,
+        val outputMs: Double,
+        val totalMs: Double
+    )
+
+    private external fun nativeRender(imagePtr: Long, params: ByteBuffer, paramsSize: Int, output: Bitmap): Boolean
+    private external fun nativeGetStats(): DoubleArray?
+    private external fun nativeTrimMemory()
+
+    init {
+        System.loadLibrary("filmtracker")
+    }
+
+    /**
+     * 渲染到 Bitmap（同步，请在后台线程调用）
+     *
+     * 可从多个线程同时调用，各调用使用 Native 管线池中不同的工作图像，预览和导出互不等待
+     *
+     * @param image 源线性图像（不修改）
+     * @param params 打包参数（直接 ByteBuffer，有效内容为 [0, limit)）
+     * @param output ARGB_8888、RGBA_F16（线性 fp16）或 RGBA_1010102（sRGB 10 位）Bitmap，尺寸与源图像不同时 Native 层先重采样
+     */
+    fun render(image: LinearImageNative, params: ByteBuffer, output: Bitmap): Boolean {
+        if (!params.isDirect) {
+            Log.e(TAG, "Params buffer must be direct")
+            return false
+        }
+        return try {
+            nativeRender(image.nativePtr, params, params.limit(), output)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error rendering", e)
+            false
+        }
+    }
+
+    /**
+     * 获取最近一次渲染的统计
+     */
+    fun getStats(): Stats? {
+        val values = nativeGetStats() ?: return null
+        if (values.size < 5) return null
+        return Stats(
+            renders = values[0].toLong(),
+            prepareMs = values[1],
+            adjustMs = values[2],
+            outputMs = values[3],
+            totalMs = values[4]
+        )
+    }
+
+    /**
+     * 释放空闲 Native 管线的工作图像（onTrimMemory 时调用）
+     */
+    fun trimMemory() {
+        nativeTrimMemory()
+    }
+}
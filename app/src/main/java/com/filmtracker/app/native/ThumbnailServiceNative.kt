@@ -0,0 +1,163 @@
+package com.filmtracker.app.native
+
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.util.Log
+
+/**
+ * RAW 缩略图服务 Native 接口
+ *
+ * 从 RAW 文件的嵌入式 JPEG 预览生成缩略图，Native 层维护内存 LRU + 磁盘打包文件两级缓存，
+ * 图库滚动时已缓存的缩略图直接返回，不再重复提取和解码预览。
+ *
+ * Android 11（API 30）及以上由 Native 层直接从文件映射解码；低版本在这里用 BitmapFactory
+ * 解码预览后交给 Native 层缩小、旋转并写入缓存。
+ */
+object ThumbnailServiceNative {
+
+    private const val TAG = "ThumbnailServiceNative"
+
+    /**
+     * 缩略图缓存统计
+     */
+    data class Stats(
+        val memoryHits: Long,
+        val diskHits: Long,
+        val misses: Long,
+        val decodes: Long,
+        val decodeFailures: Long,
+        val memoryEntries: Long,
+        val memoryBytes: Long,
+        val diskEntries: Long,
+        val diskBytes: Long
+    ) {
+        val hitRate: Double
+            get() {
+                val total = memoryHits + diskHits + misses
+                return if (total > 0) (memoryHits + diskHits).toDouble() / total else 0.0
+            }
+    }
+
+    private external fun nativeInit(cacheDir: String?, memoryCacheMB: Int, diskCacheMB: Int): Boolean
+    private external fun nativeGetThumbnail(filePath: String, maxSize: Int): Bitmap?
+    private external fun nativeFindCached(filePath: String, maxSize: Int): Bitmap?
+    private external fun nativePutThumbnail(filePath: String, maxSize: Int, bitmap: Bitmap): Bitmap?
+    private external fun nativeGetPreviewJpeg(filePath: String): ByteArray?
+    private external fun nativeIsNativeDecodeSupported(): Boolean
+    private external fun nativeGetStats(): LongArray?
+    private external fun nativeClearMemory()
+    private external fun nativeClear()
+
+    init {
+        System.loadLibrary("filmtracker")
+    }
+
+    private val nativeDecodeSupported: Boolean by lazy { nativeIsNativeDecodeSupported() }
+
+    /**
+     * 初始化缓存
+     *
+     * @param cacheDir 磁盘缓存目录（建议使用 context.cacheDir 下的子目录），null 表示只用内存缓存
+     * @param memoryCacheMB 内存缓存上限（MB）
+     * @param diskCacheMB 磁盘缓存上限（MB）
+     */
+    fun init(cacheDir: String?, memoryCacheMB: Int = 32, diskCacheMB: Int = 128): Boolean {
+        return try {
+            nativeInit(cacheDir, memoryCacheMB, diskCacheMB)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error initializing thumbnail service", e)
+            false
+        }
+    }
+
+    /**
+     * 获取缩略图（已按 EXIF 方向转正）
+     *
+     * 缓存未命中时会读取文件并解码预览，请在后台线程调用
+     *
+     * @param maxSize 长边上限（像素）
+     */
+    fun getThumbnail(filePath: String, maxSize: Int = 256): Bitmap? {
+        return try {
+            nativeGetThumbnail(filePath, maxSize) ?: decodeFallback(filePath, maxSize)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error getting thumbnail", e)
+            null
+        }
+    }
+
+    /**
+     * 只查缓存（内存 -> 磁盘），未命中返回 null，不解码
+     */
+    fun findCached(filePath: String, maxSize: Int = 256): Bitmap? {
+        return try {
+            nativeFindCached(filePath, maxSize)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error querying thumbnail cache", e)
+            null
+        }
+    }
+
+    /**
+     * 获取缓存统计
+     */
+    fun getStats(): Stats? {
+        val values = nativeGetStats() ?: return null
+        if (values.size < 9) return null
+        return Stats(
+            memoryHits = values[0],
+            diskHits = values[1],
+            misses = values[2],
+            decodes = values[3],
+            decodeFailures = values[4],
+            memoryEntries = values[5],
+            memoryBytes = values[6],
+            diskEntries = values[7],
+            diskBytes = values[8]
+        )
+    }
+
+    /**
+     * 释放内存缓存（onTrimMemory 时调用），磁盘缓存保留
+     */
+    fun clearMemory() {
+        nativeClearMemory()
+    }
+
+    /**
+     * 清空内存和磁盘缓存
+     */
+    fun clear() {
+        nativeClear()
+    }
+
+    /**
+     * Java 层解码回退：低版本系统没有 AImageDecoder，或文件头中找不到预览时走 LibRaw 提取
+     */
+    private fun decodeFallback(filePath: String, maxSize: Int): Bitmap? {
+        val jpegData = nativeGetPreviewJpeg(filePath) ?: return null
+
+        val bounds = BitmapFactory.Options().apply { inJustDecodeBounds = true }
+        BitmapFactory.decodeByteArray(jpegData, 0, jpegData.size, bounds)
+        if (bounds.outWidth <= 0 || bounds.outHeight <= 0) {
+            Log.w(TAG, "Invalid embedded preview in $filePath")
+            return null
+        }
+
+        // 2 的幂次采样到不小于目标尺寸，剩余部分由 Native 层面积平均缩小
+        var sampleSize = 1
+        while (maxOf(bounds.outWidth, bounds.outHeight) / (sampleSize * 2) >= maxSize) {
+            sampleSize *= 2
+        }
+        val options = BitmapFactory.Options().apply {
+            inSampleSize = sampleSize
+            inPreferredConfig = Bitmap.Config.ARGB_8888
+        }
+        val decoded = BitmapFactory.decodeByteArray(jpegData, 0, jpegData.size, options) ?: return null
+        return try {
+            nativePutThumbnail(filePath, maxSize, decoded)
+        } finally {
+            decoded.recycle()
+        }
+    }
+}
@@ -7,12 +7,17 @@ import android.graphics.BitmapFactory
 import android.net.Uri
 import android.os.Build
 import android.os.Environment
+import android.os.ParcelFileDescriptor
 import android.provider.MediaStore
 import android.util.Log
 import com.filmtracker.app.data.BasicAdjustmentParams
 import com.filmtracker.app.data.mapper.AdjustmentParamsMapper
 import com.filmtracker.app.domain.error.FileSystemError
 import com.filmtracker.app.domain.model.AdjustmentParams
+import com.filmtracker.app.native.BasicAdjustmentParamsNative
+import com.filmtracker.app.native.ImageConverterNative
+import com.filmtracker.app.native.ImageEncoderNative
+import com.filmtracker.app.native.RawStripExporterNative
 import com.filmtracker.app.util.StorageUtil
 import java.io.File
 import java.io.FileOutputStream
@@ -29,6 +34,7 @@ import java.io.OutputStream
  * 3. 按固定顺序处理所有阶段：GEOMETRY → TONE_BASE → CURVES → COLOR → EFFECTS → DETAILS
  * 4. 支持多种输出格式（JPEG、PNG、TIFF）
  * 5. 支持质量和位深度设置
+ * 6. RAW 文件（无几何变换时）由 Native 条带导出直接解码、调整并编码写入文件
  * 
  * 增强的错误处理：
  * - 存储空间检查
@@ -45,6 +51,10 @@ class ExportRenderingPipeline(
     
     companion object {
         private const val TAG = "ExportRenderingPipeline"
+        
+        private val RAW_EXTENSIONS = listOf(
+            ".arw", ".cr2", ".cr3", ".nef", ".raf", ".orf", ".rw2", ".pef", ".srw", ".dng", ".raw"
+        )
     }
     
     /**
@@ -184,6 +194,24 @@ class ExportRenderingPipeline(
                 )
             }
             
+            // RAW 文件走 Native 条带流式导出：全尺寸图像不经过 Java 堆上的 Bitmap，
+            // 条带计算与编码重叠进行。几何变换（旋转、裁剪）条带导出不支持，仍走 Bitmap 管线
+            val basicParams = paramsMapper.toData(params)
+            if (isRawFile(imagePath) &&
+                !stageProcessorFactory.getProcessor(ProcessingStage.GEOMETRY).shouldExecute(basicParams)) {
+                val outputFile = File(config.outputPath)
+                if (exportRawStreaming(imagePath, basicParams, outputFile, config)) {
+                    val totalTime = System.currentTimeMillis() - startTime
+                    Log.d(TAG, "Streaming RAW export completed in ${totalTime}ms")
+                    return ExportResult.Success(
+                        outputFile = outputFile,
+                        totalTimeMs = totalTime,
+                        stageResults = stageResults
+                    )
+                }
+                Log.w(TAG, "Streaming RAW export failed, falling back to bitmap pipeline")
+            }
+            
             // 3. 加载原始图像（完整分辨率，不降采样）
             // Requirement 6.1: Export Full Resolution
             currentBitmap = loadOriginalImage(imagePath)
@@ -221,9 +249,6 @@ class ExportRenderingPipeline(
                 )
             }
             
-            // 转换参数到数据层模型
-            val basicParams = paramsMapper.toData(params)
-            
             // 4. 按固定顺序处理所有阶段
             // Requirement 6.2: Export Pipeline Independence (不使用预览缓存)
             val orderedStages = ProcessingStage.getOrderedStages()
@@ -507,6 +532,105 @@ class ExportRenderingPipeline(
         }
     }
     
+    private fun isRawFile(imagePath: String): Boolean {
+        val name = imagePath.lowercase()
+        return RAW_EXTENSIONS.any { name.endsWith(it) }
+    }
+    
+    /**
+     * RAW 条带流式导出（解码、调整、编码全部在 Native 层完成）
+     * 
+     * @return 是否成功；失败时已删除不完整的输出文件
+     */
+    private fun exportRawStreaming(
+        imagePath: String,
+        params: BasicAdjustmentParams,
+        outputFile: File,
+        config: ExportConfig
+    ): Boolean {
+        val format = config.format.toEncoderFormat()
+        // JPEG 只支持 8 位
+        val pixelFormat = if (config.bitDepth == BitDepth.BIT_16 && format != ImageEncoderNative.Format.JPEG) {
+            ImageConverterNative.OutputFormat.RGBA_16
+        } else {
+            ImageConverterNative.OutputFormat.RGBA_8888
+        }
+        
+        val nativeParams = createNativeParams(params)
+        val stats = try {
+            // 确保输出目录存在，否则打开失败会回退到整帧 Bitmap 导出
+            outputFile.parentFile?.mkdirs()
+            ParcelFileDescriptor.open(
+                outputFile,
+                ParcelFileDescriptor.MODE_WRITE_ONLY or
+                    ParcelFileDescriptor.MODE_CREATE or
+                    ParcelFileDescriptor.MODE_TRUNCATE
+            ).use { pfd ->
+                RawStripExporterNative.exportToFile(
+                    filePath = imagePath,
+                    params = nativeParams,
+                    fd = pfd.fd,
+                    format = format,
+                    pixelFormat = pixelFormat,
+                    encodeQuality = config.quality.coerceIn(1, 100)
+                )
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error opening ${outputFile.absolutePath}", e)
+            null
+        } finally {
+            nativeParams.release()
+        }
+        
+        if (stats == null) {
+            outputFile.delete()
+            return false
+        }
+        Log.d(TAG, "Streamed ${stats.width}x${stats.height} in ${stats.strips} strips, " +
+                "peak strip ${"%.1f".format(stats.peakStripMB)}MB, ${stats.bytesWritten} bytes")
+        return true
+    }
+    
+    /**
+     * 完整的 Native 调整参数（条带导出一次应用全部阶段）
+     */
+    private fun createNativeParams(params: BasicAdjustmentParams): BasicAdjustmentParamsNative {
+        val nativeParams = BasicAdjustmentParamsNative.create()
+        
+        // 将 Adobe 标准参数转换为 Native 层需要的乘数
+        val contrastMultiplier = com.filmtracker.app.util.AdobeParameterConverter.contrastToMultiplier(params.contrast)
+        val saturationMultiplier = com.filmtracker.app.util.AdobeParameterConverter.saturationToMultiplier(params.saturation)
+        
+        nativeParams.setParams(
+            params.globalExposure, contrastMultiplier, saturationMultiplier,
+            params.highlights, params.shadows, params.whites, params.blacks,
+            params.clarity, params.vibrance,
+            params.temperature, params.tint,
+            params.gradingHighlightsTemp, params.gradingHighlightsTint,
+            params.gradingMidtonesTemp, params.gradingMidtonesTint,
+            params.gradingShadowsTemp, params.gradingShadowsTint,
+            params.gradingBlending, params.gradingBalance,
+            params.texture, params.dehaze, params.vignette, params.grain,
+            params.sharpening, params.noiseReduction
+        )
+        
+        nativeParams.setAllToneCurves(
+            params.enableRgbCurve, params.rgbCurvePoints,
+            params.enableRedCurve, params.redCurvePoints,
+            params.enableGreenCurve, params.greenCurvePoints,
+            params.enableBlueCurve, params.blueCurvePoints
+        )
+        
+        val hslValid = params.hslHueShift.size == 8 && params.hslSaturation.size == 8 && params.hslLuminance.size == 8
+        if (hslValid) {
+            nativeParams.setHSL(params.enableHSL, params.hslHueShift, params.hslSaturation, params.hslLuminance)
+        } else {
+            nativeParams.setHSL(false, FloatArray(8) { 0f }, FloatArray(8) { 0f }, FloatArray(8) { 0f })
+        }
+        
+        return nativeParams
+    }
+    
     /**
      * 加载原始图像（完整分辨率）
      * 
@@ -547,37 +671,19 @@ class ExportRenderingPipeline(
             // 确保输出目录存在
             outputFile.parentFile?.mkdirs()
             
-            // 根据格式编码
-            FileOutputStream(outputFile).use { outputStream ->
-                when (config.format) {
-                    ExportFormat.JPEG -> {
-                        // JPEG 格式：支持质量设置
-                        // Requirement 6.4: Export Quality Settings
-                        bitmap.compress(
-                            Bitmap.CompressFormat.JPEG,
-                            config.quality,
-                            outputStream
-                        )
-                    }
-                    ExportFormat.PNG -> {
-                        // PNG 格式：无损压缩
-                        // Requirement 6.3: 支持多种输出格式
-                        bitmap.compress(
-                            Bitmap.CompressFormat.PNG,
-                            100,  // PNG 忽略质量参数
-                            outputStream
-                        )
-                    }
-                    ExportFormat.TIFF -> {
-                        // TIFF 格式：目前 Android 不直接支持，使用 PNG 作为替代
-                        // 注意：完整的 TIFF 支持需要额外的库（如 libtiff）
-                        Log.w(TAG, "TIFF format not directly supported, using PNG instead")
-                        bitmap.compress(
-                            Bitmap.CompressFormat.PNG,
-                            100,
-                            outputStream
-                        )
-                    }
+            // Native 流式编码：行块并行压缩，直接写入文件
+            // Requirement 6.3, 6.4: 多种输出格式和质量设置
+            val stats = ImageEncoderNative.encodeBitmap(
+                bitmap, outputFile, config.format.toEncoderFormat(), config.quality
+            )
+            if (stats == null) {
+                Log.w(TAG, "Native encoder failed, falling back to Bitmap.compress")
+                val written = FileOutputStream(outputFile).use { outputStream ->
+                    compressWithBitmap(bitmap, config, outputStream)
+                }
+                if (!written) {
+                    outputFile.delete()
+                    return false
                 }
             }
             
@@ -609,7 +715,7 @@ class ExportRenderingPipeline(
             val (mimeType, extension) = when (config.format) {
                 ExportFormat.JPEG -> Pair("image/jpeg", ".jpg")
                 ExportFormat.PNG -> Pair("image/png", ".png")
-                ExportFormat.TIFF -> Pair("image/png", ".png")  // TIFF 使用 PNG 替代
+                ExportFormat.TIFF -> Pair("image/tiff", ".tif")
             }
             
             val displayName = "${config.displayName}$extension"
@@ -643,16 +749,19 @@ class ExportRenderingPipeline(
                 return Pair(null, null)
             }
             
-            // 写入图像数据
-            resolver.openOutputStream(imageUri)?.use { outputStream ->
-                val compressFormat = when (config.format) {
-                    ExportFormat.JPEG -> Bitmap.CompressFormat.JPEG
-                    ExportFormat.PNG, ExportFormat.TIFF -> Bitmap.CompressFormat.PNG
-                }
-                
-                val quality = if (config.format == ExportFormat.JPEG) config.quality else 100
-                
-                bitmap.compress(compressFormat, quality, outputStream)
+            // 写入图像数据：优先 Native 流式编码，失败时回退到 Bitmap.compress
+            val encoded = resolver.openFileDescriptor(imageUri, "w")?.use { pfd ->
+                ImageEncoderNative.encodeBitmap(
+                    bitmap, pfd.fd, config.format.toEncoderFormat(), config.quality
+                )
+            } != null || resolver.openOutputStream(imageUri, "wt")?.use { outputStream ->
+                compressWithBitmap(bitmap, config, outputStream)
+            } == true
+            
+            if (!encoded) {
+                Log.e(TAG, "Failed to encode image for gallery")
+                resolver.delete(imageUri, null, null)
+                return Pair(null, null)
             }
             
             // Android Q 及以上：标记为完成
@@ -670,4 +779,27 @@ class ExportRenderingPipeline(
             Pair(null, null)
         }
     }
+    
+    /**
+     * Bitmap.compress 回退路径（Native 编码器不可用时）
+     * 
+     * TIFF 没有系统编码器，返回 false
+     */
+    private fun compressWithBitmap(
+        bitmap: Bitmap,
+        config: ExportConfig,
+        outputStream: OutputStream
+    ): Boolean {
+        return when (config.format) {
+            ExportFormat.JPEG -> bitmap.compress(Bitmap.CompressFormat.JPEG, config.quality, outputStream)
+            ExportFormat.PNG -> bitmap.compress(Bitmap.CompressFormat.PNG, 100, outputStream)  // PNG 忽略质量参数
+            ExportFormat.TIFF -> false
+        }
+    }
+    
+    private fun ExportFormat.toEncoderFormat(): ImageEncoderNative.Format = when (this) {
+        ExportFormat.JPEG -> ImageEncoderNative.Format.JPEG
+        ExportFormat.PNG -> ImageEncoderNative.Format.PNG
+        ExportFormat.TIFF -> ImageEncoderNative.Format.TIFF
+    }
 }
@@ -7,6 +7,7 @@ import androidx.compose.ui.platform.LocalContext
 import androidx.lifecycle.viewmodel.compose.viewModel
 import com.filmtracker.app.data.BasicAdjustmentParams
 import com.filmtracker.app.data.mapper.AdjustmentParamsMapper
+import com.filmtracker.app.native.ImageResamplerNative
 import com.filmtracker.app.ui.viewmodel.ProcessingViewModel
 import com.filmtracker.app.ui.viewmodel.ViewModelFactory
 
@@ -45,19 +46,7 @@ fun FilmProcessingScreen(
     val processedThumbnail = remember(processedImage) {
         processedImage?.let { bitmap ->
             // 生成缩略图（最大 400px）
-            val maxSize = 400
-            val scale = minOf(
-                maxSize.toFloat() / bitmap.width,
-                maxSize.toFloat() / bitmap.height,
-                1f
-            )
-            if (scale < 1f) {
-                val newWidth = (bitmap.width * scale).toInt()
-                val newHeight = (bitmap.height * scale).toInt()
-                android.graphics.Bitmap.createScaledBitmap(bitmap, newWidth, newHeight, true)
-            } else {
-                bitmap
-            }
+            ImageResamplerNative.fitWithin(bitmap, 400, ImageResamplerNative.Filter.BOX)
         }
     }
     
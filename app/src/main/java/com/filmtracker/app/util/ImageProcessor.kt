@@ -29,7 +29,6 @@ import java.io.InputStream
 class ImageProcessor(private val context: Context? = null) {
     
     private val rawProcessor = RawProcessorNative()
-    private val processorEngine = ImageProcessorEngineNative()
     private val imageConverter = ImageConverterNative()
     
     suspend fun loadRawPreview(filePath: String): Bitmap? = withContext(Dispatchers.IO) {
@@ -44,59 +43,21 @@ class ImageProcessor(private val context: Context? = null) {
         originalBitmap: Bitmap,
         params: BasicAdjustmentParams
     ): Bitmap? = withContext(Dispatchers.Default) {
-        var nativeParams: BasicAdjustmentParamsNative? = null
+        val linearImage = imageConverter.bitmapToLinear(originalBitmap) ?: return@withContext null
         try {
-            val linearImage = imageConverter.bitmapToLinear(originalBitmap) ?: return@withContext null
-            
-            // 基础调整
-            processorEngine.applyBasicAdjustments(linearImage, params.globalExposure, params.contrast, params.saturation)
-            processorEngine.applyToneAdjustments(linearImage, params.highlights, params.shadows, params.whites, params.blacks)
-            processorEngine.applyPresence(linearImage, params.clarity, params.vibrance)
-            
-            // 需要 nativeParams 的调整
-            val needsNativeParams = params.enableRgbCurve || params.enableRedCurve || 
-                                   params.enableGreenCurve || params.enableBlueCurve ||
-                                   params.enableHSL ||
-                                   params.temperature != 0f || params.tint != 0f ||
-                                   params.gradingHighlightsTemp != 0f || params.gradingHighlightsTint != 0f ||
-                                   params.gradingMidtonesTemp != 0f || params.gradingMidtonesTint != 0f ||
-                                   params.gradingShadowsTemp != 0f || params.gradingShadowsTint != 0f ||
-                                   params.texture != 0f || params.dehaze != 0f || 
-                                   params.vignette != 0f || params.grain != 0f ||
-                                   params.sharpening != 0f || params.noiseReduction != 0f
-            
-            if (needsNativeParams) {
-                nativeParams = convertToNativeParams(params)
-                
-                // 应用曲线
-                if (params.enableRgbCurve || params.enableRedCurve || params.enableGreenCurve || params.enableBlueCurve) {
-                    processorEngine.applyToneCurves(linearImage, nativeParams)
-                }
-                
-                // 应用 HSL
-                if (params.enableHSL) {
-                    processorEngine.applyHSL(linearImage, nativeParams)
-                }
-                
-                // 应用颜色调整
-                processorEngine.applyColorAdjustments(linearImage, nativeParams)
-                
-                // 应用效果
-                processorEngine.applyEffects(linearImage, nativeParams)
-                
-                // 应用细节
-                processorEngine.applyDetails(linearImage, nativeParams)
+            // 单次 Native 调用完成全部调整和 sRGB 输出
+            val output = Bitmap.createBitmap(originalBitmap.width, originalBitmap.height, Bitmap.Config.ARGB_8888)
+            if (RenderPipelineNative.render(linearImage, RenderParamsPacker.pack(params), output)) {
+                output
+            } else {
+                output.recycle()
+                null
             }
-            
-            val result = imageConverter.linearToBitmap(linearImage)
-            imageConverter.release(linearImage)
-            result
         } catch (e: Exception) {
             android.util.Log.e("ImageProcessor", "Error applying adjustments", e)
             null
         } finally {
-            // 确保释放 native 资源
-            nativeParams?.release()
+            imageConverter.release(linearImage)
         }
     }
     
@@ -116,10 +77,7 @@ class ImageProcessor(private val context: Context? = null) {
                         // 预览模式：限制到 1920px，保持较高质量
                         // 非预览模式：使用原图全分辨率
                         if (previewMode && (previewBitmap.width > 1920 || previewBitmap.height > 1920)) {
-                            val scale = minOf(1920f / previewBitmap.width, 1920f / previewBitmap.height)
-                            val scaledWidth = (previewBitmap.width * scale).toInt()
-                            val scaledHeight = (previewBitmap.height * scale).toInt()
-                            scaledPreview = Bitmap.createScaledBitmap(previewBitmap, scaledWidth, scaledHeight, true)
+                            scaledPreview = ImageResamplerNative.fitWithin(previewBitmap, 1920)
                         }
                         return@withContext scaledPreview
                     }
@@ -141,10 +99,7 @@ class ImageProcessor(private val context: Context? = null) {
             // 预览模式：限制到 1920px
             // 非预览模式：使用原图全分辨率
             if (previewMode && (rgbaBitmap.width > 1920 || rgbaBitmap.height > 1920)) {
-                val scale = minOf(1920f / rgbaBitmap.width, 1920f / rgbaBitmap.height)
-                val scaledWidth = (rgbaBitmap.width * scale).toInt()
-                val scaledHeight = (rgbaBitmap.height * scale).toInt()
-                rgbaBitmap = Bitmap.createScaledBitmap(rgbaBitmap, scaledWidth, scaledHeight, true)
+                rgbaBitmap = ImageResamplerNative.fitWithin(rgbaBitmap, 1920)
             }
             
             rgbaBitmap
@@ -153,49 +108,6 @@ class ImageProcessor(private val context: Context? = null) {
         }
     }
     
-    private fun convertToNativeParams(params: BasicAdjustmentParams): BasicAdjustmentParamsNative {
-        val nativeParams = BasicAdjustmentParamsNative.create()
-        
-        // 将 Adobe 标准参数转换为 Native 层需要的乘数
-        val contrastMultiplier = AdobeParameterConverter.contrastToMultiplier(params.contrast)
-        val saturationMultiplier = AdobeParameterConverter.saturationToMultiplier(params.saturation)
-        
-        nativeParams.setParams(
-            params.globalExposure, contrastMultiplier, saturationMultiplier,
-            params.highlights, params.shadows, params.whites, params.blacks,
-            params.clarity, params.vibrance,
-            params.temperature, params.tint,
-            params.gradingHighlightsTemp, params.gradingHighlightsTint,
-            params.gradingMidtonesTemp, params.gradingMidtonesTint,
-            params.gradingShadowsTemp, params.gradingShadowsTint,
-            params.gradingBlending, params.gradingBalance,
-            params.texture, params.dehaze, params.vignette, params.grain,
-            params.sharpening, params.noiseReduction
-        )
-        nativeParams.setAllToneCurves(
-            params.enableRgbCurve, params.rgbCurvePoints,
-            params.enableRedCurve, params.redCurvePoints,
-            params.enableGreenCurve, params.greenCurvePoints,
-            params.enableBlueCurve, params.blueCurvePoints
-        )
-        
-        // 安全地设置 HSL 参数
-        try {
-            // 确保数组不为空且长度正确
-            val hueShift = if (params.hslHueShift.size == 8) params.hslHueShift else FloatArray(8) { 0.0f }
-            val saturation = if (params.hslSaturation.size == 8) params.hslSaturation else FloatArray(8) { 0.0f }
-            val luminance = if (params.hslLuminance.size == 8) params.hslLuminance else FloatArray(8) { 0.0f }
-            
-            nativeParams.setHSL(params.enableHSL, hueShift, saturation, luminance)
-        } catch (e: Exception) {
-            android.util.Log.e("ImageProcessor", "Error setting HSL parameters", e)
-            // 如果出错，禁用 HSL
-            nativeParams.setHSL(false, FloatArray(8) { 0.0f }, FloatArray(8) { 0.0f }, FloatArray(8) { 0.0f })
-        }
-        
-        return nativeParams
-    }
-    
     private fun isRawFileFormat(uri: Uri): Boolean {
         val fileName = getFileName(uri)?.lowercase() ?: return false
         val rawExtensions = listOf(".arw", ".cr2", ".cr3", ".nef", ".raf", ".orf", ".rw2", ".pef", ".srw", ".dng", ".raw")
@@ -0,0 +1,101 @@
+package com.filmtracker.app.util
+
+import com.filmtracker.app.data.BasicAdjustmentParams
+import com.filmtracker.app.native.RenderPipelineNative
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 渲染参数打包
+ *
+ * 把 [BasicAdjustmentParams] 写成 Native 层 RenderParamsLayout 的二进制布局，
+ * 供 [RenderPipelineNative.render] 一次传入。对比度、饱和度在这里转换为 Native 层使用的乘数。
+ */
+object RenderParamsPacker {
+
+    private const val MAX_CURVE_POINTS = 256
+
+    /**
+     * 打包参数
+     *
+     * @param reuse 可复用的直接缓冲区，容量不足时重新分配
+     * @param flags RenderPipelineNative.FLAG_* 组合
+     * @return 直接 ByteBuffer，position = 0，limit = 有效字节数
+     */
+    fun pack(params: BasicAdjustmentParams, flags: Int = 0, reuse: ByteBuffer? = null): ByteBuffer {
+        val curves = listOf(
+            params.enableRgbCurve to params.rgbCurvePoints,
+            params.enableRedCurve to params.redCurvePoints,
+            params.enableGreenCurve to params.greenCurvePoints,
+            params.enableBlueCurve to params.blueCurvePoints
+        ).map { (enabled, points) -> enabled to points.take(MAX_CURVE_POINTS) }
+
+        val size = RenderPipelineNative.PARAMS_HEADER_BYTES +
+            RenderPipelineNative.PARAMS_SCALAR_COUNT * 4 +
+            4 + 24 * 4 +
+            curves.sumOf { 8 + it.second.size * 8 }
+
+        val buffer = if (reuse != null && reuse.isDirect && reuse.capacity() >= size) {
+            reuse.clear()
+            reuse
+        } else {
+            ByteBuffer.allocateDirect(size)
+        }
+        buffer.order(ByteOrder.LITTLE_ENDIAN)
+
+        // 头部
+        buffer.putInt(RenderPipelineNative.PARAMS_MAGIC)
+        buffer.putInt(RenderPipelineNative.PARAMS_VERSION)
+        buffer.putInt(size)
+        buffer.putInt(flags)
+
+        // 标量（顺序与 Native 层 BasicAdjustmentParams 一致）
+        buffer.putFloat(params.globalExposure)
+        buffer.putFloat(AdobeParameterConverter.contrastToMultiplier(params.contrast))
+        buffer.putFloat(AdobeParameterConverter.saturationToMultiplier(params.saturation))
+        buffer.putFloat(params.highlights)
+        buffer.putFloat(params.shadows)
+        buffer.putFloat(params.whites)
+        buffer.putFloat(params.blacks)
+        buffer.putFloat(params.clarity)
+        buffer.putFloat(params.vibrance)
+        buffer.putFloat(params.temperature)
+        buffer.putFloat(params.tint)
+        buffer.putFloat(params.gradingHighlightsTemp)
+        buffer.putFloat(params.gradingHighlightsTint)
+        buffer.putFloat(params.gradingMidtonesTemp)
+        buffer.putFloat(params.gradingMidtonesTint)
+        buffer.putFloat(params.gradingShadowsTemp)
+        buffer.putFloat(params.gradingShadowsTint)
+        buffer.putFloat(params.gradingBlending)
+        buffer.putFloat(params.gradingBalance)
+        buffer.putFloat(params.texture)
+        buffer.putFloat(params.dehaze)
+        buffer.putFloat(params.vignette)
+        buffer.putFloat(params.grain)
+        buffer.putFloat(params.sharpening)
+        buffer.putFloat(params.noiseReduction)
+
+        // HSL（数组长度不对时按禁用处理）
+        val hslValid = params.hslHueShift.size == 8 &&
+            params.hslSaturation.size == 8 &&
+            params.hslLuminance.size == 8
+        buffer.putInt(if (params.enableHSL && hslValid) 1 else 0)
+        for (values in listOf(params.hslHueShift, params.hslSaturation, params.hslLuminance)) {
+            for (i in 0 until 8) {
+                buffer.putFloat(if (hslValid) values[i] else 0f)
+            }
+        }
+
+        // 曲线：RGB、R、G、B
+        for ((enabled, points) in curves) {
+            buffer.putInt(if (enabled && points.isNotEmpty()) 1 else 0)
+            buffer.putInt(points.size)
+            points.forEach { buffer.putFloat(it.first) }
+            points.forEach { buffer.putFloat(it.second) }
+        }
+
+        buffer.flip()
+        return buffer
+    }
+}
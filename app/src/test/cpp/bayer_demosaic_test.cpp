@@ -0,0 +1,346 @@
+#include "bayer_demosaic.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+const char* kPatternNames[4] = {"RGGB", "GRBG", "GBRG", "BGGR"};
+
+// 产品构建使用 -ffast-math，求和顺序可能与参考实现不同（差 1 ulp 量级）
+constexpr float kTolerance = 1e-6f;
+
+inline bool nearlyEqual(float a, float b) {
+    return std::fabs(a - b) <= kTolerance;
+}
+
+/**
+ * 原 RawProcessor::demosaicBayerNormalized 的逐像素实现
+ *
+ * 原实现只处理 RGGB，这里按 CFA 模式平移 R 像素的位置 (rx, ry)，其余公式不变
+ */
+LinearImage referenceBilinear(const std::vector<float>& data, uint32_t width, uint32_t height, uint32_t cfaPattern) {
+    const uint32_t rx = (cfaPattern == 1 || cfaPattern == 3) ? 1 : 0;
+    const uint32_t ry = (cfaPattern == 2 || cfaPattern == 3) ? 1 : 0;
+    LinearImage result(width, height);
+
+    auto at = [&](int32_t px, int32_t py) -> float {
+        if (px < 0 || px >= static_cast<int32_t>(width) ||
+            py < 0 || py >= static_cast<int32_t>(height)) {
+            return 0.0f;
+        }
+        return data[py * width + px];
+    };
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const int32_t ix = static_cast<int32_t>(x);
+            const int32_t iy = static_cast<int32_t>(y);
+            const uint32_t idx = y * width + x;
+            const bool isRedRow = ((y + ry) % 2 == 0);
+            const bool isRedCol = ((x + rx) % 2 == 0);
+            float r, g, b;
+
+            if (isRedRow && isRedCol) {
+                r = data[idx];
+                g = (at(ix - 1, iy) + at(ix + 1, iy) + at(ix, iy - 1) + at(ix, iy + 1)) / 4.0f;
+                b = (at(ix - 1, iy - 1) + at(ix + 1, iy - 1) + at(ix - 1, iy + 1) + at(ix + 1, iy + 1)) / 4.0f;
+            } else if (isRedRow) {
+                g = data[idx];
+                r = (at(ix - 1, iy) + at(ix + 1, iy)) / 2.0f;
+                b = (at(ix, iy - 1) + at(ix, iy + 1)) / 2.0f;
+            } else if (isRedCol) {
+                g = data[idx];
+                r = (at(ix, iy - 1) + at(ix, iy + 1)) / 2.0f;
+                b = (at(ix - 1, iy) + at(ix + 1, iy)) / 2.0f;
+            } else {
+                b = data[idx];
+                g = (at(ix - 1, iy) + at(ix + 1, iy) + at(ix, iy - 1) + at(ix, iy + 1)) / 4.0f;
+                r = (at(ix - 1, iy - 1) + at(ix + 1, iy - 1) + at(ix - 1, iy + 1) + at(ix + 1, iy + 1)) / 4.0f;
+            }
+
+            result.r[idx] = std::max(0.0f, std::min(1.0f, r));
+            result.g[idx] = std::max(0.0f, std::min(1.0f, g));
+            result.b[idx] = std::max(0.0f, std::min(1.0f, b));
+        }
+    }
+    return result;
+}
+
+/**
+ * 逐像素比较（容差 kTolerance），返回不一致的像素数（打印前几个）
+ */
+size_t compareImages(const LinearImage& actual, const LinearImage& expected, const char* label,
+                     uint32_t width, uint32_t height, uint32_t cfaPattern) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < expected.r.size(); ++i) {
+        if (!nearlyEqual(actual.r[i], expected.r[i]) ||
+            !nearlyEqual(actual.g[i], expected.g[i]) ||
+            !nearlyEqual(actual.b[i], expected.b[i])) {
+            if (mismatches < 3) {
+                std::printf("  %s %s %ux%u: mismatch at (%zu, %zu) got (%g, %g, %g) expected (%g, %g, %g)\n",
+                            label, kPatternNames[cfaPattern], width, height, i % width, i / width,
+                            actual.r[i], actual.g[i], actual.b[i],
+                            expected.r[i], expected.g[i], expected.b[i]);
+            }
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * CFA 模式下 2x2 四元组位置 (qx, qy) 的颜色：0=R, 1=G, 2=B
+ */
+int cfaColor(uint32_t cfaPattern, uint32_t qx, uint32_t qy) {
+    const uint32_t rx = (cfaPattern == 1 || cfaPattern == 3) ? 1 : 0;
+    const uint32_t ry = (cfaPattern == 2 || cfaPattern == 3) ? 1 : 0;
+    const bool isRedRow = ((qy + ry) % 2 == 0);
+    const bool isRedCol = ((qx + rx) % 2 == 0);
+    if (isRedRow && isRedCol) return 0;
+    if (!isRedRow && !isRedCol) return 2;
+    return 1;
+}
+
+BayerRawView makeView(const std::vector<uint16_t>& raw, uint32_t width, uint32_t height, uint32_t cfaPattern) {
+    BayerRawView view;
+    view.data = raw.data();
+    view.stride = width;
+    view.width = width;
+    view.height = height;
+    view.cfaPattern = cfaPattern;
+    return view;
+}
+
+std::vector<uint16_t> randomRaw(uint32_t width, uint32_t height, std::mt19937& rng) {
+    std::uniform_int_distribution<uint32_t> rawDist(0, 16383);
+    std::vector<uint16_t> raw(static_cast<size_t>(width) * height);
+    for (uint16_t& value : raw) {
+        value = static_cast<uint16_t>(rawDist(rng));
+    }
+    return raw;
+}
+
+/**
+ * 逐位比较两幅输出（同一输入经不同入口时应完全一致）
+ */
+bool identical(const LinearImage& a, const LinearImage& b) {
+    return a.width == b.width && a.height == b.height && a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+/**
+ * 平场：各通道为常数的马赛克，PPG 内部（距边界 3 像素以外）和双线性内部输出为同一常数
+ */
+size_t checkFlatField(uint32_t width, uint32_t height, uint32_t cfaPattern) {
+    const float channel[3] = {0.6f, 0.4f, 0.2f};
+    const uint16_t level = 8000;
+    std::vector<uint16_t> raw(static_cast<size_t>(width) * height, level);
+    BayerRawView view = makeView(raw, width, height, cfaPattern);
+    for (uint32_t q = 0; q < 4; ++q) {
+        view.scale[q] = channel[cfaColor(cfaPattern, q & 1, q >> 1)] / level;
+    }
+
+    size_t failures = 0;
+    const DemosaicQuality qualities[2] = {DemosaicQuality::BILINEAR, DemosaicQuality::PPG};
+    for (DemosaicQuality quality : qualities) {
+        const uint32_t border = quality == DemosaicQuality::PPG ? 3 : 1;
+        LinearImage output(1, 1);
+        BayerDemosaic::demosaic(view, quality, output);
+        size_t mismatches = 0;
+        for (uint32_t y = border; y + border < height; ++y) {
+            for (uint32_t x = border; x + border < width; ++x) {
+                const size_t idx = static_cast<size_t>(y) * width + x;
+                if (!nearlyEqual(output.r[idx], channel[0]) ||
+                    !nearlyEqual(output.g[idx], channel[1]) ||
+                    !nearlyEqual(output.b[idx], channel[2])) {
+                    if (mismatches == 0) {
+                        std::printf("  flat %s %s %ux%u: (%u, %u) got (%g, %g, %g)\n",
+                                    quality == DemosaicQuality::PPG ? "ppg" : "bilinear",
+                                    kPatternNames[cfaPattern], width, height, x, y,
+                                    output.r[idx], output.g[idx], output.b[idx]);
+                    }
+                    ++mismatches;
+                }
+            }
+        }
+        failures += mismatches > 0 ? 1 : 0;
+    }
+    return failures;
+}
+
+/**
+ * PPG：demosaic(PPG) 与 ppg() 一致，距边界 3 像素以内与双线性一致，输出在 [0, 1] 内
+ *
+ * 小于 7x7 的帧全部是边界像素，整幅应与双线性一致（同时用于检查小帧不越界读取）
+ */
+size_t checkPpg(uint32_t width, uint32_t height, uint32_t cfaPattern, std::mt19937& rng) {
+    const std::vector<uint16_t> raw = randomRaw(width, height, rng);
+    BayerRawView view = makeView(raw, width, height, cfaPattern);
+    std::fill(view.black, view.black + 4, 512.0f);
+    std::fill(view.scale, view.scale + 4, 1.0f / (16383.0f - 512.0f));
+
+    LinearImage ppg(1, 1);
+    LinearImage dispatched(1, 1);
+    LinearImage bilinear(1, 1);
+    BayerDemosaic::ppg(view, ppg);
+    BayerDemosaic::demosaic(view, DemosaicQuality::PPG, dispatched);
+    BayerDemosaic::bilinear(view, bilinear);
+
+    size_t failures = 0;
+    if (!identical(ppg, dispatched)) {
+        std::printf("  ppg %s %ux%u: demosaic(PPG) differs from ppg()\n", kPatternNames[cfaPattern], width, height);
+        ++failures;
+    }
+
+    size_t mismatches = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const size_t idx = static_cast<size_t>(y) * width + x;
+            const float values[3] = {ppg.r[idx], ppg.g[idx], ppg.b[idx]};
+            bool ok = true;
+            for (float value : values) {
+                ok = ok && value >= 0.0f && value <= 1.0f;
+            }
+            const bool nearBorder = x < 3 || y < 3 || x + 3 >= width || y + 3 >= height;
+            if (nearBorder) {
+                ok = ok && nearlyEqual(ppg.r[idx], bilinear.r[idx]) &&
+                     nearlyEqual(ppg.g[idx], bilinear.g[idx]) &&
+                     nearlyEqual(ppg.b[idx], bilinear.b[idx]);
+            }
+            if (!ok) {
+                if (mismatches == 0) {
+                    std::printf("  ppg %s %ux%u: (%u, %u) got (%g, %g, %g) bilinear (%g, %g, %g)\n",
+                                kPatternNames[cfaPattern], width, height, x, y,
+                                ppg.r[idx], ppg.g[idx], ppg.b[idx],
+                                bilinear.r[idx], bilinear.g[idx], bilinear.b[idx]);
+                }
+                ++mismatches;
+            }
+        }
+    }
+    return failures + (mismatches > 0 ? 1 : 0);
+}
+
+/**
+ * hasColorMatrix：与先去马赛克再逐像素乘矩阵（负值截断为 0）的结果一致
+ */
+size_t checkColorMatrix(uint32_t width, uint32_t height, uint32_t cfaPattern, std::mt19937& rng) {
+    const float matrix[9] = {
+         1.6f, -0.4f, -0.2f,
+        -0.3f,  1.5f, -0.2f,
+         0.1f, -0.6f,  1.5f
+    };
+    const std::vector<uint16_t> raw = randomRaw(width, height, rng);
+    BayerRawView view = makeView(raw, width, height, cfaPattern);
+    std::fill(view.scale, view.scale + 4, 1.0f / 16383.0f);
+
+    size_t failures = 0;
+    const DemosaicQuality qualities[2] = {DemosaicQuality::BILINEAR, DemosaicQuality::PPG};
+    for (DemosaicQuality quality : qualities) {
+        LinearImage expected(1, 1);
+        view.hasColorMatrix = false;
+        BayerDemosaic::demosaic(view, quality, expected);
+        for (size_t i = 0; i < expected.r.size(); ++i) {
+            const float r = expected.r[i];
+            const float g = expected.g[i];
+            const float b = expected.b[i];
+            expected.r[i] = std::max(0.0f, matrix[0] * r + matrix[1] * g + matrix[2] * b);
+            expected.g[i] = std::max(0.0f, matrix[3] * r + matrix[4] * g + matrix[5] * b);
+            expected.b[i] = std::max(0.0f, matrix[6] * r + matrix[7] * g + matrix[8] * b);
+        }
+
+        LinearImage actual(1, 1);
+        view.hasColorMatrix = true;
+        std::copy(matrix, matrix + 9, view.colorMatrix);
+        BayerDemosaic::demosaic(view, quality, actual);
+        std::fill(view.colorMatrix, view.colorMatrix + 9, 0.0f);
+        view.colorMatrix[0] = view.colorMatrix[4] = view.colorMatrix[8] = 1.0f;
+        failures += compareImages(actual, expected,
+                                  quality == DemosaicQuality::PPG ? "matrix ppg" : "matrix bilinear",
+                                  width, height, cfaPattern) ? 1 : 0;
+    }
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    // 奇偶尺寸、单行/单列、多于线程数的行带、NEON 8 像素块的尾部
+    const uint32_t sizes[][2] = {
+        {1, 1}, {2, 2}, {3, 3}, {1, 9}, {9, 1}, {5, 7}, {17, 9}, {64, 33}, {101, 57}, {640, 481}
+    };
+
+    std::mt19937 rng(27);
+    size_t failures = 0;
+
+    for (const auto& size : sizes) {
+        const uint32_t width = size[0];
+        const uint32_t height = size[1];
+        for (uint32_t cfaPattern = 0; cfaPattern < 4; ++cfaPattern) {
+            // 浮点入口：包含越界值，验证输出截断
+            std::uniform_real_distribution<float> floatDist(-0.1f, 1.2f);
+            std::vector<float> bayer(static_cast<size_t>(width) * height);
+            for (float& value : bayer) {
+                value = floatDist(rng);
+            }
+            LinearImage expected = referenceBilinear(bayer, width, height, cfaPattern);
+            LinearImage actual(1, 1);
+            BayerDemosaic::bilinear(bayer.data(), width, height, cfaPattern, actual);
+            failures += compareImages(actual, expected, "float", width, height, cfaPattern) ? 1 : 0;
+
+            // uint16 入口：带行跨度和黑电平，与先归一化再插值的结果一致
+            const uint32_t stride = width + 3;
+            const float black = 512.0f;
+            const float scale = 1.0f / (16383.0f - black);
+            std::uniform_int_distribution<uint32_t> rawDist(0, 16383);
+            std::vector<uint16_t> raw(static_cast<size_t>(stride) * height);
+            for (uint16_t& value : raw) {
+                value = static_cast<uint16_t>(rawDist(rng));
+            }
+            std::vector<float> normalized(static_cast<size_t>(width) * height);
+            for (uint32_t y = 0; y < height; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    const float value = (static_cast<float>(raw[y * stride + x]) - black) * scale;
+                    normalized[y * width + x] = std::max(0.0f, std::min(1.0f, value));
+                }
+            }
+
+            BayerRawView view;
+            view.data = raw.data();
+            view.stride = stride;
+            view.width = width;
+            view.height = height;
+            view.cfaPattern = cfaPattern;
+            std::fill(view.black, view.black + 4, black);
+            std::fill(view.scale, view.scale + 4, scale);
+
+            expected = referenceBilinear(normalized, width, height, cfaPattern);
+            BayerDemosaic::bilinear(view, actual);
+            failures += compareImages(actual, expected, "raw", width, height, cfaPattern) ? 1 : 0;
+        }
+    }
+
+    // PPG：各 CFA 模式的平场、边界与小帧（2x2、3x3、5x4 等全部为边界像素）
+    const uint32_t ppgSizes[][2] = {
+        {1, 1}, {2, 2}, {3, 3}, {5, 4}, {4, 5}, {6, 6}, {7, 7}, {9, 8}, {33, 17}, {130, 75}
+    };
+    for (uint32_t cfaPattern = 0; cfaPattern < 4; ++cfaPattern) {
+        failures += checkFlatField(64, 48, cfaPattern);
+        failures += checkFlatField(17, 9, cfaPattern);
+        for (const auto& size : ppgSizes) {
+            failures += checkPpg(size[0], size[1], cfaPattern, rng);
+        }
+        failures += checkColorMatrix(37, 21, cfaPattern, rng);
+    }
+
+    if (failures > 0) {
+        std::printf("bayer_demosaic_test: FAILED (%zu cases)\n", failures);
+        return 1;
+    }
+    std::printf("bayer_demosaic_test: OK\n");
+    return 0;
+}
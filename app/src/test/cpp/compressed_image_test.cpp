@@ -0,0 +1,166 @@
+#include "compressed_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+// HALF_DELTA 的相对误差上限（fp16 尾数 10 位，舍入误差 2^-11 ≈ 4.9e-4）
+constexpr float kHalfRelativeError = 5e-4f;
+
+inline uint32_t bitsOf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * 测试图像：平滑渐变 + 噪声，首个像素起依次放入特殊值
+ *
+ * withSpecials 为 true 时写入 -0、1e30、NaN、±Inf 和非规格化数（只用于无损模式）
+ */
+LinearImage makeImage(uint32_t width, uint32_t height, bool withSpecials, std::mt19937& rng) {
+    LinearImage image(width, height);
+    std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const size_t idx = static_cast<size_t>(y) * width + x;
+            const float base = 0.05f + 0.9f * (static_cast<float>(x + y) / static_cast<float>(width + height));
+            image.r[idx] = base + noise(rng);
+            image.g[idx] = base * 0.5f + noise(rng);
+            image.b[idx] = 2.0f - base + noise(rng);
+        }
+    }
+    if (withSpecials) {
+        const float specials[] = {
+            -0.0f, 1e30f, std::numeric_limits<float>::quiet_NaN(),
+            std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+            std::numeric_limits<float>::denorm_min(), -1e-30f, -3.5f
+        };
+        const size_t count = std::min(sizeof(specials) / sizeof(specials[0]), static_cast<size_t>(width) * height);
+        for (size_t i = 0; i < count; ++i) {
+            image.r[i] = specials[i];
+            image.g[count - 1 - i] = specials[i];
+            image.b[image.b.size() - 1 - i] = specials[i];
+        }
+    }
+    image.provenance = 0x1234;
+    return image;
+}
+
+const char* planeName(int plane) {
+    return plane == 0 ? "r" : (plane == 1 ? "g" : "b");
+}
+
+const std::vector<float>& planeOf(const LinearImage& image, int plane) {
+    return plane == 0 ? image.r : (plane == 1 ? image.g : image.b);
+}
+
+bool checkHeader(const CompressedImage& compressed, const LinearImage& input, const LinearImage& output,
+                 const char* label) {
+    if (compressed.width() != input.width || compressed.height() != input.height ||
+        output.width != input.width || output.height != input.height ||
+        compressed.provenance() != input.provenance || output.provenance != input.provenance) {
+        std::printf("  %s %ux%u: size or provenance mismatch\n", label, input.width, input.height);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 无损模式：逐位一致（比较位模式，-ffast-math 下 NaN 的比较不可靠）
+ */
+bool checkLossless(const LinearImage& input) {
+    auto compressed = CompressedImage::compress(input, CacheCompression::LOSSLESS_DELTA);
+    auto output = compressed->decompress();
+    if (!checkHeader(*compressed, input, *output, "lossless")) {
+        return false;
+    }
+    for (int plane = 0; plane < 3; ++plane) {
+        const std::vector<float>& expected = planeOf(input, plane);
+        const std::vector<float>& actual = planeOf(*output, plane);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (bitsOf(actual[i]) != bitsOf(expected[i])) {
+                std::printf("  lossless %ux%u: %s[%zu] bits 0x%08x expected 0x%08x\n",
+                            input.width, input.height, planeName(plane), i,
+                            bitsOf(actual[i]), bitsOf(expected[i]));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * fp16 模式：相对误差不超过 kHalfRelativeError
+ */
+bool checkHalf(const LinearImage& input) {
+    auto compressed = CompressedImage::compress(input, CacheCompression::HALF_DELTA);
+    // 解压到尺寸不符的调用方缓冲区，验证重新分配
+    LinearImage output(1, 1);
+    compressed->decompress(output);
+    if (!checkHeader(*compressed, input, output, "half")) {
+        return false;
+    }
+    for (int plane = 0; plane < 3; ++plane) {
+        const std::vector<float>& expected = planeOf(input, plane);
+        const std::vector<float>& actual = planeOf(output, plane);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            const float error = std::fabs(actual[i] - expected[i]);
+            if (error > std::fabs(expected[i]) * kHalfRelativeError) {
+                std::printf("  half %ux%u: %s[%zu] got %g expected %g\n",
+                            input.width, input.height, planeName(plane), i, actual[i], expected[i]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    // 单像素、单行/单列、不是编码带（16 行）或残差组（32 个）整数倍的尺寸、多个编码带
+    const uint32_t sizes[][2] = {
+        {1, 1}, {7, 100}, {100, 7}, {1, 33}, {33, 1}, {31, 17}, {32, 16}, {65, 49}, {257, 129}
+    };
+
+    std::mt19937 rng(50);
+    size_t failures = 0;
+
+    for (const auto& size : sizes) {
+        const LinearImage special = makeImage(size[0], size[1], true, rng);
+        failures += checkLossless(special) ? 0 : 1;
+
+        const LinearImage smooth = makeImage(size[0], size[1], false, rng);
+        failures += checkLossless(smooth) ? 0 : 1;
+        failures += checkHalf(smooth) ? 0 : 1;
+    }
+
+    // 压缩率：平滑图像 fp16 模式应明显小于 fp32 平面
+    {
+        LinearImage flat(256, 256);
+        std::fill(flat.r.begin(), flat.r.end(), 0.25f);
+        std::fill(flat.g.begin(), flat.g.end(), 0.5f);
+        std::fill(flat.b.begin(), flat.b.end(), 0.75f);
+        auto compressed = CompressedImage::compress(flat, CacheCompression::HALF_DELTA);
+        if (compressed->compressedBytes() * 4 > compressed->uncompressedBytes()) {
+            std::printf("  half 256x256 flat: %zu bytes of %zu\n",
+                        compressed->compressedBytes(), compressed->uncompressedBytes());
+            ++failures;
+        }
+    }
+
+    if (failures > 0) {
+        std::printf("compressed_image_test: FAILED (%zu cases)\n", failures);
+        return 1;
+    }
+    std::printf("compressed_image_test: OK\n");
+    return 0;
+}
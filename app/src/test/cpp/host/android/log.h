@@ -0,0 +1,17 @@
+#ifndef FILMTRACKER_TEST_ANDROID_LOG_H
+#define FILMTRACKER_TEST_ANDROID_LOG_H
+
+/**
+ * 主机端测试用的 android/log.h：日志直接丢弃
+ */
+
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6
+};
+
+#define __android_log_print(prio, tag, ...) ((void)(prio), (void)(tag), 0)
+
+#endif // FILMTRACKER_TEST_ANDROID_LOG_H
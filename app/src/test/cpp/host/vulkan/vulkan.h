@@ -0,0 +1,29 @@
+#ifndef FILMTRACKER_TEST_VULKAN_H
+#define FILMTRACKER_TEST_VULKAN_H
+
+/**
+ * 主机端测试用的 vulkan/vulkan.h：只声明 vulkan_bilateral_filter.h 用到的句柄和类型，
+ * 实现由 host/vulkan_bilateral_filter_stub.cpp 提供（始终不可用，双边滤波走 CPU 路径）
+ */
+
+#include <cstdint>
+
+#define VK_NULL_HANDLE nullptr
+
+typedef struct VkInstance_T* VkInstance;
+typedef struct VkPhysicalDevice_T* VkPhysicalDevice;
+typedef struct VkDevice_T* VkDevice;
+typedef struct VkQueue_T* VkQueue;
+typedef struct VkCommandPool_T* VkCommandPool;
+typedef struct VkDescriptorPool_T* VkDescriptorPool;
+typedef struct VkPipeline_T* VkPipeline;
+typedef struct VkPipelineLayout_T* VkPipelineLayout;
+typedef struct VkDescriptorSetLayout_T* VkDescriptorSetLayout;
+typedef struct VkShaderModule_T* VkShaderModule;
+typedef struct VkBuffer_T* VkBuffer;
+typedef struct VkDeviceMemory_T* VkDeviceMemory;
+typedef uint64_t VkDeviceSize;
+typedef uint32_t VkBufferUsageFlags;
+typedef uint32_t VkMemoryPropertyFlags;
+
+#endif // FILMTRACKER_TEST_VULKAN_H
@@ -0,0 +1,24 @@
+#include "vulkan_bilateral_filter.h"
+
+/**
+ * 主机端测试用的 VulkanBilateralFilter：GPU 始终不可用，调用方回退到 CPU 实现
+ */
+
+namespace filmtracker {
+
+bool VulkanBilateralFilter::initialize() {
+    return false;
+}
+
+void VulkanBilateralFilter::cleanup() {
+}
+
+bool VulkanBilateralFilter::isAvailable() {
+    return false;
+}
+
+bool VulkanBilateralFilter::apply(const LinearImage&, LinearImage&, float, float) {
+    return false;
+}
+
+} // namespace filmtracker
@@ -0,0 +1,123 @@
+#include "image_converter.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+constexpr uint8_t kGuardByte = 0xA5;
+constexpr size_t kStridePadding = 12;
+
+// 波前同步的竞争只在部分运行中出现，每种线程数重复多次
+constexpr int kRepeats = 5;
+
+/**
+ * 测试图像：缓慢的水平渐变（容易出现断层，误差跨行累积）+ 超过 1 的高光 + 噪声
+ */
+LinearImage makeImage(uint32_t width, uint32_t height) {
+    LinearImage image(width, height);
+    std::mt19937 rng(width * 31u + height);
+    std::uniform_real_distribution<float> noise(0.0f, 0.004f);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const size_t i = static_cast<size_t>(y) * width + x;
+            const float base = static_cast<float>(x) / static_cast<float>(width) * (y < height / 2 ? 0.3f : 1.6f);
+            image.r[i] = base + noise(rng);
+            image.g[i] = base * 0.7f + noise(rng);
+            image.b[i] = 0.02f + base * 0.4f + noise(rng);
+        }
+    }
+    return image;
+}
+
+std::vector<uint8_t> renderDithered(const LinearImage& image, bool softClip, uint32_t threads) {
+    const size_t stride = static_cast<size_t>(image.width) * 4 + kStridePadding;
+    std::vector<uint8_t> out(stride * image.height, kGuardByte);
+    ImageConverter::linearToSRGBDithered(image, out.data(), stride, softClip, threads);
+    return out;
+}
+
+bool paddingIntact(const std::vector<uint8_t>& out, uint32_t width, uint32_t height) {
+    const size_t stride = static_cast<size_t>(width) * 4 + kStridePadding;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* pad = out.data() + y * stride + static_cast<size_t>(width) * 4;
+        if (!std::all_of(pad, pad + kStridePadding, [](uint8_t b) { return b == kGuardByte; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 多线程波前抖动与单线程逐行扫描逐字节一致
+ *
+ * 宽度覆盖小于 / 不整除查表分段的情况，高度覆盖少于线程数的情况
+ */
+void testThreadCountIndependent(uint32_t width, uint32_t height) {
+    const LinearImage image = makeImage(width, height);
+    for (bool softClip : {false, true}) {
+        const std::vector<uint8_t> reference = renderDithered(image, softClip, 1);
+        expect(paddingIntact(reference, width, height), "single-thread output stays within width");
+        for (uint32_t threads : {2u, 3u, 4u, 7u}) {
+            for (int repeat = 0; repeat < kRepeats; ++repeat) {
+                const std::vector<uint8_t> output = renderDithered(image, softClip, threads);
+                if (output != reference) {
+                    size_t firstDiff = 0;
+                    while (firstDiff < output.size() && output[firstDiff] == reference[firstDiff]) {
+                        ++firstDiff;
+                    }
+                    const size_t stride = static_cast<size_t>(width) * 4 + kStridePadding;
+                    std::printf("  %ux%u softClip=%d threads=%u run %d: first difference at row %zu, byte %zu\n",
+                                width, height, softClip, threads, repeat, firstDiff / stride, firstDiff % stride);
+                    expect(false, "multi-thread dither matches single-thread output");
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * 误差跨行传递：同一输入重复两遍（上下两半相同）时，下半部分的输出不应与上半部分逐行相同
+ * （每行重置误差时两半完全一致）
+ */
+void testErrorCarriedAcrossRows() {
+    const uint32_t width = 301;
+    const uint32_t half = 64;
+    LinearImage image(width, half * 2);
+    for (uint32_t y = 0; y < half; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const float v = 0.05f + 0.1f * static_cast<float>(x) / width;
+            for (uint32_t copy = 0; copy < 2; ++copy) {
+                const size_t i = static_cast<size_t>(y + copy * half) * width + x;
+                image.r[i] = v;
+                image.g[i] = v * 0.9f;
+                image.b[i] = v * 0.8f;
+            }
+        }
+    }
+    const std::vector<uint8_t> output = renderDithered(image, false, 4);
+    const size_t stride = static_cast<size_t>(width) * 4 + kStridePadding;
+    const bool halvesEqual = std::equal(output.begin(), output.begin() + stride * half,
+                                        output.begin() + stride * half);
+    expect(!halvesEqual, "dither error carries across rows and bands");
+}
+
+} // namespace
+
+int main() {
+    testThreadCountIndependent(1001, 257);
+    testThreadCountIndependent(4000, 300);
+    testThreadCountIndependent(64, 129);
+    testThreadCountIndependent(3, 40);
+    testThreadCountIndependent(1, 17);
+    testThreadCountIndependent(517, 3);
+    testErrorCarriedAcrossRows();
+
+    return finish("image_converter_test");
+}
@@ -0,0 +1,530 @@
+#include "image_encoder.h"
+#include "half_float.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <jpeglib.h>
+#include <png.h>
+#include <zlib.h>
+
+using namespace filmtracker;
+
+namespace {
+
+/**
+ * 测试图像：平滑渐变 + 亮度噪声（各通道相同，色度保持平滑，4:2:0 也能保持较高 PSNR）
+ *
+ * RGBA_8888 / RGBA_16 为整数样本；RGBA_F16 为 [0, 1] 的半精度值
+ */
+std::vector<uint8_t> makeRows(uint32_t width, uint32_t height, OutputPixelFormat format) {
+    const size_t bpp = ImageConverter::bytesPerPixel(format);
+    std::vector<uint8_t> rows(static_cast<size_t>(width) * height * bpp);
+    std::mt19937 rng(width * 7919u + height);
+    std::uniform_real_distribution<float> noise(-0.03f, 0.03f);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const float fx = static_cast<float>(x) / static_cast<float>(std::max(1u, width - 1));
+            const float fy = static_cast<float>(y) / static_cast<float>(std::max(1u, height - 1));
+            const float n = noise(rng);
+            const float rgb[3] = {
+                std::min(1.0f, std::max(0.0f, 0.1f + 0.8f * fx + n)),
+                std::min(1.0f, std::max(0.0f, 0.1f + 0.8f * fy + n)),
+                std::min(1.0f, std::max(0.0f, 0.5f + 0.3f * (fx - fy) + n))
+            };
+            const size_t idx = (static_cast<size_t>(y) * width + x) * bpp;
+            for (int c = 0; c < 4; ++c) {
+                const float v = c < 3 ? rgb[c] : 1.0f;
+                if (format == OutputPixelFormat::RGBA_8888) {
+                    rows[idx + c] = static_cast<uint8_t>(std::lround(v * 255.0f));
+                } else {
+                    const uint16_t sample = format == OutputPixelFormat::RGBA_16
+                                                ? static_cast<uint16_t>(std::lround(v * 65535.0f))
+                                                : floatToHalf(v);
+                    std::memcpy(&rows[idx + c * 2], &sample, 2);
+                }
+            }
+        }
+    }
+    return rows;
+}
+
+/**
+ * 经 ImageEncoder 编码，每次写入 chunkRows 行（与条带导出一样不按块对齐）
+ */
+bool encode(const EncodeOptions& options, uint32_t width, uint32_t height, const std::vector<uint8_t>& rows,
+            uint32_t chunkRows, std::vector<uint8_t>& file, EncodeStats& stats) {
+    file.clear();
+    ImageEncoder encoder(options, [&file](const uint8_t* data, size_t size) {
+        file.insert(file.end(), data, data + size);
+        return true;
+    });
+    if (!encoder.begin(width, height)) {
+        return false;
+    }
+    const size_t stride = static_cast<size_t>(width) * ImageConverter::bytesPerPixel(options.pixelFormat);
+    for (uint32_t y = 0; y < height; y += chunkRows) {
+        const uint32_t count = std::min(chunkRows, height - y);
+        if (!encoder.writeRows(rows.data() + stride * y, count, stride)) {
+            return false;
+        }
+    }
+    const bool finished = encoder.finish();
+    stats = encoder.getStats();
+    return finished && stats.bytesWritten == file.size();
+}
+
+// ---------------------------------------------------------------------------
+// JPEG
+// ---------------------------------------------------------------------------
+
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    JpegErrorManager* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    std::longjmp(err->jump, 1);
+}
+
+void jpegEmitMessage(j_common_ptr cinfo, int level) {
+    // 损坏的 RST 标记、数据提前结束等都以警告报告
+    if (level < 0) {
+        cinfo->err->num_warnings++;
+    }
+}
+
+/**
+ * 用 libjpeg 解码为 RGB
+ */
+bool decodeJpeg(const std::vector<uint8_t>& file, uint32_t& width, uint32_t& height,
+                std::vector<uint8_t>& rgb, long& warnings) {
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager err;
+    cinfo.err = jpeg_std_error(&err.base);
+    err.base.error_exit = jpegErrorExit;
+    err.base.emit_message = jpegEmitMessage;
+    if (setjmp(err.jump)) {
+        std::printf("  libjpeg: %s\n", err.message);
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char*>(file.data()), static_cast<unsigned long>(file.size()));
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = rgb.data() + static_cast<size_t>(cinfo.output_scanline) * width * 3;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    warnings = err.base.num_warnings;
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+/**
+ * 熵编码段中的 RSTn 标记（SOS 之后，0xFF 后跟 0x00 为填充字节）
+ */
+std::vector<uint8_t> restartMarkers(const std::vector<uint8_t>& file, bool& hasDri) {
+    std::vector<uint8_t> markers;
+    hasDri = false;
+    size_t pos = 2;
+    while (pos + 4 <= file.size() && file[pos] == 0xFF) {
+        const uint8_t type = file[pos + 1];
+        const size_t length = (static_cast<size_t>(file[pos + 2]) << 8) | file[pos + 3];
+        if (type == 0xDD) {
+            hasDri = true;
+        }
+        pos += 2 + length;
+        if (type == 0xDA) {
+            break;
+        }
+    }
+    for (; pos + 1 < file.size(); ++pos) {
+        if (file[pos] == 0xFF && file[pos + 1] >= 0xD0 && file[pos + 1] <= 0xD7) {
+            markers.push_back(file[pos + 1]);
+        }
+    }
+    return markers;
+}
+
+void testJpeg(uint32_t width, uint32_t height, int quality, EncodeColorSpace colorSpace, double minPsnr) {
+    const std::vector<uint8_t> rows = makeRows(width, height, OutputPixelFormat::RGBA_8888);
+    EncodeOptions options;
+    options.format = EncodeFormat::JPEG;
+    options.quality = quality;
+    options.colorSpace = colorSpace;
+    std::vector<uint8_t> file;
+    EncodeStats stats;
+    if (!encode(options, width, height, rows, 37, file, stats)) {
+        std::printf("  JPEG %ux%u q%d: encode failed\n", width, height, quality);
+        expect(false, "JPEG encode");
+        return;
+    }
+
+    // 每块一个 restart interval，RSTn 按 D0..D7 循环
+    bool hasDri = false;
+    const std::vector<uint8_t> markers = restartMarkers(file, hasDri);
+    bool markersInOrder = true;
+    for (size_t i = 0; i < markers.size(); ++i) {
+        markersInOrder = markersInOrder && markers[i] == 0xD0 + (i & 7);
+    }
+
+    uint32_t decodedWidth = 0;
+    uint32_t decodedHeight = 0;
+    std::vector<uint8_t> rgb;
+    long warnings = -1;
+    const bool decoded = decodeJpeg(file, decodedWidth, decodedHeight, rgb, warnings);
+
+    double psnr = 0.0;
+    if (decoded && decodedWidth == width && decodedHeight == height) {
+        double squaredError = 0.0;
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                const double diff = static_cast<double>(rgb[i * 3 + c]) - rows[i * 4 + c];
+                squaredError += diff * diff;
+            }
+        }
+        const double mse = squaredError / (static_cast<double>(width) * height * 3);
+        psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+    }
+
+    const bool ok = decoded && decodedWidth == width && decodedHeight == height && warnings == 0 &&
+                    markers.size() + 1 == stats.blocks && hasDri == (stats.blocks > 1) &&
+                    markersInOrder && psnr >= minPsnr;
+    if (!ok) {
+        std::printf("  JPEG %ux%u q%d: decoded=%d %ux%u warnings=%ld blocks=%u rst=%zu dri=%d psnr=%.2f\n",
+                    width, height, quality, decoded, decodedWidth, decodedHeight, warnings,
+                    stats.blocks, markers.size(), hasDri, psnr);
+    }
+    expect(ok, "JPEG round-trip");
+}
+
+// ---------------------------------------------------------------------------
+// PNG
+// ---------------------------------------------------------------------------
+
+struct PngSource {
+    const std::vector<uint8_t>* file;
+    size_t offset;
+};
+
+void pngRead(png_structp png, png_bytep data, png_size_t length) {
+    PngSource* source = static_cast<PngSource*>(png_get_io_ptr(png));
+    if (source->offset + length > source->file->size()) {
+        png_error(png, "read past end");
+    }
+    std::memcpy(data, source->file->data() + source->offset, length);
+    source->offset += length;
+}
+
+void pngError(png_structp png, png_const_charp message) {
+    std::printf("  libpng: %s\n", message);
+    png_longjmp(png, 1);
+}
+
+void pngWarning(png_structp, png_const_charp message) {
+    std::printf("  libpng warning: %s\n", message);
+}
+
+/**
+ * 用 libpng 解码（16 位样本转为本机字节序）
+ */
+bool decodePng(const std::vector<uint8_t>& file, uint32_t& width, uint32_t& height, int& bitDepth,
+               std::vector<uint8_t>& pixels) {
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, pngError, pngWarning);
+    png_infop info = png_create_info_struct(png);
+    std::vector<png_bytep> rowPointers;
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return false;
+    }
+    PngSource source{&file, 0};
+    png_set_read_fn(png, &source, pngRead);
+    png_read_info(png, info);
+    width = png_get_image_width(png, info);
+    height = png_get_image_height(png, info);
+    bitDepth = png_get_bit_depth(png, info);
+    if (png_get_color_type(png, info) != PNG_COLOR_TYPE_RGB) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return false;
+    }
+    if (bitDepth == 16) {
+        png_set_swap(png);
+    }
+    png_read_update_info(png, info);
+    const size_t rowBytes = png_get_rowbytes(png, info);
+    pixels.resize(rowBytes * height);
+    rowPointers.resize(height);
+    for (uint32_t y = 0; y < height; ++y) {
+        rowPointers[y] = pixels.data() + rowBytes * y;
+    }
+    png_read_image(png, rowPointers.data());
+    png_read_end(png, nullptr);
+    png_destroy_read_struct(&png, &info, nullptr);
+    return true;
+}
+
+/**
+ * 拼接全部 IDAT 并用 zlib 完整解压（校验合并后的 Adler-32）
+ */
+bool inflateIdat(const std::vector<uint8_t>& file, size_t expectedBytes, size_t& idatCount) {
+    std::vector<uint8_t> stream;
+    idatCount = 0;
+    size_t pos = 8;
+    while (pos + 12 <= file.size()) {
+        const uint32_t length = (static_cast<uint32_t>(file[pos]) << 24) | (file[pos + 1] << 16) |
+                                (file[pos + 2] << 8) | file[pos + 3];
+        if (std::memcmp(&file[pos + 4], "IDAT", 4) == 0) {
+            stream.insert(stream.end(), file.begin() + pos + 8, file.begin() + pos + 8 + length);
+            ++idatCount;
+        }
+        pos += 12 + length;
+    }
+    std::vector<uint8_t> raw(expectedBytes + 1);
+    uLongf rawLength = static_cast<uLongf>(raw.size());
+    const int result = uncompress(raw.data(), &rawLength, stream.data(), static_cast<uLong>(stream.size()));
+    return result == Z_OK && rawLength == expectedBytes;
+}
+
+void testPng(uint32_t width, uint32_t height, bool sixteenBit, int level) {
+    const OutputPixelFormat format = sixteenBit ? OutputPixelFormat::RGBA_16 : OutputPixelFormat::RGBA_8888;
+    const std::vector<uint8_t> rows = makeRows(width, height, format);
+    EncodeOptions options;
+    options.format = EncodeFormat::PNG;
+    options.pixelFormat = format;
+    options.compressionLevel = level;
+    options.colorSpace = EncodeColorSpace::SRGB;
+    std::vector<uint8_t> file;
+    EncodeStats stats;
+    if (!encode(options, width, height, rows, 53, file, stats)) {
+        std::printf("  PNG %ux%u %d-bit: encode failed\n", width, height, sixteenBit ? 16 : 8);
+        expect(false, "PNG encode");
+        return;
+    }
+
+    const size_t sampleBytes = sixteenBit ? 2 : 1;
+    size_t idatCount = 0;
+    const bool inflated = inflateIdat(file, (static_cast<size_t>(width) * 3 * sampleBytes + 1) * height, idatCount);
+
+    uint32_t decodedWidth = 0;
+    uint32_t decodedHeight = 0;
+    int bitDepth = 0;
+    std::vector<uint8_t> pixels;
+    const bool decoded = decodePng(file, decodedWidth, decodedHeight, bitDepth, pixels);
+
+    size_t mismatches = 0;
+    if (decoded && decodedWidth == width && decodedHeight == height) {
+        const size_t bpp = ImageConverter::bytesPerPixel(format);
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+            if (std::memcmp(&pixels[i * 3 * sampleBytes], &rows[i * bpp], 3 * sampleBytes) != 0) {
+                ++mismatches;
+            }
+        }
+    }
+
+    // 最后一个 IDAT 只放 Adler-32
+    const bool ok = inflated && decoded && decodedWidth == width && decodedHeight == height &&
+                    bitDepth == (sixteenBit ? 16 : 8) && mismatches == 0 && idatCount == stats.blocks + 1;
+    if (!ok) {
+        std::printf("  PNG %ux%u %d-bit: inflated=%d decoded=%d %ux%u depth=%d mismatches=%zu blocks=%u idat=%zu\n",
+                    width, height, sixteenBit ? 16 : 8, inflated, decoded, decodedWidth, decodedHeight,
+                    bitDepth, mismatches, stats.blocks, idatCount);
+    }
+    expect(ok, "PNG round-trip");
+}
+
+// ---------------------------------------------------------------------------
+// TIFF
+// ---------------------------------------------------------------------------
+
+uint16_t readU16(const std::vector<uint8_t>& file, size_t pos) {
+    return static_cast<uint16_t>(file[pos] | (file[pos + 1] << 8));
+}
+
+uint32_t readU32(const std::vector<uint8_t>& file, size_t pos) {
+    return static_cast<uint32_t>(file[pos]) | (static_cast<uint32_t>(file[pos + 1]) << 8) |
+           (static_cast<uint32_t>(file[pos + 2]) << 16) | (static_cast<uint32_t>(file[pos + 3]) << 24);
+}
+
+/**
+ * LONG 数组标签的值（count 为 1 时值在条目内）
+ */
+std::vector<uint32_t> readLongArray(const std::vector<uint8_t>& file, size_t entry) {
+    const uint32_t count = readU32(file, entry + 4);
+    const uint32_t value = readU32(file, entry + 8);
+    std::vector<uint32_t> values;
+    if (count == 1) {
+        values.push_back(value);
+        return values;
+    }
+    for (uint32_t i = 0; i < count && value + i * 4 + 4 <= file.size(); ++i) {
+        values.push_back(readU32(file, value + i * 4));
+    }
+    return values;
+}
+
+void testTiff(uint32_t width, uint32_t height, OutputPixelFormat format, EncodeColorSpace colorSpace) {
+    const std::vector<uint8_t> rows = makeRows(width, height, format);
+    EncodeOptions options;
+    options.format = EncodeFormat::TIFF;
+    options.pixelFormat = format;
+    options.colorSpace = colorSpace;
+    std::vector<uint8_t> file;
+    EncodeStats stats;
+    if (!encode(options, width, height, rows, 41, file, stats)) {
+        std::printf("  TIFF %ux%u format=%d: encode failed\n", width, height, static_cast<int>(format));
+        expect(false, "TIFF encode");
+        return;
+    }
+
+    bool headerOk = file.size() >= 8 && file[0] == 'I' && file[1] == 'I' && readU16(file, 2) == 42;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> counts;
+    uint32_t imageWidth = 0;
+    uint32_t imageLength = 0;
+    uint32_t rowsPerStrip = 0;
+    if (headerOk) {
+        const uint32_t ifd = readU32(file, 4);
+        const uint16_t entries = readU16(file, ifd);
+        for (uint16_t i = 0; i < entries; ++i) {
+            const size_t entry = ifd + 2 + i * 12;
+            switch (readU16(file, entry)) {
+                case 256: imageWidth = readU32(file, entry + 8); break;
+                case 257: imageLength = readU32(file, entry + 8); break;
+                case 273: offsets = readLongArray(file, entry); break;
+                case 278: rowsPerStrip = readU32(file, entry + 8); break;
+                case 279: counts = readLongArray(file, entry); break;
+                default: break;
+            }
+        }
+    }
+
+    // 条带数、每条带字节数与文件长度一致，条带首尾相接并以文件末尾结束
+    const size_t packedRowBytes = static_cast<size_t>(width) * 3 * (format == OutputPixelFormat::RGBA_8888 ? 1 : 2);
+    const uint32_t expectedStrips = rowsPerStrip > 0 ? (height + rowsPerStrip - 1) / rowsPerStrip : 0;
+    bool layoutOk = headerOk && imageWidth == width && imageLength == height && rowsPerStrip > 0 &&
+                    offsets.size() == expectedStrips && counts.size() == expectedStrips &&
+                    expectedStrips == stats.blocks;
+    for (size_t i = 0; layoutOk && i < offsets.size(); ++i) {
+        const uint32_t stripRows = std::min(rowsPerStrip, height - static_cast<uint32_t>(i) * rowsPerStrip);
+        layoutOk = counts[i] == packedRowBytes * stripRows &&
+                   static_cast<uint64_t>(offsets[i]) + counts[i] <= file.size() &&
+                   (i == 0 || offsets[i] == offsets[i - 1] + counts[i - 1]);
+    }
+    layoutOk = layoutOk && !offsets.empty() &&
+               static_cast<uint64_t>(offsets.back()) + counts.back() == file.size();
+
+    size_t mismatches = 0;
+    if (layoutOk) {
+        const size_t bpp = ImageConverter::bytesPerPixel(format);
+        const size_t sampleBytes = format == OutputPixelFormat::RGBA_8888 ? 1 : 2;
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+            if (std::memcmp(&file[offsets[0] + i * 3 * sampleBytes], &rows[i * bpp], 3 * sampleBytes) != 0) {
+                ++mismatches;
+            }
+        }
+    }
+
+    const bool ok = layoutOk && mismatches == 0;
+    if (!ok) {
+        std::printf("  TIFF %ux%u format=%d: header=%d layout=%d strips=%zu/%zu rowsPerStrip=%u "
+                    "fileBytes=%zu mismatches=%zu\n",
+                    width, height, static_cast<int>(format), headerOk, layoutOk, offsets.size(), counts.size(),
+                    rowsPerStrip, file.size(), mismatches);
+    }
+    expect(ok, "TIFF strip layout");
+}
+
+// ---------------------------------------------------------------------------
+// 工作线程
+// ---------------------------------------------------------------------------
+
+/**
+ * 块按顺序写出：1 个和多个工作线程的输出逐字节一致；未 finish 就析构时停止工作线程
+ */
+void testWorkerCountIndependent(EncodeFormat format, OutputPixelFormat pixelFormat, const char* name) {
+    const uint32_t width = 611;
+    const uint32_t height = 1333;
+    const std::vector<uint8_t> rows = makeRows(width, height, pixelFormat);
+    EncodeOptions options;
+    options.format = format;
+    options.pixelFormat = pixelFormat;
+
+    std::vector<uint8_t> reference;
+    EncodeStats referenceStats;
+    options.maxThreads = 1;
+    const bool referenceOk = encode(options, width, height, rows, 97, reference, referenceStats);
+    for (uint32_t threads : {2u, 4u, 7u}) {
+        options.maxThreads = threads;
+        std::vector<uint8_t> file;
+        EncodeStats stats;
+        const bool ok = referenceOk && encode(options, width, height, rows, 97, file, stats);
+        if (!ok || file != reference || stats.blocks != referenceStats.blocks) {
+            std::printf("  %s with %u workers: ok=%d, %zu vs %zu bytes, %u vs %u blocks\n", name, threads, ok,
+                        file.size(), reference.size(), stats.blocks, referenceStats.blocks);
+            expect(false, "encoder output independent of worker count");
+        }
+    }
+
+    // 只写入一部分行就析构：排队的块被丢弃，正在压缩的块完成后 join
+    options.maxThreads = 4;
+    std::vector<uint8_t> partial;
+    {
+        ImageEncoder encoder(options, [&partial](const uint8_t* data, size_t size) {
+            partial.insert(partial.end(), data, data + size);
+            return true;
+        });
+        const size_t stride = static_cast<size_t>(width) * ImageConverter::bytesPerPixel(pixelFormat);
+        expect(encoder.begin(width, height) && encoder.writeRows(rows.data(), height / 2, stride),
+               "partial encode accepted");
+    }
+    expect(partial.size() < reference.size(), "abandoned encoder writes a prefix only");
+}
+
+} // namespace
+
+int main() {
+    // JPEG：4:4:4（质量 >= 90）与 4:2:0，宽高都不是 MCU 的整数倍；
+    // 宽度不同时每个 restart interval 的 MCU 数也不同，高度覆盖单块、多块和超过 8 块（RSTn 回绕）
+    testJpeg(37, 23, 95, EncodeColorSpace::NONE, 36.0);
+    testJpeg(1001, 700, 95, EncodeColorSpace::SRGB, 36.0);
+    testJpeg(2050, 517, 95, EncodeColorSpace::NONE, 36.0);
+    testJpeg(1003, 3001, 92, EncodeColorSpace::NONE, 36.0);
+    testJpeg(45, 29, 75, EncodeColorSpace::NONE, 33.0);
+    testJpeg(1001, 700, 75, EncodeColorSpace::SRGB, 33.0);
+    testJpeg(1537, 2777, 80, EncodeColorSpace::NONE, 33.0);
+
+    // PNG：8 / 16 位，单块和跨多块（块首行滤波依赖上一块最后一行）
+    testPng(31, 17, false, 6);
+    testPng(1000, 800, false, 6);
+    testPng(777, 1200, false, 1);
+    testPng(29, 19, true, 6);
+    testPng(700, 600, true, 6);
+    testPng(1301, 333, true, 9);
+
+    // TIFF：单条带（偏移在条目内）和多条带，最后一个条带较短
+    testTiff(33, 21, OutputPixelFormat::RGBA_8888, EncodeColorSpace::NONE);
+    testTiff(1000, 800, OutputPixelFormat::RGBA_8888, EncodeColorSpace::SRGB);
+    testTiff(777, 501, OutputPixelFormat::RGBA_16, EncodeColorSpace::NONE);
+    testTiff(640, 450, OutputPixelFormat::RGBA_F16, EncodeColorSpace::LINEAR_SRGB);
+
+    // 工作线程数不影响输出（自动模式在单核机器上只有一个线程，这里显式指定）
+    testWorkerCountIndependent(EncodeFormat::JPEG, OutputPixelFormat::RGBA_8888, "JPEG");
+    testWorkerCountIndependent(EncodeFormat::PNG, OutputPixelFormat::RGBA_16, "PNG");
+    testWorkerCountIndependent(EncodeFormat::TIFF, OutputPixelFormat::RGBA_8888, "TIFF");
+
+    return finish("image_encoder_test");
+}
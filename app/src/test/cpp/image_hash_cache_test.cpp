@@ -0,0 +1,234 @@
+#include "image_hash_cache.h"
+#include "compressed_image.h"
+#include "memory_governor.h"
+#include "provenance.h"
+#include "result_spill_cache.h"
+#include "test_util.h"
+#include <sys/resource.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+constexpr size_t kShardCount = 8;
+
+ImageHashCache::HashKey makeKey(uint64_t imageHash) {
+    return ImageHashCache::HashKey{imageHash, 2.0f, 0.1f, 0};
+}
+
+/**
+ * 与 ImageHashCache::shardFor 相同的分片选择，用于挑选落在不同分片的键
+ */
+size_t shardOf(const ImageHashCache::HashKey& key) {
+    const uint64_t h = static_cast<uint64_t>(ImageHashCache::HashKeyHash{}(key)) * xxh64::kPrime1;
+    return (h >> 59) & (kShardCount - 1);
+}
+
+/**
+ * 各自落在不同分片的 count 个键
+ */
+std::vector<ImageHashCache::HashKey> keysInDistinctShards(size_t count) {
+    std::vector<ImageHashCache::HashKey> keys;
+    bool used[kShardCount] = {};
+    for (uint64_t hash = 1; keys.size() < count; ++hash) {
+        const ImageHashCache::HashKey key = makeKey(hash * 0x9E3779B97F4A7C15ULL);
+        const size_t shard = shardOf(key);
+        if (!used[shard]) {
+            used[shard] = true;
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+std::shared_ptr<const LinearImage> makeImage(uint32_t width, uint32_t height, float value) {
+    auto image = std::make_shared<LinearImage>(width, height);
+    std::fill(image->r.begin(), image->r.end(), value);
+    std::fill(image->g.begin(), image->g.end(), value * 0.5f);
+    std::fill(image->b.begin(), image->b.end(), value * 0.25f);
+    return image;
+}
+
+size_t fp32Bytes(uint32_t width, uint32_t height) {
+    return static_cast<size_t>(width) * height * 3 * sizeof(float);
+}
+
+/**
+ * 已驱逐的是全局最久未使用的条目，而不是新条目所在分片的尾部
+ */
+void testEvictionOrderAcrossShards(ImageHashCache& cache) {
+    cache.clear();
+    cache.setCompression(CacheCompression::NONE);
+    cache.setMaxSize(4);
+
+    const std::vector<ImageHashCache::HashKey> keys = keysInDistinctShards(6);
+    for (size_t i = 0; i < 4; ++i) {
+        cache.insert(keys[i], makeImage(8, 8, static_cast<float>(i)));
+    }
+    // 访问 0 号后最久未使用的是 1 号、2 号
+    expect(cache.find(keys[0]) != nullptr, "entry 0 present before eviction");
+    cache.insert(keys[4], makeImage(8, 8, 4.0f));
+    cache.insert(keys[5], makeImage(8, 8, 5.0f));
+
+    expect(cache.size() == 4, "size stays at the limit");
+    expect(cache.getStats().evictions == 2, "two evictions");
+    expect(cache.find(keys[1]) == nullptr, "entry 1 evicted first");
+    expect(cache.find(keys[2]) == nullptr, "entry 2 evicted second");
+    expect(cache.find(keys[0]) != nullptr, "recently used entry 0 kept");
+    expect(cache.find(keys[3]) != nullptr, "entry 3 kept");
+    expect(cache.find(keys[4]) != nullptr, "entry 4 kept");
+    expect(cache.find(keys[5]) != nullptr, "entry 5 kept");
+
+    std::shared_ptr<const LinearImage> hit = cache.find(keys[5]);
+    expect(hit && hit->r[0] == 5.0f, "hit returns the inserted buffer");
+}
+
+/**
+ * clear() 之后缓存和 MemoryGovernor 的 CACHES 计数都回到 0
+ */
+void testClearReleasesMemory(ImageHashCache& cache, CacheCompression compression) {
+    MemoryGovernor& governor = MemoryGovernor::getInstance();
+    cache.clear();
+    cache.setCompression(compression);
+    cache.setMaxSize(16);
+
+    const std::vector<ImageHashCache::HashKey> keys = keysInDistinctShards(kShardCount);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        cache.insert(keys[i], makeImage(32, 24, 0.1f * static_cast<float>(i + 1)));
+    }
+    expect(cache.memoryUsage() > 0, "memory charged after insert");
+    expect(governor.usage(MemoryCategory::CACHES) == cache.memoryUsage(), "governor matches memoryUsage");
+
+    cache.clear();
+    expect(cache.size() == 0, "no entries after clear");
+    expect(cache.memoryUsage() == 0, "memoryUsage is 0 after clear");
+    expect(cache.getStats().logicalBytes == 0, "logicalBytes is 0 after clear");
+    expect(governor.usage(MemoryCategory::CACHES) == 0, "governor CACHES is 0 after clear");
+}
+
+/**
+ * 替换同一个键时减去旧条目的大小
+ */
+void testReplaceSubtractsOldEntry(ImageHashCache& cache, CacheCompression compression) {
+    MemoryGovernor& governor = MemoryGovernor::getInstance();
+    cache.clear();
+    cache.setCompression(compression);
+    cache.setMaxSize(16);
+
+    const ImageHashCache::HashKey key = makeKey(42);
+    std::shared_ptr<const LinearImage> large = makeImage(64, 48, 0.5f);
+    std::shared_ptr<const LinearImage> small = makeImage(16, 8, 0.25f);
+    const size_t smallBytes = compression == CacheCompression::NONE
+        ? fp32Bytes(small->width, small->height)
+        : CompressedImage::compress(*small, compression)->compressedBytes();
+
+    cache.insert(key, large);
+    const size_t largeUsage = cache.memoryUsage();
+    cache.insert(key, small);
+
+    expect(cache.size() == 1, "replacement keeps one entry");
+    expect(cache.memoryUsage() == smallBytes, "memoryUsage equals the replacement entry");
+    expect(cache.memoryUsage() < largeUsage, "old entry size subtracted");
+    expect(cache.getStats().logicalBytes == fp32Bytes(small->width, small->height), "logicalBytes equals the replacement");
+    expect(governor.usage(MemoryCategory::CACHES) == smallBytes, "governor equals the replacement entry");
+
+    std::shared_ptr<const LinearImage> hit = cache.find(key);
+    expect(hit && hit->width == small->width && hit->height == small->height, "find returns the replacement");
+
+    cache.clear();
+    expect(governor.usage(MemoryCategory::CACHES) == 0, "governor CACHES is 0 after clear");
+}
+
+/**
+ * 目录中唯一的溢出文件路径
+ */
+std::string findSpillFile(const std::string& dir) {
+    std::string found;
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return found;
+    }
+    while (struct dirent* entry = readdir(d)) {
+        const size_t length = std::strlen(entry->d_name);
+        if (length > 4 && std::strcmp(entry->d_name + length - 4, ".fsc") == 0) {
+            found = dir + "/" + entry->d_name;
+        }
+    }
+    closedir(d);
+    return found;
+}
+
+/**
+ * 溢出文件暂时打不开（文件描述符耗尽）只算未命中，条目保留；文件损坏才删除
+ */
+void testSpillReadFailureKeepsEntry() {
+    char dirTemplate[] = "/tmp/spill_test_XXXXXX";
+    const char* dir = mkdtemp(dirTemplate);
+    expect(dir != nullptr, "create spill directory");
+    if (!dir) {
+        return;
+    }
+    ResultSpillCache& spill = ResultSpillCache::getInstance();
+    expect(spill.initialize(dir, 64), "initialize spill cache");
+
+    const ImageHashCache::HashKey key = makeKey(0xABCDEF);
+    spill.spill(key, makeImage(40, 30, 0.75f));
+    spill.flush();
+    expect(spill.getStats().entryCount == 1, "spilled entry written");
+    expect(MemoryGovernor::getInstance().usage(MemoryCategory::CACHES) == 0, "queue charge released after write");
+
+    // 软限制设为当前最小空闲描述符，之后的 open 返回 EMFILE
+    struct rlimit original;
+    getrlimit(RLIMIT_NOFILE, &original);
+    const int probe = open("/dev/null", O_RDONLY);
+    close(probe);
+    struct rlimit limited = original;
+    limited.rlim_cur = static_cast<rlim_t>(probe);
+    const bool limitedOk = probe >= 0 && setrlimit(RLIMIT_NOFILE, &limited) == 0;
+    std::shared_ptr<const LinearImage> miss = spill.find(key);
+    setrlimit(RLIMIT_NOFILE, &original);
+    expect(limitedOk, "lower RLIMIT_NOFILE");
+    expect(miss == nullptr, "find misses while files cannot be opened");
+    expect(spill.getStats().entryCount == 1, "entry kept after transient open failure");
+
+    std::shared_ptr<const LinearImage> hit = spill.find(key);
+    expect(hit && hit->width == 40 && hit->height == 30 && hit->r[0] == 0.75f, "entry readable after limit restored");
+
+    // 截断的文件是真正的损坏，删除条目和文件
+    const std::string path = findSpillFile(dir);
+    expect(!path.empty() && truncate(path.c_str(), 100) == 0, "truncate spill file");
+    expect(spill.find(key) == nullptr, "truncated entry misses");
+    expect(spill.getStats().entryCount == 0, "truncated entry removed from index");
+    expect(findSpillFile(dir).empty(), "truncated file deleted");
+
+    spill.clear();
+    unlink((std::string(dir) + "/spill.version").c_str());
+    rmdir(dir);
+}
+
+} // namespace
+
+int main() {
+    ImageHashCache& cache = ImageHashCache::getInstance();
+    cache.setMaxMemoryMB(64);
+
+    testEvictionOrderAcrossShards(cache);
+    for (CacheCompression compression : {CacheCompression::NONE, CacheCompression::HALF_DELTA,
+                                         CacheCompression::LOSSLESS_DELTA}) {
+        testClearReleasesMemory(cache, compression);
+        testReplaceSubtractsOldEntry(cache, compression);
+    }
+    testSpillReadFailureKeepsEntry();
+
+    return finish("image_hash_cache_test");
+}
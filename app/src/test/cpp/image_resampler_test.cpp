@@ -0,0 +1,221 @@
+#include "image_resampler.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+// 归一化权重的累加误差上限（-ffast-math 下求和顺序可能变化）
+constexpr float kConstantTolerance = 1e-5f;
+
+const char* filterName(ResampleFilter filter) {
+    switch (filter) {
+        case ResampleFilter::BOX: return "box";
+        case ResampleFilter::BICUBIC: return "bicubic";
+        case ResampleFilter::LANCZOS3: return "lanczos3";
+    }
+    return "?";
+}
+
+LinearImage makeConstant(uint32_t width, uint32_t height, float r, float g, float b) {
+    LinearImage image(width, height);
+    std::fill(image.r.begin(), image.r.end(), r);
+    std::fill(image.g.begin(), image.g.end(), g);
+    std::fill(image.b.begin(), image.b.end(), b);
+    return image;
+}
+
+float maxDeviation(const std::vector<float>& plane, float value) {
+    float deviation = 0.0f;
+    for (float v : plane) {
+        deviation = std::max(deviation, std::fabs(v - value));
+    }
+    return deviation;
+}
+
+struct SizeCase {
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+};
+
+// 缩小、放大和两个方向相反的缩放；输出高度都不是 32（行块高度）的整数倍，最后一块较短
+const SizeCase kSizeCases[] = {
+    {257, 131, 64, 33},
+    {100, 100, 37, 71},
+    {13, 7, 97, 70},
+    {50, 40, 200, 161},
+    {640, 480, 1, 1},
+    {1, 1, 5, 3},
+};
+
+const ResampleFilter kFilters[] = {ResampleFilter::BOX, ResampleFilter::BICUBIC, ResampleFilter::LANCZOS3};
+
+/**
+ * 常数图像缩放后仍是同一常数（权重归一化，越界部分折叠到边缘），输出尺寸与请求一致
+ */
+void testConstantPreserved() {
+    const float r = 0.37f;
+    const float g = 1.75f;
+    const float b = 0.002f;
+    for (const SizeCase& c : kSizeCases) {
+        const LinearImage src = makeConstant(c.srcWidth, c.srcHeight, r, g, b);
+        for (ResampleFilter filter : kFilters) {
+            const LinearImage dst = ImageResampler::resize(src, c.dstWidth, c.dstHeight, filter);
+            const size_t pixels = static_cast<size_t>(c.dstWidth) * c.dstHeight;
+            const bool sizeOk = dst.width == c.dstWidth && dst.height == c.dstHeight &&
+                                dst.r.size() == pixels && dst.g.size() == pixels && dst.b.size() == pixels;
+            const float deviation = sizeOk ? std::max({maxDeviation(dst.r, r), maxDeviation(dst.g, g),
+                                                       maxDeviation(dst.b, b)})
+                                           : 0.0f;
+            if (!sizeOk || deviation > kConstantTolerance * g) {
+                std::printf("  %s %ux%u -> %ux%u: got %ux%u, max deviation %g\n", filterName(filter),
+                            c.srcWidth, c.srcHeight, c.dstWidth, c.dstHeight, dst.width, dst.height, deviation);
+            }
+            expect(sizeOk, "resize output dimensions");
+            expect(deviation <= kConstantTolerance * g, "resize preserves constant image");
+        }
+    }
+}
+
+/**
+ * 行块交错分配给线程：单线程与多线程结果逐位一致
+ */
+void testThreadCountIndependent() {
+    LinearImage src(301, 257);
+    for (size_t i = 0; i < src.r.size(); ++i) {
+        src.r[i] = static_cast<float>(i % 97) / 97.0f;
+        src.g[i] = static_cast<float>((i * 7) % 131) / 131.0f;
+        src.b[i] = static_cast<float>((i * 13) % 61) / 61.0f;
+    }
+    for (ResampleFilter filter : kFilters) {
+        for (const SizeCase& size : {SizeCase{0, 0, 123, 101}, SizeCase{0, 0, 500, 333}}) {
+            const LinearImage single = ImageResampler::resize(src, size.dstWidth, size.dstHeight, filter, 1);
+            const LinearImage multi = ImageResampler::resize(src, size.dstWidth, size.dstHeight, filter, 4);
+            const bool same = single.r == multi.r && single.g == multi.g && single.b == multi.b;
+            if (!same) {
+                std::printf("  %s -> %ux%u: 1-thread and 4-thread output differ\n", filterName(filter),
+                            size.dstWidth, size.dstHeight);
+            }
+            expect(same, "resize independent of thread count");
+        }
+    }
+}
+
+/**
+ * RGBA8：常数颜色保持不变，只写 dstWidth * 4 字节，行尾填充不变
+ */
+void testRgba8ConstantAndStride() {
+    const uint8_t color[4] = {200, 17, 96, 255};
+    const uint8_t guard = 0xA5;
+    for (const SizeCase& c : kSizeCases) {
+        const size_t srcStride = static_cast<size_t>(c.srcWidth) * 4 + 12;
+        const size_t dstStride = static_cast<size_t>(c.dstWidth) * 4 + 8;
+        std::vector<uint8_t> src(srcStride * c.srcHeight, 0);
+        for (uint32_t y = 0; y < c.srcHeight; ++y) {
+            for (uint32_t x = 0; x < c.srcWidth; ++x) {
+                std::memcpy(&src[y * srcStride + x * 4], color, 4);
+            }
+        }
+        for (ResampleFilter filter : kFilters) {
+            std::vector<uint8_t> dst(dstStride * c.dstHeight, guard);
+            ImageResampler::resizeRgba8(src.data(), c.srcWidth, c.srcHeight, srcStride,
+                                        dst.data(), c.dstWidth, c.dstHeight, dstStride, filter);
+            size_t wrongPixels = 0;
+            size_t touchedPadding = 0;
+            for (uint32_t y = 0; y < c.dstHeight; ++y) {
+                const uint8_t* row = &dst[y * dstStride];
+                for (uint32_t x = 0; x < c.dstWidth; ++x) {
+                    if (std::memcmp(row + x * 4, color, 4) != 0) {
+                        ++wrongPixels;
+                    }
+                }
+                for (size_t i = static_cast<size_t>(c.dstWidth) * 4; i < dstStride; ++i) {
+                    if (row[i] != guard) {
+                        ++touchedPadding;
+                    }
+                }
+            }
+            if (wrongPixels > 0 || touchedPadding > 0) {
+                std::printf("  rgba8 %s %ux%u -> %ux%u: %zu wrong pixels, %zu padding bytes written\n",
+                            filterName(filter), c.srcWidth, c.srcHeight, c.dstWidth, c.dstHeight,
+                            wrongPixels, touchedPadding);
+            }
+            expect(wrongPixels == 0, "resizeRgba8 preserves constant color");
+            expect(touchedPadding == 0, "resizeRgba8 stays within dstWidth");
+        }
+    }
+}
+
+/**
+ * 整数倍块平均：输出尺寸为 ceil(size / factor)，边缘不完整的块只对有效像素平均
+ */
+void testDownsampleBlocks() {
+    LinearImage src(67, 35);
+    for (uint32_t y = 0; y < src.height; ++y) {
+        for (uint32_t x = 0; x < src.width; ++x) {
+            const size_t idx = static_cast<size_t>(y) * src.width + x;
+            src.r[idx] = static_cast<float>(x);
+            src.g[idx] = static_cast<float>(y);
+            src.b[idx] = 0.5f;
+        }
+    }
+    LinearImage dst(0, 0);
+    ImageResampler::downsampleBlocks(src, dst, 4);
+    expect(dst.width == 17 && dst.height == 9, "downsampleBlocks output dimensions");
+    if (dst.width != 17 || dst.height != 9) {
+        return;
+    }
+    // 第一块 x = 0..3 平均 1.5；最后一列只有 x = 64..66，平均 65
+    const size_t last = static_cast<size_t>(dst.height - 1) * dst.width + dst.width - 1;
+    expect(std::fabs(dst.r[0] - 1.5f) < 1e-4f && std::fabs(dst.g[0] - 1.5f) < 1e-4f, "downsampleBlocks full block");
+    expect(std::fabs(dst.r[last] - 65.0f) < 1e-4f && std::fabs(dst.g[last] - 33.0f) < 1e-4f,
+           "downsampleBlocks partial edge block");
+    expect(maxDeviation(dst.b, 0.5f) < 1e-6f, "downsampleBlocks preserves constant plane");
+}
+
+/**
+ * 来源标识：缩放结果由源来源、输出尺寸和滤波器决定；同尺寸直接沿用；匿名源的结果也匿名
+ */
+void testProvenance() {
+    LinearImage src = makeConstant(120, 80, 0.5f, 0.5f, 0.5f);
+    src.provenance = 0x1234ABCDull;
+
+    const LinearImage a = ImageResampler::resize(src, 60, 40, ResampleFilter::LANCZOS3);
+    const LinearImage again = ImageResampler::resize(src, 60, 40, ResampleFilter::LANCZOS3);
+    const LinearImage otherFilter = ImageResampler::resize(src, 60, 40, ResampleFilter::BOX);
+    const LinearImage otherSize = ImageResampler::resize(src, 61, 40, ResampleFilter::LANCZOS3);
+    const LinearImage sameSize = ImageResampler::resize(src, 120, 80, ResampleFilter::LANCZOS3);
+
+    expect(a.provenance != 0 && a.provenance != src.provenance, "resized provenance derived from source");
+    expect(a.provenance == again.provenance, "resized provenance deterministic");
+    expect(a.provenance != otherFilter.provenance, "resized provenance depends on filter");
+    expect(a.provenance != otherSize.provenance, "resized provenance depends on size");
+    expect(sameSize.provenance == src.provenance, "same-size copy keeps provenance");
+
+    LinearImage blocks(0, 0);
+    ImageResampler::downsampleBlocks(src, blocks, 2);
+    expect(blocks.provenance != 0 && blocks.provenance != a.provenance, "block downsample provenance");
+
+    src.provenance = 0;
+    expect(ImageResampler::resize(src, 60, 40, ResampleFilter::LANCZOS3).provenance == 0,
+           "anonymous source stays anonymous");
+}
+
+} // namespace
+
+int main() {
+    testConstantPreserved();
+    testThreadCountIndependent();
+    testRgba8ConstantAndStride();
+    testDownsampleBlocks();
+    testProvenance();
+
+    return finish("image_resampler_test");
+}
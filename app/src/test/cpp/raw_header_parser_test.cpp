@@ -0,0 +1,487 @@
+#include "raw_header_parser.h"
+#include "test_util.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+// TIFF 字段类型
+constexpr uint16_t kAscii = 2;
+constexpr uint16_t kShort = 3;
+constexpr uint16_t kLong = 4;
+constexpr uint16_t kRational = 5;
+
+// 内嵌预览 / 原始图像尺寸
+constexpr uint16_t kPreviewWidth = 256;
+constexpr uint16_t kPreviewHeight = 171;
+
+/**
+ * 最小的 JPEG 流：SOI + SOF0（尺寸）+ EOI，可选在 SOF 前放一个 APP1 Exif 段
+ */
+Bytes makeJpeg(uint16_t width, uint16_t height, const Bytes& exifTiff = Bytes()) {
+    Bytes jpeg = {0xFF, 0xD8};
+    if (!exifTiff.empty()) {
+        const size_t length = 2 + 6 + exifTiff.size();
+        jpeg.insert(jpeg.end(), {0xFF, 0xE1, static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length),
+                                 'E', 'x', 'i', 'f', 0, 0});
+        jpeg.insert(jpeg.end(), exifTiff.begin(), exifTiff.end());
+    }
+    jpeg.insert(jpeg.end(), {0xFF, 0xC0, 0x00, 0x11, 0x08,
+                             static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+                             static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width), 0x03,
+                             0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01,
+                             0xFF, 0xD9});
+    return jpeg;
+}
+
+/**
+ * IFD 条目：值不超过 4 字节时内联，否则追加到 IFD 之后；count 单独给出（用于构造损坏的计数）
+ */
+struct Entry {
+    uint16_t tag;
+    uint16_t type;
+    uint32_t count;
+    Bytes value;
+};
+
+/**
+ * 小端 TIFF 构造器：先追加数据和子 IFD，最后写 IFD0 并回填文件头中的偏移
+ */
+class TiffBuilder {
+public:
+    TiffBuilder() : m_bytes({'I', 'I', 42, 0, 0, 0, 0, 0}) {}
+
+    static Bytes u16(uint16_t value) {
+        return {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)};
+    }
+
+    static Bytes u32(uint32_t value) {
+        return {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+                static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+    }
+
+    static Entry shortEntry(uint16_t tag, uint16_t value) { return {tag, kShort, 1, u16(value)}; }
+    static Entry longEntry(uint16_t tag, uint32_t value) { return {tag, kLong, 1, u32(value)}; }
+
+    static Entry rationalEntry(uint16_t tag, uint32_t numerator, uint32_t denominator) {
+        Bytes value = u32(numerator);
+        const Bytes d = u32(denominator);
+        value.insert(value.end(), d.begin(), d.end());
+        return {tag, kRational, 1, value};
+    }
+
+    static Entry asciiEntry(uint16_t tag, const char* text) {
+        Bytes value(text, text + std::strlen(text) + 1);
+        return {tag, kAscii, static_cast<uint32_t>(value.size()), value};
+    }
+
+    uint32_t append(const Bytes& data) {
+        align();
+        const uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+        m_bytes.insert(m_bytes.end(), data.begin(), data.end());
+        return offset;
+    }
+
+    uint32_t addIfd(const std::vector<Entry>& entries, uint32_t next = 0) {
+        align();
+        const uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+        uint32_t dataOffset = offset + 2 + static_cast<uint32_t>(entries.size()) * 12 + 4;
+        Bytes table = u16(static_cast<uint16_t>(entries.size()));
+        Bytes data;
+        for (const Entry& entry : entries) {
+            put(table, u16(entry.tag));
+            put(table, u16(entry.type));
+            put(table, u32(entry.count));
+            if (entry.value.size() <= 4) {
+                Bytes inlineValue = entry.value;
+                inlineValue.resize(4, 0);
+                put(table, inlineValue);
+            } else {
+                put(table, u32(dataOffset + static_cast<uint32_t>(data.size())));
+                put(data, entry.value);
+                data.resize((data.size() + 1) & ~size_t(1), 0);
+            }
+        }
+        put(table, u32(next));
+        put(m_bytes, table);
+        put(m_bytes, data);
+        return offset;
+    }
+
+    void setFirstIfd(uint32_t offset) { patchU32(4, offset); }
+
+    void patchU32(size_t at, uint32_t value) {
+        const Bytes v = u32(value);
+        std::memcpy(&m_bytes[at], v.data(), 4);
+    }
+
+    const Bytes& bytes() const { return m_bytes; }
+
+private:
+    static void put(Bytes& dst, const Bytes& src) { dst.insert(dst.end(), src.begin(), src.end()); }
+    void align() { m_bytes.resize((m_bytes.size() + 1) & ~size_t(1), 0); }
+
+    Bytes m_bytes;
+};
+
+/**
+ * DNG 样例的各个可调部分
+ */
+struct DngOptions {
+    uint32_t isoCount = 1;          // 损坏的计数：0x80000001 个 SHORT 按 32 位相乘会回绕成 2 字节
+    uint32_t makeCount = 0;         // 0 = 正常长度
+    bool loopChain = false;         // IFD0 的下一个 IFD 指回自己
+    bool loopSubIfd = false;        // SubIFD 指回 IFD0
+};
+
+struct DngFixture {
+    Bytes bytes;
+    uint32_t jpegOffset;
+    uint32_t jpegLength;
+};
+
+/**
+ * DNG：IFD0 为 JPEG 预览（方向 6），SubIFD 为 6000x4000 CFA，Exif IFD 含 ISO / 快门 / 光圈 / 焦距
+ */
+DngFixture makeDng(const DngOptions& options = DngOptions()) {
+    TiffBuilder tiff;
+    const Bytes jpeg = makeJpeg(kPreviewWidth, kPreviewHeight);
+    const uint32_t jpegOffset = tiff.append(jpeg);
+
+    const uint32_t rawOffset = tiff.append(Bytes(64, 0x55));
+    const uint32_t subIfd = tiff.addIfd({
+        TiffBuilder::longEntry(0x00FE, 0),
+        TiffBuilder::longEntry(0x0100, 6000),
+        TiffBuilder::longEntry(0x0101, 4000),
+        TiffBuilder::shortEntry(0x0102, 16),
+        TiffBuilder::shortEntry(0x0103, 1),
+        TiffBuilder::shortEntry(0x0106, 32803),
+        TiffBuilder::longEntry(0x0111, rawOffset),
+        TiffBuilder::longEntry(0x0117, 64),
+    });
+
+    const uint32_t exifIfd = tiff.addIfd({
+        TiffBuilder::rationalEntry(0x829A, 1, 250),
+        TiffBuilder::rationalEntry(0x829D, 28, 10),
+        Entry{0x8827, kShort, options.isoCount, TiffBuilder::u16(400)},
+        TiffBuilder::rationalEntry(0x920A, 50, 1),
+    });
+
+    Entry make = TiffBuilder::asciiEntry(0x010F, "Leica Camera AG");
+    if (options.makeCount != 0) {
+        make.count = options.makeCount;
+    }
+    // IFD0 的偏移在写入前就确定：当前末尾（2 字节对齐）
+    const uint32_t ifd0 = static_cast<uint32_t>((tiff.bytes().size() + 1) & ~size_t(1));
+    tiff.addIfd({
+        TiffBuilder::longEntry(0x00FE, 1),
+        TiffBuilder::longEntry(0x0100, kPreviewWidth),
+        TiffBuilder::longEntry(0x0101, kPreviewHeight),
+        TiffBuilder::shortEntry(0x0102, 8),
+        TiffBuilder::shortEntry(0x0103, 7),
+        TiffBuilder::shortEntry(0x0106, 6),
+        make,
+        TiffBuilder::asciiEntry(0x0110, "M11"),
+        TiffBuilder::longEntry(0x0111, jpegOffset),
+        TiffBuilder::shortEntry(0x0112, 6),
+        TiffBuilder::longEntry(0x0117, static_cast<uint32_t>(jpeg.size())),
+        TiffBuilder::longEntry(0x014A, options.loopSubIfd ? ifd0 : subIfd),
+        TiffBuilder::longEntry(0x8769, exifIfd),
+        Entry{0xC612, 1, 4, {1, 4, 0, 0}},
+    }, options.loopChain ? ifd0 : 0);
+    tiff.setFirstIfd(ifd0);
+    return {tiff.bytes(), jpegOffset, static_cast<uint32_t>(jpeg.size())};
+}
+
+/**
+ * ISO BMFF box（大端）
+ */
+Bytes box(const char* type, const Bytes& payload) {
+    const uint32_t size = static_cast<uint32_t>(8 + payload.size());
+    Bytes out = {static_cast<uint8_t>(size >> 24), static_cast<uint8_t>(size >> 16),
+                 static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size)};
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+Bytes be32(uint32_t value) {
+    return {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+}
+
+Bytes concat(std::initializer_list<Bytes> parts) {
+    Bytes out;
+    for (const Bytes& part : parts) {
+        out.insert(out.end(), part.begin(), part.end());
+    }
+    return out;
+}
+
+/**
+ * CR3 轨道：stsd 中一个 CRAW 样本项（宽高位于 +32 / +34，子 box 从 +90 开始）+ stsz + stco
+ */
+Bytes cr3Track(uint16_t width, uint16_t height, const char* codec, uint32_t sampleSize, uint32_t chunkOffset) {
+    Bytes entryPayload(90 - 8, 0);
+    entryPayload[32 - 8] = static_cast<uint8_t>(width >> 8);
+    entryPayload[33 - 8] = static_cast<uint8_t>(width);
+    entryPayload[34 - 8] = static_cast<uint8_t>(height >> 8);
+    entryPayload[35 - 8] = static_cast<uint8_t>(height);
+    const Bytes child = box(codec, Bytes());
+    entryPayload.insert(entryPayload.end(), child.begin(), child.end());
+
+    const Bytes stsd = box("stsd", concat({be32(0), be32(1), box("CRAW", entryPayload)}));
+    const Bytes stsz = box("stsz", concat({be32(0), be32(sampleSize), be32(1)}));
+    const Bytes stco = box("stco", concat({be32(0), be32(1), be32(chunkOffset)}));
+    return box("trak", box("mdia", box("minf", box("stbl", concat({stsd, stsz, stco})))));
+}
+
+struct Cr3Fixture {
+    Bytes bytes;
+    uint32_t jpegOffset;
+    uint32_t jpegLength;
+};
+
+/**
+ * CR3：ftyp + mdat（预览 JPEG）+ moov（Canon uuid 内的 CMT1 / CMT2，预览轨道和 RAW 轨道）
+ */
+Cr3Fixture makeCr3() {
+    const Bytes ftyp = box("ftyp", {'c', 'r', 'x', ' ', 0, 0, 0, 1, 'c', 'r', 'x', ' '});
+    const Bytes jpeg = makeJpeg(1620, 1080);
+    const Bytes mdat = box("mdat", jpeg);
+    const uint32_t jpegOffset = static_cast<uint32_t>(ftyp.size() + 8);
+
+    TiffBuilder cmt1;
+    cmt1.setFirstIfd(cmt1.addIfd({
+        TiffBuilder::asciiEntry(0x010F, "Canon"),
+        TiffBuilder::asciiEntry(0x0110, "Canon EOS R5"),
+        TiffBuilder::shortEntry(0x0112, 8),
+    }));
+    TiffBuilder cmt2;
+    cmt2.setFirstIfd(cmt2.addIfd({
+        TiffBuilder::rationalEntry(0x829A, 1, 1000),
+        TiffBuilder::shortEntry(0x8827, 800),
+    }));
+
+    static const uint8_t kCanonUuid[16] = {0x85, 0xC0, 0xB6, 0x87, 0x82, 0x0F, 0x11, 0xE0,
+                                           0x81, 0x11, 0xF4, 0xCE, 0x46, 0x2B, 0x6A, 0x48};
+    const Bytes canon = box("uuid", concat({Bytes(kCanonUuid, kCanonUuid + 16),
+                                            box("CMT1", cmt1.bytes()), box("CMT2", cmt2.bytes())}));
+    const Bytes moov = box("moov", concat({canon,
+                                           cr3Track(1620, 1080, "JPEG", static_cast<uint32_t>(jpeg.size()), jpegOffset),
+                                           cr3Track(8192, 5464, "CMP1", 4096, jpegOffset)}));
+    return {concat({ftyp, mdat, moov}), jpegOffset, static_cast<uint32_t>(jpeg.size())};
+}
+
+struct RafFixture {
+    Bytes bytes;
+    uint32_t jpegOffset;
+    uint32_t jpegLength;
+};
+
+/**
+ * RAF：固定文件头 + 偏移表，内嵌 JPEG 的 APP1 中带 Exif（ISO 3200、方向 3），CFA 头目录给出 6240x4160
+ */
+RafFixture makeRaf() {
+    Bytes raf(160, 0);
+    std::memcpy(raf.data(), "FUJIFILMCCD-RAW 0201FF393101", 28);
+    std::memcpy(raf.data() + 28, "X-T5", 4);
+
+    TiffBuilder exif;
+    exif.setFirstIfd(exif.addIfd({
+        TiffBuilder::shortEntry(0x0112, 3),
+        TiffBuilder::shortEntry(0x8827, 3200),
+    }));
+    const Bytes jpeg = makeJpeg(1920, 1280, exif.bytes());
+    const uint32_t jpegOffset = static_cast<uint32_t>(raf.size());
+    raf.insert(raf.end(), jpeg.begin(), jpeg.end());
+
+    const uint32_t cfaOffset = static_cast<uint32_t>(raf.size());
+    const Bytes cfa = concat({be32(2),
+                              {0x01, 0x30, 0x00, 0x04, 0xAA, 0xBB, 0xCC, 0xDD},
+                              {0x01, 0x00, 0x00, 0x04, 0x10, 0x40, 0x18, 0x60}});
+    raf.insert(raf.end(), cfa.begin(), cfa.end());
+
+    const Bytes offsets = concat({be32(jpegOffset), be32(static_cast<uint32_t>(jpeg.size())), be32(cfaOffset)});
+    std::memcpy(raf.data() + 84, offsets.data(), offsets.size());
+    return {raf, jpegOffset, static_cast<uint32_t>(jpeg.size())};
+}
+
+/**
+ * 按精确长度复制后解析：越界读取会落在堆缓冲区之外（AddressSanitizer 可检出）
+ */
+bool parseCopy(const Bytes& bytes, size_t length, RawFileInfo& info) {
+    const Bytes copy(bytes.begin(), bytes.begin() + length);
+    return RawHeaderParser::parseBuffer(copy.data(), copy.size(), info);
+}
+
+void testDng() {
+    const DngFixture dng = makeDng();
+    RawFileInfo info;
+    expect(RawHeaderParser::parseBuffer(dng.bytes.data(), dng.bytes.size(), info), "DNG recognized");
+    expect(std::strcmp(info.format, "DNG") == 0, "DNG format");
+    expect(info.width == 6000 && info.height == 4000, "DNG raw dimensions from CFA SubIFD");
+    expect(info.orientation == 6, "DNG orientation");
+    expect(info.iso == 400.0f, "DNG ISO from Exif IFD");
+    expect(info.exposureTime > 0.0039f && info.exposureTime < 0.0041f, "DNG exposure time");
+    expect(info.aperture > 2.79f && info.aperture < 2.81f, "DNG aperture");
+    expect(std::strcmp(info.make, "Leica Camera AG") == 0 && std::strcmp(info.model, "M11") == 0, "DNG make / model");
+    expect(info.previewOffset == dng.jpegOffset && info.previewLength == dng.jpegLength, "DNG preview location");
+    expect(info.previewWidth == kPreviewWidth && info.previewHeight == kPreviewHeight, "DNG preview dimensions");
+}
+
+/**
+ * 文件路径 / 文件描述符路径（pread + 开头块缓存）与内存缓冲区结果一致，截断的文件不越界
+ */
+void testDngFromFile() {
+    const DngFixture dng = makeDng();
+    char path[] = "/tmp/raw_header_parser_test_XXXXXX";
+    const int fd = mkstemp(path);
+    expect(fd >= 0, "create temporary file");
+    if (fd < 0) {
+        return;
+    }
+    expect(write(fd, dng.bytes.data(), dng.bytes.size()) == static_cast<ssize_t>(dng.bytes.size()),
+           "write temporary file");
+
+    RawFileInfo info;
+    expect(RawHeaderParser::parse(path, info), "DNG file recognized");
+    expect(info.width == 6000 && info.height == 4000 && info.orientation == 6 && info.iso == 400.0f,
+           "DNG file fields");
+    expect(info.previewOffset == dng.jpegOffset, "DNG file preview offset");
+
+    // 截断到 IFD0 之前：不能识别，也不能读到文件之外
+    expect(ftruncate(fd, 12) == 0, "truncate temporary file");
+    expect(!RawHeaderParser::parseFd(fd, info), "truncated DNG file rejected");
+
+    close(fd);
+    unlink(path);
+    expect(!RawHeaderParser::parse(path, info), "missing file rejected");
+}
+
+void testCr3() {
+    const Cr3Fixture cr3 = makeCr3();
+    RawFileInfo info;
+    expect(RawHeaderParser::parseBuffer(cr3.bytes.data(), cr3.bytes.size(), info), "CR3 recognized");
+    expect(std::strcmp(info.format, "CR3") == 0, "CR3 format");
+    expect(info.width == 8192 && info.height == 5464, "CR3 raw dimensions from CMP1 track");
+    expect(info.orientation == 8, "CR3 orientation from CMT1");
+    expect(info.iso == 800.0f, "CR3 ISO from CMT2");
+    expect(std::strcmp(info.model, "Canon EOS R5") == 0, "CR3 model");
+    expect(info.previewOffset == cr3.jpegOffset && info.previewLength == cr3.jpegLength, "CR3 preview location");
+    expect(info.previewWidth == 1620 && info.previewHeight == 1080, "CR3 preview dimensions");
+}
+
+void testRaf() {
+    const RafFixture raf = makeRaf();
+    RawFileInfo info;
+    expect(RawHeaderParser::parseBuffer(raf.bytes.data(), raf.bytes.size(), info), "RAF recognized");
+    expect(std::strcmp(info.format, "RAF") == 0, "RAF format");
+    expect(info.width == 6240 && info.height == 4160, "RAF raw dimensions from CFA header");
+    expect(info.orientation == 3, "RAF orientation from embedded Exif");
+    expect(info.iso == 3200.0f, "RAF ISO from embedded Exif");
+    expect(std::strcmp(info.make, "FUJIFILM") == 0 && std::strcmp(info.model, "X-T5") == 0, "RAF make / model");
+    expect(info.previewOffset == raf.jpegOffset && info.previewLength == raf.jpegLength, "RAF preview location");
+    expect(info.previewWidth == 1920 && info.previewHeight == 1280, "RAF preview dimensions");
+}
+
+/**
+ * 每个长度的截断：8 字节以下都不能识别；越界的偏移不能成为预览位置
+ */
+void testTruncated() {
+    const std::vector<Bytes> fixtures = {makeDng().bytes, makeCr3().bytes, makeRaf().bytes};
+    for (const Bytes& bytes : fixtures) {
+        bool previewInBounds = true;
+        bool shortRejected = true;
+        for (size_t length = 1; length < bytes.size(); ++length) {
+            RawFileInfo info;
+            const bool recognized = parseCopy(bytes, length, info);
+            if (length < 8 && recognized) {
+                shortRejected = false;
+            }
+            if (info.previewLength > 0 && info.previewOffset + info.previewLength > length) {
+                previewInBounds = false;
+            }
+        }
+        expect(shortRejected, "header-only prefixes rejected");
+        expect(previewInBounds, "truncated file never reports a preview past the end");
+    }
+    RawFileInfo info;
+    expect(!RawHeaderParser::parseBuffer(nullptr, 0, info), "empty buffer rejected");
+    const Bytes garbage(4096, 0x5A);
+    expect(!RawHeaderParser::parseBuffer(garbage.data(), garbage.size(), info), "unknown container rejected");
+}
+
+/**
+ * IFD 链 / SubIFD 指回自己时解析终止，结果与正常文件一致
+ */
+void testLoopingIfd() {
+    DngOptions chain;
+    chain.loopChain = true;
+    const Bytes chained = makeDng(chain).bytes;
+    RawFileInfo info;
+    expect(RawHeaderParser::parseBuffer(chained.data(), chained.size(), info), "looping IFD chain terminates");
+    expect(info.width == 6000 && info.height == 4000 && info.orientation == 6, "looping IFD chain fields");
+
+    DngOptions sub;
+    sub.loopSubIfd = true;
+    const Bytes subLoop = makeDng(sub).bytes;
+    expect(RawHeaderParser::parseBuffer(subLoop.data(), subLoop.size(), info), "looping SubIFD terminates");
+    expect(info.width == 0 && info.height == 0, "looping SubIFD has no raw image");
+}
+
+/**
+ * 条目数超过上限的 IFD 整个丢弃
+ */
+void testTooManyEntries() {
+    Bytes bytes = {'I', 'I', 42, 0, 8, 0, 0, 0, 0x58, 0x02};   // IFD0 声明 600 个条目
+    bytes.resize(8 + 2 + 600 * 12 + 4, 0);
+    for (size_t i = 0; i < 600; ++i) {
+        bytes[10 + i * 12] = 0x00;
+        bytes[11 + i * 12] = 0x01;       // ImageWidth
+        bytes[12 + i * 12] = kShort;
+        bytes[14 + i * 12] = 1;
+        bytes[18 + i * 12] = 0x40;
+    }
+    RawFileInfo info;
+    expect(!parseCopy(bytes, bytes.size(), info), "IFD with too many entries rejected");
+}
+
+/**
+ * 巨大的 count：值大小超出文件的条目被跳过，不按 32 位回绕后的大小当作内联值读取
+ */
+void testHugeCount() {
+    DngOptions options;
+    options.isoCount = 0x80000001u;
+    options.makeCount = 0xFFFFFFFFu;
+    const Bytes bytes = makeDng(options).bytes;
+    RawFileInfo info;
+    expect(parseCopy(bytes, bytes.size(), info), "DNG with huge counts recognized");
+    expect(info.width == 6000 && info.height == 4000, "huge counts keep raw dimensions");
+    expect(info.iso == 0.0f, "ISO entry with huge count ignored");
+    expect(info.make[0] == '\0', "Make entry with huge count ignored");
+}
+
+} // namespace
+
+int main() {
+    testDng();
+    testDngFromFile();
+    testCr3();
+    testRaf();
+    testTruncated();
+    testLoopingIfd();
+    testTooManyEntries();
+    testHugeCount();
+
+    return finish("raw_header_parser_test");
+}
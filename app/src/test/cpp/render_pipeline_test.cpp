@@ -0,0 +1,326 @@
+#include "render_pipeline.h"
+#include "image_converter.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace filmtracker;
+
+namespace {
+
+constexpr uint8_t kGuardByte = 0xA5;
+
+/**
+ * 与 RenderParamsPacker.pack 相同的布局（小端）
+ */
+class ParamsWriter {
+public:
+    void putU32(uint32_t value) {
+        const size_t offset = m_data.size();
+        m_data.resize(offset + 4);
+        std::memcpy(m_data.data() + offset, &value, 4);
+    }
+
+    void putFloat(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        putU32(bits);
+    }
+
+    std::vector<uint8_t>& data() { return m_data; }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+struct PackedCurve {
+    bool enabled;
+    std::vector<float> x;
+    std::vector<float> y;
+};
+
+/**
+ * 打包参数：scalars 按 RenderParamsLayout 的标量顺序，对比度、饱和度为乘数
+ */
+std::vector<uint8_t> packParams(const float (&scalars)[RenderParamsLayout::kScalarCount],
+                                const PackedCurve& rgbCurve, uint32_t flags) {
+    ParamsWriter writer;
+    writer.putU32(RenderParamsLayout::kMagic);
+    writer.putU32(RenderParamsLayout::kVersion);
+    writer.putU32(0);   // totalSize，最后回填
+    writer.putU32(flags);
+    for (float value : scalars) {
+        writer.putFloat(value);
+    }
+    writer.putU32(0);   // HSL 禁用
+    for (int i = 0; i < 24; ++i) {
+        writer.putFloat(0.0f);
+    }
+    const PackedCurve empty{false, {}, {}};
+    for (const PackedCurve* curve : {&rgbCurve, &empty, &empty, &empty}) {
+        writer.putU32(curve->enabled ? 1 : 0);
+        writer.putU32(static_cast<uint32_t>(curve->x.size()));
+        for (float x : curve->x) writer.putFloat(x);
+        for (float y : curve->y) writer.putFloat(y);
+    }
+    std::vector<uint8_t>& data = writer.data();
+    const uint32_t totalSize = static_cast<uint32_t>(data.size());
+    std::memcpy(data.data() + 8, &totalSize, 4);
+    return data;
+}
+
+/**
+ * 中性参数：全部为 0，对比度 / 饱和度乘数为 1，分级混合 50
+ */
+void neutralScalars(float (&scalars)[RenderParamsLayout::kScalarCount]) {
+    std::fill(std::begin(scalars), std::end(scalars), 0.0f);
+    scalars[1] = 1.0f;      // contrast
+    scalars[2] = 1.0f;      // saturation
+    scalars[17] = 50.0f;    // gradingBlending
+}
+
+/**
+ * 合成源图像：水平 / 垂直渐变，覆盖 0~1.2 的线性范围
+ */
+LinearImage makeView(uint32_t width, uint32_t height) {
+    LinearImage view(width, height);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const size_t idx = static_cast<size_t>(y) * width + x;
+            view.r[idx] = 1.2f * static_cast<float>(x) / static_cast<float>(width - 1);
+            view.g[idx] = static_cast<float>(y) / static_cast<float>(height - 1);
+            view.b[idx] = 0.25f;
+        }
+    }
+    return view;
+}
+
+/**
+ * 输出缓冲区，每行末尾留 guard 字节检查越界写入
+ */
+struct OutputBuffer {
+    std::vector<uint8_t> bytes;
+    RenderBuffer buffer;
+
+    OutputBuffer(uint32_t width, uint32_t height, OutputPixelFormat format) {
+        const size_t rowBytes = static_cast<size_t>(width) * ImageConverter::bytesPerPixel(format);
+        buffer.width = width;
+        buffer.height = height;
+        buffer.stride = rowBytes + 16;
+        buffer.format = format;
+        bytes.assign(buffer.stride * height, kGuardByte);
+        buffer.pixels = bytes.data();
+    }
+
+    bool guardsIntact() const {
+        const size_t rowBytes = static_cast<size_t>(buffer.width) * ImageConverter::bytesPerPixel(buffer.format);
+        for (uint32_t y = 0; y < buffer.height; ++y) {
+            const uint8_t* row = bytes.data() + y * buffer.stride;
+            if (!std::all_of(row + rowBytes, row + buffer.stride, [](uint8_t b) { return b == kGuardByte; })) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * 每像素 alpha 是否为不透明
+     */
+    bool alphaOpaque() const {
+        for (uint32_t y = 0; y < buffer.height; ++y) {
+            const uint8_t* row = bytes.data() + y * buffer.stride;
+            for (uint32_t x = 0; x < buffer.width; ++x) {
+                bool opaque = false;
+                switch (buffer.format) {
+                    case OutputPixelFormat::RGBA_8888:
+                        opaque = row[x * 4 + 3] == 0xFF;
+                        break;
+                    case OutputPixelFormat::RGBA_16: {
+                        uint16_t a;
+                        std::memcpy(&a, row + x * 8 + 6, 2);
+                        opaque = a == 0xFFFF;
+                        break;
+                    }
+                    case OutputPixelFormat::RGBA_F16: {
+                        uint16_t a;
+                        std::memcpy(&a, row + x * 8 + 6, 2);
+                        opaque = a == 0x3C00;   // 1.0
+                        break;
+                    }
+                    case OutputPixelFormat::RGBA_1010102: {
+                        uint32_t packed;
+                        std::memcpy(&packed, row + x * 4, 4);
+                        opaque = (packed >> 30) == 3;
+                        break;
+                    }
+                }
+                if (!opaque) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * 打包参数解析：标量、曲线和标志逐项还原，损坏的缓冲区被拒绝
+ */
+void testUnpack() {
+    float scalars[RenderParamsLayout::kScalarCount];
+    neutralScalars(scalars);
+    scalars[0] = 0.75f;     // globalExposure
+    scalars[24] = 12.0f;    // noiseReduction
+    const PackedCurve curve{true, {0.0f, 0.5f, 1.0f}, {0.0f, 0.6f, 1.0f}};
+    std::vector<uint8_t> packed = packParams(scalars, curve, RENDER_FLAG_DITHER);
+
+    BasicAdjustmentParams params;
+    uint32_t flags = 0;
+    expect(RenderPipeline::unpackParams(packed.data(), packed.size(), params, flags), "unpack packed params");
+    expect(flags == RENDER_FLAG_DITHER, "flags round-trip");
+    expect(params.globalExposure == 0.75f && params.contrast == 1.0f &&
+           params.gradingBlending == 50.0f && params.noiseReduction == 12.0f, "scalars round-trip");
+    expect(params.hslParams && !params.hslParams->enableHSL, "HSL disabled");
+    expect(params.curveParams && params.curveParams->rgbCurve.enabled &&
+           params.curveParams->rgbCurve.pointCount == 3 &&
+           params.curveParams->rgbCurve.yCoords[1] == 0.6f, "RGB curve round-trip");
+    expect(params.curveParams && !params.curveParams->redCurve.enabled, "empty curve disabled");
+
+    BasicAdjustmentParams rejected;
+    expect(!RenderPipeline::unpackParams(packed.data(), packed.size() - 4, rejected, flags),
+           "reject truncated buffer");
+    std::vector<uint8_t> badMagic = packed;
+    badMagic[0] ^= 0xFF;
+    expect(!RenderPipeline::unpackParams(badMagic.data(), badMagic.size(), rejected, flags),
+           "reject bad magic");
+    std::vector<uint8_t> badVersion = packed;
+    badVersion[4] = static_cast<uint8_t>(RenderParamsLayout::kVersion + 1);
+    expect(!RenderPipeline::unpackParams(badVersion.data(), badVersion.size(), rejected, flags),
+           "reject newer version");
+}
+
+/**
+ * 中性参数、同尺寸渲染与直接 sRGB 编码一致
+ */
+void testNeutralMatchesConverter() {
+    const LinearImage view = makeView(64, 48);
+    float scalars[RenderParamsLayout::kScalarCount];
+    neutralScalars(scalars);
+    std::vector<uint8_t> packed = packParams(scalars, PackedCurve{false, {}, {}}, 0);
+
+    BasicAdjustmentParams params;
+    uint32_t flags = 0;
+    expect(RenderPipeline::unpackParams(packed.data(), packed.size(), params, flags), "unpack neutral params");
+
+    RenderPipeline pipeline;
+    OutputBuffer output(view.width, view.height, OutputPixelFormat::RGBA_8888);
+    expect(pipeline.render(view, params, output.buffer, flags), "neutral render");
+
+    std::vector<uint8_t> expected(static_cast<size_t>(view.width) * view.height * 4);
+    ImageConverter::writePixels(view, OutputPixelFormat::RGBA_8888, expected.data(), view.width * 4);
+    size_t mismatches = 0;
+    for (uint32_t y = 0; y < view.height; ++y) {
+        const uint8_t* row = output.bytes.data() + y * output.buffer.stride;
+        const uint8_t* ref = expected.data() + static_cast<size_t>(y) * view.width * 4;
+        for (size_t i = 0; i < static_cast<size_t>(view.width) * 4; ++i) {
+            if (std::abs(static_cast<int>(row[i]) - static_cast<int>(ref[i])) > 1) {
+                ++mismatches;
+            }
+        }
+    }
+    if (mismatches > 0) {
+        std::printf("  neutral render: %zu channel values differ from writePixels\n", mismatches);
+    }
+    expect(mismatches == 0, "neutral render matches writePixels");
+    expect(output.guardsIntact(), "neutral render stays within stride");
+}
+
+/**
+ * 缩放到输出尺寸，每种输出格式写满 width * bpp 并保持行尾不变
+ */
+void testFormatsAndSizes() {
+    const LinearImage view = makeView(97, 61);
+    float scalars[RenderParamsLayout::kScalarCount];
+    neutralScalars(scalars);
+    scalars[0] = 0.5f;      // globalExposure
+    scalars[1] = 1.2f;      // contrast
+    scalars[3] = -30.0f;    // highlights
+    scalars[9] = 15.0f;     // temperature
+    const PackedCurve curve{true, {0.0f, 0.25f, 1.0f}, {0.0f, 0.3f, 1.0f}};
+
+    struct Case {
+        uint32_t width;
+        uint32_t height;
+        OutputPixelFormat format;
+        uint32_t flags;
+    };
+    const Case cases[] = {
+        {48, 30, OutputPixelFormat::RGBA_8888, 0},
+        {48, 30, OutputPixelFormat::RGBA_8888, RENDER_FLAG_DITHER},
+        {97, 61, OutputPixelFormat::RGBA_16, RENDER_FLAG_DITHER},
+        {150, 95, OutputPixelFormat::RGBA_F16, 0},
+        {33, 21, OutputPixelFormat::RGBA_1010102, 0},
+    };
+
+    RenderPipeline pipeline;
+    for (const Case& c : cases) {
+        std::vector<uint8_t> packed = packParams(scalars, curve, c.flags);
+        BasicAdjustmentParams params;
+        uint32_t flags = 0;
+        expect(RenderPipeline::unpackParams(packed.data(), packed.size(), params, flags), "unpack params");
+
+        OutputBuffer output(c.width, c.height, c.format);
+        const bool rendered = pipeline.render(view, params, output.buffer, flags);
+        if (!rendered || !output.guardsIntact() || !output.alphaOpaque()) {
+            std::printf("  render %ux%u format=%d flags=%u: rendered=%d guards=%d alpha=%d\n",
+                        c.width, c.height, static_cast<int>(c.format), flags,
+                        rendered, output.guardsIntact(), output.alphaOpaque());
+        }
+        expect(rendered, "render succeeds");
+        expect(output.guardsIntact(), "render stays within stride");
+        expect(output.alphaOpaque(), "every pixel written with opaque alpha");
+    }
+    expect(pipeline.getStats().renders == sizeof(cases) / sizeof(cases[0]), "render count");
+
+    // stride 小于一行像素时拒绝
+    BasicAdjustmentParams params;
+    OutputBuffer output(16, 16, OutputPixelFormat::RGBA_16);
+    output.buffer.stride = 16 * 4;
+    expect(!pipeline.render(view, params, output.buffer), "reject short stride");
+}
+
+/**
+ * 管线池：多次渲染复用空闲管线，回收后仍可渲染
+ */
+void testPool() {
+    const LinearImage view = makeView(40, 40);
+    float scalars[RenderParamsLayout::kScalarCount];
+    neutralScalars(scalars);
+    std::vector<uint8_t> packed = packParams(scalars, PackedCurve{false, {}, {}}, 0);
+    BasicAdjustmentParams params;
+    uint32_t flags = 0;
+    RenderPipeline::unpackParams(packed.data(), packed.size(), params, flags);
+
+    RenderPipelinePool& pool = RenderPipelinePool::getInstance();
+    OutputBuffer output(20, 20, OutputPixelFormat::RGBA_8888);
+    const uint64_t before = pool.getStats().renders;
+    expect(pool.render(view, params, output.buffer, flags), "pool render");
+    expect(pool.trimMemory() > 0, "trim releases idle working image");
+    expect(pool.render(view, params, output.buffer, flags), "pool render after trim");
+    expect(pool.getStats().renders == before + 2, "pool render count");
+    expect(output.guardsIntact(), "pool render stays within stride");
+}
+
+} // namespace
+
+int main() {
+    testUnpack();
+    testNeutralMatchesConverter();
+    testFormatsAndSizes();
+    testPool();
+
+    return finish("render_pipeline_test");
+}
@@ -0,0 +1,32 @@
+#ifndef FILMTRACKER_TEST_UTIL_H
+#define FILMTRACKER_TEST_UTIL_H
+
+#include <cstddef>
+#include <cstdio>
+
+/**
+ * 主机端测试的检查与汇总
+ *
+ * expect() 记录失败的检查并继续执行，main() 最后返回 finish(测试名)：
+ * 有失败时打印失败数并返回 1（ctest 判定失败），否则打印 OK 并返回 0。
+ */
+
+inline size_t g_failures = 0;
+
+inline void expect(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("  FAILED: %s\n", what);
+        ++g_failures;
+    }
+}
+
+inline int finish(const char* name) {
+    if (g_failures > 0) {
+        std::printf("%s: FAILED (%zu checks)\n", name, g_failures);
+        return 1;
+    }
+    std::printf("%s: OK\n", name);
+    return 0;
+}
+
+#endif // FILMTRACKER_TEST_UTIL_H
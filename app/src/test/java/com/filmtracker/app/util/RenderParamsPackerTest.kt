@@ -0,0 +1,203 @@
+package com.filmtracker.app.util
+
+import com.filmtracker.app.data.BasicAdjustmentParams
+import com.filmtracker.app.native.RenderPipelineNative
+import org.junit.Test
+import org.junit.Assert.*
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Unit tests for RenderParamsPacker.
+ *
+ * Checks the packed buffer against the native RenderParamsLayout
+ * (render_pipeline.h): header, layout version, scalar order and the
+ * HSL / curve block offsets.
+ */
+class RenderParamsPackerTest {
+
+    companion object {
+        private const val HEADER_BYTES = 16
+        private const val SCALAR_COUNT = 25
+        private const val HSL_OFFSET = HEADER_BYTES + SCALAR_COUNT * 4
+        private const val CURVE_OFFSET = HSL_OFFSET + 4 + 24 * 4
+        private const val DELTA = 1e-6f
+    }
+
+    /**
+     * Reads `static constexpr uint32_t <name> = <value>;` from the native layout.
+     * Unit tests run with the module directory as working directory.
+     */
+    private fun nativeLayoutConstant(name: String): Long {
+        val header = File("src/main/cpp/core/render_pipeline.h")
+        assertTrue("Native layout header not found: ${header.absolutePath}", header.exists())
+        val match = Regex("""static constexpr uint32_t $name = (0x[0-9A-Fa-f]+|\d+);""")
+            .find(header.readText())
+        assertNotNull("RenderParamsLayout::$name not found", match)
+        val literal = match!!.groupValues[1]
+        return if (literal.startsWith("0x")) literal.substring(2).toLong(16) else literal.toLong()
+    }
+
+    private fun curveBytes(points: Int) = 8 + points * 8
+
+    @Test
+    fun `constants match native RenderParamsLayout`() {
+        assertEquals(nativeLayoutConstant("kMagic"), RenderPipelineNative.PARAMS_MAGIC.toLong())
+        assertEquals(nativeLayoutConstant("kVersion"), RenderPipelineNative.PARAMS_VERSION.toLong())
+        assertEquals(nativeLayoutConstant("kHeaderBytes"), RenderPipelineNative.PARAMS_HEADER_BYTES.toLong())
+        assertEquals(nativeLayoutConstant("kScalarCount"), RenderPipelineNative.PARAMS_SCALAR_COUNT.toLong())
+        assertEquals(HEADER_BYTES, RenderPipelineNative.PARAMS_HEADER_BYTES)
+        assertEquals(SCALAR_COUNT, RenderPipelineNative.PARAMS_SCALAR_COUNT)
+    }
+
+    @Test
+    fun `header holds magic version size and flags`() {
+        val buffer = RenderParamsPacker.pack(BasicAdjustmentParams(), RenderPipelineNative.FLAG_DITHER)
+
+        assertTrue("Buffer must be direct", buffer.isDirect)
+        assertEquals(ByteOrder.LITTLE_ENDIAN, buffer.order())
+        assertEquals(0, buffer.position())
+        // "FTRP" in byte order
+        assertEquals('F'.code.toByte(), buffer.get(0))
+        assertEquals('T'.code.toByte(), buffer.get(1))
+        assertEquals('R'.code.toByte(), buffer.get(2))
+        assertEquals('P'.code.toByte(), buffer.get(3))
+        assertEquals(RenderPipelineNative.PARAMS_MAGIC, buffer.getInt(0))
+        assertEquals(RenderPipelineNative.PARAMS_VERSION, buffer.getInt(4))
+        assertEquals(buffer.limit(), buffer.getInt(8))
+        assertEquals(RenderPipelineNative.FLAG_DITHER, buffer.getInt(12))
+    }
+
+    @Test
+    fun `total size covers header scalars HSL and four curves`() {
+        val params = BasicAdjustmentParams(
+            rgbCurvePoints = listOf(0f to 0f, 0.5f to 0.6f, 1f to 1f),
+            redCurvePoints = emptyList()
+        )
+        val buffer = RenderParamsPacker.pack(params)
+
+        val expected = CURVE_OFFSET + curveBytes(3) + curveBytes(0) + curveBytes(2) + curveBytes(2)
+        assertEquals(expected, buffer.limit())
+        assertEquals(expected, buffer.getInt(8))
+    }
+
+    @Test
+    fun `scalars follow native field order`() {
+        val params = BasicAdjustmentParams(
+            globalExposure = 1.5f,
+            contrast = 40f,
+            saturation = -30f,
+            highlights = -20f,
+            gradingBlending = 70f,
+            noiseReduction = 33f
+        )
+        val buffer = RenderParamsPacker.pack(params)
+
+        fun scalar(index: Int) = buffer.getFloat(HEADER_BYTES + index * 4)
+        assertEquals(1.5f, scalar(0), DELTA)
+        // contrast / saturation are packed as multipliers
+        assertEquals(AdobeParameterConverter.contrastToMultiplier(40f), scalar(1), DELTA)
+        assertEquals(AdobeParameterConverter.saturationToMultiplier(-30f), scalar(2), DELTA)
+        assertEquals(-20f, scalar(3), DELTA)
+        assertEquals(70f, scalar(17), DELTA)
+        assertEquals(33f, scalar(SCALAR_COUNT - 1), DELTA)
+    }
+
+    @Test
+    fun `HSL block starts after scalars`() {
+        val params = BasicAdjustmentParams(
+            enableHSL = true,
+            hslHueShift = FloatArray(8) { it.toFloat() },
+            hslSaturation = FloatArray(8) { 10f + it },
+            hslLuminance = FloatArray(8) { -it.toFloat() }
+        )
+        val buffer = RenderParamsPacker.pack(params)
+
+        assertEquals(1, buffer.getInt(HSL_OFFSET))
+        for (i in 0 until 8) {
+            assertEquals(i.toFloat(), buffer.getFloat(HSL_OFFSET + 4 + i * 4), DELTA)
+            assertEquals(10f + i, buffer.getFloat(HSL_OFFSET + 4 + 32 + i * 4), DELTA)
+            assertEquals(-i.toFloat(), buffer.getFloat(HSL_OFFSET + 4 + 64 + i * 4), DELTA)
+        }
+    }
+
+    @Test
+    fun `HSL with wrong array length is packed disabled`() {
+        val params = BasicAdjustmentParams(enableHSL = true, hslHueShift = FloatArray(3) { 5f })
+        val buffer = RenderParamsPacker.pack(params)
+
+        assertEquals(0, buffer.getInt(HSL_OFFSET))
+        for (i in 0 until 24) {
+            assertEquals(0f, buffer.getFloat(HSL_OFFSET + 4 + i * 4), DELTA)
+        }
+    }
+
+    @Test
+    fun `curves are packed as enabled count xs ys in RGB R G B order`() {
+        val params = BasicAdjustmentParams(
+            enableRgbCurve = true,
+            rgbCurvePoints = listOf(0f to 0.1f, 0.5f to 0.7f, 1f to 0.9f),
+            enableGreenCurve = true,
+            greenCurvePoints = listOf(0f to 0.2f, 1f to 0.8f)
+        )
+        val buffer = RenderParamsPacker.pack(params)
+
+        var offset = CURVE_OFFSET
+        // RGB
+        assertEquals(1, buffer.getInt(offset))
+        assertEquals(3, buffer.getInt(offset + 4))
+        assertEquals(0.5f, buffer.getFloat(offset + 8 + 4), DELTA)
+        assertEquals(0.1f, buffer.getFloat(offset + 8 + 12), DELTA)
+        assertEquals(0.9f, buffer.getFloat(offset + 8 + 12 + 8), DELTA)
+        offset += curveBytes(3)
+        // R (disabled)
+        assertEquals(0, buffer.getInt(offset))
+        assertEquals(2, buffer.getInt(offset + 4))
+        offset += curveBytes(2)
+        // G
+        assertEquals(1, buffer.getInt(offset))
+        assertEquals(2, buffer.getInt(offset + 4))
+        assertEquals(0.2f, buffer.getFloat(offset + 8 + 8), DELTA)
+        assertEquals(0.8f, buffer.getFloat(offset + 8 + 12), DELTA)
+        offset += curveBytes(2)
+        // B
+        assertEquals(0, buffer.getInt(offset))
+        offset += curveBytes(2)
+        assertEquals(buffer.limit(), offset)
+    }
+
+    @Test
+    fun `enabled curve without points is packed disabled`() {
+        val params = BasicAdjustmentParams(enableRgbCurve = true, rgbCurvePoints = emptyList())
+        val buffer = RenderParamsPacker.pack(params)
+
+        assertEquals(0, buffer.getInt(CURVE_OFFSET))
+        assertEquals(0, buffer.getInt(CURVE_OFFSET + 4))
+    }
+
+    @Test
+    fun `curve points are truncated to native maximum`() {
+        val maxPoints = nativeLayoutConstant("kMaxCurvePoints").toInt()
+        val points = List(maxPoints + 10) { i -> i.toFloat() / (maxPoints + 9) to 0.5f }
+        val buffer = RenderParamsPacker.pack(BasicAdjustmentParams(enableRgbCurve = true, rgbCurvePoints = points))
+
+        assertEquals(maxPoints, buffer.getInt(CURVE_OFFSET + 4))
+    }
+
+    @Test
+    fun `reuse keeps a large enough direct buffer`() {
+        val reuse = ByteBuffer.allocateDirect(4096)
+        val packed = RenderParamsPacker.pack(BasicAdjustmentParams(), reuse = reuse)
+        assertSame(reuse, packed)
+        assertEquals(0, packed.position())
+
+        val small = ByteBuffer.allocateDirect(16)
+        assertNotSame(small, RenderParamsPacker.pack(BasicAdjustmentParams(), reuse = small))
+
+        val heap = ByteBuffer.allocate(4096)
+        val fromHeap = RenderParamsPacker.pack(BasicAdjustmentParams(), reuse = heap)
+        assertNotSame(heap, fromHeap)
+        assertTrue(fromHeap.isDirect)
+    }
+}